@@ -2,6 +2,7 @@
 # CaDiCaL_FOUND - system has CaDiCaL lib
 # CaDiCaL_INCLUDE_DIR - the CaDiCaL include directory
 # CaDiCaL_LIBRARIES - Libraries needed to use CaDiCaL
+# CaDiCaL_HAS_PROPAGATOR - CaDiCaL provides the external propagator interface
 
 find_path(CaDiCaL_INCLUDE_DIR NAMES cadical.hpp)
 find_library(CaDiCaL_LIBRARIES NAMES cadical)
@@ -11,6 +12,30 @@ find_package_handle_standard_args(CaDiCaL
   DEFAULT_MSG
   CaDiCaL_INCLUDE_DIR CaDiCaL_LIBRARIES)
 
+# The external propagator interface (IPASIR-UP) with the callback signatures
+# we implement was introduced in CaDiCaL 2.0.
+if(CaDiCaL_INCLUDE_DIR)
+  include(CheckCXXSourceCompiles)
+  set(CMAKE_REQUIRED_INCLUDES ${CaDiCaL_INCLUDE_DIR})
+  check_cxx_source_compiles(
+    "
+    #include <cadical.hpp>
+    #include <vector>
+    struct P : CaDiCaL::ExternalPropagator {
+      void notify_assignment(const std::vector<int>&) override {}
+      void notify_new_decision_level() override {}
+      void notify_backtrack(size_t) override {}
+      bool cb_check_found_model(const std::vector<int>&) override { return true; }
+      bool cb_has_external_clause(bool&) override { return false; }
+      int cb_add_external_clause_lit() override { return 0; }
+    };
+    int main() { P p; return 0; }
+    "
+    CaDiCaL_HAS_PROPAGATOR
+  )
+  unset(CMAKE_REQUIRED_INCLUDES)
+endif()
+
 mark_as_advanced(CaDiCaL_INCLUDE_DIR CaDiCaL_LIBRARIES)
 if(CaDiCaL_LIBRARIES)
   message(STATUS "Found CaDiCaL libs: ${CaDiCaL_LIBRARIES}")
@@ -33,6 +33,7 @@ The following flags enable optional features (disable with --no-<option name>).
   --debug-symbols          include debug symbols
   --valgrind               Valgrind instrumentation
   --debug-context-mm       use the debug context memory manager
+  --concurrent-nm          support terms built concurrently by several threads
   --statistics             include statistics
   --replay                 turn on the replay feature
   --assertions             turn on assertions
@@ -120,6 +121,7 @@ coverage=default
 cryptominisat=default
 debug_symbols=default
 debug_context_mm=default
+concurrent_nm=default
 drat2er=default
 dumping=default
 gpl=default
@@ -219,6 +221,9 @@ do
     --debug-context-mm) debug_context_mm=ON;;
     --no-debug-context-mm) debug_context_mm=OFF;;
 
+    --concurrent-nm) concurrent_nm=ON;;
+    --no-concurrent-nm) concurrent_nm=OFF;;
+
     --drat2er) drat2er=ON;;
     --no-drat2er) drat2er=OFF;;
 
@@ -374,6 +379,8 @@ cmake_opts=""
   && cmake_opts="$cmake_opts -DENABLE_DEBUG_SYMBOLS=$debug_symbols"
 [ $debug_context_mm != default ] \
   && cmake_opts="$cmake_opts -DENABLE_DEBUG_CONTEXT_MM=$debug_context_mm"
+[ $concurrent_nm != default ] \
+  && cmake_opts="$cmake_opts -DENABLE_CONCURRENT_NM=$concurrent_nm"
 [ $dumping != default ] \
   && cmake_opts="$cmake_opts -DENABLE_DUMPING=$dumping"
 [ $gpl != default ] \
@@ -99,6 +99,8 @@ public:
 
   static bool isBuiltWithCadical();
 
+  static bool isBuiltWithCadicalPropagator();
+
   static bool isBuiltWithCryptominisat();
 
   static bool isBuiltWithDrat2Er();
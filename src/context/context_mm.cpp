@@ -15,6 +15,7 @@
  **/
 
 
+#include <algorithm>
 #include <cstdlib>
 #include <vector>
 #include <deque>
@@ -27,90 +28,270 @@
 #include "base/check.h"
 #include "base/output.h"
 #include "context/context_mm.h"
+#include "util/statistics_registry.h"
 
 namespace CVC4 {
 namespace context {
 
 #ifndef CVC4_DEBUG_CONTEXT_MEMORY_MANAGER
 
-void ContextMemoryManager::newChunk() {
+const size_t ContextMemoryManager::s_minChunkSizeBytes;
+const size_t ContextMemoryManager::s_maxChunkSizeBytes;
+const size_t ContextMemoryManager::s_largeObjectBytes;
+const size_t ContextMemoryManager::s_maxAllocationBytes;
+const size_t ContextMemoryManager::s_defaultMaxFreeBytes;
+
+/** The per-level byte counts of a ContextMemoryManager, as a histogram */
+class ContextLevelBytesStat : public Stat
+{
+ public:
+  ContextLevelBytesStat(const std::string& name,
+                        const std::vector<int64_t>& bytesPerLevel)
+      : Stat(name), d_bytesPerLevel(bytesPerLevel)
+  {
+  }
+
+  void flushInformation(std::ostream& out) const override
+  {
+    out << "[";
+    for (size_t i = 0, n = d_bytesPerLevel.size(); i < n; ++i)
+    {
+      out << (i == 0 ? "" : ", ") << "(" << i << " : " << d_bytesPerLevel[i]
+          << ")";
+    }
+    out << "]";
+  }
+
+  void safeFlushInformation(int fd) const override
+  {
+    safe_print(fd, "[");
+    for (size_t i = 0, n = d_bytesPerLevel.size(); i < n; ++i)
+    {
+      if (i > 0)
+      {
+        safe_print(fd, ", ");
+      }
+      safe_print(fd, "(");
+      safe_print<uint64_t>(fd, i);
+      safe_print(fd, " : ");
+      safe_print<int64_t>(fd, d_bytesPerLevel[i]);
+      safe_print(fd, ")");
+    }
+    safe_print(fd, "]");
+  }
+
+ private:
+  const std::vector<int64_t>& d_bytesPerLevel;
+}; /* class ContextLevelBytesStat */
+
+struct ContextMemoryManager::Statistics
+{
+  /** Bytes in use per context level */
+  ContextLevelBytesStat d_bytesPerLevel;
+  /** Bytes in chunks owned by the memory manager */
+  ReferenceStat<int64_t> d_chunkBytes;
+  /** Bytes in cached free chunks */
+  ReferenceStat<size_t> d_freeBytes;
+  /** Bytes in separately allocated objects */
+  ReferenceStat<int64_t> d_largeObjectBytes;
+  /** Chunks obtained from malloc */
+  ReferenceStat<int64_t> d_chunksAllocated;
+
+  Statistics(StatisticsRegistry& stats,
+             const std::string& prefix,
+             const ContextMemoryManager& cmm);
+  ~Statistics();
+
+ private:
+  StatisticsRegistry& d_statisticsRegistry;
+};
+
+ContextMemoryManager::Statistics::Statistics(StatisticsRegistry& stats,
+                                             const std::string& prefix,
+                                             const ContextMemoryManager& cmm)
+    : d_bytesPerLevel(prefix + "bytesPerLevel", cmm.d_bytesPerLevel),
+      d_chunkBytes(prefix + "chunkBytes", cmm.d_chunkBytes),
+      d_freeBytes(prefix + "freeBytes", cmm.d_freeBytes),
+      d_largeObjectBytes(prefix + "largeObjectBytes", cmm.d_largeObjectBytes),
+      d_chunksAllocated(prefix + "chunksAllocated", cmm.d_chunksAllocated),
+      d_statisticsRegistry(stats)
+{
+  d_statisticsRegistry.registerStat(&d_bytesPerLevel);
+  d_statisticsRegistry.registerStat(&d_chunkBytes);
+  d_statisticsRegistry.registerStat(&d_freeBytes);
+  d_statisticsRegistry.registerStat(&d_largeObjectBytes);
+  d_statisticsRegistry.registerStat(&d_chunksAllocated);
+}
+
+ContextMemoryManager::Statistics::~Statistics()
+{
+  d_statisticsRegistry.unregisterStat(&d_bytesPerLevel);
+  d_statisticsRegistry.unregisterStat(&d_chunkBytes);
+  d_statisticsRegistry.unregisterStat(&d_freeBytes);
+  d_statisticsRegistry.unregisterStat(&d_largeObjectBytes);
+  d_statisticsRegistry.unregisterStat(&d_chunksAllocated);
+}
+
+void ContextMemoryManager::newChunk(size_t minSize) {
 
   // Increment index to chunk list
   ++d_indexChunkList;
   Assert(d_chunkList.size() == d_indexChunkList)
       << "Index should be at the end of the list";
+  Assert(minSize <= s_largeObjectBytes);
 
-  // Create new chunk if no free chunk available
-  if(d_freeChunks.empty()) {
-    d_chunkList.push_back((char*)malloc(chunkSizeBytes));
-    if(d_chunkList.back() == NULL) {
+  // Create new chunk if no free chunk of the requested size is available,
+  // a free chunk that is too small stays in the cache
+  if (d_freeChunks.empty() || d_freeChunks.back().d_size < minSize)
+  {
+    // Grow geometrically with the number of chunks in use
+    size_t size = s_maxChunkSizeBytes;
+    if (d_indexChunkList < 32)
+    {
+      size = std::min(s_minChunkSizeBytes << d_indexChunkList,
+                      s_maxChunkSizeBytes);
+    }
+    while (size < minSize)
+    {
+      size <<= 1;
+    }
+    Chunk chunk = {static_cast<char*>(malloc(size)), size};
+    if (chunk.d_data == NULL)
+    {
       throw std::bad_alloc();
     }
+    d_chunkList.push_back(chunk);
+    d_chunkBytes += size;
+    ++d_chunksAllocated;
 
 #ifdef CVC4_VALGRIND
-    VALGRIND_MAKE_MEM_NOACCESS(d_chunkList.back(), chunkSizeBytes);
+    VALGRIND_MAKE_MEM_NOACCESS(chunk.d_data, size);
 #endif /* CVC4_VALGRIND */
   }
   // If there is a free chunk, use that
   else {
     d_chunkList.push_back(d_freeChunks.back());
     d_freeChunks.pop_back();
+    d_freeBytes -= d_chunkList.back().d_size;
   }
   // Set up the current chunk pointers
-  d_nextFree = d_chunkList.back();
-  d_endChunk = d_nextFree + chunkSizeBytes;
+  d_nextFree = d_chunkList.back().d_data;
+  d_endChunk = d_nextFree + d_chunkList.back().d_size;
+}
+
+void* ContextMemoryManager::newLargeObject(size_t size)
+{
+  char* res = static_cast<char*>(malloc(size));
+  if (res == NULL)
+  {
+    throw std::bad_alloc();
+  }
+  d_largeObjects.push_back(std::make_pair(res, size));
+  d_largeObjectBytes += size;
+
+#ifdef CVC4_VALGRIND
+  VALGRIND_MAKE_MEM_NOACCESS(res, size);
+  VALGRIND_MEMPOOL_ALLOC(this, res, size);
+  d_allocations.back().push_back(res);
+#endif /* CVC4_VALGRIND */
+
+  return res;
 }
 
+void ContextMemoryManager::trimFreeChunks()
+{
+  // Delete excess free chunks, least recently used first
+  while (d_freeBytes > d_maxFreeBytes)
+  {
+    const Chunk& chunk = d_freeChunks.front();
+    free(chunk.d_data);
+    d_freeBytes -= chunk.d_size;
+    d_chunkBytes -= chunk.d_size;
+    d_freeChunks.pop_front();
+  }
+}
 
-ContextMemoryManager::ContextMemoryManager() : d_indexChunkList(0) {
+ContextMemoryManager::ContextMemoryManager()
+    : d_freeBytes(0),
+      d_maxFreeBytes(s_defaultMaxFreeBytes),
+      d_indexChunkList(0),
+      d_bytesPerLevel(1, 0),
+      d_chunkBytes(s_minChunkSizeBytes),
+      d_largeObjectBytes(0),
+      d_chunksAllocated(1)
+{
   // Create initial chunk
-  d_chunkList.push_back((char*)malloc(chunkSizeBytes));
-  d_nextFree = d_chunkList.back();
-  if(d_nextFree == NULL) {
+  Chunk chunk = {static_cast<char*>(malloc(s_minChunkSizeBytes)),
+                 s_minChunkSizeBytes};
+  if (chunk.d_data == NULL)
+  {
     throw std::bad_alloc();
   }
-  d_endChunk = d_nextFree + chunkSizeBytes;
+  d_chunkList.push_back(chunk);
+  d_nextFree = chunk.d_data;
+  d_endChunk = d_nextFree + s_minChunkSizeBytes;
 
 #ifdef CVC4_VALGRIND
   VALGRIND_CREATE_MEMPOOL(this, 0, false);
-  VALGRIND_MAKE_MEM_NOACCESS(d_nextFree, chunkSizeBytes);
+  VALGRIND_MAKE_MEM_NOACCESS(d_nextFree, s_minChunkSizeBytes);
   d_allocations.push_back(std::vector<char*>());
 #endif /* CVC4_VALGRIND */
 }
 
 
 ContextMemoryManager::~ContextMemoryManager() {
+  d_statistics.reset();
+
 #ifdef CVC4_VALGRIND
   VALGRIND_DESTROY_MEMPOOL(this);
 #endif /* CVC4_VALGRIND */
 
   // Delete all chunks
-  while(!d_chunkList.empty()) {
-    free(d_chunkList.back());
-    d_chunkList.pop_back();
+  for (const Chunk& chunk : d_chunkList)
+  {
+    free(chunk.d_data);
   }
-  while(!d_freeChunks.empty()) {
-    free(d_freeChunks.back());
-    d_freeChunks.pop_back();
+  for (const Chunk& chunk : d_freeChunks)
+  {
+    free(chunk.d_data);
+  }
+  for (const std::pair<char*, size_t>& obj : d_largeObjects)
+  {
+    free(obj.first);
   }
 }
 
 
 void* ContextMemoryManager::newData(size_t size) {
+  if (size > s_maxAllocationBytes)
+  {
+    throw std::bad_alloc();
+  }
+  d_bytesPerLevel[d_nextFreeStack.size()] += size;
+
+  // Serve big requests separately
+  if (size > s_largeObjectBytes)
+  {
+    void* res = newLargeObject(size);
+    Debug("context") << "ContextMemoryManager::newData(" << size
+                     << ") returning large object " << res << " at level "
+                     << d_nextFreeStack.size() << std::endl;
+    return res;
+  }
+
   // Use next available free location in current chunk
   void* res = (void*)d_nextFree;
   d_nextFree += size;
   // Check if the request is too big for the chunk
   if(d_nextFree > d_endChunk) {
-    newChunk();
+    newChunk(size);
     res = (void*)d_nextFree;
     d_nextFree += size;
-    AlwaysAssert(d_nextFree <= d_endChunk)
-        << "Request is bigger than memory chunk size";
+    Assert(d_nextFree <= d_endChunk);
   }
   Debug("context") << "ContextMemoryManager::newData(" << size
                    << ") returning " << res << " at level "
-                   << d_chunkList.size() << std::endl;
+                   << d_nextFreeStack.size() << std::endl;
 
 #ifdef CVC4_VALGRIND
   VALGRIND_MEMPOOL_ALLOC(this, static_cast<char*>(res), size);
@@ -130,6 +311,12 @@ void ContextMemoryManager::push() {
   d_nextFreeStack.push_back(d_nextFree);
   d_endChunkStack.push_back(d_endChunk);
   d_indexChunkListStack.push_back(d_indexChunkList);
+  d_largeObjectsStack.push_back(d_largeObjects.size());
+
+  if (d_bytesPerLevel.size() == d_nextFreeStack.size())
+  {
+    d_bytesPerLevel.push_back(0);
+  }
 }
 
 
@@ -144,6 +331,9 @@ void ContextMemoryManager::pop() {
 
   Assert(d_nextFreeStack.size() > 0 && d_endChunkStack.size() > 0);
 
+  // All the memory of the level is released
+  d_bytesPerLevel[d_nextFreeStack.size()] = 0;
+
   // Restore state from stack
   d_nextFree = d_nextFreeStack.back();
   d_nextFreeStack.pop_back();
@@ -152,22 +342,43 @@ void ContextMemoryManager::pop() {
 
   // Free all the new chunks since the last push
   while(d_indexChunkList > d_indexChunkListStack.back()) {
-    d_freeChunks.push_back(d_chunkList.back());
+    const Chunk& chunk = d_chunkList.back();
 #ifdef CVC4_VALGRIND
-    VALGRIND_MAKE_MEM_NOACCESS(d_chunkList.back(), chunkSizeBytes);
+    VALGRIND_MAKE_MEM_NOACCESS(chunk.d_data, chunk.d_size);
 #endif /* CVC4_VALGRIND */
+    d_freeChunks.push_back(chunk);
+    d_freeBytes += chunk.d_size;
     d_chunkList.pop_back();
     --d_indexChunkList;
   }
   d_indexChunkListStack.pop_back();
 
-  // Delete excess free chunks
-  while(d_freeChunks.size() > maxFreeChunks) {
-    free(d_freeChunks.front());
-    d_freeChunks.pop_front();
+  // Free the large objects allocated since the last push
+  while (d_largeObjects.size() > d_largeObjectsStack.back())
+  {
+    free(d_largeObjects.back().first);
+    d_largeObjectBytes -= d_largeObjects.back().second;
+    d_largeObjects.pop_back();
   }
+  d_largeObjectsStack.pop_back();
+
+  trimFreeChunks();
+}
+
+void ContextMemoryManager::setMaxFreeBytes(size_t maxFreeBytes)
+{
+  d_maxFreeBytes = maxFreeBytes;
+  trimFreeChunks();
+}
+
+void ContextMemoryManager::registerStatistics(StatisticsRegistry& stats,
+                                              const std::string& prefix)
+{
+  d_statistics.reset(new Statistics(stats, prefix, *this));
 }
 
+void ContextMemoryManager::unregisterStatistics() { d_statistics.reset(); }
+
 #endif /* CVC4_DEBUG_CONTEXT_MEMORY_MANAGER */
 
 } /* CVC4::context namespace */
@@ -22,9 +22,15 @@
 
 #include <deque>
 #include <limits>
+#include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
 namespace CVC4 {
+
+class StatisticsRegistry;
+
 namespace context {
 
 #ifndef CVC4_DEBUG_CONTEXT_MEMORY_MANAGER
@@ -38,29 +44,59 @@ namespace context {
  * stack, and a new current region is created.  A subsequent call to pop
  * releases the new region and restores the top region from the stack.
  *
+ * Memory is carved out of chunks whose size grows geometrically with the
+ * number of chunks in use, so that deep push/pop sequences go to malloc
+ * less and less often.  Requests that are too big to be carved out of a
+ * chunk are allocated separately and released when their region is popped.
+ * Chunks released by pop are kept in a cache of free chunks, whose size is
+ * bounded by setMaxFreeBytes().
  */
 class ContextMemoryManager {
 
-  /**
-   * Memory in regions is allocated in chunks.  This is the chunk size
-   */
-  static const unsigned chunkSizeBytes = 16384;
+  /** The size of the first chunk */
+  static const size_t s_minChunkSizeBytes = 16384;
+
+  /** Chunks do not grow larger than this */
+  static const size_t s_maxChunkSizeBytes = 1 << 20;
 
   /**
-   * A list of free chunks is maintained.  This is the maximum number of
-   * free chunks.
+   * Requests larger than this are not carved out of a chunk but allocated
+   * separately.  Smaller ones get a chunk that is big enough if the current
+   * one is full.
    */
-  static const unsigned maxFreeChunks = 100;
+  static const size_t s_largeObjectBytes = s_maxChunkSizeBytes / 4;
+
+  /** The largest request served, see getMaxAllocationSize() */
+  static const size_t s_maxAllocationBytes = 1 << 30;
+
+  /** A chunk of memory */
+  struct Chunk
+  {
+    char* d_data;
+    size_t d_size;
+  };
 
   /**
    * List of all chunks that are currently active
    */
-  std::vector<char*> d_chunkList;
+  std::vector<Chunk> d_chunkList;
 
   /**
    * Queue of free chunks (for best cache performance, LIFO order is used)
    */
-  std::deque<char*> d_freeChunks;
+  std::deque<Chunk> d_freeChunks;
+
+  /** The total size of the chunks in d_freeChunks */
+  size_t d_freeBytes;
+
+  /** The maximum total size of the chunks in d_freeChunks */
+  size_t d_maxFreeBytes;
+
+  /**
+   * The separately allocated (large) objects of all regions, together with
+   * their sizes
+   */
+  std::vector<std::pair<char*, size_t>> d_largeObjects;
 
   /**
    * Pointer to the beginning of available memory in the current chunk in
@@ -98,11 +134,41 @@ class ContextMemoryManager {
   std::vector<unsigned> d_indexChunkListStack;
 
   /**
-   * Private method to grab a new chunk for the current region.  Uses chunk
-   * from d_freeChunks if available.  Creates a new one otherwise.  Sets the
-   * new chunk to be the current chunk.
+   * Part of the stack of saved regions.  This vector stores the saved size
+   * of d_largeObjects
+   */
+  std::vector<size_t> d_largeObjectsStack;
+
+  /**
+   * The number of bytes requested from each level that is in use, the
+   * entries of the popped levels are zero
    */
-  void newChunk();
+  std::vector<int64_t> d_bytesPerLevel;
+
+  /** The number of bytes in chunks owned by this memory manager */
+  int64_t d_chunkBytes;
+
+  /** The number of bytes in separately allocated objects */
+  int64_t d_largeObjectBytes;
+
+  /** The number of chunks obtained from malloc */
+  int64_t d_chunksAllocated;
+
+  struct Statistics;
+  std::unique_ptr<Statistics> d_statistics;
+
+  /**
+   * Private method to grab a new chunk of at least minSize bytes for the
+   * current region.  Uses chunk from d_freeChunks if available.  Creates a
+   * new one otherwise.  Sets the new chunk to be the current chunk.
+   */
+  void newChunk(size_t minSize);
+
+  /** Allocate size bytes outside of the chunks for the current region */
+  void* newLargeObject(size_t size);
+
+  /** Free chunks from the front of d_freeChunks until it fits the bound */
+  void trimFreeChunks();
 
 #ifdef CVC4_VALGRIND
   /**
@@ -113,12 +179,15 @@ class ContextMemoryManager {
 #endif
 
  public:
+  /** The default bound on the total size of the cached free chunks */
+  static const size_t s_defaultMaxFreeBytes = 16 << 20;
+
   /**
-   * Get the maximum allocation size for this memory manager.
+   * Get the maximum allocation size for this memory manager.  Requests of
+   * more than s_largeObjectBytes, up to this size, are allocated separately
+   * from the chunks.
    */
-  static unsigned getMaxAllocationSize() {
-    return chunkSizeBytes;
-  }
+  static unsigned getMaxAllocationSize() { return s_maxAllocationBytes; }
 
   /**
    * Constructor - creates an initial region and an empty stack
@@ -146,6 +215,37 @@ class ContextMemoryManager {
    */
   void pop();
 
+  /**
+   * Bound the total size of the chunks kept for reuse after a pop to
+   * maxFreeBytes.
+   */
+  void setMaxFreeBytes(size_t maxFreeBytes);
+
+  /**
+   * Get the number of bytes requested at the given level, which are freed
+   * when the level is popped
+   */
+  int64_t getBytesAllocated(size_t level) const
+  {
+    return level < d_bytesPerLevel.size() ? d_bytesPerLevel[level] : 0;
+  }
+
+  /** Get the number of bytes in chunks owned by this memory manager */
+  int64_t getChunkBytes() const { return d_chunkBytes; }
+
+  /** Get the number of bytes in cached free chunks */
+  size_t getFreeBytes() const { return d_freeBytes; }
+
+  /**
+   * Register the statistics of this memory manager with stats, prefixing
+   * their names by prefix.  They stay registered until unregisterStatistics
+   * is called.
+   */
+  void registerStatistics(StatisticsRegistry& stats, const std::string& prefix);
+
+  /** Unregister the statistics registered by registerStatistics */
+  void unregisterStatistics();
+
 };/* class ContextMemoryManager */
 
 #else /* CVC4_DEBUG_CONTEXT_MEMORY_MANAGER */
@@ -196,6 +296,15 @@ class ContextMemoryManager
     d_allocations.pop_back();
   }
 
+  void setMaxFreeBytes(size_t maxFreeBytes) {}
+  int64_t getBytesAllocated(size_t level) const { return 0; }
+  int64_t getChunkBytes() const { return 0; }
+  size_t getFreeBytes() const { return 0; }
+  void registerStatistics(StatisticsRegistry& stats, const std::string& prefix)
+  {
+  }
+  void unregisterStatistics() {}
+
  private:
   std::vector<std::vector<char*>> d_allocations;
 }; /* ContextMemoryManager */
@@ -20,6 +20,7 @@
 #include "expr/node.h"
 #include "options/decision_options.h"
 #include "options/smt_options.h"
+#include "smt/smt_statistics_registry.h"
 
 using namespace std;
 
@@ -36,9 +37,17 @@ DecisionEngine::DecisionEngine(context::Context *sc,
   d_satContext(sc),
   d_userContext(uc),
   d_result(sc, SAT_VALUE_UNKNOWN),
-  d_engineState(0)
+  d_engineState(0),
+  d_numDecisions("decision::decisions", 0)
 {
   Trace("decision") << "Creating decision engine" << std::endl;
+  smtStatisticsRegistry()->registerStat(&d_numDecisions);
+}
+
+DecisionEngine::~DecisionEngine()
+{
+  Trace("decision") << "Destroying decision engine" << std::endl;
+  smtStatisticsRegistry()->unregisterStat(&d_numDecisions);
 }
 
 void DecisionEngine::init()
@@ -30,6 +30,7 @@
 #include "prop/sat_solver_types.h"
 #include "smt/smt_engine_scope.h"
 #include "smt/term_formula_removal.h"
+#include "util/statistics_registry.h"
 
 using namespace std;
 using namespace CVC4::prop;
@@ -61,16 +62,18 @@ class DecisionEngine {
 
   // init/shutdown state
   unsigned d_engineState;    // 0=pre-init; 1=init,pre-shutdown; 2=shutdown
+
+  /** Statistic: the number of decisions made by the strategies */
+  IntStat d_numDecisions;
+
 public:
   // Necessary functions
 
   /** Constructor */
   DecisionEngine(context::Context *sc, context::UserContext *uc);
 
-  /** Destructor, currently does nothing */
-  ~DecisionEngine() {
-    Trace("decision") << "Destroying decision engine" << std::endl;
-  }
+  /** Destructor */
+  ~DecisionEngine();
 
   // void setPropEngine(PropEngine* pe) {
   //   // setPropEngine should not be called more than once
@@ -131,6 +134,10 @@ public:
           and stopSearch == false; ++i) {
       ret = d_enabledStrategies[i]->getNext(stopSearch);
     }
+    if (ret != undefSatLiteral)
+    {
+      ++d_numDecisions;
+    }
     return ret;
   }
 
@@ -205,9 +212,25 @@ public:
   SatValue getSatValue(TNode n) {
     return getSatValue(getSatLiteral(n));
   }
+  /** The value of the literal of n, unknown if it does not have one */
+  SatValue tryGetSatValue(TNode n)
+  {
+    const CnfStream::NodeToLiteralMap& cache =
+        d_cnfStream->getTranslationCache();
+    CnfStream::NodeToLiteralMap::const_iterator it = cache.find(n);
+    return it == cache.end() ? SAT_VALUE_UNKNOWN
+                             : d_satSolver->value((*it).second);
+  }
   Node getNode(SatLiteral l) {
     return d_cnfStream->getNode(l);
   }
+  /** The number of assigned literals on the trail of the SAT solver */
+  size_t getTrailSize() { return d_satSolver->getTrailSize(); }
+  /** The literal at position i of the trail of the SAT solver */
+  SatLiteral getTrailLiteral(size_t i)
+  {
+    return d_satSolver->getTrailLiteral(i);
+  }
 
 private:
   /**
@@ -21,6 +21,7 @@
 #include "expr/kind.h"
 #include "expr/node_manager.h"
 #include "options/decision_options.h"
+#include "options/prop_options.h"
 #include "theory/rewriter.h"
 #include "smt/term_formula_removal.h"
 #include "smt/smt_statistics_registry.h"
@@ -38,6 +39,7 @@ JustificationHeuristic::JustificationHeuristic(CVC4::DecisionEngine* de,
   d_threshPrvsIndex(c, 0),
   d_helfulness("decision::jh::helpfulness", 0),
   d_giveup("decision::jh::giveup", 0),
+  d_watchJustified("decision::jh::watchJustified", 0),
   d_timestat("decision::jh::time"),
   d_assertions(uc),
   d_iteAssertions(uc),
@@ -48,9 +50,14 @@ JustificationHeuristic::JustificationHeuristic(CVC4::DecisionEngine* de,
   d_curThreshold(0),
   d_childCache(uc),
   d_weightCache(uc),
+  d_watches(),
+  d_watchedGates(),
+  d_watchedVars(),
+  d_trailHead(c, 0),
   d_startIndexCache(c) {
   smtStatisticsRegistry()->registerStat(&d_helfulness);
   smtStatisticsRegistry()->registerStat(&d_giveup);
+  smtStatisticsRegistry()->registerStat(&d_watchJustified);
   smtStatisticsRegistry()->registerStat(&d_timestat);
   Trace("decision") << "Justification heuristic enabled" << std::endl;
 }
@@ -59,6 +66,7 @@ JustificationHeuristic::~JustificationHeuristic()
 {
   smtStatisticsRegistry()->unregisterStat(&d_helfulness);
   smtStatisticsRegistry()->unregisterStat(&d_giveup);
+  smtStatisticsRegistry()->unregisterStat(&d_watchJustified);
   smtStatisticsRegistry()->unregisterStat(&d_timestat);
 }
 
@@ -80,7 +88,13 @@ CVC4::prop::SatLiteral JustificationHeuristic::getNextThresh(bool &stopSearch, D
   Trace("decision") << "JustificationHeuristic::getNextThresh(stopSearch, "<<threshold<<")" << std::endl;
   TimerStat::CodeTimer codeTimer(d_timestat);
 
-  d_visited.clear();
+  updateFromTrail();
+
+  // only left over when a splitter was found below an ITE
+  if (!d_visited.empty())
+  {
+    d_visited.clear();
+  }
   d_curThreshold = threshold;
 
   if(Trace.isOn("justified")) {
@@ -214,9 +228,9 @@ bool JustificationHeuristic::checkJustified(TNode n)
 
 DecisionWeight JustificationHeuristic::getExploredThreshold(TNode n)
 {
-  return
-    d_exploredThreshold.find(n) == d_exploredThreshold.end() ?
-    numeric_limits<DecisionWeight>::max() : d_exploredThreshold[n];
+  ExploredThreshold::const_iterator it = d_exploredThreshold.find(n);
+  return it == d_exploredThreshold.end() ? numeric_limits<DecisionWeight>::max()
+                                         : (*it).second;
 }
 
 void JustificationHeuristic::setExploredThreshold(TNode n)
@@ -254,7 +268,8 @@ DecisionWeight JustificationHeuristic::getWeightPolarized(TNode n, bool polarity
     return getWeight(n);
   }
 
-  if(d_weightCache.find(n) == d_weightCache.end()) {
+  WeightCache::const_iterator it = d_weightCache.find(n);
+  if(it == d_weightCache.end()) {
     Kind k = n.getKind();
     theory::TheoryId tId  = theory::kindToTheoryId(k);
     DecisionWeight dW1, dW2;
@@ -292,9 +307,11 @@ DecisionWeight JustificationHeuristic::getWeightPolarized(TNode n, bool polarity
       }
 
     }
-    d_weightCache[n] = make_pair(dW1, dW2);
+    d_weightCache.insert(n, make_pair(dW1, dW2));
+    return polarity ? dW1 : dW2;
   }
-  return polarity ? d_weightCache[n].get().first : d_weightCache[n].get().second;
+  const pair<DecisionWeight, DecisionWeight>& dW = (*it).second;
+  return polarity ? dW.first : dW.second;
 }
 
 DecisionWeight JustificationHeuristic::getWeight(TNode n) {
@@ -350,33 +367,26 @@ TNode JustificationHeuristic::getChildByWeight(TNode n, int i, bool polarity) {
   }
 }
 
-SatValue JustificationHeuristic::tryGetSatValue(Node n)
+SatValue JustificationHeuristic::tryGetSatValue(TNode n)
 {
-  Debug("decision") << "   "  << n << " has sat value " << " ";
-  if(d_decisionEngine->hasSatLiteral(n) ) {
-    Debug("decision") << d_decisionEngine->getSatValue(n) << std::endl;
-    return d_decisionEngine->getSatValue(n);
-  } else {
-    Debug("decision") << "NO SAT LITERAL" << std::endl;
-    return SAT_VALUE_UNKNOWN;
-  }//end of else
+  SatValue v = d_decisionEngine->tryGetSatValue(n);
+  Debug("decision") << "   " << n << " has sat value " << v << std::endl;
+  return v;
 }
 
-JustificationHeuristic::IteList
-JustificationHeuristic::getITEs(TNode n)
+const JustificationHeuristic::IteList& JustificationHeuristic::getITEs(TNode n)
 {
-  IteCache::iterator it = d_iteCache.find(n);
-  if(it != d_iteCache.end()) {
-    return (*it).second;
-  } else {
+  IteCache::const_iterator it = d_iteCache.find(n);
+  if (it == d_iteCache.end())
+  {
     // Compute the list of ITEs
-    // TODO: optimize by avoiding multiple lookup for d_iteCache[n]
     d_visitedComputeITE.clear();
     IteList ilist;
     computeITEs(n, ilist);
     d_iteCache.insert(n, ilist);
-    return ilist;
+    it = d_iteCache.find(n);
   }
+  return (*it).second;
 }
 
 void JustificationHeuristic::computeITEs(TNode n, IteList &l)
@@ -396,6 +406,118 @@ void JustificationHeuristic::computeITEs(TNode n, IteList &l)
   }
 }
 
+bool JustificationHeuristic::isAtom(TNode n)
+{
+  Kind k = n.getKind();
+  theory::TheoryId tId = theory::kindToTheoryId(k);
+  return k == kind::BOOLEAN_TERM_VARIABLE
+         || (tId != theory::THEORY_BOOL
+             && (k != kind::EQUAL || !n[0].getType().isBoolean()));
+}
+
+void JustificationHeuristic::watchChildren(TNode node, SatValue desiredVal)
+{
+  d_watchedGates.insert(node);
+  for (int i = 0, numChildren = node.getNumChildren(); i < numChildren; ++i)
+  {
+    TNode child = getChildByWeight(node, i, desiredVal);
+    while (child.getKind() == kind::NOT)
+    {
+      child = child[0];
+    }
+    d_watches[child].push_back(Watch(node, i));
+    if (isAtom(child) && d_decisionEngine->hasSatLiteral(child))
+    {
+      SatVariable v = d_decisionEngine->getSatLiteral(child).getSatVariable();
+      if (v >= d_watchedVars.size())
+      {
+        d_watchedVars.resize(v + 1, false);
+      }
+      d_watchedVars[v] = true;
+    }
+  }
+}
+
+bool JustificationHeuristic::isChildJustified(TNode node,
+                                              int i,
+                                              SatValue desiredVal)
+{
+  TNode child = getChildByWeight(node, i, desiredVal);
+  while (child.getKind() == kind::NOT)
+  {
+    desiredVal = invertValue(desiredVal);
+    child = child[0];
+  }
+  return checkJustified(child) && tryGetSatValue(child) == desiredVal;
+}
+
+void JustificationHeuristic::updateFromTrail()
+{
+  size_t trailSize = d_decisionEngine->getTrailSize();
+  for (size_t i = std::min<size_t>(d_trailHead, trailSize); i < trailSize; ++i)
+  {
+    SatVariable v = d_decisionEngine->getTrailLiteral(i).getSatVariable();
+    if (v >= d_watchedVars.size() || !d_watchedVars[v])
+    {
+      continue;
+    }
+    // an atom with term-ITEs is only justified once they are
+    Node atom = d_decisionEngine->getNode(SatLiteral(v));
+    if (isAtom(atom) && !checkJustified(atom)
+        && (d_iteAssertions.empty() || getITEs(atom).empty()))
+    {
+      justifyWatched(atom);
+    }
+  }
+  d_trailHead = trailSize;
+}
+
+void JustificationHeuristic::justifyWatched(TNode n)
+{
+  setJustified(n);
+  ++d_watchJustified;
+  std::vector<TNode> justified(1, n);
+  while (!justified.empty())
+  {
+    WatchLists::const_iterator it = d_watches.find(justified.back());
+    justified.pop_back();
+    if (it == d_watches.end())
+    {
+      continue;
+    }
+    for (const Watch& w : (*it).second)
+    {
+      TNode node = w.first;
+      if (getStartIndex(node) != w.second || checkJustified(node))
+      {
+        continue;
+      }
+      // the value that the and/or needs from all of its children
+      SatValue desiredVal =
+          node.getKind() == kind::AND ? SAT_VALUE_TRUE : SAT_VALUE_FALSE;
+      int numChildren = node.getNumChildren();
+      int i = w.second;
+      while (i < numChildren && isChildJustified(node, i, desiredVal))
+      {
+        ++i;
+      }
+      if (i < numChildren)
+      {
+        if (i != w.second)
+        {
+          saveStartIndex(node, i);
+        }
+      }
+      else
+      {
+        setJustified(node);
+        ++d_watchJustified;
+        justified.push_back(node);
+      }
+    }
+  }
+}
+
 JustificationHeuristic::SearchResult
 JustificationHeuristic::findSplitterRec(TNode node, SatValue desiredVal)
 {
@@ -453,22 +575,18 @@ JustificationHeuristic::findSplitterRec(TNode node, SatValue desiredVal)
 
   /* What type of node is this */
   Kind k = node.getKind();
-  theory::TheoryId tId = theory::kindToTheoryId(k);
-  bool isAtom =
-     (k == kind::BOOLEAN_TERM_VARIABLE ) ||
-     ( (tId != theory::THEORY_BOOL) &&
-       (k != kind::EQUAL || (!node[0].getType().isBoolean())) );
 
   /* Some debugging stuff */
   Debug("decision::jh") << "kind = " << k << std::endl
-                        << "theoryId = " << tId << std::endl
+                        << "theoryId = " << theory::kindToTheoryId(k)
+                        << std::endl
                         << "node = " << node << std::endl
                         << "litVal = " << litVal << std::endl;
 
   /**
    * If not in theory of booleans, check if this is something to split-on.
    */
-  if(isAtom) {
+  if(isAtom(node)) {
     // if node has embedded ites, resolve that first
     if(handleEmbeddedITEs(node) == FOUND_SPLITTER)
       return FOUND_SPLITTER;
@@ -546,7 +664,9 @@ JustificationHeuristic::findSplitterRec(TNode node, SatValue desiredVal)
   }
 
   if(ret == NO_SPLITTER) {
-    Assert(litPresent == false || litVal == desiredVal)
+    // With --cnf-polarity the literal of a gate may only imply its formula
+    Assert(litPresent == false || litVal == desiredVal
+           || options::cnfPolarity())
         << "Output should be justified";
     setJustified(node);
   }
@@ -575,7 +695,8 @@ JustificationHeuristic::handleAndOrEasy(TNode node, SatValue desiredVal)
 }
 
 int JustificationHeuristic::getStartIndex(TNode node) {
-  return d_startIndexCache[node];
+  StartIndexCache::const_iterator it = d_startIndexCache.find(node);
+  return it == d_startIndexCache.end() ? 0 : (*it).second;
 }
 void JustificationHeuristic::saveStartIndex(TNode node, int val) {
   d_startIndexCache[node] = val;
@@ -586,18 +707,28 @@ JustificationHeuristic::SearchResult JustificationHeuristic::handleAndOrHard(TNo
   Assert((node.getKind() == kind::AND and desiredVal == SAT_VALUE_TRUE)
          or (node.getKind() == kind::OR and desiredVal == SAT_VALUE_FALSE));
 
+  if (d_watchedGates.find(node) == d_watchedGates.end())
+  {
+    watchChildren(node, desiredVal);
+  }
+
   int numChildren = node.getNumChildren();
   bool noSplitter = true;
   int i_st = getStartIndex(node);
+  // The children before the first one that is not justified stay justified
+  // until we backtrack, which restores the start index as well
+  int i_watch = i_st;
   for(int i = i_st; i < numChildren; ++i) {
     TNode curNode = getChildByWeight(node, i, desiredVal);
     SearchResult ret = findSplitterRec(curNode, desiredVal);
     if (ret == FOUND_SPLITTER) {
-      if(i != i_st) saveStartIndex(node, i);
+      if (i_watch != i_st) saveStartIndex(node, i_watch);
       return FOUND_SPLITTER;
     }
     noSplitter = noSplitter && (ret == NO_SPLITTER);
+    if (noSplitter) i_watch = i + 1;
   }
+  if (i_watch != i_st) saveStartIndex(node, i_watch);
   return noSplitter ? NO_SPLITTER : DONT_KNOW;
 }
 
@@ -701,7 +832,11 @@ JustificationHeuristic::SearchResult JustificationHeuristic::handleITE(TNode nod
 
 JustificationHeuristic::SearchResult JustificationHeuristic::handleEmbeddedITEs(TNode node)
 {
-  const IteList l = getITEs(node);
+  if (d_iteAssertions.empty())
+  {
+    return NO_SPLITTER;
+  }
+  const IteList& l = getITEs(node);
   Trace("decision::jh::ite") << " ite size = " << l.size() << std::endl;
 
   bool noSplitter = true;
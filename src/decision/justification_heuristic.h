@@ -23,6 +23,7 @@
 #ifndef CVC4__DECISION__JUSTIFICATION_HEURISTIC
 #define CVC4__DECISION__JUSTIFICATION_HEURISTIC
 
+#include <unordered_map>
 #include <unordered_set>
 
 #include "context/cdhashmap.h"
@@ -59,6 +60,7 @@ class JustificationHeuristic : public ITEDecisionStrategy {
 
   IntStat d_helfulness;
   IntStat d_giveup;
+  IntStat d_watchJustified;
   TimerStat d_timestat;
 
   /**
@@ -100,6 +102,30 @@ class JustificationHeuristic : public ITEDecisionStrategy {
   /** computed polarized weight cache */
   WeightCache d_weightCache;
 
+  /**
+   * A watch of a big and/or that has to be justified on one of its children:
+   * the and/or and the position of the child in the order of
+   * getChildByWeight().  Only the watch on the child at the start index of
+   * the and/or is active.
+   */
+  typedef std::pair<Node, int> Watch;
+  typedef std::unordered_map<Node, std::vector<Watch>, NodeHashFunction>
+      WatchLists;
+  /** The watches on each node, NOTs removed */
+  WatchLists d_watches;
+
+  /** The and/or nodes that have watches on their children */
+  std::unordered_set<Node, NodeHashFunction> d_watchedGates;
+
+  /** Whether a SAT variable is the variable of a watched atom */
+  std::vector<bool> d_watchedVars;
+
+  /**
+   * The position on the SAT trail up to which the assignments have been
+   * processed, see updateFromTrail()
+   */
+  context::CDO<size_t> d_trailHead;
+
 
   class myCompareClass {
     JustificationHeuristic* d_jh;
@@ -123,6 +149,12 @@ public:
   void addAssertions(
       const preprocessing::AssertionPipeline &assertions) override;
 
+  /**
+   * The decision weight of n, computed from the weights of its children
+   * according to --decision-weight-internal and cached on n.
+   */
+  static DecisionWeight getWeight(TNode);
+
  private:
   /* getNext with an option to specify threshold */
   prop::SatLiteral getNextThresh(bool &stopSearch, DecisionWeight threshold);
@@ -143,22 +175,21 @@ public:
   int  getPrvsIndex();
   DecisionWeight getWeightPolarized(TNode n, bool polarity);
   DecisionWeight getWeightPolarized(TNode n, SatValue);
-  static DecisionWeight getWeight(TNode);
   bool compareByWeightFalse(TNode, TNode);
   bool compareByWeightTrue(TNode, TNode);
   TNode getChildByWeight(TNode n, int i, bool polarity);
 
   /* If literal exists corresponding to the node return
      that. Otherwise an UNKNOWN */
-  SatValue tryGetSatValue(Node n);
+  SatValue tryGetSatValue(TNode n);
 
   /* Get list of all term-ITEs for the atomic formula v */
-  JustificationHeuristic::IteList getITEs(TNode n);
+  const IteList& getITEs(TNode n);
 
 
   /**
-   * For big and/or nodes, a cache to save starting index into children
-   * for efficiently.
+   * For big and/or nodes, the index of the first child that may not be
+   * justified, so that the search does not go over the justified ones again.
    */
   typedef context::CDHashMap<TNode, int, TNodeHashFunction> StartIndexCache;
   StartIndexCache d_startIndexCache;
@@ -168,6 +199,32 @@ public:
   /* Compute all term-ITEs in a node recursively */
   void computeITEs(TNode n, IteList &l);
 
+  /** Whether n is an atom, something to split on */
+  static bool isAtom(TNode n);
+
+  /** Add the watches of the and/or node on its children */
+  void watchChildren(TNode node, SatValue desiredVal);
+
+  /**
+   * Whether the i-th child of the and/or node is justified and has the value
+   * that the node needs from all of its children
+   */
+  bool isChildJustified(TNode node, int i, SatValue desiredVal);
+
+  /**
+   * Justify the atoms of the watches that have been assigned since the last
+   * call, the SAT context restores the position on the trail when
+   * backtracking.
+   */
+  void updateFromTrail();
+
+  /**
+   * Justify n and move the watches on it to the next child of their and/or
+   * that is not justified.  An and/or whose children are then all justified
+   * is justified in turn.
+   */
+  void justifyWatched(TNode n);
+
   SearchResult handleAndOrEasy(TNode node, SatValue desiredVal);
   SearchResult handleAndOrHard(TNode node, SatValue desiredVal);
   SearchResult handleBinaryEasy(TNode node1, SatValue desiredVal1,
@@ -50,6 +50,11 @@ void AttributeManager::deleteAllAttributes(NodeValue* nv) {
   deleteFromTable(d_nodes, nv);
   deleteFromTable(d_types, nv);
   deleteFromTable(d_strings, nv);
+  deleteFromTable(d_denseInts, nv);
+  deleteFromTable(d_denseTNodes, nv);
+  deleteFromTable(d_denseNodes, nv);
+  deleteFromTable(d_denseTypes, nv);
+  deleteFromTable(d_denseStrings, nv);
 }
 
 void AttributeManager::deleteAllAttributes() {
@@ -59,6 +64,11 @@ void AttributeManager::deleteAllAttributes() {
   deleteAllFromTable(d_nodes);
   deleteAllFromTable(d_types);
   deleteAllFromTable(d_strings);
+  deleteAllFromTable(d_denseInts);
+  deleteAllFromTable(d_denseTNodes);
+  deleteAllFromTable(d_denseNodes);
+  deleteAllFromTable(d_denseTypes);
+  deleteAllFromTable(d_denseStrings);
 }
 
 void AttributeManager::deleteAttributes(const AttrIdVec& atids) {
@@ -97,6 +107,22 @@ void AttributeManager::deleteAttributes(const AttrIdVec& atids) {
       deleteAttributesFromTable(d_strings, ids);
       break;
 
+    case AttrTableDenseUInt64:
+      deleteAttributesFromTable(d_denseInts, ids);
+      break;
+    case AttrTableDenseTNode:
+      deleteAttributesFromTable(d_denseTNodes, ids);
+      break;
+    case AttrTableDenseNode:
+      deleteAttributesFromTable(d_denseNodes, ids);
+      break;
+    case AttrTableDenseTypeNode:
+      deleteAttributesFromTable(d_denseTypes, ids);
+      break;
+    case AttrTableDenseString:
+      deleteAttributesFromTable(d_denseStrings, ids);
+      break;
+
     case AttrTableCDBool:
     case AttrTableCDUInt64:
     case AttrTableCDTNode:
@@ -57,6 +57,16 @@ class AttributeManager {
   template <class T>
   void reconstructTable(AttrHash<T>& table);
 
+  template <class T>
+  void deleteFromTable(DenseAttrTable<T>& table, NodeValue* nv);
+
+  template <class T>
+  void deleteAllFromTable(DenseAttrTable<T>& table);
+
+  template <class T>
+  void deleteAttributesFromTable(DenseAttrTable<T>& table,
+                                 const std::vector<uint64_t>& ids);
+
   /**
    * getTable<> is a helper template that gets the right table from an
    * AttributeManager given its type.
@@ -64,6 +74,9 @@ class AttributeManager {
   template <class T, bool context_dep, class Enable>
   friend struct getTable;
 
+  template <class T, class Enable>
+  friend struct getDenseTable;
+
   bool d_inGarbageCollection;
 
   void clearDeleteAllAttributesBuffer();
@@ -89,6 +102,17 @@ public:
   /** Underlying hash table for string-valued attributes */
   AttrHash<std::string> d_strings;
 
+  /** Underlying dense table for integral-valued dense attributes */
+  DenseAttrTable<uint64_t> d_denseInts;
+  /** Underlying dense table for TNode-valued dense attributes */
+  DenseAttrTable<TNode> d_denseTNodes;
+  /** Underlying dense table for node-valued dense attributes */
+  DenseAttrTable<Node> d_denseNodes;
+  /** Underlying dense table for type-valued dense attributes */
+  DenseAttrTable<TypeNode> d_denseTypes;
+  /** Underlying dense table for string-valued dense attributes */
+  DenseAttrTable<std::string> d_denseStrings;
+
   /**
    * Get a particular attribute on a particular node.
    *
@@ -281,6 +305,101 @@ struct getTable<std::string, false> {
   }
 };
 
+/**
+ * The getDenseTable<> template provides (static) access to the
+ * AttributeManager field holding the dense table for a value type (see
+ * DenseAttribute<>).
+ */
+template <class T, class Enable = void>
+struct getDenseTable;
+
+/** Access the "d_denseInts" member of AttributeManager. */
+template <class T>
+struct getDenseTable<
+    T,
+    // Use this specialization only for unsigned integers
+    typename std::enable_if<std::is_unsigned<T>::value>::type>
+{
+  static const AttrTableId id = AttrTableDenseUInt64;
+  typedef DenseAttrTable<uint64_t> table_type;
+  static inline table_type& get(AttributeManager& am) {
+    return am.d_denseInts;
+  }
+  static inline const table_type& get(const AttributeManager& am) {
+    return am.d_denseInts;
+  }
+};
+
+/** Access the "d_denseTNodes" member of AttributeManager. */
+template <>
+struct getDenseTable<TNode> {
+  static const AttrTableId id = AttrTableDenseTNode;
+  typedef DenseAttrTable<TNode> table_type;
+  static inline table_type& get(AttributeManager& am) {
+    return am.d_denseTNodes;
+  }
+  static inline const table_type& get(const AttributeManager& am) {
+    return am.d_denseTNodes;
+  }
+};
+
+/** Access the "d_denseNodes" member of AttributeManager. */
+template <>
+struct getDenseTable<Node> {
+  static const AttrTableId id = AttrTableDenseNode;
+  typedef DenseAttrTable<Node> table_type;
+  static inline table_type& get(AttributeManager& am) {
+    return am.d_denseNodes;
+  }
+  static inline const table_type& get(const AttributeManager& am) {
+    return am.d_denseNodes;
+  }
+};
+
+/** Access the "d_denseTypes" member of AttributeManager. */
+template <>
+struct getDenseTable<TypeNode> {
+  static const AttrTableId id = AttrTableDenseTypeNode;
+  typedef DenseAttrTable<TypeNode> table_type;
+  static inline table_type& get(AttributeManager& am) {
+    return am.d_denseTypes;
+  }
+  static inline const table_type& get(const AttributeManager& am) {
+    return am.d_denseTypes;
+  }
+};
+
+/** Access the "d_denseStrings" member of AttributeManager. */
+template <>
+struct getDenseTable<std::string> {
+  static const AttrTableId id = AttrTableDenseString;
+  typedef DenseAttrTable<std::string> table_type;
+  static inline table_type& get(AttributeManager& am) {
+    return am.d_denseStrings;
+  }
+  static inline const table_type& get(const AttributeManager& am) {
+    return am.d_denseStrings;
+  }
+};
+
+/**
+ * The getAttrTable<> template selects the table holding an attribute
+ * kind: the dense table of its value type for a DenseAttribute<>, and
+ * the table given by getTable<> otherwise.
+ */
+template <class AttrKind, bool dense = AttrKind::dense_storage>
+struct getAttrTable
+    : public getTable<typename AttrKind::value_type,
+                      AttrKind::context_dependent>
+{
+};
+
+template <class AttrKind>
+struct getAttrTable<AttrKind, true>
+    : public getDenseTable<typename AttrKind::value_type>
+{
+};
+
 }/* CVC4::expr::attr namespace */
 
 // ATTRIBUTE MANAGER IMPLEMENTATIONS ===========================================
@@ -293,11 +412,10 @@ typename AttrKind::value_type
 AttributeManager::getAttribute(NodeValue* nv, const AttrKind&) const {
   typedef typename AttrKind::value_type value_type;
   typedef KindValueToTableValueMapping<value_type> mapping;
-  typedef typename getTable<value_type, AttrKind::context_dependent>::
-            table_type table_type;
+  typedef typename getAttrTable<AttrKind>::table_type table_type;
 
   const table_type& ah =
-    getTable<value_type, AttrKind::context_dependent>::get(*this);
+    getAttrTable<AttrKind>::get(*this);
   typename table_type::const_iterator i =
     ah.find(std::make_pair(AttrKind::getId(), nv));
 
@@ -335,12 +453,10 @@ struct HasAttribute<true, AttrKind> {
                                   typename AttrKind::value_type& ret) {
     typedef typename AttrKind::value_type value_type;
     typedef KindValueToTableValueMapping<value_type> mapping;
-    typedef typename getTable<value_type,
-                              AttrKind::context_dependent>::table_type
-      table_type;
+    typedef typename getAttrTable<AttrKind>::table_type table_type;
 
     const table_type& ah =
-      getTable<value_type, AttrKind::context_dependent>::get(*am);
+      getAttrTable<AttrKind>::get(*am);
     typename table_type::const_iterator i =
       ah.find(std::make_pair(AttrKind::getId(), nv));
 
@@ -362,13 +478,10 @@ template <class AttrKind>
 struct HasAttribute<false, AttrKind> {
   static inline bool hasAttribute(const AttributeManager* am,
                                   NodeValue* nv) {
-    typedef typename AttrKind::value_type value_type;
-    //typedef KindValueToTableValueMapping<value_type> mapping;
-    typedef typename getTable<value_type, AttrKind::context_dependent>::
-              table_type table_type;
+    typedef typename getAttrTable<AttrKind>::table_type table_type;
 
     const table_type& ah =
-      getTable<value_type, AttrKind::context_dependent>::get(*am);
+      getAttrTable<AttrKind>::get(*am);
     typename table_type::const_iterator i =
       ah.find(std::make_pair(AttrKind::getId(), nv));
 
@@ -384,11 +497,10 @@ struct HasAttribute<false, AttrKind> {
                                   typename AttrKind::value_type& ret) {
     typedef typename AttrKind::value_type value_type;
     typedef KindValueToTableValueMapping<value_type> mapping;
-    typedef typename getTable<value_type, AttrKind::context_dependent>::
-              table_type table_type;
+    typedef typename getAttrTable<AttrKind>::table_type table_type;
 
     const table_type& ah =
-      getTable<value_type, AttrKind::context_dependent>::get(*am);
+      getAttrTable<AttrKind>::get(*am);
     typename table_type::const_iterator i =
       ah.find(std::make_pair(AttrKind::getId(), nv));
 
@@ -424,11 +536,10 @@ AttributeManager::setAttribute(NodeValue* nv,
                                const typename AttrKind::value_type& value) {
   typedef typename AttrKind::value_type value_type;
   typedef KindValueToTableValueMapping<value_type> mapping;
-  typedef typename getTable<value_type, AttrKind::context_dependent>::
-            table_type table_type;
+  typedef typename getAttrTable<AttrKind>::table_type table_type;
 
   table_type& ah =
-      getTable<value_type, AttrKind::context_dependent>::get(*this);
+      getAttrTable<AttrKind>::get(*this);
   ah[std::make_pair(AttrKind::getId(), nv)] = mapping::convert(value);
 }
 
@@ -454,11 +565,26 @@ inline void AttributeManager::deleteAllFromTable(AttrHash<T>& table) {
   Assert(!d_inGarbageCollection);
 }
 
+/** Remove the values of all dense attributes from the NodeValue. */
+template <class T>
+inline void AttributeManager::deleteFromTable(DenseAttrTable<T>& table,
+                                              NodeValue* nv) {
+  table.erase(nv);
+}
+
+/** Remove all attributes from the dense table. */
+template <class T>
+inline void AttributeManager::deleteAllFromTable(DenseAttrTable<T>& table) {
+  Assert(!d_inGarbageCollection);
+  d_inGarbageCollection = true;
+  table.clear();
+  d_inGarbageCollection = false;
+  Assert(!d_inGarbageCollection);
+}
+
 template <class AttrKind>
 AttributeUniqueId AttributeManager::getAttributeId(const AttrKind& attr){
-  typedef typename AttrKind::value_type value_type;
-  AttrTableId tableId = getTable<value_type,
-                                 AttrKind::context_dependent>::id;
+  AttrTableId tableId = getAttrTable<AttrKind>::id;
   return AttributeUniqueId(tableId, attr.getId());
 }
 
@@ -493,6 +619,14 @@ void AttributeManager::deleteAttributesFromTable(AttrHash<T>& table, const std::
   }
 }
 
+template <class T>
+void AttributeManager::deleteAttributesFromTable(
+    DenseAttrTable<T>& table, const std::vector<uint64_t>& ids) {
+  d_inGarbageCollection = true;
+  table.eraseAttributes(ids);
+  d_inGarbageCollection = false;
+}
+
 template <class T>
 void AttributeManager::reconstructTable(AttrHash<T>& table){
   d_inGarbageCollection = true;
@@ -510,12 +644,14 @@ void AttributeManager::reconstructTable(AttrHash<T>& table){
 template <class AttrKind>
 inline typename AttrKind::value_type
 NodeManager::getAttribute(expr::NodeValue* nv, const AttrKind&) const {
+  ConcurrentLock lock(this, d_attrMutex);
   return d_attrManager->getAttribute(nv, AttrKind());
 }
 
 template <class AttrKind>
 inline bool NodeManager::hasAttribute(expr::NodeValue* nv,
                                       const AttrKind&) const {
+  ConcurrentLock lock(this, d_attrMutex);
   return d_attrManager->hasAttribute(nv, AttrKind());
 }
 
@@ -523,6 +659,7 @@ template <class AttrKind>
 inline bool
 NodeManager::getAttribute(expr::NodeValue* nv, const AttrKind&,
                           typename AttrKind::value_type& ret) const {
+  ConcurrentLock lock(this, d_attrMutex);
   return d_attrManager->getAttribute(nv, AttrKind(), ret);
 }
 
@@ -530,18 +667,21 @@ template <class AttrKind>
 inline void
 NodeManager::setAttribute(expr::NodeValue* nv, const AttrKind&,
                           const typename AttrKind::value_type& value) {
+  ConcurrentLock lock(this, d_attrMutex);
   d_attrManager->setAttribute(nv, AttrKind(), value);
 }
 
 template <class AttrKind>
 inline typename AttrKind::value_type
 NodeManager::getAttribute(TNode n, const AttrKind&) const {
+  ConcurrentLock lock(this, d_attrMutex);
   return d_attrManager->getAttribute(n.d_nv, AttrKind());
 }
 
 template <class AttrKind>
 inline bool
 NodeManager::hasAttribute(TNode n, const AttrKind&) const {
+  ConcurrentLock lock(this, d_attrMutex);
   return d_attrManager->hasAttribute(n.d_nv, AttrKind());
 }
 
@@ -549,6 +689,7 @@ template <class AttrKind>
 inline bool
 NodeManager::getAttribute(TNode n, const AttrKind&,
                           typename AttrKind::value_type& ret) const {
+  ConcurrentLock lock(this, d_attrMutex);
   return d_attrManager->getAttribute(n.d_nv, AttrKind(), ret);
 }
 
@@ -556,18 +697,21 @@ template <class AttrKind>
 inline void
 NodeManager::setAttribute(TNode n, const AttrKind&,
                           const typename AttrKind::value_type& value) {
+  ConcurrentLock lock(this, d_attrMutex);
   d_attrManager->setAttribute(n.d_nv, AttrKind(), value);
 }
 
 template <class AttrKind>
 inline typename AttrKind::value_type
 NodeManager::getAttribute(TypeNode n, const AttrKind&) const {
+  ConcurrentLock lock(this, d_attrMutex);
   return d_attrManager->getAttribute(n.d_nv, AttrKind());
 }
 
 template <class AttrKind>
 inline bool
 NodeManager::hasAttribute(TypeNode n, const AttrKind&) const {
+  ConcurrentLock lock(this, d_attrMutex);
   return d_attrManager->hasAttribute(n.d_nv, AttrKind());
 }
 
@@ -575,6 +719,7 @@ template <class AttrKind>
 inline bool
 NodeManager::getAttribute(TypeNode n, const AttrKind&,
                           typename AttrKind::value_type& ret) const {
+  ConcurrentLock lock(this, d_attrMutex);
   return d_attrManager->getAttribute(n.d_nv, AttrKind(), ret);
 }
 
@@ -582,6 +727,7 @@ template <class AttrKind>
 inline void
 NodeManager::setAttribute(TypeNode n, const AttrKind&,
                           const typename AttrKind::value_type& value) {
+  ConcurrentLock lock(this, d_attrMutex);
   d_attrManager->setAttribute(n.d_nv, AttrKind(), value);
 }
 
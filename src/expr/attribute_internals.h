@@ -23,8 +23,11 @@
 #ifndef CVC4__EXPR__ATTRIBUTE_INTERNALS_H
 #define CVC4__EXPR__ATTRIBUTE_INTERNALS_H
 
+#include <algorithm>
 #include <cstdint>
+#include <memory>
 #include <unordered_map>
+#include <vector>
 
 namespace CVC4 {
 namespace expr {
@@ -364,6 +367,216 @@ public:
   }
 };/* class AttrHash<bool> */
 
+/**
+ * A "DenseAttrTable<value_type>" is the table underlying dense
+ * attributes (see DenseAttribute<>).  Instead of hashing pairs
+ * (unique-attribute-id, Node), it keeps one paged array per attribute,
+ * indexed directly by NodeValue::getId().  Node ids are handed out
+ * densely by the NodeManager, so a lookup is a couple of array
+ * accesses, and nodes created close together share a page.  A page is
+ * allocated when the first value on it is set, and freed as soon as
+ * its last value is erased.
+ *
+ * Like AttrHash<bool>, the iterator type doesn't support anything
+ * except comparison and dereference; it's intended just for the result
+ * of find() on the table.
+ */
+template <class value_type>
+class DenseAttrTable {
+
+  /** log2 of the number of values in a page */
+  static const unsigned s_pageBits = 9;
+
+  /** The number of values in a page */
+  static const uint64_t s_pageSize = uint64_t(1) << s_pageBits;
+
+  /** A page of values, along with a bitmap of the values that are set */
+  struct Page {
+    Page() : d_count(0) {
+      std::fill(d_present, d_present + s_pageSize / 64, 0);
+    }
+
+    bool isSet(uint64_t i) const {
+      return (d_present[i >> 6] & GetBitSet(i & 63)) != 0;
+    }
+
+    value_type d_values[s_pageSize];
+    uint64_t d_present[s_pageSize / 64];
+    /** The number of bits set in d_present */
+    uint64_t d_count;
+  };/* struct DenseAttrTable<>::Page */
+
+  /** The pages of one attribute, indexed by (node id / s_pageSize) */
+  typedef std::vector<std::unique_ptr<Page> > PageVector;
+
+  /** The pages of each attribute, indexed by attribute id */
+  std::vector<PageVector> d_attrs;
+
+  /** The number of values set, over all attributes */
+  size_t d_size;
+
+  /** The page holding the value of attribute attrId on node nvId, if any */
+  const Page* getPage(uint64_t attrId, uint64_t nvId) const {
+    if(attrId >= d_attrs.size()) {
+      return NULL;
+    }
+    const PageVector& pages = d_attrs[attrId];
+    const uint64_t p = nvId >> s_pageBits;
+    return p < pages.size() ? pages[p].get() : NULL;
+  }
+
+  /** Unset value i of pages[p], which must be set. */
+  void eraseFromPage(PageVector& pages, uint64_t p, uint64_t i) {
+    Page* page = pages[p].get();
+    page->d_present[i >> 6] &= ~GetBitSet(i & 63);
+    --d_size;
+    if(--page->d_count == 0) {
+      // destroying the values may release other nodes, so detach the
+      // page from the table first
+      std::unique_ptr<Page> empty(std::move(pages[p]));
+    } else {
+      page->d_values[i] = value_type();
+    }
+  }
+
+  /**
+   * A (somewhat degenerate) const_iterator over dense attribute values.
+   */
+  class ConstIterator {
+
+    NodeValue* d_nv;
+
+    const value_type* d_value;
+
+   public:
+
+    ConstIterator() :
+      d_nv(NULL),
+      d_value(NULL) {
+    }
+
+    ConstIterator(NodeValue* nv, const value_type& value) :
+      d_nv(nv),
+      d_value(&value) {
+    }
+
+    std::pair<NodeValue*, const value_type&> operator*() const {
+      return std::pair<NodeValue*, const value_type&>(d_nv, *d_value);
+    }
+
+    bool operator==(const ConstIterator& b) const {
+      return d_value == b.d_value;
+    }
+  };/* class DenseAttrTable<>::ConstIterator */
+
+public:
+
+  typedef std::pair<uint64_t, NodeValue*> key_type;
+  typedef value_type data_type;
+
+  /** a const_iterator type; see above for limitations */
+  typedef ConstIterator const_iterator;
+
+  DenseAttrTable() : d_size(0) {}
+
+  /**
+   * Find the value in the table.  Returns something == end() if not
+   * found.
+   */
+  ConstIterator find(const std::pair<uint64_t, NodeValue*>& k) const {
+    const uint64_t nvId = k.second->getId();
+    const Page* page = getPage(k.first, nvId);
+    const uint64_t i = nvId & (s_pageSize - 1);
+    if(page == NULL || !page->isSet(i)) {
+      return ConstIterator();
+    }
+    return ConstIterator(k.second, page->d_values[i]);
+  }
+
+  /** The "off the end" const_iterator */
+  ConstIterator end() const {
+    return ConstIterator();
+  }
+
+  /**
+   * Access the value of the given attribute on the given node.  Marks
+   * the value as set (to the default value) if it's not already.
+   */
+  value_type& operator[](const std::pair<uint64_t, NodeValue*>& k) {
+    const uint64_t nvId = k.second->getId();
+    if(k.first >= d_attrs.size()) {
+      d_attrs.resize(k.first + 1);
+    }
+    PageVector& pages = d_attrs[k.first];
+    const uint64_t p = nvId >> s_pageBits;
+    if(p >= pages.size()) {
+      pages.resize(p + 1);
+    }
+    if(!pages[p]) {
+      pages[p].reset(new Page());
+    }
+    Page& page = *pages[p];
+    const uint64_t i = nvId & (s_pageSize - 1);
+    if(!page.isSet(i)) {
+      page.d_present[i >> 6] |= GetBitSet(i & 63);
+      ++page.d_count;
+      ++d_size;
+    }
+    return page.d_values[i];
+  }
+
+  /**
+   * Delete the values of all attributes from the given node.
+   */
+  void erase(NodeValue* nv) {
+    const uint64_t nvId = nv->getId();
+    const uint64_t p = nvId >> s_pageBits;
+    const uint64_t i = nvId & (s_pageSize - 1);
+    for(PageVector& pages : d_attrs) {
+      if(p < pages.size() && pages[p] && pages[p]->isSet(i)) {
+        eraseFromPage(pages, p, i);
+      }
+    }
+  }
+
+  /**
+   * Delete all values of the given attributes.
+   */
+  void eraseAttributes(const std::vector<uint64_t>& ids) {
+    for(uint64_t id : ids) {
+      if(id >= d_attrs.size()) {
+        continue;
+      }
+      PageVector pages;
+      pages.swap(d_attrs[id]);
+      for(const std::unique_ptr<Page>& page : pages) {
+        if(page) {
+          d_size -= page->d_count;
+        }
+      }
+    }
+  }
+
+  /**
+   * Clear the table.
+   */
+  void clear() {
+    std::vector<PageVector> attrs;
+    attrs.swap(d_attrs);
+    d_size = 0;
+  }
+
+  /** Is the table empty? */
+  bool empty() const {
+    return d_size == 0;
+  }
+
+  /** The number of values set, over all attributes */
+  size_t size() const {
+    return d_size;
+  }
+};/* class DenseAttrTable<> */
+
 }/* CVC4::expr::attr namespace */
 
 // ATTRIBUTE IDENTIFIER ASSIGNMENT TEMPLATE ====================================
@@ -438,6 +651,9 @@ public:
    */
   static const bool context_dependent = context_dep;
 
+  /** This attribute is stored in the hash table of its value type. */
+  static const bool dense_storage = false;
+
   /**
    * Register this attribute kind and check that the ID is a valid ID
    * for bool-valued attributes.  Fail an assert if not.  Otherwise
@@ -486,6 +702,9 @@ public:
    */
   static const bool context_dependent = context_dep;
 
+  /** This attribute is stored in the hash table of its value type. */
+  static const bool dense_storage = false;
+
   /**
    * Register this attribute kind and check that the ID is a valid ID
    * for bool-valued attributes.  Fail an assert if not.  Otherwise
@@ -499,6 +718,60 @@ public:
   }
 };/* class Attribute<..., bool, ...> */
 
+/**
+ * An "attribute type" structure for attributes stored in dense side
+ * tables (see DenseAttrTable<>).  It is declared and used like an
+ * Attribute<T, value_t>, but its values are kept in an array indexed by
+ * node id rather than in the hash table shared by all attributes of
+ * value_t.  Lookups are much cheaper, at the cost of memory that grows
+ * with the range of ids of the nodes having the attribute; this is
+ * intended for hot attributes that are set on most nodes, such as the
+ * type and rewrite caches.
+ *
+ * Dense attributes are never context-dependent, and cannot be
+ * bool-valued (flags are already packed into words, see AttrHash<bool>).
+ */
+template <class T, class value_t>
+class DenseAttribute
+{
+  /**
+   * The unique ID associated to this attribute.  Assigned statically,
+   * at load time.
+   */
+  static const uint64_t s_id;
+
+public:
+
+  /** The value type for this attribute. */
+  typedef value_t value_type;
+
+  /** Get the unique ID associated to this attribute. */
+  static inline uint64_t getId() { return s_id; }
+
+  /** See Attribute<>::has_default_value. */
+  static const bool has_default_value = false;
+
+  /** Dense attributes are not context-dependent. */
+  static const bool context_dependent = false;
+
+  /** This attribute is stored in the dense table of its value type. */
+  static const bool dense_storage = true;
+
+  /**
+   * Register this attribute kind and return its id.  Dense attributes
+   * are numbered separately from hashed ones, since the id indexes
+   * into the dense table of the value type.
+   */
+  static inline uint64_t registerAttribute() {
+    static_assert(!std::is_same<value_t, bool>::value,
+                  "bool-valued attributes cannot use dense storage");
+    typedef typename attr::KindValueToTableValueMapping<value_t>::
+                     table_value_type table_value_type;
+    return attr::LastAttributeId<attr::DenseAttrTable<table_value_type>,
+                                 false>::getNextId();
+  }
+};/* class DenseAttribute<> */
+
 // ATTRIBUTE IDENTIFIER ASSIGNMENT =============================================
 
 /** Assign unique IDs to attributes at load time. */
@@ -512,6 +785,11 @@ template <class T, bool context_dep>
 const uint64_t Attribute<T, bool, context_dep>::s_id =
     Attribute<T, bool, context_dep>::registerAttribute();
 
+/** Assign unique IDs to attributes at load time. */
+template <class T, class value_t>
+const uint64_t DenseAttribute<T, value_t>::s_id =
+    DenseAttribute<T, value_t>::registerAttribute();
+
 }/* CVC4::expr namespace */
 }/* CVC4 namespace */
 
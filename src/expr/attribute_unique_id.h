@@ -41,6 +41,11 @@ enum AttrTableId {
   AttrTableCDNode,
   AttrTableCDString,
   AttrTableCDPointer,
+  AttrTableDenseUInt64,
+  AttrTableDenseTNode,
+  AttrTableDenseNode,
+  AttrTableDenseTypeNode,
+  AttrTableDenseString,
   LastAttrTable
 };
 
@@ -77,7 +77,7 @@
  **         decrement them again on destruction.  The existing
  **         NodeManager pool entry is returned.
  **
- **   1(b). A new heap-allocated NodeValue must be constructed and all
+ **   1(b). A new NodeValue must be allocated by the NodeManager and all
  **         settings and children from d_inlineNv copied into it.
  **         This new NodeValue is put into the NodeManager's pool.
  **         The NodeBuilder is marked as "used" and the number of
@@ -94,12 +94,12 @@
  **         cause any problems.  The existing NodeManager pool entry
  **         is returned.
  **
- **   2(b). The heap-allocated d_nv is "cropped" to the correct size
- **         (based on the number of children it _actually_ has).  d_nv
- **         is repointed to d_inlineNv so that destruction of the
- **         NodeBuilder doesn't cause any problems, and the (old)
- **         value it had is placed into the NodeManager's pool and
- **         returned in a Node wrapper.
+ **   2(b). The settings and children of the heap-allocated d_nv are
+ **         moved into a new NodeValue obtained from the NodeManager's
+ **         allocator and d_nv is freed.  d_nv is repointed to
+ **         d_inlineNv so that destruction of the NodeBuilder doesn't
+ **         cause any problems, and the new NodeValue is placed into
+ **         the NodeManager's pool and returned in a Node wrapper.
  **
  ** NOTE IN 1(b) AND 2(b) THAT we can NOT create Node wrapper
  ** temporary for the NodeValue in the NodeBuilder<>::operator Node()
@@ -316,34 +316,6 @@ class NodeBuilder {
    */
   void decrRefCounts();
 
-  /**
-   * Trim d_nv down to the size it needs to be for the number of
-   * children it has.  Used when a Node is extracted from a
-   * NodeBuilder and we want the returned memory not to suffer from
-   * internal fragmentation.  If d_nv was not heap-allocated by this
-   * class, or is already the right size, this function does nothing.
-   *
-   * @throws bad_alloc if the reallocation fails
-   */
-  void crop() {
-    if(__builtin_expect( ( nvIsAllocated() ), false ) &&
-       __builtin_expect( ( d_nvMaxChildren > d_nv->d_nchildren ), true )) {
-      // Ensure d_nv is not modified on allocation failure
-      expr::NodeValue* newBlock = (expr::NodeValue*)
-        std::realloc(d_nv,
-                     sizeof(expr::NodeValue) +
-                     ( sizeof(expr::NodeValue*) * d_nv->d_nchildren ));
-      if(newBlock == NULL) {
-        // In this case, d_nv was NOT freed.  If we throw, the
-        // deallocation should occur on destruction of the
-        // NodeBuilder.
-        throw std::bad_alloc();
-      }
-      d_nv = newBlock;
-      d_nvMaxChildren = d_nv->d_nchildren;
-    }
-  }
-
   // used by convenience node builders
   NodeBuilder<nchild_thresh>& collapseTo(Kind k) {
     AssertArgument(k != kind::UNDEFINED_KIND &&
@@ -934,16 +906,12 @@ expr::NodeValue* NodeBuilder<nchild_thresh>::constructNV() {
            "no children permitted";
 
     // we have to copy the inline NodeValue out
-    expr::NodeValue* nv = (expr::NodeValue*)
-      std::malloc(sizeof(expr::NodeValue));
-    if(nv == NULL) {
-      throw std::bad_alloc();
-    }
+    expr::NodeValue* nv = d_nm->allocateNodeValue(0);
     // there are no children, so we don't have to worry about
     // reference counts in this case.
     nv->d_nchildren = 0;
     nv->d_kind = d_nv->d_kind;
-    nv->d_id = d_nm->next_id++;// FIXME multithreading
+    nv->d_id = d_nm->newNodeId();
     nv->d_rc = 0;
     setUsed();
     if(Debug.isOn("gc")) {
@@ -976,12 +944,16 @@ expr::NodeValue* NodeBuilder<nchild_thresh>::constructNV() {
   // NodeManager pool of Nodes.  See implementation notes at the top
   // of this file.
 
+  // In concurrent mode, no other thread may insert the same node between
+  // the lookup and the insertion below.
+  NodeManager::PoolLock pool(d_nm, d_nv);
+
   if(__builtin_expect( ( ! nvIsAllocated() ), true )) {
     /** Case 1.  d_nv points to d_inlineNv: it is the backing store
      ** allocated "inline" in this NodeBuilder. **/
 
     // Lookup the expression value in the pool we already have
-    expr::NodeValue* poolNv = d_nm->poolLookup(&d_inlineNv);
+    expr::NodeValue* poolNv = pool.lookup(&d_inlineNv);
     // If something else is there, we reuse it
     if(poolNv != NULL) {
       /* Subcase (a): The Node under construction already exists in
@@ -1012,15 +984,10 @@ expr::NodeValue* NodeBuilder<nchild_thresh>::constructNV() {
        * reference count. */
 
       // create the canonical expression value for this node
-      expr::NodeValue* nv = (expr::NodeValue*)
-        std::malloc(sizeof(expr::NodeValue) +
-                    ( sizeof(expr::NodeValue*) * d_inlineNv.d_nchildren ));
-      if(nv == NULL) {
-        throw std::bad_alloc();
-      }
+      expr::NodeValue* nv = d_nm->allocateNodeValue(d_inlineNv.d_nchildren);
       nv->d_nchildren = d_inlineNv.d_nchildren;
       nv->d_kind = d_inlineNv.d_kind;
-      nv->d_id = d_nm->next_id++;// FIXME multithreading
+      nv->d_id = d_nm->newNodeId();
       nv->d_rc = 0;
 
       std::copy(d_inlineNv.d_children,
@@ -1031,7 +998,7 @@ expr::NodeValue* NodeBuilder<nchild_thresh>::constructNV() {
       setUsed();
 
       //poolNv = nv;
-      d_nm->poolInsert(nv);
+      pool.insert(nv);
       if(Debug.isOn("gc")) {
         Debug("gc") << "creating node value " << nv
                     << " [" << nv->d_id << "]: ";
@@ -1045,7 +1012,7 @@ expr::NodeValue* NodeBuilder<nchild_thresh>::constructNV() {
      ** buffer that was heap-allocated by this NodeBuilder. **/
 
     // Lookup the expression value in the pool we already have (with insert)
-    expr::NodeValue* poolNv = d_nm->poolLookup(d_nv);
+    expr::NodeValue* poolNv = pool.lookup(d_nv);
     // If something else is there, we reuse it
     if(poolNv != NULL) {
       /* Subcase (a): The Node under construction already exists in
@@ -1065,22 +1032,29 @@ expr::NodeValue* NodeBuilder<nchild_thresh>::constructNV() {
       /* Subcase (b) The Node under construction is NOT already in the
        * NodeManager's pool. */
 
-      /* 2(b). The heap-allocated d_nv is "cropped" to the correct
-       * size (based on the number of children it _actually_ has).
-       * d_nv is repointed to d_inlineNv so that destruction of the
-       * NodeBuilder doesn't cause any problems, and the (old) value
-       * it had is placed into the NodeManager's pool and returned in
-       * a Node wrapper. */
+      /* 2(b). The contents of the heap-allocated d_nv are moved
+       * into storage obtained from the NodeManager's allocator, and
+       * d_nv is freed (the child reference counts are taken over by
+       * the new NodeValue).  d_nv is repointed to d_inlineNv so that
+       * destruction of the NodeBuilder doesn't cause any problems,
+       * and the new NodeValue is placed into the NodeManager's pool
+       * and returned in a Node wrapper. */
 
-      crop();
-      expr::NodeValue* nv = d_nv;
-      nv->d_id = d_nm->next_id++;// FIXME multithreading
+      expr::NodeValue* nv = d_nm->allocateNodeValue(d_nv->d_nchildren);
+      nv->d_nchildren = d_nv->d_nchildren;
+      nv->d_kind = d_nv->d_kind;
+      nv->d_rc = 0;
+      std::copy(d_nv->d_children,
+                d_nv->d_children + d_nv->d_nchildren,
+                nv->d_children);
+      free(d_nv);
+      nv->d_id = d_nm->newNodeId();
       d_nv = &d_inlineNv;
       d_nvMaxChildren = nchild_thresh;
       setUsed();
 
       //poolNv = nv;
-      d_nm->poolInsert(nv);
+      pool.insert(nv);
       Debug("gc") << "creating node value " << nv
                   << " [" << nv->d_id << "]: " << *nv << "\n";
       return nv;
@@ -1114,16 +1088,12 @@ expr::NodeValue* NodeBuilder<nchild_thresh>::constructNV() const {
            "no children permitted";
 
     // we have to copy the inline NodeValue out
-    expr::NodeValue* nv = (expr::NodeValue*)
-      std::malloc(sizeof(expr::NodeValue));
-    if(nv == NULL) {
-      throw std::bad_alloc();
-    }
+    expr::NodeValue* nv = d_nm->allocateNodeValue(0);
     // there are no children, so we don't have to worry about
     // reference counts in this case.
     nv->d_nchildren = 0;
     nv->d_kind = d_nv->d_kind;
-    nv->d_id = d_nm->next_id++;// FIXME multithreading
+    nv->d_id = d_nm->newNodeId();
     nv->d_rc = 0;
     Debug("gc") << "creating node value " << nv
                 << " [" << nv->d_id << "]: " << *nv << "\n";
@@ -1159,12 +1129,16 @@ expr::NodeValue* NodeBuilder<nchild_thresh>::constructNV() const {
   // NodeManager pool of Nodes.  See implementation notes at the top
   // of this file.
 
+  // In concurrent mode, no other thread may insert the same node between
+  // the lookup and the insertion below.
+  NodeManager::PoolLock pool(d_nm, d_nv);
+
   if(__builtin_expect( ( ! nvIsAllocated() ), true )) {
     /** Case 1.  d_nv points to d_inlineNv: it is the backing store
      ** allocated "inline" in this NodeBuilder. **/
 
     // Lookup the expression value in the pool we already have
-    expr::NodeValue* poolNv = d_nm->poolLookup(const_cast<expr::NodeValue*>(&d_inlineNv));
+    expr::NodeValue* poolNv = pool.lookup(const_cast<expr::NodeValue*>(&d_inlineNv));
     // If something else is there, we reuse it
     if(poolNv != NULL) {
       /* Subcase (a): The Node under construction already exists in
@@ -1189,15 +1163,10 @@ expr::NodeValue* NodeBuilder<nchild_thresh>::constructNV() const {
        * count. */
 
       // create the canonical expression value for this node
-      expr::NodeValue* nv = (expr::NodeValue*)
-        std::malloc(sizeof(expr::NodeValue) +
-                    ( sizeof(expr::NodeValue*) * d_inlineNv.d_nchildren ));
-      if(nv == NULL) {
-        throw std::bad_alloc();
-      }
+      expr::NodeValue* nv = d_nm->allocateNodeValue(d_inlineNv.d_nchildren);
       nv->d_nchildren = d_inlineNv.d_nchildren;
       nv->d_kind = d_inlineNv.d_kind;
-      nv->d_id = d_nm->next_id++;// FIXME multithreading
+      nv->d_id = d_nm->newNodeId();
       nv->d_rc = 0;
 
       std::copy(d_inlineNv.d_children,
@@ -1211,7 +1180,7 @@ expr::NodeValue* NodeBuilder<nchild_thresh>::constructNV() const {
       }
 
       //poolNv = nv;
-      d_nm->poolInsert(nv);
+      pool.insert(nv);
       Debug("gc") << "creating node value " << nv
                   << " [" << nv->d_id << "]: " << *nv << "\n";
       return nv;
@@ -1221,7 +1190,7 @@ expr::NodeValue* NodeBuilder<nchild_thresh>::constructNV() const {
      ** buffer that was heap-allocated by this NodeBuilder. **/
 
     // Lookup the expression value in the pool we already have (with insert)
-    expr::NodeValue* poolNv = d_nm->poolLookup(d_nv);
+    expr::NodeValue* poolNv = pool.lookup(d_nv);
     // If something else is there, we reuse it
     if(poolNv != NULL) {
       /* Subcase (a): The Node under construction already exists in
@@ -1243,15 +1212,10 @@ expr::NodeValue* NodeBuilder<nchild_thresh>::constructNV() const {
        * decremented to match at NodeBuilder destruction time. */
 
       // create the canonical expression value for this node
-      expr::NodeValue* nv = (expr::NodeValue*)
-        std::malloc(sizeof(expr::NodeValue) +
-                    ( sizeof(expr::NodeValue*) * d_nv->d_nchildren ));
-      if(nv == NULL) {
-        throw std::bad_alloc();
-      }
+      expr::NodeValue* nv = d_nm->allocateNodeValue(d_nv->d_nchildren);
       nv->d_nchildren = d_nv->d_nchildren;
       nv->d_kind = d_nv->d_kind;
-      nv->d_id = d_nm->next_id++;// FIXME multithreading
+      nv->d_id = d_nm->newNodeId();
       nv->d_rc = 0;
 
       std::copy(d_nv->d_children,
@@ -1265,7 +1229,7 @@ expr::NodeValue* NodeBuilder<nchild_thresh>::constructNV() const {
       }
 
       //poolNv = nv;
-      d_nm->poolInsert(nv);
+      pool.insert(nv);
       Debug("gc") << "creating node value " << nv
                   << " [" << nv->d_id << "]: " << *nv << "\n";
       return nv;
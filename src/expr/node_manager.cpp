@@ -18,6 +18,7 @@
 #include "expr/node_manager.h"
 
 #include <algorithm>
+#include <chrono>
 #include <stack>
 #include <utility>
 
@@ -28,6 +29,7 @@
 #include "expr/node_manager_attributes.h"
 #include "expr/node_manager_listeners.h"
 #include "expr/type_checker.h"
+#include "options/expr_options.h"
 #include "options/options.h"
 #include "options/smt_options.h"
 #include "util/resource_manager.h"
@@ -84,6 +86,48 @@ struct NVReclaim {
 
 } // namespace
 
+class NodeManager::Statistics
+{
+ public:
+  /** Number of rounds of zombie reclamation */
+  IntStat d_reclaimRounds;
+  /** Number of NodeValues reclaimed */
+  IntStat d_zombiesReclaimed;
+  /** Total time spent reclaiming zombies */
+  TimerStat d_reclaimTime;
+  /** Average length of a round of reclamation, in microseconds */
+  AverageStat d_avgReclaimPause;
+  /** Longest round of reclamation, in microseconds */
+  IntStat d_maxReclaimPause;
+
+  Statistics(StatisticsRegistry& stats)
+      : d_reclaimRounds("expr::NodeManager::reclaimRounds", 0),
+        d_zombiesReclaimed("expr::NodeManager::zombiesReclaimed", 0),
+        d_reclaimTime("expr::NodeManager::reclaimTime"),
+        d_avgReclaimPause("expr::NodeManager::avgReclaimPauseMicros"),
+        d_maxReclaimPause("expr::NodeManager::maxReclaimPauseMicros", 0),
+        d_statisticsRegistry(stats)
+  {
+    d_statisticsRegistry.registerStat(&d_reclaimRounds);
+    d_statisticsRegistry.registerStat(&d_zombiesReclaimed);
+    d_statisticsRegistry.registerStat(&d_reclaimTime);
+    d_statisticsRegistry.registerStat(&d_avgReclaimPause);
+    d_statisticsRegistry.registerStat(&d_maxReclaimPause);
+  }
+
+  ~Statistics()
+  {
+    d_statisticsRegistry.unregisterStat(&d_reclaimRounds);
+    d_statisticsRegistry.unregisterStat(&d_zombiesReclaimed);
+    d_statisticsRegistry.unregisterStat(&d_reclaimTime);
+    d_statisticsRegistry.unregisterStat(&d_avgReclaimPause);
+    d_statisticsRegistry.unregisterStat(&d_maxReclaimPause);
+  }
+
+ private:
+  StatisticsRegistry& d_statisticsRegistry;
+}; /* class NodeManager::Statistics */
+
 namespace attr {
   struct LambdaBoundVarListTag { };
 }/* CVC4::attr namespace */
@@ -96,11 +140,13 @@ NodeManager::NodeManager(ExprManager* exprManager)
       d_statisticsRegistry(new StatisticsRegistry()),
       d_resourceManager(new ResourceManager(*d_statisticsRegistry, *d_options)),
       d_registrations(new ListenerRegistrationList()),
+      d_nvAllocator(new expr::NodeValueAllocator(*d_statisticsRegistry)),
       next_id(0),
       d_attrManager(new expr::attr::AttributeManager()),
       d_exprManager(exprManager),
       d_nodeUnderDeletion(NULL),
       d_inReclaimZombies(false),
+      d_statistics(new Statistics(*d_statisticsRegistry)),
       d_abstractValueCount(0),
       d_skolemCounter(0)
 {
@@ -112,11 +158,13 @@ NodeManager::NodeManager(ExprManager* exprManager, const Options& options)
       d_statisticsRegistry(new StatisticsRegistry()),
       d_resourceManager(new ResourceManager(*d_statisticsRegistry, *d_options)),
       d_registrations(new ListenerRegistrationList()),
+      d_nvAllocator(new expr::NodeValueAllocator(*d_statisticsRegistry)),
       next_id(0),
       d_attrManager(new expr::attr::AttributeManager()),
       d_exprManager(exprManager),
       d_nodeUnderDeletion(NULL),
       d_inReclaimZombies(false),
+      d_statistics(new Statistics(*d_statisticsRegistry)),
       d_abstractValueCount(0),
       d_skolemCounter(0)
 {
@@ -215,19 +263,27 @@ NodeManager::~NodeManager() {
 
   if(Debug.isOn("gc:leaks")) {
     Debug("gc:leaks") << "still in pool:" << endl;
-    for(NodeValuePool::const_iterator i = d_nodeValuePool.begin(),
-          iend = d_nodeValuePool.end();
-        i != iend;
-        ++i) {
-      Debug("gc:leaks") << "  " << *i
-                        << " id=" << (*i)->d_id
-                        << " rc=" << (*i)->d_rc
-                        << " " << **i << endl;
+    for (const PoolShard& shard : d_poolShards)
+    {
+      for (NodeValuePool::const_iterator i = shard.d_pool.begin(),
+                                         iend = shard.d_pool.end();
+           i != iend;
+           ++i)
+      {
+        Debug("gc:leaks") << "  " << *i
+                          << " id=" << (*i)->d_id
+                          << " rc=" << (*i)->d_rc
+                          << " " << **i << endl;
+      }
     }
     Debug("gc:leaks") << ":end:" << endl;
   }
 
   // defensive coding, in case destruction-order issues pop up (they often do)
+  delete d_nvAllocator;
+  d_nvAllocator = NULL;
+  delete d_statistics;
+  d_statistics = NULL;
   delete d_resourceManager;
   d_resourceManager = NULL;
   delete d_statisticsRegistry;
@@ -253,11 +309,29 @@ const DType& NodeManager::getDTypeForIndex(unsigned index) const
   return *d_ownedDTypes[index];
 }
 
-void NodeManager::reclaimZombies() {
-  // FIXME multithreading
+void NodeManager::reclaimZombiesStep()
+{
+  if ((*d_options)[options::incrementalGc])
+  {
+    reclaimZombies(
+        std::max(1u, (unsigned)(*d_options)[options::incrementalGcBudget]));
+  }
+  else
+  {
+    reclaimZombies();
+  }
+}
+
+void NodeManager::reclaimZombies(size_t budget) {
+  Assert(!isConcurrent()) << "zombies are not reclaimed in concurrent mode";
   Assert(!d_attrManager->inGarbageCollection());
 
-  Debug("gc") << "reclaiming " << d_zombies.size() << " zombie(s)!\n";
+  Debug("gc") << "reclaiming " << std::min(budget, d_zombies.size()) << " of "
+              << d_zombies.size() << " zombie(s)!\n";
+
+  TimerStat::CodeTimer reclaimTimer(d_statistics->d_reclaimTime);
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
 
   // during reclamation, reclaimZombies() is never supposed to be called
   Assert(!d_inReclaimZombies)
@@ -281,12 +355,30 @@ void NodeManager::reclaimZombies() {
   // iterator, causing a crash.  So we need to copy the set away.
 
   vector<NodeValue*> zombies;
-  zombies.reserve(d_zombies.size());
-  remove_copy_if(d_zombies.begin(),
-                 d_zombies.end(),
-                 back_inserter(zombies),
-                 NodeValueReferenceCountNonZero());
-  d_zombies.clear();
+  if (budget >= d_zombies.size())
+  {
+    zombies.reserve(d_zombies.size());
+    remove_copy_if(d_zombies.begin(),
+                   d_zombies.end(),
+                   back_inserter(zombies),
+                   NodeValueReferenceCountNonZero());
+    d_zombies.clear();
+  }
+  else
+  {
+    // Only take budget zombies out of the set, the rest are left for
+    // later rounds.
+    zombies.reserve(budget);
+    NodeValueIDSet::iterator it = d_zombies.begin();
+    for (size_t i = 0; i < budget; ++i)
+    {
+      if ((*it)->d_rc == 0)
+      {
+        zombies.push_back(*it);
+      }
+      it = d_zombies.erase(it);
+    }
+  }
 
 #ifdef _LIBCPP_VERSION
   NodeValue* last = NULL;
@@ -352,9 +444,20 @@ void NodeManager::reclaimZombies() {
         // type for a constant payload.)
         kind::metakind::deleteNodeValueConstant(nv);
       }
-      free(nv);
+      deallocateNodeValue(nv);
     }
   }
+
+  // hand chunks that became empty in this round back to the heap
+  d_nvAllocator->releaseEmptyChunks();
+
+  int64_t pause = std::chrono::duration_cast<std::chrono::microseconds>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+  ++d_statistics->d_reclaimRounds;
+  d_statistics->d_zombiesReclaimed += zombies.size();
+  d_statistics->d_avgReclaimPause.addEntry(pause);
+  d_statistics->d_maxReclaimPause.maxAssign(pause);
 }/* NodeManager::reclaimZombies() */
 
 std::vector<NodeValue*> NodeManager::TopologicalSort(
@@ -474,7 +577,12 @@ Node NodeManager::mkSkolem(const std::string& prefix, const TypeNode& type, cons
   setAttribute(n, TypeCheckedAttr(), true);
   if((flags & SKOLEM_EXACT_NAME) == 0) {
     stringstream name;
-    name << prefix << '_' << ++d_skolemCounter;
+    unsigned counter;
+    {
+      ConcurrentLock lock(this, d_cachesMutex);
+      counter = ++d_skolemCounter;
+    }
+    name << prefix << '_' << counter;
     setAttribute(n, expr::VarNameAttr(), name.str());
   } else {
     setAttribute(n, expr::VarNameAttr(), prefix);
@@ -583,10 +691,12 @@ TypeNode NodeManager::mkTupleType(const std::vector<TypeNode>& types) {
     Debug("tuprec-debug") << types[i] << " ";
   }
   Debug("tuprec-debug") << std::endl;
+  ConcurrentLock lock(this, d_cachesMutex);
   return d_tt_cache.getTupleType( this, ts );
 }
 
 TypeNode NodeManager::mkRecordType(const Record& rec) {
+  ConcurrentLock lock(this, d_cachesMutex);
   return d_rt_cache.getRecordType( this, rec );
 }
 
@@ -604,7 +714,12 @@ void NodeManager::reclaimZombiesUntil(uint32_t k){
 }
 
 size_t NodeManager::poolSize() const{
-  return d_nodeValuePool.size();
+  size_t size = 0;
+  for (const PoolShard& shard : d_poolShards)
+  {
+    size += shard.d_pool.size();
+  }
+  return size;
 }
 
 TypeNode NodeManager::mkSort(uint32_t flags) {
@@ -777,6 +892,7 @@ Node NodeManager::mkBooleanTermVariable() {
 }
 
 Node NodeManager::mkNullaryOperator(const TypeNode& type, Kind k) {
+  ConcurrentLock lock(this, d_cachesMutex);
   std::map< TypeNode, Node >::iterator it = d_unique_vars[k].find( type );
   if( it==d_unique_vars[k].end() ){
     Node n = NodeBuilder<0>(this, k).constructNode();
@@ -791,18 +907,52 @@ Node NodeManager::mkNullaryOperator(const TypeNode& type, Kind k) {
 }
 
 Node NodeManager::mkAbstractValue(const TypeNode& type) {
-  Node n = mkConst(AbstractValue(++d_abstractValueCount));
+  unsigned counter;
+  {
+    ConcurrentLock lock(this, d_cachesMutex);
+    counter = ++d_abstractValueCount;
+  }
+  Node n = mkConst(AbstractValue(counter));
   n.setAttribute(TypeAttr(), type);
   n.setAttribute(TypeCheckedAttr(), true);
   return n;
 }
 
 bool NodeManager::safeToReclaimZombies() const{
-  // FIXME multithreading
-  return !d_inReclaimZombies && !d_attrManager->inGarbageCollection();
+  // zombies may be revived concurrently in concurrent mode, they are
+  // reclaimed when leaving it
+  return !isConcurrent() && !d_inReclaimZombies
+         && !d_attrManager->inGarbageCollection();
+}
+
+#ifdef CVC4_CONCURRENT_NODE_MANAGER
+NodeManager::ConcurrentScope::ConcurrentScope(NodeManager* nm) : d_nm(nm)
+{
+  Assert(!d_nm->d_concurrent) << "ConcurrentScopes must not be nested";
+  d_nm->d_concurrent = true;
+  ++expr::NodeValue::s_concurrentManagers;
+}
+
+NodeManager::ConcurrentScope::~ConcurrentScope()
+{
+  --expr::NodeValue::s_concurrentManagers;
+  d_nm->d_concurrent = false;
+  // hand the zombies marked concurrently over to the sequential collector,
+  // those that were revived in the meantime are skipped when reclaiming
+  for (ZombieShard& shard : d_nm->d_zombieShards)
+  {
+    d_nm->d_zombies.insert(shard.d_zombies.begin(), shard.d_zombies.end());
+    shard.d_zombies.clear();
+  }
+  if (d_nm->d_zombies.size() > 5000 && d_nm->safeToReclaimZombies())
+  {
+    d_nm->reclaimZombiesStep();
+  }
 }
+#endif /* CVC4_CONCURRENT_NODE_MANAGER */
 
 void NodeManager::deleteAttributes(const std::vector<const expr::attr::AttributeUniqueId*>& ids){
+  ConcurrentLock lock(this, d_attrMutex);
   d_attrManager->deleteAttributes(ids);
 }
 
@@ -30,12 +30,17 @@
 
 #include <vector>
 #include <string>
+#include <atomic>
+#include <limits>
+#include <mutex>
 #include <unordered_set>
 
 #include "base/check.h"
 #include "expr/kind.h"
 #include "expr/metakind.h"
 #include "expr/node_value.h"
+#include "expr/node_value_allocator.h"
+#include "expr/node_value_pool.h"
 #include "options/options.h"
 
 namespace CVC4 {
@@ -99,9 +104,7 @@ class NodeManager {
     bool operator()(expr::NodeValue* nv) { return nv->d_rc > 0; }
   };
 
-  typedef std::unordered_set<expr::NodeValue*,
-                             expr::NodeValuePoolHashFunction,
-                             expr::NodeValuePoolEq> NodeValuePool;
+  typedef expr::NodeValuePool NodeValuePool;
   typedef std::unordered_set<expr::NodeValue*,
                              expr::NodeValueIDHashFunction,
                              expr::NodeValueIDEquality> NodeValueIDSet;
@@ -119,9 +122,159 @@ class NodeManager {
    */
   ListenerRegistrationList* d_registrations;
 
-  NodeValuePool d_nodeValuePool;
+#ifdef CVC4_CONCURRENT_NODE_MANAGER
+  /**
+   * Whether this NodeManager is in concurrent mode, see ConcurrentScope.
+   * Only changed while a single thread uses the NodeManager.
+   */
+  bool d_concurrent = false;
+
+  /** Locks the given mutex of nm if nm is in concurrent mode */
+  class ConcurrentLock
+  {
+   public:
+    ConcurrentLock(const NodeManager* nm, std::recursive_mutex& m)
+        : d_mutex(nm->d_concurrent ? &m : NULL)
+    {
+      if (d_mutex != NULL)
+      {
+        d_mutex->lock();
+      }
+    }
+    ~ConcurrentLock()
+    {
+      if (d_mutex != NULL)
+      {
+        d_mutex->unlock();
+      }
+    }
+
+   private:
+    std::recursive_mutex* d_mutex;
+  }; /* class NodeManager::ConcurrentLock */
+#else  /* CVC4_CONCURRENT_NODE_MANAGER */
+  /** Without concurrent mode, there is nothing to lock */
+  class ConcurrentLock
+  {
+   public:
+    ConcurrentLock(const NodeManager* nm, std::recursive_mutex& m) {}
+  }; /* class NodeManager::ConcurrentLock */
+#endif /* CVC4_CONCURRENT_NODE_MANAGER */
+
+  /** The number of shards of the pool, a power of two */
+  static const size_t s_numPoolShards = 16;
+
+  /**
+   * A shard of the hash-consing pool, which holds the NodeValues whose pool
+   * hash is congruent to its index modulo s_numPoolShards.
+   */
+  struct PoolShard
+  {
+    NodeValuePool d_pool;
+    /**
+     * In concurrent mode, guards d_pool: held from the pool lookup of a node
+     * to the insertion of a new one.  Recursive, since debug output while it
+     * is held may construct nodes.
+     */
+    std::recursive_mutex d_mutex;
+  };
+
+  /**
+   * A share of the zombies marked in concurrent mode, selected by id.  They
+   * are moved to d_zombies when concurrent mode is left.
+   */
+  struct ZombieShard
+  {
+    std::vector<expr::NodeValue*> d_zombies;
+    std::recursive_mutex d_mutex;
+  };
+
+  /** The hash-consing pool, in shards that are locked independently */
+  PoolShard d_poolShards[s_numPoolShards];
+
+  /** The zombies marked in concurrent mode */
+  ZombieShard d_zombieShards[s_numPoolShards];
+
+  /** The pool shard of the NodeValues with the given pool hash */
+  PoolShard& getPoolShard(size_t hash)
+  {
+    return d_poolShards[hash & (s_numPoolShards - 1)];
+  }
+
+  /**
+   * The pool shard of a NodeValue, locked in concurrent mode while in scope
+   * so that no other thread can insert the same node between its lookup and
+   * its insertion.
+   */
+  class PoolLock
+  {
+   public:
+    PoolLock(NodeManager* nm, const expr::NodeValue* nv)
+        : d_hash(nv->poolHash()),
+          d_shard(nm->getPoolShard(d_hash)),
+          d_lock(nm, d_shard.d_mutex)
+    {
+    }
+
+    /** Look up nv, see NodeManager::poolLookup() */
+    expr::NodeValue* lookup(const expr::NodeValue* nv) const
+    {
+      return d_shard.d_pool.find(nv, d_hash);
+    }
+
+    /**
+     * Insert nv, the fully constructed equivalent of the NodeValue this
+     * lock was taken for, see NodeManager::poolInsert()
+     */
+    void insert(expr::NodeValue* nv)
+    {
+      Assert(nv->poolHash() == d_hash);
+      Assert(d_shard.d_pool.find(nv, d_hash) == NULL)
+          << "NodeValue already in the pool!";
+      d_shard.d_pool.insert(nv, d_hash);
+    }
+
+   private:
+    size_t d_hash;
+    PoolShard& d_shard;
+    ConcurrentLock d_lock;
+  }; /* class NodeManager::PoolLock */
+
+  /** The slab allocator backing the non-constant NodeValues */
+  expr::NodeValueAllocator* d_nvAllocator;
+
+  /** In concurrent mode, guards d_nvAllocator */
+  std::recursive_mutex d_allocMutex;
+
+  /** The id of the next NodeValue */
+#ifdef CVC4_CONCURRENT_NODE_MANAGER
+  std::atomic<uint64_t> next_id;
+#else  /* CVC4_CONCURRENT_NODE_MANAGER */
+  uint64_t next_id;
+#endif /* CVC4_CONCURRENT_NODE_MANAGER */
+
+  /** Returns a fresh NodeValue id */
+  uint64_t newNodeId()
+  {
+#ifdef CVC4_CONCURRENT_NODE_MANAGER
+    return next_id.fetch_add(1, std::memory_order_relaxed);
+#else  /* CVC4_CONCURRENT_NODE_MANAGER */
+    return next_id++;
+#endif /* CVC4_CONCURRENT_NODE_MANAGER */
+  }
 
-  size_t next_id;
+  /** In concurrent mode, guards d_attrManager */
+  mutable std::recursive_mutex d_attrMutex;
+
+  /** In concurrent mode, guards d_maxedOut */
+  std::recursive_mutex d_maxedOutMutex;
+
+  /**
+   * In concurrent mode, guards the counters and caches of types and
+   * special nodes: d_skolemCounter, d_abstractValueCount, d_unique_vars,
+   * d_tt_cache and d_rt_cache.
+   */
+  std::recursive_mutex d_cachesMutex;
 
   expr::attr::AttributeManager* d_attrManager;
 
@@ -153,6 +306,10 @@ class NodeManager {
    */
   NodeValueIDSet d_zombies;
 
+  /** Statistics about garbage collection */
+  class Statistics;
+  Statistics* d_statistics;
+
   /**
    * NodeValues with maxed out reference counts. These live as long as the
    * NodeManager. They have a custom deallocation procedure at the very end.
@@ -238,6 +395,9 @@ class NodeManager {
    * NULL, the caller should fully construct an equivalent one before
    * calling poolInsert().  NON-FULLY-CONSTRUCTED NODEVALUES are not
    * permitted in the pool!
+   *
+   * Not for concurrent mode, where nodes are looked up through a
+   * PoolLock.
    */
   inline expr::NodeValue* poolLookup(expr::NodeValue* nv) const;
 
@@ -245,7 +405,8 @@ class NodeManager {
    * Insert a NodeValue into the NodeManager's pool.
    *
    * It is an error to insert a NodeValue already in the pool.
-   * Enquire first with poolLookup().
+   * Enquire first with poolLookup().  Not for concurrent mode, where
+   * nodes are inserted through a PoolLock.
    */
   inline void poolInsert(expr::NodeValue* nv);
 
@@ -253,10 +414,37 @@ class NodeManager {
    * Remove a NodeValue from the NodeManager's pool.
    *
    * It is an error to request the removal of a NodeValue from the
-   * pool that is not in the pool.
+   * pool that is not in the pool.  Only called when reclaiming zombies,
+   * hence never in concurrent mode.
    */
   inline void poolRemove(expr::NodeValue* nv);
 
+  /**
+   * Allocate uninitialized storage for a (non-constant) NodeValue with
+   * nchildren children.
+   */
+  expr::NodeValue* allocateNodeValue(uint32_t nchildren)
+  {
+    ConcurrentLock lock(this, d_allocMutex);
+    return d_nvAllocator->allocate(nchildren);
+  }
+
+  /**
+   * Release the storage of a reclaimed NodeValue.  Constants are malloc'ed
+   * by mkConst(), all other NodeValues come from allocateNodeValue().
+   */
+  void deallocateNodeValue(expr::NodeValue* nv)
+  {
+    if (nv->getMetaKind() == kind::metakind::CONSTANT)
+    {
+      free(nv);
+    }
+    else
+    {
+      d_nvAllocator->deallocate(nv);
+    }
+  }
+
   /**
    * Determine if nv is currently being deleted by the NodeManager.
    */
@@ -268,7 +456,8 @@ class NodeManager {
    * Register a NodeValue as a zombie.
    */
   inline void markForDeletion(expr::NodeValue* nv) {
-    Assert(nv->d_rc == 0);
+    // in concurrent mode, nv may have been revived by another thread already
+    Assert(isConcurrent() || nv->d_rc == 0);
 
     // if d_reclaiming is set, make sure we don't call
     // reclaimZombies(), because it's already running.
@@ -288,13 +477,21 @@ class NodeManager {
     // on that node while a different `NodeManager` n2 is in scope. When that
     // `Expr` is deleted and the node reaches refcount zero in the `Expr`'s
     // destructor, then `markForDeletion()` will be called on n2.
+    if (isConcurrent())
+    {
+      ZombieShard& shard = d_zombieShards[nv->d_id & (s_numPoolShards - 1)];
+      ConcurrentLock lock(this, shard.d_mutex);
+      shard.d_zombies.push_back(nv);
+      return;
+    }
+
     Assert(d_zombies.find(nv) == d_zombies.end() || *d_zombies.find(nv) == nv);
 
-    d_zombies.insert(nv);  // FIXME multithreading
+    d_zombies.insert(nv);
 
     if(safeToReclaimZombies()) {
       if(d_zombies.size() > 5000) {
-        reclaimZombies();
+        reclaimZombiesStep();
       }
     }
   }
@@ -309,13 +506,25 @@ class NodeManager {
       Debug("gc") << "marking node value " << nv
                   << " [" << nv->d_id << "]: as maxed out" << std::endl;
     }
+    ConcurrentLock lock(this, d_maxedOutMutex);
     d_maxedOut.push_back(nv);
   }
 
   /**
-   * Reclaim all zombies.
+   * Reclaim at most budget zombies (all of them by default).  Zombies
+   * created while reclaiming, i.e., children whose reference count
+   * drops to zero, are left for later rounds.
+   */
+  void reclaimZombies(size_t budget = std::numeric_limits<size_t>::max());
+
+  /**
+   * Run one round of zombie reclamation on behalf of markForDeletion().
+   * With --incremental-gc, the round is bounded by
+   * --incremental-gc-budget so that the cost of collecting a large dead
+   * DAG is spread over subsequent calls; the remainder is drained by
+   * reclaimAllZombies() at safe points.
    */
-  void reclaimZombies();
+  void reclaimZombiesStep();
 
   /**
    * It is safe to collect zombies.
@@ -393,6 +602,41 @@ public:
   /** The resource manager associated with the current node manager */
   static ResourceManager* currentResourceManager() { return s_current->d_resourceManager; }
 
+#ifdef CVC4_CONCURRENT_NODE_MANAGER
+  /**
+   * Puts a NodeManager in concurrent mode while in scope.  In concurrent
+   * mode, several threads may construct nodes, types and skolems, copy and
+   * release them, and get and set their attributes concurrently, each
+   * thread under its own NodeManagerScope.  Node construction only locks
+   * the pool shard of the new node.  Zombies are not reclaimed in
+   * concurrent mode, they are reclaimed when the scope is left.
+   *
+   * The NodeManagerListeners are notified on the constructing thread, so
+   * they must be thread-safe themselves if they are notified in concurrent
+   * mode.  The scope must be entered and left while a single thread uses
+   * the NodeManager.
+   */
+  class ConcurrentScope
+  {
+   public:
+    ConcurrentScope(NodeManager* nm);
+    ~ConcurrentScope();
+
+   private:
+    NodeManager* d_nm;
+  }; /* class NodeManager::ConcurrentScope */
+
+  /** Whether this NodeManager is in concurrent mode */
+  bool isConcurrent() const { return d_concurrent; }
+#else  /* CVC4_CONCURRENT_NODE_MANAGER */
+  /**
+   * Whether this NodeManager is in concurrent mode, which is only available
+   * if CVC4 is configured with --concurrent-nm
+   */
+  bool isConcurrent() const { return false; }
+#endif /* CVC4_CONCURRENT_NODE_MANAGER */
+
+
   /** Get this node manager's options (const version) */
   const Options& getOptions() const {
     return *d_options;
@@ -1199,25 +1443,20 @@ inline TypeNode NodeManager::mkTesterType(TypeNode domain) {
 }
 
 inline expr::NodeValue* NodeManager::poolLookup(expr::NodeValue* nv) const {
-  NodeValuePool::const_iterator find = d_nodeValuePool.find(nv);
-  if(find == d_nodeValuePool.end()) {
-    return NULL;
-  } else {
-    return *find;
-  }
+  size_t hash = nv->poolHash();
+  return d_poolShards[hash & (s_numPoolShards - 1)].d_pool.find(nv, hash);
 }
 
 inline void NodeManager::poolInsert(expr::NodeValue* nv) {
-  Assert(d_nodeValuePool.find(nv) == d_nodeValuePool.end())
-      << "NodeValue already in the pool!";
-  d_nodeValuePool.insert(nv);// FIXME multithreading
+  Assert(poolLookup(nv) == NULL) << "NodeValue already in the pool!";
+  size_t hash = nv->poolHash();
+  getPoolShard(hash).d_pool.insert(nv, hash);
 }
 
 inline void NodeManager::poolRemove(expr::NodeValue* nv) {
-  Assert(d_nodeValuePool.find(nv) != d_nodeValuePool.end())
-      << "NodeValue is not in the pool!";
-
-  d_nodeValuePool.erase(nv);// FIXME multithreading
+  Assert(poolLookup(nv) == nv) << "NodeValue is not in the pool!";
+  size_t hash = nv->poolHash();
+  getPoolShard(hash).d_pool.erase(nv, hash);
 }
 
 inline Expr NodeManager::toExpr(TNode n) {
@@ -1552,31 +1791,36 @@ NodeClass NodeManager::mkConstInternal(const T& val) {
 
   nvStack.d_children[0] =
     const_cast<expr::NodeValue*>(reinterpret_cast<const expr::NodeValue*>(&val));
-  expr::NodeValue* nv = poolLookup(&nvStack);
+
+  expr::NodeValue* nv;
+  {
+    PoolLock pool(this, &nvStack);
+    nv = pool.lookup(&nvStack);
 
 #if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 6))
 #pragma GCC diagnostic pop
 #endif
 
-  if(nv != NULL) {
-    return NodeClass(nv);
-  }
+    if(nv != NULL) {
+      return NodeClass(nv);
+    }
 
-  nv = (expr::NodeValue*)
-    std::malloc(sizeof(expr::NodeValue) + sizeof(T));
-  if(nv == NULL) {
-    throw std::bad_alloc();
-  }
+    nv = (expr::NodeValue*)
+      std::malloc(sizeof(expr::NodeValue) + sizeof(T));
+    if(nv == NULL) {
+      throw std::bad_alloc();
+    }
 
-  nv->d_nchildren = 0;
-  nv->d_kind = kind::metakind::ConstantMap<T>::kind;
-  nv->d_id = next_id++;// FIXME multithreading
-  nv->d_rc = 0;
+    nv->d_nchildren = 0;
+    nv->d_kind = kind::metakind::ConstantMap<T>::kind;
+    nv->d_id = newNodeId();
+    nv->d_rc = 0;
 
-  //OwningTheory::mkConst(val);
-  new (&nv->d_children) T(val);
+    //OwningTheory::mkConst(val);
+    new (&nv->d_children) T(val);
 
-  poolInsert(nv);
+    pool.insert(nv);
+  }
   if(Debug.isOn("gc")) {
     Debug("gc") << "creating node value " << nv
                 << " [" << nv->d_id << "]: ";
@@ -92,5 +92,92 @@ NodeValue::iterator<NodeTemplate<false> > operator+(
   return i + p;
 }
 
+#ifdef CVC4_CONCURRENT_NODE_MANAGER
+
+std::atomic<unsigned> NodeValue::s_concurrentManagers(0);
+
+namespace {
+
+/** The number of spin locks the reference counts are striped over */
+const size_t s_numRefCountLocks = 256;
+
+/** The reference count locks, see RefCountLock */
+std::atomic<bool> s_refCountLocks[s_numRefCountLocks];
+
+/**
+ * Spin lock guarding the reference count of a NodeValue in concurrent mode.
+ * Critical sections are a few instructions long, so the NodeValues share a
+ * small set of locks selected by their address.
+ */
+class RefCountLock
+{
+ public:
+  RefCountLock(const NodeValue* nv)
+      : d_lock(s_refCountLocks[(reinterpret_cast<uintptr_t>(nv) >> 4)
+                               % s_numRefCountLocks])
+  {
+    while (d_lock.exchange(true, std::memory_order_acquire))
+    {
+    }
+  }
+  ~RefCountLock() { d_lock.store(false, std::memory_order_release); }
+
+ private:
+  std::atomic<bool>& d_lock;
+}; /* class RefCountLock */
+
+}  // namespace
+
+void NodeValue::incConcurrent()
+{
+  bool maxedOut = false;
+  {
+    RefCountLock lock(this);
+    if (d_rc < MAX_RC - 1)
+    {
+      ++d_rc;
+    }
+    else if (d_rc == MAX_RC - 1)
+    {
+      ++d_rc;
+      maxedOut = true;
+    }
+  }
+  if (maxedOut)
+  {
+    Assert(NodeManager::currentNM() != NULL)
+        << "No current NodeManager on incrementing of NodeValue: "
+           "maybe a public CVC4 interface function is missing a "
+           "NodeManagerScope ?";
+    NodeManager::currentNM()->markRefCountMaxedOut(this);
+  }
+}
+
+void NodeValue::decConcurrent()
+{
+  bool zombie = false;
+  {
+    RefCountLock lock(this);
+    if (d_rc < MAX_RC)
+    {
+      --d_rc;
+      zombie = (d_rc == 0);
+    }
+  }
+  if (zombie)
+  {
+    // another thread may revive this NodeValue before it is marked, but
+    // zombies are only reclaimed outside of concurrent mode, and only if
+    // their reference count is still zero
+    Assert(NodeManager::currentNM() != NULL)
+        << "No current NodeManager on destruction of NodeValue: "
+           "maybe a public CVC4 interface function is missing a "
+           "NodeManagerScope ?";
+    NodeManager::currentNM()->markForDeletion(this);
+  }
+}
+
+#endif /* CVC4_CONCURRENT_NODE_MANAGER */
+
 } /* CVC4::expr namespace */
 } /* CVC4 namespace */
@@ -28,6 +28,7 @@
 
 #include <stdint.h>
 
+#include <atomic>
 #include <iterator>
 #include <string>
 
@@ -43,6 +44,7 @@ class NodeManager;
 
 namespace expr {
   class NodeValue;
+  class NodeValueAllocator;
 }
 
 namespace kind {
@@ -70,6 +72,7 @@ class NodeValue
   template <unsigned nchild_thresh>
   friend class ::CVC4::NodeBuilder;
   friend class ::CVC4::NodeManager;
+  friend class NodeValueAllocator;
 
   template <Kind k, bool pool>
   friend struct ::CVC4::kind::metakind::NodeValueConstCompare;
@@ -304,6 +307,20 @@ class NodeValue
   void inc();
   void dec();
 
+#ifdef CVC4_CONCURRENT_NODE_MANAGER
+  /**
+   * The number of NodeManagers in concurrent mode (see
+   * NodeManager::ConcurrentScope).  While it is nonzero, inc() and dec()
+   * update reference counts under a lock.
+   */
+  static std::atomic<unsigned> s_concurrentManagers;
+
+  /** inc() for concurrent mode */
+  void incConcurrent();
+  /** dec() for concurrent mode */
+  void decConcurrent();
+#endif /* CVC4_CONCURRENT_NODE_MANAGER */
+
   /** Decrement ref counts of children */
   inline void decrRefCounts();
 
@@ -424,7 +441,14 @@ inline void NodeValue::inc() {
   Assert(!isBeingDeleted())
       << "NodeValue is currently being deleted "
          "and increment is being called on it. Don't Do That!";
-  // FIXME multithreading
+#ifdef CVC4_CONCURRENT_NODE_MANAGER
+  if (__builtin_expect(
+          s_concurrentManagers.load(std::memory_order_relaxed) != 0, false))
+  {
+    incConcurrent();
+    return;
+  }
+#endif /* CVC4_CONCURRENT_NODE_MANAGER */
   if (__builtin_expect((d_rc < MAX_RC - 1), true)) {
     ++d_rc;
   } else if (__builtin_expect((d_rc == MAX_RC - 1), false)) {
@@ -438,7 +462,14 @@ inline void NodeValue::inc() {
 }
 
 inline void NodeValue::dec() {
-  // FIXME multithreading
+#ifdef CVC4_CONCURRENT_NODE_MANAGER
+  if (__builtin_expect(
+          s_concurrentManagers.load(std::memory_order_relaxed) != 0, false))
+  {
+    decConcurrent();
+    return;
+  }
+#endif /* CVC4_CONCURRENT_NODE_MANAGER */
   if(__builtin_expect( ( d_rc < MAX_RC ), true )) {
     --d_rc;
     if(__builtin_expect( ( d_rc == 0 ), false )) {
@@ -0,0 +1,217 @@
+/*********************                                                        */
+/*! \file node_value_allocator.cpp
+ ** \verbatim
+ ** Top contributors (to current version):
+ **
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2019 by the authors listed in the file AUTHORS
+ ** in the top-level source directory) and their institutional affiliations.
+ ** All rights reserved.  See the file COPYING in the top-level source
+ ** directory for licensing information.\endverbatim
+ **
+ ** \brief Implementation of the NodeValue slab allocator.
+ **
+ ** Implementation of the NodeValue slab allocator.
+ **/
+
+#include "expr/node_value_allocator.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "base/check.h"
+#include "base/output.h"
+#include "util/statistics_registry.h"
+
+namespace CVC4 {
+namespace expr {
+
+struct NodeValueAllocator::Statistics
+{
+  /** Bytes handed out per size class */
+  std::vector<ReferenceStat<int64_t>*> d_bytesInUse;
+  /** Bytes handed out for NodeValues without a size class */
+  ReferenceStat<int64_t> d_largeBytesInUse;
+  /** Bytes in chunks owned by the allocator */
+  ReferenceStat<int64_t> d_chunkBytes;
+  /** Chunks returned to the heap */
+  ReferenceStat<int64_t> d_chunksReleased;
+
+  Statistics(StatisticsRegistry& stats, const NodeValueAllocator& alloc);
+  ~Statistics();
+
+ private:
+  StatisticsRegistry& d_statisticsRegistry;
+};
+
+NodeValueAllocator::Statistics::Statistics(StatisticsRegistry& stats,
+                                           const NodeValueAllocator& alloc)
+    : d_largeBytesInUse("expr::NodeValueAllocator::largeBytesInUse",
+                        alloc.d_largeBytesInUse),
+      d_chunkBytes("expr::NodeValueAllocator::chunkBytes", alloc.d_chunkBytes),
+      d_chunksReleased("expr::NodeValueAllocator::chunksReleased",
+                       alloc.d_chunksReleased),
+      d_statisticsRegistry(stats)
+{
+  for (uint32_t i = 0; i < s_numSizeClasses; ++i)
+  {
+    std::stringstream ss;
+    ss << "expr::NodeValueAllocator::bytesInUse" << i;
+    d_bytesInUse.push_back(
+        new ReferenceStat<int64_t>(ss.str(), alloc.d_classes[i].d_bytesInUse));
+    d_statisticsRegistry.registerStat(d_bytesInUse.back());
+  }
+  d_statisticsRegistry.registerStat(&d_largeBytesInUse);
+  d_statisticsRegistry.registerStat(&d_chunkBytes);
+  d_statisticsRegistry.registerStat(&d_chunksReleased);
+}
+
+NodeValueAllocator::Statistics::~Statistics()
+{
+  for (ReferenceStat<int64_t>* s : d_bytesInUse)
+  {
+    d_statisticsRegistry.unregisterStat(s);
+    delete s;
+  }
+  d_statisticsRegistry.unregisterStat(&d_largeBytesInUse);
+  d_statisticsRegistry.unregisterStat(&d_chunkBytes);
+  d_statisticsRegistry.unregisterStat(&d_chunksReleased);
+}
+
+NodeValueAllocator::NodeValueAllocator(StatisticsRegistry& stats)
+    : d_largeBytesInUse(0), d_chunkBytes(0), d_chunksReleased(0)
+{
+  for (uint32_t i = 0; i < s_numSizeClasses; ++i)
+  {
+    SizeClass& sc = d_classes[i];
+    sc.d_blockSize = getBlockSize(i);
+    sc.d_freeList = NULL;
+    sc.d_numFree = 0;
+    sc.d_numFreeAtLastScan = 0;
+    sc.d_nextFree = NULL;
+    sc.d_endChunk = NULL;
+    sc.d_bytesInUse = 0;
+  }
+  d_statistics.reset(new Statistics(stats, *this));
+}
+
+NodeValueAllocator::~NodeValueAllocator()
+{
+  d_statistics.reset();
+  for (uint32_t i = 0; i < s_numSizeClasses; ++i)
+  {
+    for (char* chunk : d_classes[i].d_chunks)
+    {
+      std::free(chunk);
+    }
+  }
+}
+
+void NodeValueAllocator::newChunk(SizeClass& sc)
+{
+  char* chunk = static_cast<char*>(std::malloc(s_chunkSizeBytes));
+  if (chunk == NULL)
+  {
+    throw std::bad_alloc();
+  }
+  sc.d_chunks.push_back(chunk);
+  sc.d_nextFree = chunk;
+  // only hand out whole blocks, the tail of the chunk is never used
+  sc.d_endChunk =
+      chunk + (s_chunkSizeBytes / sc.d_blockSize) * sc.d_blockSize;
+  d_chunkBytes += s_chunkSizeBytes;
+}
+
+void NodeValueAllocator::releaseEmptyChunks()
+{
+  for (uint32_t i = 0; i < s_numSizeClasses; ++i)
+  {
+    SizeClass& sc = d_classes[i];
+    if (sc.d_numFree < sc.d_numFreeAtLastScan)
+    {
+      sc.d_numFreeAtLastScan = sc.d_numFree;
+    }
+    // Only look for empty chunks if this class holds enough free memory to
+    // make the scan worthwhile.
+    if (sc.d_numFree * sc.d_blockSize >= 2 * s_chunkSizeBytes
+        && sc.d_numFree >= 2 * sc.d_numFreeAtLastScan)
+    {
+      releaseEmptyChunks(sc);
+      sc.d_numFreeAtLastScan = sc.d_numFree;
+    }
+  }
+}
+
+void NodeValueAllocator::releaseEmptyChunks(SizeClass& sc)
+{
+  // The current chunk is partly uncarved, so never consider it empty.
+  Assert(!sc.d_chunks.empty());
+  char* current = sc.d_chunks.back();
+  std::vector<char*> chunks(sc.d_chunks.begin(), sc.d_chunks.end() - 1);
+  std::sort(chunks.begin(), chunks.end());
+
+  // count the free blocks in each chunk
+  std::vector<size_t> numFree(chunks.size(), 0);
+  for (FreeBlock* b = sc.d_freeList; b != NULL; b = b->d_next)
+  {
+    char* p = reinterpret_cast<char*>(b);
+    std::vector<char*>::iterator it =
+        std::upper_bound(chunks.begin(), chunks.end(), p);
+    if (it != chunks.begin() && p < *(it - 1) + s_chunkSizeBytes)
+    {
+      ++numFree[(it - 1) - chunks.begin()];
+    }
+  }
+
+  size_t blocksPerChunk = s_chunkSizeBytes / sc.d_blockSize;
+  std::vector<char*> empty;
+  std::vector<char*> kept;
+  for (size_t i = 0, n = chunks.size(); i < n; ++i)
+  {
+    if (numFree[i] == blocksPerChunk)
+    {
+      empty.push_back(chunks[i]);
+    }
+    else
+    {
+      kept.push_back(chunks[i]);
+    }
+  }
+  if (empty.empty())
+  {
+    return;
+  }
+
+  Debug("gc") << "NodeValueAllocator: releasing " << empty.size()
+              << " chunk(s) of block size " << sc.d_blockSize << std::endl;
+
+  // unlink the blocks of the empty chunks from the free list
+  FreeBlock** link = &sc.d_freeList;
+  while (*link != NULL)
+  {
+    char* p = reinterpret_cast<char*>(*link);
+    std::vector<char*>::iterator it =
+        std::upper_bound(empty.begin(), empty.end(), p);
+    if (it != empty.begin() && p < *(it - 1) + s_chunkSizeBytes)
+    {
+      *link = (*link)->d_next;
+      --sc.d_numFree;
+    }
+    else
+    {
+      link = &(*link)->d_next;
+    }
+  }
+
+  for (char* chunk : empty)
+  {
+    std::free(chunk);
+  }
+  kept.push_back(current);
+  sc.d_chunks.swap(kept);
+  d_chunkBytes -= empty.size() * s_chunkSizeBytes;
+  d_chunksReleased += empty.size();
+}
+
+}  // namespace expr
+}  // namespace CVC4
@@ -0,0 +1,204 @@
+/*********************                                                        */
+/*! \file node_value_allocator.h
+ ** \verbatim
+ ** Top contributors (to current version):
+ **
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2019 by the authors listed in the file AUTHORS
+ ** in the top-level source directory) and their institutional affiliations.
+ ** All rights reserved.  See the file COPYING in the top-level source
+ ** directory for licensing information.\endverbatim
+ **
+ ** \brief Size-classed slab allocator for NodeValues
+ **
+ ** Size-classed slab allocator for NodeValues.  Designed for use by
+ ** NodeManager.
+ **/
+
+#include "cvc4_private.h"
+
+// circular dependency: NodeManager needs the complete allocator
+#include "expr/node_value.h"
+
+#ifndef CVC4__EXPR__NODE_VALUE_ALLOCATOR_H
+#define CVC4__EXPR__NODE_VALUE_ALLOCATOR_H
+
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace CVC4 {
+
+class StatisticsRegistry;
+
+namespace expr {
+
+/**
+ * Slab allocator for the NodeValues owned by a NodeManager.
+ *
+ * NodeValues are keyed on their number of children (d_nchildren): each
+ * size class carves fixed-size blocks out of large chunks and keeps freed
+ * blocks on a free list, so term creation and zombie reclamation do not go
+ * through the general-purpose heap.  NodeValues with at least
+ * s_numSizeClasses children are rare and are served by malloc().
+ *
+ * Freed blocks are only handed back to the heap in bulk: after a round of
+ * zombie reclamation, NodeManager calls releaseEmptyChunks(), which returns
+ * every chunk whose blocks are all free.
+ *
+ * Constants carry a payload of arbitrary size instead of a child array and
+ * are not allocated here.
+ */
+class NodeValueAllocator
+{
+ public:
+  /** NodeValues with fewer children than this are allocated from slabs */
+  static const uint32_t s_numSizeClasses = 16;
+
+  /** Memory for each size class is allocated in chunks of this size */
+  static const size_t s_chunkSizeBytes = 65536;
+
+  NodeValueAllocator(StatisticsRegistry& stats);
+  ~NodeValueAllocator();
+
+  /** The number of bytes used by a NodeValue with nchildren children. */
+  static size_t getBlockSize(uint32_t nchildren)
+  {
+    return sizeof(NodeValue) + sizeof(NodeValue*) * nchildren;
+  }
+
+  /** Whether NodeValues with nchildren children are allocated from slabs. */
+  static bool hasSizeClass(uint32_t nchildren)
+  {
+    return nchildren < s_numSizeClasses;
+  }
+
+  /**
+   * Allocate uninitialized storage for a NodeValue with nchildren children.
+   */
+  inline NodeValue* allocate(uint32_t nchildren);
+
+  /**
+   * Return the storage of nv to its size class.  nv must have been obtained
+   * from allocate() with nv->d_nchildren children.
+   */
+  inline void deallocate(NodeValue* nv);
+
+  /**
+   * Return the chunks that contain only free blocks to the heap.  A size
+   * class is only searched for empty chunks once its free list has doubled
+   * since the last search, so the cost is amortized over the deallocations.
+   */
+  void releaseEmptyChunks();
+
+ private:
+  /** A block on a free list */
+  struct FreeBlock
+  {
+    FreeBlock* d_next;
+  };
+
+  /** The state of a size class */
+  struct SizeClass
+  {
+    /** The size of the blocks of this class in bytes */
+    size_t d_blockSize;
+    /** The list of freed blocks (LIFO for best cache performance) */
+    FreeBlock* d_freeList;
+    /** The number of blocks on d_freeList */
+    size_t d_numFree;
+    /**
+     * The (smallest) number of blocks on d_freeList since the last search
+     * for empty chunks
+     */
+    size_t d_numFreeAtLastScan;
+    /** The beginning of the uncarved memory in the current chunk */
+    char* d_nextFree;
+    /** One past the last byte of the current chunk */
+    char* d_endChunk;
+    /** The chunks of this class, the current chunk is the last one */
+    std::vector<char*> d_chunks;
+    /** The number of bytes currently handed out from this class */
+    int64_t d_bytesInUse;
+  };
+
+  /** Set up a new current chunk for sc. */
+  void newChunk(SizeClass& sc);
+
+  /** Release the chunks of sc that contain only free blocks. */
+  void releaseEmptyChunks(SizeClass& sc);
+
+  /** The size classes, indexed by number of children */
+  SizeClass d_classes[s_numSizeClasses];
+
+  /** The number of bytes currently handed out by malloc() */
+  int64_t d_largeBytesInUse;
+
+  /** The number of bytes in chunks currently owned by this allocator */
+  int64_t d_chunkBytes;
+
+  /** The number of chunks returned to the heap */
+  int64_t d_chunksReleased;
+
+  struct Statistics;
+  std::unique_ptr<Statistics> d_statistics;
+}; /* class NodeValueAllocator */
+
+inline NodeValue* NodeValueAllocator::allocate(uint32_t nchildren)
+{
+  if (__builtin_expect(!hasSizeClass(nchildren), false))
+  {
+    size_t size = getBlockSize(nchildren);
+    NodeValue* nv = static_cast<NodeValue*>(std::malloc(size));
+    if (nv == NULL)
+    {
+      throw std::bad_alloc();
+    }
+    d_largeBytesInUse += size;
+    return nv;
+  }
+
+  SizeClass& sc = d_classes[nchildren];
+  void* block;
+  if (sc.d_freeList != NULL)
+  {
+    block = sc.d_freeList;
+    sc.d_freeList = sc.d_freeList->d_next;
+    --sc.d_numFree;
+  }
+  else
+  {
+    if (static_cast<size_t>(sc.d_endChunk - sc.d_nextFree) < sc.d_blockSize)
+    {
+      newChunk(sc);
+    }
+    block = sc.d_nextFree;
+    sc.d_nextFree += sc.d_blockSize;
+  }
+  sc.d_bytesInUse += sc.d_blockSize;
+  return static_cast<NodeValue*>(block);
+}
+
+inline void NodeValueAllocator::deallocate(NodeValue* nv)
+{
+  uint32_t nchildren = nv->d_nchildren;
+  if (__builtin_expect(!hasSizeClass(nchildren), false))
+  {
+    d_largeBytesInUse -= getBlockSize(nchildren);
+    std::free(nv);
+    return;
+  }
+
+  SizeClass& sc = d_classes[nchildren];
+  FreeBlock* block = reinterpret_cast<FreeBlock*>(nv);
+  block->d_next = sc.d_freeList;
+  sc.d_freeList = block;
+  ++sc.d_numFree;
+  sc.d_bytesInUse -= sc.d_blockSize;
+}
+
+}  // namespace expr
+}  // namespace CVC4
+
+#endif /* CVC4__EXPR__NODE_VALUE_ALLOCATOR_H */
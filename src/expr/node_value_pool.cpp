@@ -0,0 +1,77 @@
+/*********************                                                        */
+/*! \file node_value_pool.cpp
+ ** \verbatim
+ ** Top contributors (to current version):
+ **
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2019 by the authors listed in the file AUTHORS
+ ** in the top-level source directory) and their institutional affiliations.
+ ** All rights reserved.  See the file COPYING in the top-level source
+ ** directory for licensing information.\endverbatim
+ **
+ ** \brief Implementation of the hash-consing pool of NodeValues.
+ **
+ ** Implementation of the hash-consing pool of NodeValues.
+ **/
+
+#include "expr/node_value_pool.h"
+
+#include <utility>
+
+namespace CVC4 {
+namespace expr {
+
+namespace {
+/** The initial number of slots, must be a power of two */
+const size_t s_initialCapacity = 1024;
+/** log2(s_initialCapacity) */
+const unsigned s_initialCapacityLog = 10;
+}  // namespace
+
+NodeValuePool::NodeValuePool()
+    : d_slots(s_initialCapacity, Slot{0, NULL}),
+      d_mask(s_initialCapacity - 1),
+      d_shift(64 - s_initialCapacityLog),
+      d_size(0)
+{
+}
+
+void NodeValuePool::insertNoGrow(size_t hash, NodeValue* nv)
+{
+  Slot cur{hash, nv};
+  for (size_t i = homeSlot(hash), dist = 0;; i = (i + 1) & d_mask, ++dist)
+  {
+    Slot& s = d_slots[i];
+    if (s.d_nv == NULL)
+    {
+      s = cur;
+      return;
+    }
+    Assert(s.d_nv != nv) << "NodeValue already in the pool!";
+    // Robin Hood: the entry closer to its home slot gives way
+    size_t sdist = probeDistance(i);
+    if (sdist < dist)
+    {
+      std::swap(s, cur);
+      dist = sdist;
+    }
+  }
+}
+
+void NodeValuePool::grow()
+{
+  std::vector<Slot> old(2 * d_slots.size(), Slot{0, NULL});
+  old.swap(d_slots);
+  d_mask = d_slots.size() - 1;
+  --d_shift;
+  for (const Slot& s : old)
+  {
+    if (s.d_nv != NULL)
+    {
+      insertNoGrow(s.d_hash, s.d_nv);
+    }
+  }
+}
+
+}  // namespace expr
+}  // namespace CVC4
@@ -0,0 +1,221 @@
+/*********************                                                        */
+/*! \file node_value_pool.h
+ ** \verbatim
+ ** Top contributors (to current version):
+ **
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2019 by the authors listed in the file AUTHORS
+ ** in the top-level source directory) and their institutional affiliations.
+ ** All rights reserved.  See the file COPYING in the top-level source
+ ** directory for licensing information.\endverbatim
+ **
+ ** \brief The hash-consing pool of NodeValues
+ **
+ ** The hash-consing pool of NodeValues, an open-addressing hash table
+ ** used by NodeManager.
+ **/
+
+#include "cvc4_private.h"
+
+// circular dependency: NodeManager needs the complete pool
+#include "expr/node_value.h"
+
+#ifndef CVC4__EXPR__NODE_VALUE_POOL_H
+#define CVC4__EXPR__NODE_VALUE_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "base/check.h"
+
+namespace CVC4 {
+namespace expr {
+
+/**
+ * The set of hash-consed NodeValues of a NodeManager.
+ *
+ * This is an open-addressing hash table with linear probing and Robin Hood
+ * insertion.  Each slot stores the NodeValue pointer together with its
+ * cached poolHash(), so that a lookup walks a contiguous run of slots and
+ * only compares NodeValues whose hashes agree.  Robin Hood ordering bounds
+ * unsuccessful lookups and allows erase() to shift entries back instead of
+ * leaving tombstones.
+ *
+ * Like an std::unordered_set<NodeValue*, NodeValuePoolHashFunction,
+ * NodeValuePoolEq>, lookups accept "non-inlined" constant NodeValues (see
+ * NodeManager::poolLookup()).
+ */
+class NodeValuePool
+{
+  /** A slot of the table, empty iff d_nv is NULL */
+  struct Slot
+  {
+    size_t d_hash;
+    NodeValue* d_nv;
+  };
+
+ public:
+  /** Iterator over the NodeValues in the pool */
+  class const_iterator
+  {
+   public:
+    const_iterator(const Slot* s, const Slot* end) : d_slot(s), d_end(end)
+    {
+      skipEmpty();
+    }
+    NodeValue* operator*() const { return d_slot->d_nv; }
+    const_iterator& operator++()
+    {
+      ++d_slot;
+      skipEmpty();
+      return *this;
+    }
+    bool operator==(const const_iterator& other) const
+    {
+      return d_slot == other.d_slot;
+    }
+    bool operator!=(const const_iterator& other) const
+    {
+      return d_slot != other.d_slot;
+    }
+
+   private:
+    void skipEmpty()
+    {
+      while (d_slot != d_end && d_slot->d_nv == NULL)
+      {
+        ++d_slot;
+      }
+    }
+    const Slot* d_slot;
+    const Slot* d_end;
+  }; /* class NodeValuePool::const_iterator */
+
+  NodeValuePool();
+
+  /** The number of NodeValues in the pool */
+  size_t size() const { return d_size; }
+
+  /** The number of slots of the table */
+  size_t capacity() const { return d_slots.size(); }
+
+  /**
+   * Find the pool entry equal (w.r.t. NodeValuePoolEq) to nv, or NULL if
+   * there is none.
+   */
+  NodeValue* find(const NodeValue* nv) const
+  {
+    return find(nv, nv->poolHash());
+  }
+
+  /** Like find(nv), where hash is nv->poolHash() */
+  inline NodeValue* find(const NodeValue* nv, size_t hash) const;
+
+  /** Insert nv, which must not be in the pool. */
+  void insert(NodeValue* nv) { insert(nv, nv->poolHash()); }
+
+  /** Like insert(nv), where hash is nv->poolHash() */
+  inline void insert(NodeValue* nv, size_t hash);
+
+  /** Remove nv, which must be in the pool. */
+  void erase(NodeValue* nv) { erase(nv, nv->poolHash()); }
+
+  /** Like erase(nv), where hash is nv->poolHash() */
+  inline void erase(NodeValue* nv, size_t hash);
+
+  const_iterator begin() const
+  {
+    return const_iterator(d_slots.data(), d_slots.data() + d_slots.size());
+  }
+  const_iterator end() const
+  {
+    const Slot* e = d_slots.data() + d_slots.size();
+    return const_iterator(e, e);
+  }
+
+ private:
+  /** Spread the bits of a pool hash and map it to its home slot */
+  size_t homeSlot(size_t hash) const
+  {
+    return static_cast<size_t>(
+        (static_cast<uint64_t>(hash) * UINT64_C(11400714819323198485))
+        >> d_shift);
+  }
+
+  /** The distance of the entry in slot i from its home slot */
+  size_t probeDistance(size_t i) const
+  {
+    return (i - homeSlot(d_slots[i].d_hash)) & d_mask;
+  }
+
+  /** Insert into a table known to have room and not to contain nv */
+  void insertNoGrow(size_t hash, NodeValue* nv);
+
+  /** Double the number of slots and reinsert all entries */
+  void grow();
+
+  /** The slots of the table, the size is a power of two */
+  std::vector<Slot> d_slots;
+  /** d_slots.size() - 1 */
+  size_t d_mask;
+  /** 64 - log2(d_slots.size()) */
+  unsigned d_shift;
+  /** The number of entries */
+  size_t d_size;
+}; /* class NodeValuePool */
+
+inline NodeValue* NodeValuePool::find(const NodeValue* nv, size_t hash) const
+{
+  NodeValuePoolEq eq;
+  for (size_t i = homeSlot(hash), dist = 0;; i = (i + 1) & d_mask, ++dist)
+  {
+    const Slot& s = d_slots[i];
+    // Robin Hood invariant: nv would have displaced an entry closer to
+    // its home slot
+    if (s.d_nv == NULL || probeDistance(i) < dist)
+    {
+      return NULL;
+    }
+    if (s.d_hash == hash && eq(s.d_nv, nv))
+    {
+      return s.d_nv;
+    }
+  }
+}
+
+inline void NodeValuePool::insert(NodeValue* nv, size_t hash)
+{
+  // keep the load factor below 7/8
+  if (__builtin_expect((d_size + 1) * 8 > d_slots.size() * 7, false))
+  {
+    grow();
+  }
+  insertNoGrow(hash, nv);
+  ++d_size;
+}
+
+inline void NodeValuePool::erase(NodeValue* nv, size_t hash)
+{
+  size_t i = homeSlot(hash);
+  while (d_slots[i].d_nv != nv)
+  {
+    Assert(d_slots[i].d_nv != NULL) << "NodeValue is not in the pool!";
+    i = (i + 1) & d_mask;
+  }
+  // shift the following displaced entries back by one slot
+  size_t next = (i + 1) & d_mask;
+  while (d_slots[next].d_nv != NULL && probeDistance(next) != 0)
+  {
+    d_slots[i] = d_slots[next];
+    i = next;
+    next = (next + 1) & d_mask;
+  }
+  d_slots[i].d_nv = NULL;
+  --d_size;
+}
+
+}  // namespace expr
+}  // namespace CVC4
+
+#endif /* CVC4__EXPR__NODE_VALUE_POOL_H */
@@ -117,23 +117,19 @@ void CommandExecutor::reset()
 
 bool CommandExecutor::doCommandSingleton(Command* cmd)
 {
-  bool status = true;
-  if(d_options.getVerbosity() >= -1) {
-    status = smtEngineInvoke(d_smtEngine, cmd, d_options.getOut());
-  } else {
-    status = smtEngineInvoke(d_smtEngine, cmd, NULL);
-  }
+  Command* resultCmd;
+  bool status = invokeCommand(cmd, resultCmd);
 
   Result res;
-  CheckSatCommand* cs = dynamic_cast<CheckSatCommand*>(cmd);
+  CheckSatCommand* cs = dynamic_cast<CheckSatCommand*>(resultCmd);
   if(cs != NULL) {
     d_result = res = cs->getResult();
   }
-  QueryCommand* q = dynamic_cast<QueryCommand*>(cmd);
+  QueryCommand* q = dynamic_cast<QueryCommand*>(resultCmd);
   if(q != NULL) {
     d_result = res = q->getResult();
   }
-  CheckSynthCommand* csy = dynamic_cast<CheckSynthCommand*>(cmd);
+  CheckSynthCommand* csy = dynamic_cast<CheckSynthCommand*>(resultCmd);
   if(csy != NULL) {
     d_result = res = csy->getResult();
   }
@@ -196,6 +192,15 @@ bool CommandExecutor::doCommandSingleton(Command* cmd)
   return status;
 }
 
+bool CommandExecutor::invokeCommand(Command* cmd, Command*& resultCmd)
+{
+  resultCmd = cmd;
+  if(d_options.getVerbosity() >= -1) {
+    return smtEngineInvoke(d_smtEngine, cmd, d_options.getOut());
+  }
+  return smtEngineInvoke(d_smtEngine, cmd, NULL);
+}
+
 bool smtEngineInvoke(SmtEngine* smt, Command* cmd, std::ostream *out)
 {
   if(out == NULL) {
@@ -93,6 +93,13 @@ protected:
   /** Executes treating cmd as a singleton */
   virtual bool doCommandSingleton(CVC4::Command* cmd);
 
+  /**
+   * Invokes cmd, which is not a command sequence, and returns whether it
+   * succeeded.  Sets resultCmd to the command that holds the result of the
+   * invocation: cmd itself, unless a copy of cmd was invoked instead.
+   */
+  virtual bool invokeCommand(CVC4::Command* cmd, CVC4::Command*& resultCmd);
+
 private:
   CommandExecutor();
 
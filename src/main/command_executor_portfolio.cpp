@@ -0,0 +1,707 @@
+/*********************                                                        */
+/*! \file command_executor_portfolio.cpp
+ ** \verbatim
+ ** Top contributors (to current version):
+ **
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2019 by the authors listed in the file AUTHORS
+ ** in the top-level source directory) and their institutional affiliations.
+ ** All rights reserved.  See the file COPYING in the top-level source
+ ** directory for licensing information.\endverbatim
+ **
+ ** \brief An additional layer between commands and invoking them, running
+ ** a portfolio of solver instances.
+ **
+ ** An additional layer between commands and invoking them, running a
+ ** portfolio of differently configured solver instances on separate threads
+ ** (see --portfolio).
+ **/
+
+#include "main/command_executor_portfolio.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "api/cvc4cpp.h"
+#include "base/modal_exception.h"
+#include "base/output.h"
+#include "expr/expr.h"
+#include "options/option_exception.h"
+#include "smt/command.h"
+#include "smt/smt_engine.h"
+#include "util/clause_exchange.h"
+#include "util/result.h"
+
+namespace CVC4 {
+namespace main {
+
+namespace {
+
+/**
+ * The configurations of the workers the user did not configure with
+ * --threadN, used round-robin.  Each worker also gets its own random seed.
+ */
+const char* s_defaultConfigs[] = {
+    "--decision=justification",
+    "--simplification=none",
+    "--random-freq=0.02",
+    "--restart-int-base=100",
+};
+const size_t s_numDefaultConfigs =
+    sizeof(s_defaultConfigs) / sizeof(s_defaultConfigs[0]);
+
+/** Whether cmd is raced between the instances */
+bool isRace(Command* cmd)
+{
+  return dynamic_cast<CheckSatCommand*>(cmd) != NULL
+         || dynamic_cast<CheckSatAssumingCommand*>(cmd) != NULL
+         || dynamic_cast<QueryCommand*>(cmd) != NULL;
+}
+
+/** Whether cmd refers to the result of the last race */
+bool needsWinner(Command* cmd)
+{
+  return dynamic_cast<GetValueCommand*>(cmd) != NULL
+         || dynamic_cast<GetAssignmentCommand*>(cmd) != NULL
+         || dynamic_cast<GetModelCommand*>(cmd) != NULL
+         || dynamic_cast<BlockModelCommand*>(cmd) != NULL
+         || dynamic_cast<BlockModelValuesCommand*>(cmd) != NULL
+         || dynamic_cast<GetProofCommand*>(cmd) != NULL
+         || dynamic_cast<GetInstantiationsCommand*>(cmd) != NULL
+         || dynamic_cast<GetUnsatAssumptionsCommand*>(cmd) != NULL
+         || dynamic_cast<GetUnsatCoreCommand*>(cmd) != NULL;
+}
+
+/**
+ * Whether cmd only prints something and does not change the state of the
+ * instance it is invoked on
+ */
+bool isOutputOnly(Command* cmd)
+{
+  return dynamic_cast<EchoCommand*>(cmd) != NULL
+         || dynamic_cast<CommentCommand*>(cmd) != NULL
+         || dynamic_cast<GetInfoCommand*>(cmd) != NULL
+         || dynamic_cast<GetOptionCommand*>(cmd) != NULL
+         || dynamic_cast<GetAssertionsCommand*>(cmd) != NULL
+         || dynamic_cast<SimplifyCommand*>(cmd) != NULL
+         || dynamic_cast<ExpandDefinitionsCommand*>(cmd) != NULL
+         || dynamic_cast<CheckSynthCommand*>(cmd) != NULL
+         || dynamic_cast<GetSynthSolutionCommand*>(cmd) != NULL
+         || dynamic_cast<GetAbductCommand*>(cmd) != NULL
+         || dynamic_cast<GetQuantifierEliminationCommand*>(cmd) != NULL;
+}
+
+/** The result of a raced command, unknown if it has not run */
+Result getRaceResult(Command* cmd)
+{
+  if (CheckSatCommand* cs = dynamic_cast<CheckSatCommand*>(cmd))
+  {
+    return cs->getResult();
+  }
+  if (CheckSatAssumingCommand* csa = dynamic_cast<CheckSatAssumingCommand*>(cmd))
+  {
+    return csa->getResult();
+  }
+  if (QueryCommand* q = dynamic_cast<QueryCommand*>(cmd))
+  {
+    return q->getResult();
+  }
+  return Result();
+}
+
+/** Print the result of cmd like Command::invoke(SmtEngine*, std::ostream&) */
+void printCommandResult(Command* cmd,
+                        bool muted,
+                        SmtEngine* smt,
+                        std::ostream& out)
+{
+  if (!(muted && cmd->ok()))
+  {
+    cmd->printResult(
+        out,
+        smt->getOption("command-verbosity:" + cmd->getCommandName())
+            .getIntegerValue()
+            .toUnsignedInt());
+  }
+}
+
+}  // namespace
+
+CommandExecutorPortfolio::Worker::Worker(const Options& options,
+                                         unsigned index)
+    : d_index(index)
+{
+  d_options.copyValues(options);
+  addInstanceOptions(d_options, index);
+  d_solver.reset(new api::Solver(&d_options));
+}
+
+CommandExecutorPortfolio::CommandExecutorPortfolio(api::Solver* solver,
+                                                   Options& options)
+    : CommandExecutor(solver, options),
+      d_lastWinner(0),
+      d_pinned(false),
+      d_statRaces("portfolio::races", 0),
+      d_statWinner("portfolio::winner"),
+      d_statRaceTime("portfolio::raceTime"),
+      d_statCubes("portfolio::cubes", 0),
+      d_statCubeTime("portfolio::cubeTime")
+{
+  for (unsigned i = 1; i < options.getPortfolio(); ++i)
+  {
+    d_workers.emplace_back(new Worker(options, i));
+  }
+  d_stats.registerStat(&d_statRaces);
+  d_stats.registerStat(&d_statWinner);
+  d_stats.registerStat(&d_statRaceTime);
+  d_stats.registerStat(&d_statCubes);
+  d_stats.registerStat(&d_statCubeTime);
+}
+
+CommandExecutorPortfolio::~CommandExecutorPortfolio()
+{
+  d_stats.unregisterStat(&d_statRaces);
+  d_stats.unregisterStat(&d_statWinner);
+  d_stats.unregisterStat(&d_statRaceTime);
+  d_stats.unregisterStat(&d_statCubes);
+  d_stats.unregisterStat(&d_statCubeTime);
+}
+
+void CommandExecutorPortfolio::addInstanceOptions(Options& options,
+                                                  unsigned index)
+{
+  const std::vector<std::string>& threadArgv = options.getThreadArgv();
+  std::string args;
+  if (index < threadArgv.size() && !threadArgv[index].empty())
+  {
+    args = threadArgv[index];
+  }
+  else if (index > 0)
+  {
+    std::stringstream ss;
+    ss << s_defaultConfigs[(index - 1) % s_numDefaultConfigs]
+       << " --random-seed=" << index;
+    args = ss.str();
+  }
+
+  // split the options at whitespace, as a shell would without quoting
+  std::istringstream iss(args);
+  std::vector<std::string> words((std::istream_iterator<std::string>(iss)),
+                                 std::istream_iterator<std::string>());
+  if (options.getCubes() > 0 && options.getPortfolio() > 1
+      && !options.getProof())
+  {
+    // the cubes are solved as assumptions
+    words.insert(words.begin(), "--incremental");
+  }
+  if (words.empty())
+  {
+    return;
+  }
+  std::string binaryName = options.getBinaryName();
+  std::vector<char*> argv;
+  argv.push_back(&binaryName[0]);
+  for (std::string& w : words)
+  {
+    argv.push_back(&w[0]);
+  }
+  argv.push_back(NULL);
+  std::vector<std::string> nonoptions =
+      Options::parseOptions(&options, argv.size() - 1, argv.data());
+  if (!nonoptions.empty())
+  {
+    std::stringstream ss;
+    ss << "--thread" << index << " takes only options, but got `"
+       << nonoptions[0] << "'";
+    throw OptionException(ss.str());
+  }
+}
+
+bool CommandExecutorPortfolio::invokeCommand(Command* cmd,
+                                             Command*& resultCmd)
+{
+  d_copies.clear();
+  d_dropped.clear();
+  resultCmd = cmd;
+  std::ostream* out =
+      d_options.getVerbosity() >= -1 ? d_options.getOut() : NULL;
+
+  if (d_pinned || needsWinner(cmd))
+  {
+    return invokeOnWinner(cmd, out, resultCmd);
+  }
+  if (d_workers.empty() || isOutputOnly(cmd))
+  {
+    return smtEngineInvoke(d_smtEngine, cmd, out);
+  }
+  if (d_options.getCubes() > 0 && dynamic_cast<CheckSatCommand*>(cmd) != NULL
+      && dynamic_cast<CheckSatCommand*>(cmd)->getExpr().isNull())
+  {
+    return invokeCubes(cmd, out, resultCmd);
+  }
+  if (isRace(cmd))
+  {
+    return invokeRace(cmd, out, resultCmd);
+  }
+  if (dynamic_cast<ResetCommand*>(cmd) != NULL
+      || dynamic_cast<ResetAssertionsCommand*>(cmd) != NULL)
+  {
+    // the shared clauses not imported yet follow from the old assertions
+    ClauseExchange* exchange = d_options.getClauseExchange();
+    if (exchange != NULL)
+    {
+      exchange->clear();
+    }
+  }
+  bool status = invokeOnAll(cmd, out);
+  if (dynamic_cast<ResetCommand*>(cmd) != NULL)
+  {
+    d_lastWinner = 0;
+  }
+  return status;
+}
+
+Command* CommandExecutorPortfolio::exportCommand(Command* cmd, Worker& w)
+{
+  try
+  {
+    Command* copy = cmd->exportTo(w.d_solver->getExprManager(),
+                                  w.d_variableMap);
+    d_copies.emplace_back(copy);
+    return copy;
+  }
+  catch (ExportUnsupportedException& e)
+  {
+    Notice() << "portfolio: can't export `" << cmd->getCommandName()
+             << "' to instance " << w.d_index << ": " << e.getMessage()
+             << std::endl;
+    return NULL;
+  }
+}
+
+CommandExecutorPortfolio::Worker* CommandExecutorPortfolio::getWorker(
+    size_t index)
+{
+  for (std::unique_ptr<Worker>& w : d_workers)
+  {
+    if (w->d_index == index)
+    {
+      return w.get();
+    }
+  }
+  return NULL;
+}
+
+template <class Pred>
+void CommandExecutorPortfolio::dropWorkers(Pred keep, const std::string& why)
+{
+  std::vector<std::unique_ptr<Worker>> kept;
+  for (std::unique_ptr<Worker>& w : d_workers)
+  {
+    if (keep(*w))
+    {
+      kept.push_back(std::move(w));
+    }
+    else
+    {
+      Notice() << "portfolio: dropping instance " << w->d_index << ", " << why
+               << std::endl;
+      d_dropped.push_back(std::move(w));
+    }
+  }
+  d_workers.swap(kept);
+}
+
+bool CommandExecutorPortfolio::invokeOnAll(Command* cmd, std::ostream* out)
+{
+  std::vector<Command*> copies;
+  for (std::unique_ptr<Worker>& w : d_workers)
+  {
+    copies.push_back(exportCommand(cmd, *w));
+    if (copies.back() == NULL)
+    {
+      dropWorkers([](const Worker&) { return false; },
+                  "a command can't be exported");
+      return smtEngineInvoke(d_smtEngine, cmd, out);
+    }
+  }
+
+  bool status = smtEngineInvoke(d_smtEngine, cmd, out);
+  std::vector<bool> failed(d_workers.size(), false);
+  for (size_t i = 0; i < d_workers.size(); ++i)
+  {
+    SmtEngine* smt = d_workers[i]->d_solver->getSmtEngine();
+    failed[i] = !smtEngineInvoke(smt, copies[i], NULL) && status;
+  }
+  if (status)
+  {
+    size_t i = 0;
+    dropWorkers([&](const Worker&) { return !failed[i++]; },
+                "it failed on `" + cmd->getCommandName() + "'");
+  }
+  return status;
+}
+
+bool CommandExecutorPortfolio::invokeRace(Command* cmd,
+                                          std::ostream* out,
+                                          Command*& resultCmd)
+{
+  // the instances taking part, entry 0 is instance 0
+  std::vector<SmtEngine*> engines(1, d_smtEngine);
+  std::vector<Command*> cmds(1, cmd);
+  for (std::unique_ptr<Worker>& w : d_workers)
+  {
+    Command* copy = exportCommand(cmd, *w);
+    if (copy == NULL)
+    {
+      dropWorkers([](const Worker&) { return false; },
+                  "a command can't be exported");
+      return smtEngineInvoke(d_smtEngine, cmd, out);
+    }
+    engines.push_back(w->d_solver->getSmtEngine());
+    cmds.push_back(copy);
+  }
+
+  ++d_statRaces;
+  TimerStat::CodeTimer raceTimer(d_statRaceTime);
+  size_t n = engines.size();
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<bool> done(n, false);
+  std::vector<bool> status(n, false);
+  std::vector<std::exception_ptr> errors(n);
+  size_t numDone = 0;
+  size_t winner = n;
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < n; ++i)
+  {
+    threads.emplace_back([&, i]() {
+      bool st = false;
+      try
+      {
+        st = smtEngineInvoke(engines[i], cmds[i], NULL);
+      }
+      catch (...)
+      {
+        errors[i] = std::current_exception();
+      }
+      std::lock_guard<std::mutex> lock(mutex);
+      status[i] = st;
+      done[i] = true;
+      ++numDone;
+      if (winner == n && st && !getRaceResult(cmds[i]).isUnknown())
+      {
+        winner = i;
+      }
+      cv.notify_all();
+    });
+  }
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&]() { return winner < n || numDone == n; });
+    // An interrupt that arrives before an instance has started its search
+    // is lost, so repeat it until every instance has stopped.
+    while (numDone < n)
+    {
+      for (size_t i = 0; i < n; ++i)
+      {
+        if (!done[i])
+        {
+          engines[i]->interrupt();
+        }
+      }
+      cv.wait_for(lock, std::chrono::milliseconds(10));
+    }
+  }
+  for (std::thread& t : threads)
+  {
+    t.join();
+  }
+
+  if (errors[0])
+  {
+    std::rethrow_exception(errors[0]);
+  }
+  if (winner == n)
+  {
+    // no definitive result, report the one of instance 0
+    winner = 0;
+  }
+  d_lastWinner = winner == 0 ? 0 : d_workers[winner - 1]->d_index;
+  d_statWinner << d_lastWinner;
+  Trace("portfolio") << "portfolio: instance " << d_lastWinner << " answered `"
+                     << cmd->getCommandName() << "' with "
+                     << getRaceResult(cmds[winner]) << std::endl;
+
+  resultCmd = cmds[winner];
+  if (out != NULL)
+  {
+    printCommandResult(cmds[winner], cmd->isMuted(), engines[winner], *out);
+  }
+  bool winnerStatus = status[winner];
+
+  // drop the workers that broke down, the result they are asked about next
+  // would be meaningless
+  size_t i = 1;
+  dropWorkers(
+      [&](const Worker&) {
+        size_t j = i++;
+        return !errors[j] && (status[j] || !status[0]);
+      },
+      "it failed on `" + cmd->getCommandName() + "'");
+  return winnerStatus;
+}
+
+bool CommandExecutorPortfolio::invokeCubes(Command* cmd,
+                                           std::ostream* out,
+                                           Command*& resultCmd)
+{
+  if (d_smtEngine->getOption("incremental").getValue() != "true"
+      || d_smtEngine->getOption("produce-unsat-cores").getValue() == "true")
+  {
+    // an unsat core under a cube is no unsat core of the assertions
+    return invokeRace(cmd, out, resultCmd);
+  }
+  std::vector<std::vector<Expr>> cubes;
+  try
+  {
+    cubes = d_smtEngine->getCubes(d_options.getCubes());
+  }
+  catch (ModalException& e)
+  {
+    Notice() << "portfolio: can't split into cubes: " << e.getMessage()
+             << std::endl;
+  }
+  if (cubes.size() <= 1)
+  {
+    return invokeRace(cmd, out, resultCmd);
+  }
+
+  // the commands solving the cubes, by instance, entry 0 is instance 0.
+  // Exprs can't be exported concurrently, so they are all exported here.
+  std::vector<SmtEngine*> engines(1, d_smtEngine);
+  std::vector<std::vector<Command*>> cmds(1);
+  for (const std::vector<Expr>& cube : cubes)
+  {
+    Expr conj = cube.size() == 1 ? cube[0]
+                                 : d_smtEngine->getExprManager()->mkExpr(
+                                       kind::AND, cube);
+    d_copies.emplace_back(new CheckSatCommand(conj));
+    cmds[0].push_back(d_copies.back().get());
+  }
+  for (std::unique_ptr<Worker>& w : d_workers)
+  {
+    engines.push_back(w->d_solver->getSmtEngine());
+    cmds.emplace_back();
+    for (Command* c : cmds[0])
+    {
+      Command* copy = exportCommand(c, *w);
+      if (copy == NULL)
+      {
+        dropWorkers([](const Worker&) { return false; },
+                    "a command can't be exported");
+        return smtEngineInvoke(d_smtEngine, cmd, out);
+      }
+      cmds.back().push_back(copy);
+    }
+  }
+
+  ++d_statRaces;
+  TimerStat::CodeTimer raceTimer(d_statRaceTime);
+  size_t n = engines.size();
+  size_t m = cubes.size();
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<size_t> pending;
+  for (size_t c = 0; c < m; ++c)
+  {
+    pending.push_back(c);
+  }
+  // the instance solving each cube, n if none has
+  std::vector<size_t> solvedBy(m, n);
+  std::vector<bool> running(n, false);
+  std::vector<bool> status(n, true);
+  std::vector<std::exception_ptr> errors(n);
+  size_t numDone = 0;
+  size_t numSolved = 0;
+  // a satisfiable, an unknown and an unsatisfiable cube, m if there is none
+  size_t winner = m;
+  size_t unknown = m;
+  size_t unsat = m;
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < n; ++i)
+  {
+    threads.emplace_back([&, i]() {
+      std::unique_lock<std::mutex> lock(mutex);
+      while (winner == m && !pending.empty())
+      {
+        size_t c = pending.front();
+        pending.pop_front();
+        running[i] = true;
+        lock.unlock();
+        bool st = false;
+        std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+        try
+        {
+          st = smtEngineInvoke(engines[i], cmds[i][c], NULL);
+        }
+        catch (...)
+        {
+          errors[i] = std::current_exception();
+        }
+        std::chrono::duration<double> time =
+            std::chrono::steady_clock::now() - start;
+        lock.lock();
+        running[i] = false;
+        Result r = getRaceResult(cmds[i][c]);
+        if (!st || errors[i])
+        {
+          // leave the cube to the others
+          status[i] = false;
+          pending.push_back(c);
+          break;
+        }
+        Notice() << "portfolio: cube " << c << " (" << cubes[c].size()
+                 << " literals) " << r << " in " << time.count()
+                 << "s on instance "
+                 << (i == 0 ? 0 : d_workers[i - 1]->d_index) << std::endl;
+        ++d_statCubes;
+        d_statCubeTime.addEntry(time.count());
+        solvedBy[c] = i;
+        ++numSolved;
+        if (r.asSatisfiabilityResult().isSat() == Result::SAT)
+        {
+          winner = winner == m ? c : winner;
+        }
+        else if (r.isUnknown())
+        {
+          unknown = unknown == m ? c : unknown;
+        }
+        else
+        {
+          unsat = c;
+        }
+      }
+      ++numDone;
+      cv.notify_all();
+    });
+  }
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&]() { return winner < m || numDone == n; });
+    // An interrupt that arrives before an instance has started its search
+    // is lost, so repeat it until every instance has stopped.
+    while (numDone < n)
+    {
+      for (size_t i = 0; i < n; ++i)
+      {
+        if (running[i])
+        {
+          engines[i]->interrupt();
+        }
+      }
+      cv.wait_for(lock, std::chrono::milliseconds(10));
+    }
+  }
+  for (std::thread& t : threads)
+  {
+    t.join();
+  }
+
+  if (errors[0])
+  {
+    std::rethrow_exception(errors[0]);
+  }
+  if (numSolved < m && winner == m)
+  {
+    // the instances failed on some cubes, solve the check-sat as a whole
+    Notice() << "portfolio: " << m - numSolved
+             << " cubes unsolved, racing the instances instead" << std::endl;
+    size_t i = 1;
+    dropWorkers([&](const Worker&) { return status[i++]; },
+                "it failed on `" + cmd->getCommandName() + "'");
+    return invokeRace(cmd, out, resultCmd);
+  }
+
+  // the problem is sat if a cube is, unsat if all are
+  size_t c = winner < m ? winner : (unknown < m ? unknown : unsat);
+  size_t e = solvedBy[c];
+  d_lastWinner = e == 0 ? 0 : d_workers[e - 1]->d_index;
+  d_statWinner << d_lastWinner;
+  Trace("portfolio") << "portfolio: instance " << d_lastWinner
+                     << " answered cube " << c << " with "
+                     << getRaceResult(cmds[e][c]) << std::endl;
+
+  resultCmd = cmds[e][c];
+  if (out != NULL)
+  {
+    printCommandResult(cmds[e][c], cmd->isMuted(), engines[e], *out);
+  }
+
+  // drop the workers that broke down, but not e, it holds the result
+  size_t i = 1;
+  dropWorkers(
+      [&](const Worker&) {
+        size_t j = i++;
+        return status[j] || j == e;
+      },
+      "it failed on `" + cmd->getCommandName() + "'");
+  return true;
+}
+
+bool CommandExecutorPortfolio::invokeOnWinner(Command* cmd,
+                                              std::ostream* out,
+                                              Command*& resultCmd)
+{
+  Worker* w = getWorker(d_lastWinner);
+  bool status;
+  if (w == NULL)
+  {
+    status = smtEngineInvoke(d_smtEngine, cmd, out);
+  }
+  else
+  {
+    Command* copy = exportCommand(cmd, *w);
+    if (copy == NULL)
+    {
+      // the result of the last race is only known to the winner
+      throw Exception("portfolio: can't export `" + cmd->getCommandName()
+                      + "' to the instance that answered the last check");
+    }
+    status = smtEngineInvoke(w->d_solver->getSmtEngine(), copy, out);
+    resultCmd = copy;
+  }
+
+  if (dynamic_cast<BlockModelCommand*>(cmd) != NULL
+      || dynamic_cast<BlockModelValuesCommand*>(cmd) != NULL)
+  {
+    // Only the winner has a model to block, so it is the only instance
+    // with the current assertions from now on.
+    if (w == NULL)
+    {
+      dropWorkers([](const Worker&) { return false; },
+                  "only instance 0 has blocked the model");
+    }
+    else if (!d_pinned)
+    {
+      Notice() << "portfolio: only instance " << d_lastWinner
+               << " has blocked the model, continuing with it alone"
+               << std::endl;
+      d_pinned = true;
+    }
+  }
+  return status;
+}
+
+}  // namespace main
+}  // namespace CVC4
@@ -0,0 +1,172 @@
+/*********************                                                        */
+/*! \file command_executor_portfolio.h
+ ** \verbatim
+ ** Top contributors (to current version):
+ **
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2019 by the authors listed in the file AUTHORS
+ ** in the top-level source directory) and their institutional affiliations.
+ ** All rights reserved.  See the file COPYING in the top-level source
+ ** directory for licensing information.\endverbatim
+ **
+ ** \brief An additional layer between commands and invoking them, running
+ ** a portfolio of solver instances.
+ **
+ ** An additional layer between commands and invoking them, running a
+ ** portfolio of differently configured solver instances on separate threads
+ ** (see --portfolio).
+ **/
+
+#ifndef CVC4__MAIN__COMMAND_EXECUTOR_PORTFOLIO_H
+#define CVC4__MAIN__COMMAND_EXECUTOR_PORTFOLIO_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "expr/variable_type_map.h"
+#include "main/command_executor.h"
+#include "options/options.h"
+#include "util/statistics_registry.h"
+
+namespace CVC4 {
+
+namespace api {
+class Solver;
+}
+
+namespace main {
+
+/**
+ * A command executor for --portfolio=N.
+ *
+ * Instance 0 of the portfolio is the solver the commands are parsed into.
+ * Instances 1 to N-1 are workers, each with its own ExprManager and
+ * SmtEngine, configured with the options of the command line followed by
+ * the options given with --threadN (or a built-in configuration if there
+ * are none).  Every command is exported to the workers and replayed there,
+ * except for the following:
+ *
+ * - check-sat, check-sat-assuming and query commands are raced: they are
+ *   invoked on all instances in parallel, the first definitive result is
+ *   reported and the other instances are interrupted.
+ * - Commands that inspect the last result (get-model, get-value, ...) are
+ *   only invoked on the instance that answered the last race.
+ * - Commands that only print something (echo, get-info, ...) are only
+ *   invoked on instance 0.
+ *
+ * During a race the instances share short learnt clauses through the
+ * ClauseExchange set in the options (see prop::TheoryProxy).
+ *
+ * With --cubes=K, a check-sat is not raced but split: instance 0 splits the
+ * search space into K cubes by lookahead (see SmtEngine::getCubes()), and
+ * the instances solve the assertions under one cube at a time until one of
+ * them is satisfiable or all are unsatisfiable.  The instances are
+ * incremental then, so that the cubes can be assumed.
+ *
+ * If a command cannot be exported, or a worker fails on a command that
+ * instance 0 accepted, the affected workers are dropped and solving
+ * continues with the remaining instances.
+ */
+class CommandExecutorPortfolio : public CommandExecutor
+{
+ public:
+  CommandExecutorPortfolio(api::Solver* solver, Options& options);
+  ~CommandExecutorPortfolio();
+
+  /**
+   * Add the options given with --thread<index> to options.  Instance 0 is
+   * created by the driver, which calls this before creating it.
+   */
+  static void addInstanceOptions(Options& options, unsigned index);
+
+ protected:
+  bool invokeCommand(CVC4::Command* cmd, CVC4::Command*& resultCmd) override;
+
+ private:
+  /** A solver instance of the portfolio other than instance 0 */
+  struct Worker
+  {
+    Worker(const Options& options, unsigned index);
+
+    /** The index of this instance in the portfolio */
+    unsigned d_index;
+    /** The options of this instance */
+    Options d_options;
+    /** The solver of this instance */
+    std::unique_ptr<api::Solver> d_solver;
+    /**
+     * The map between the variables of instance 0 and this instance.  It
+     * holds Exprs of both, so it must be destroyed before d_solver.
+     */
+    ExprManagerMapCollection d_variableMap;
+  };
+
+  /** The worker that is instance index, NULL if there is none. */
+  Worker* getWorker(size_t index);
+
+  /** Export cmd to worker w, return NULL if it can't be exported. */
+  Command* exportCommand(Command* cmd, Worker& w);
+
+  /**
+   * Invoke cmd on instance 0 and a copy of it on every worker, only
+   * instance 0 prints to out.
+   */
+  bool invokeOnAll(Command* cmd, std::ostream* out);
+
+  /** Race cmd (a check) on all instances, see invokeCommand(). */
+  bool invokeRace(Command* cmd, std::ostream* out, Command*& resultCmd);
+
+  /**
+   * Solve cmd (a check-sat) by splitting it into cubes, see --cubes.  Falls
+   * back to invokeRace() if it can't be split.
+   */
+  bool invokeCubes(Command* cmd, std::ostream* out, Command*& resultCmd);
+
+  /** Invoke cmd on the instance that answered the last race. */
+  bool invokeOnWinner(Command* cmd, std::ostream* out, Command*& resultCmd);
+
+  /**
+   * Drop the workers not satisfying keep, explaining why in a notice.  They
+   * are destroyed with the copies of the current command.
+   */
+  template <class Pred>
+  void dropWorkers(Pred keep, const std::string& why);
+
+  /** The workers, instances 1 to N-1 */
+  std::vector<std::unique_ptr<Worker>> d_workers;
+
+  /** The dropped workers, kept while d_copies may refer to them */
+  std::vector<std::unique_ptr<Worker>> d_dropped;
+
+  /** The index of the instance that answered the last race */
+  size_t d_lastWinner;
+
+  /**
+   * Whether all commands go to d_lastWinner only, because it is the only
+   * instance holding the current assertions (e.g. after block-model)
+   */
+  bool d_pinned;
+
+  /**
+   * The copies of the current command invoked on workers.  They hold Exprs
+   * of the workers, so they are declared after them to be destroyed first.
+   */
+  std::vector<std::unique_ptr<Command>> d_copies;
+
+  /** The number of races */
+  IntStat d_statRaces;
+  /** How often each instance answered a race */
+  HistogramStat<uint64_t> d_statWinner;
+  /** Time spent in races */
+  TimerStat d_statRaceTime;
+  /** The number of cubes solved */
+  IntStat d_statCubes;
+  /** The average time to solve a cube, in seconds */
+  AverageStat d_statCubeTime;
+}; /* class CommandExecutorPortfolio */
+
+}  // namespace main
+}  // namespace CVC4
+
+#endif /* CVC4__MAIN__COMMAND_EXECUTOR_PORTFOLIO_H */
@@ -30,6 +30,7 @@
 #include "expr/expr_iomanip.h"
 #include "expr/expr_manager.h"
 #include "main/command_executor.h"
+#include "main/command_executor_portfolio.h"
 #include "main/interactive_shell.h"
 #include "main/main.h"
 #include "options/options.h"
@@ -38,6 +39,7 @@
 #include "parser/parser_builder.h"
 #include "parser/parser_exception.h"
 #include "smt/command.h"
+#include "util/clause_exchange.h"
 #include "util/result.h"
 #include "util/statistics_registry.h"
 
@@ -181,10 +183,38 @@ int runCvc4(int argc, char* argv[], Options& opts) {
   // important even for muzzled builds (to get result output right)
   (*(opts.getOut())) << language::SetLanguage(opts.getOutputLanguage());
 
+  const bool portfolio = opts.getPortfolio() > 1;
+  if (portfolio)
+  {
+    if (opts.getTearDownIncremental() > 0)
+    {
+      throw OptionException(
+          "--tear-down-incremental doesn't work with --portfolio");
+    }
+    // instance 0 of the portfolio is the solver the commands are parsed into
+    CommandExecutorPortfolio::addInstanceOptions(opts, 0);
+  }
+
+  // The instances of the portfolio share learnt clauses through this, so it
+  // must outlive all of them.
+  std::unique_ptr<ClauseExchange> clauseExchange;
+  if (portfolio)
+  {
+    clauseExchange.reset(new ClauseExchange());
+    opts.setClauseExchange(clauseExchange.get());
+  }
+
   // Create the expression manager using appropriate options
   std::unique_ptr<api::Solver> solver;
   solver.reset(new api::Solver(&opts));
-  pExecutor = new CommandExecutor(solver.get(), opts);
+  if (portfolio)
+  {
+    pExecutor = new CommandExecutorPortfolio(solver.get(), opts);
+  }
+  else
+  {
+    pExecutor = new CommandExecutor(solver.get(), opts);
+  }
 
   std::unique_ptr<Parser> replayParser;
   if (opts.getReplayInputFilename() != "")
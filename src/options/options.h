@@ -33,6 +33,8 @@
 
 namespace CVC4 {
 
+class ClauseExchange;
+
 namespace api {
 class Solver;
 }
@@ -233,12 +235,17 @@ public:
   std::string getBinaryName() const;
   std::string getReplayInputFilename() const;
   unsigned getParseStep() const;
+  unsigned getPortfolio() const;
+  unsigned getCubes() const;
+  const std::vector<std::string>& getThreadArgv() const;
+  ClauseExchange* getClauseExchange() const;
 
   // TODO: Document these.
   void setInputLanguage(InputLanguage);
   void setInteractive(bool);
   void setOut(std::ostream*);
   void setOutputLanguage(OutputLanguage);
+  void setClauseExchange(ClauseExchange*);
 
   bool wasSetByUserCeGuidedInst() const;
   bool wasSetByUserDumpSynth() const;
@@ -35,6 +35,7 @@
 #include "options/didyoumean.h"
 #include "options/language.h"
 #include "options/option_exception.h"
+#include "options/prop_options.h"
 #include "options/smt_options.h"
 #include "options/theory_options.h"
 
@@ -244,6 +245,32 @@ void OptionsHandler::setBitblastAig(std::string option, bool arg)
   }
 }
 
+// prop/options_handlers.h
+void OptionsHandler::checkPropSatSolver(std::string option,
+                                        PropSatSolverMode m)
+{
+  if (m != PropSatSolverMode::CADICAL)
+  {
+    return;
+  }
+  if (!Configuration::isBuiltWithCadical())
+  {
+    std::stringstream ss;
+    ss << "option `" << option
+       << "' requires a CaDiCaL build of CVC4; this binary was not built with "
+          "CaDiCaL support";
+    throw OptionException(ss.str());
+  }
+  if (!Configuration::isBuiltWithCadicalPropagator())
+  {
+    std::stringstream ss;
+    ss << "option `" << option
+       << "' requires CaDiCaL 2.0 or later (with the external propagator "
+          "interface); this binary was built against an older CaDiCaL";
+    throw OptionException(ss.str());
+  }
+}
+
 // theory/options_handlers.h
 std::string OptionsHandler::handleUseTheoryList(std::string option, std::string optarg) {
   std::string currentList = options::useTheoryList();
@@ -472,6 +499,8 @@ void OptionsHandler::showConfiguration(std::string option) {
   print_config_cond("cln", Configuration::isBuiltWithCln());
   print_config_cond("glpk", Configuration::isBuiltWithGlpk());
   print_config_cond("cadical", Configuration::isBuiltWithCadical());
+  print_config_cond("cadical-propagator",
+                    Configuration::isBuiltWithCadicalPropagator());
   print_config_cond("cryptominisat", Configuration::isBuiltWithCryptominisat());
   print_config_cond("drat2er", Configuration::isBuiltWithDrat2Er());
   print_config_cond("gmp", Configuration::isBuiltWithGmp());
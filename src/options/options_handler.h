@@ -30,6 +30,7 @@
 #include "options/option_exception.h"
 #include "options/options.h"
 #include "options/printer_modes.h"
+#include "options/prop_options.h"
 #include "options/quantifiers_options.h"
 
 namespace CVC4 {
@@ -74,6 +75,9 @@ public:
 
   void setBitblastAig(std::string option, bool arg);
 
+  // prop/options_handlers.h
+  void checkPropSatSolver(std::string option, PropSatSolverMode m);
+
   // theory/options_handlers.h
   void notifyUseTheoryList(std::string option);
   std::string handleUseTheoryList(std::string option, std::string optarg);
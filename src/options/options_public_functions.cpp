@@ -32,6 +32,7 @@
 #include "options/parser_options.h"
 #include "options/printer_modes.h"
 #include "options/printer_options.h"
+#include "options/prop_options.h"
 #include "options/quantifiers_options.h"
 #include "options/smt_options.h"
 #include "options/uf_options.h"
@@ -195,6 +196,22 @@ unsigned Options::getParseStep() const{
   return (*this)[options::parseStep];
 }
 
+unsigned Options::getPortfolio() const{
+  return (*this)[options::portfolio];
+}
+
+unsigned Options::getCubes() const{
+  return (*this)[options::cubes];
+}
+
+const std::vector<std::string>& Options::getThreadArgv() const{
+  return (*this)[options::threadArgv];
+}
+
+ClauseExchange* Options::getClauseExchange() const{
+  return (*this)[options::satClauseExchange];
+}
+
 std::ostream* Options::currentGetOut() {
   return current()->getOut();
 }
@@ -218,6 +235,10 @@ void Options::setOutputLanguage(OutputLanguage value) {
   set(options::outputLanguage, value);
 }
 
+void Options::setClauseExchange(ClauseExchange* value) {
+  set(options::satClauseExchange, value);
+}
+
 bool Options::wasSetByUserCeGuidedInst() const {
   return wasSetByUser(options::ceGuidedInst);
 }
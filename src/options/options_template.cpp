@@ -39,6 +39,7 @@ extern int optreset;
 #include <stdint.h>
 #include <time.h>
 
+#include <cctype>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -47,6 +48,7 @@ extern int optreset;
 #include <string>
 #include <sstream>
 #include <limits>
+#include <vector>
 
 #include "base/check.h"
 #include "base/exception.h"
@@ -733,6 +735,43 @@ ${options_handler}$
 
     case '?':
     default:
+      // --threadN=OPTIONS and --threadN OPTIONS give the options of the Nth
+      // solver instance of a portfolio (see --portfolio)
+      if (option.compare(0, 8, "--thread") == 0 && option.size() > 8)
+      {
+        char* end;
+        unsigned long tnum = strtoul(option.c_str() + 8, &end, 10);
+        if (!isdigit(option[8]) || (*end != '\0' && *end != '='))
+        {
+          throw OptionException(formatThreadOptionException(option));
+        }
+        std::string targs;
+        if (*end == '=')
+        {
+          targs = end + 1;
+        }
+        else
+        {
+          if (main_optind >= argc)
+          {
+            throw OptionException(formatThreadOptionException(option));
+          }
+          targs = argv[main_optind];
+          ++main_optind;
+          extender->popFrontArgument();
+        }
+        std::vector<std::string>& threadArgv = options->d_holder->threadArgv;
+        if (threadArgv.size() <= tnum)
+        {
+          threadArgv.resize(tnum + 1);
+        }
+        if (!threadArgv[tnum].empty())
+        {
+          threadArgv[tnum] += " ";
+        }
+        threadArgv[tnum] += targs;
+        continue;
+      }
       throw OptionException(std::string("can't understand option `") + option +
                             "'" + suggestCommandLineOptions(option));
     }
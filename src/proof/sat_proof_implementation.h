@@ -641,9 +641,14 @@ void TSatProof<Solver>::removedDfs(typename Solver::TLit lit,
     return;
   }
 
+  // The implied literal ~lit is not necessarily the first one of its reason:
+  // minisat propagates binary clauses without reordering them.
   int size = getClause(reason_ref).size();
-  for (int i = 1; i < size; i++) {
+  for (int i = 0; i < size; i++) {
     typename Solver::TLit v = getClause(reason_ref)[i];
+    if (v == ~lit) {
+      continue;
+    }
     if (inClause.count(v) == 0 && seen.count(v) == 0) {
       removedDfs(v, removedSet, removeStack, inClause, seen);
     }
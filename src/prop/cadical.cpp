@@ -11,7 +11,8 @@
  **
  ** \brief Wrapper for CaDiCaL SAT Solver.
  **
- ** Implementation of the CaDiCaL SAT solver for CVC4 (bitvectors).
+ ** Implementation of the CaDiCaL SAT solver for CVC4 (bitvectors), and of
+ ** CaDiCaL as the DPLL(T) solver of the PropEngine.
  **/
 
 #include "prop/cadical.h"
@@ -21,6 +22,13 @@
 #include "base/check.h"
 #include "proof/sat_proof.h"
 
+#ifdef CVC4_USE_CADICAL_PROPAGATOR
+#include "context/context.h"
+#include "prop/theory_proxy.h"
+#include "theory/theory.h"
+#include "util/resource_manager.h"
+#endif
+
 namespace CVC4 {
 namespace prop {
 
@@ -54,6 +62,13 @@ CadicalLit toCadicalLit(const SatLiteral lit)
 
 CadicalVar toCadicalVar(SatVariable var) { return var; }
 
+#ifdef CVC4_USE_CADICAL_PROPAGATOR
+SatLiteral toSatLiteral(CadicalLit lit)
+{
+  return lit < 0 ? SatLiteral(-lit, true) : SatLiteral(lit, false);
+}
+#endif
+
 }  // namespace helper functions
 
 CadicalSolver::CadicalSolver(StatisticsRegistry* registry,
@@ -175,6 +190,537 @@ CadicalSolver::Statistics::~Statistics() {
   d_registry->unregisterStat(&d_solveTime);
 }
 
+#ifdef CVC4_USE_CADICAL_PROPAGATOR
+
+CadicalDPLLSatSolver::CadicalDPLLSatSolver(StatisticsRegistry* registry)
+    : d_solver(new CaDiCaL::Solver()),
+      d_context(NULL),
+      d_proxy(NULL),
+      d_nextVarIdx(1),
+      // index 0 is not a CaDiCaL variable
+      d_values(1, SAT_VALUE_UNKNOWN),
+      d_isTheoryAtom(1, false),
+      d_isActive(1, false),
+      d_trailPos(1, 0),
+      d_requiredPhase(1, 0),
+      d_pendingClausePos(0),
+      d_reasonPos(0),
+      d_inSearch(false),
+      d_interrupted(false),
+      d_okay(true),
+      d_statistics(registry)
+{
+  d_solver->set("quiet", 1);
+  // The SAT context is pushed and popped with the decision levels, which
+  // requires backtracking to be non-chronological.
+  d_solver->set("chrono", 0);
+  // Our trail is only valid if CaDiCaL starts each solve() from level 0.
+  d_solver->set("ilb", 0);
+  d_solver->connect_external_propagator(this);
+  d_solver->connect_learner(this);
+  d_solver->connect_terminator(this);
+
+  d_true = newVar();
+  d_false = newVar();
+  d_solver->add(toCadicalVar(d_true));
+  d_solver->add(0);
+  d_solver->add(-toCadicalVar(d_false));
+  d_solver->add(0);
+}
+
+CadicalDPLLSatSolver::~CadicalDPLLSatSolver()
+{
+  d_solver->disconnect_terminator();
+  d_solver->disconnect_learner();
+  d_solver->disconnect_external_propagator();
+}
+
+void CadicalDPLLSatSolver::initialize(context::Context* context,
+                                      TheoryProxy* theoryProxy)
+{
+  d_context = context;
+  d_proxy = theoryProxy;
+}
+
+ClauseId CadicalDPLLSatSolver::addClause(SatClause& clause, bool removable)
+{
+  std::vector<CadicalLit> lits;
+  lits.reserve(clause.size() + 1);
+  for (const SatLiteral& lit : clause)
+  {
+    lits.push_back(toCadicalLit(lit));
+  }
+  if (!d_activationLits.empty())
+  {
+    lits.push_back(-d_activationLits.back());
+  }
+  ++d_statistics.d_numClauses;
+
+  if (d_inSearch)
+  {
+    // CaDiCaL only accepts clauses during search through
+    // cb_add_external_clause_lit()
+    ++d_statistics.d_numLemmas;
+    d_pendingClauses.emplace_back(std::move(lits), removable);
+    return ClauseIdError;
+  }
+  for (CadicalLit lit : lits)
+  {
+    d_solver->add(lit);
+  }
+  d_solver->add(0);
+  return ClauseIdError;
+}
+
+ClauseId CadicalDPLLSatSolver::addXorClause(SatClause& clause,
+                                            bool rhs,
+                                            bool removable)
+{
+  Unreachable() << "CaDiCaL does not support adding XOR clauses.";
+}
+
+SatVariable CadicalDPLLSatSolver::allocateVar(bool observe, bool isTheoryAtom)
+{
+  SatVariable var = d_nextVarIdx++;
+  d_values.push_back(SAT_VALUE_UNKNOWN);
+  d_isTheoryAtom.push_back(isTheoryAtom);
+  d_isActive.push_back(observe);
+  d_trailPos.push_back(0);
+  d_requiredPhase.push_back(0);
+  if (observe)
+  {
+    d_solver->add_observed_var(toCadicalVar(var));
+  }
+  ++d_statistics.d_numVariables;
+  return var;
+}
+
+SatVariable CadicalDPLLSatSolver::newVar(bool isTheoryAtom,
+                                         bool preRegister,
+                                         bool canErase)
+{
+  SatVariable var = allocateVar(true, isTheoryAtom);
+  // If the variable is introduced at non-zero level, we need to reintroduce
+  // it on backtracks
+  if (preRegister)
+  {
+    d_varsToRegister.emplace_back(var, decisionLevel());
+  }
+  return var;
+}
+
+SatValue CadicalDPLLSatSolver::solve()
+{
+  return doSolve(std::vector<SatLiteral>());
+}
+
+SatValue CadicalDPLLSatSolver::solve(long unsigned int&)
+{
+  Unimplemented() << "Setting limits for CaDiCaL not supported yet";
+}
+
+SatValue CadicalDPLLSatSolver::solve(const std::vector<SatLiteral>& assumptions)
+{
+  return doSolve(assumptions);
+}
+
+SatValue CadicalDPLLSatSolver::doSolve(
+    const std::vector<SatLiteral>& assumptions)
+{
+  Assert(d_proxy != NULL);
+  TimerStat::CodeTimer codeTimer(d_statistics.d_solveTime);
+  ++d_statistics.d_numSatCalls;
+
+  d_interrupted = false;
+  for (CadicalLit lit : d_activationLits)
+  {
+    d_solver->assume(lit);
+  }
+  for (const SatLiteral& lit : assumptions)
+  {
+    d_solver->assume(toCadicalLit(lit));
+  }
+
+  d_inSearch = true;
+  int result = d_solver->solve();
+  d_inSearch = false;
+  d_propagations.clear();
+  d_reason.clear();
+  d_reasonPos = 0;
+  flushPendingClauses();
+
+  SatValue res = d_interrupted ? SAT_VALUE_UNKNOWN : toSatValue(result);
+  d_okay = (res != SAT_VALUE_FALSE);
+  if (res == SAT_VALUE_TRUE)
+  {
+    // keep the trail for value() until resetTrail(), like Minisat
+    d_model = d_values;
+  }
+  else
+  {
+    backtrack(0);
+  }
+  return res;
+}
+
+void CadicalDPLLSatSolver::flushPendingClauses()
+{
+  if (d_pendingClausePos > 0)
+  {
+    // CaDiCaL was interrupted in the middle of this clause
+    d_pendingClauses.pop_front();
+    d_pendingClausePos = 0;
+  }
+  for (const std::pair<std::vector<CadicalLit>, bool>& c : d_pendingClauses)
+  {
+    for (CadicalLit lit : c.first)
+    {
+      d_solver->add(lit);
+    }
+    d_solver->add(0);
+  }
+  d_pendingClauses.clear();
+}
+
+void CadicalDPLLSatSolver::interrupt() { d_interrupted = true; }
+
+bool CadicalDPLLSatSolver::learning(int size)
+{
+  // spendResource() calls interrupt() once a resource limit is reached
+  d_proxy->spendResource(ResourceManager::Resource::SatConflictStep);
+  return false;
+}
+
+bool CadicalDPLLSatSolver::terminate() { return d_interrupted; }
+
+SatValue CadicalDPLLSatSolver::value(SatLiteral l)
+{
+  SatValue v = d_values[l.getSatVariable()];
+  return l.isNegated() ? invertValue(v) : v;
+}
+
+SatValue CadicalDPLLSatSolver::modelValue(SatLiteral l)
+{
+  Assert(l.getSatVariable() < d_model.size());
+  SatValue v = d_model[l.getSatVariable()];
+  return l.isNegated() ? invertValue(v) : v;
+}
+
+unsigned CadicalDPLLSatSolver::getAssertionLevel() const
+{
+  return d_activationLits.size();
+}
+
+void CadicalDPLLSatSolver::push()
+{
+  Assert(!d_inSearch);
+  backtrack(0);
+  d_varsLim.push_back(d_nextVarIdx);
+  d_activationLits.push_back(toCadicalVar(allocateVar(false, false)));
+  d_context->push();
+}
+
+void CadicalDPLLSatSolver::pop()
+{
+  Assert(!d_inSearch);
+  Assert(!d_activationLits.empty());
+  backtrack(0);
+
+  // disable the clauses of the popped level for good
+  d_solver->add(-d_activationLits.back());
+  d_solver->add(0);
+  d_activationLits.pop_back();
+  unsigned level = d_activationLits.size();
+
+  d_context->pop();
+
+  // The nodes of the variables introduced at the popped level are gone, stop
+  // observing them.
+  for (unsigned var = d_varsLim.back(); var < d_nextVarIdx; ++var)
+  {
+    if (d_isActive[var])
+    {
+      d_solver->remove_observed_var(toCadicalVar(var));
+      d_isActive[var] = false;
+    }
+  }
+  d_varsLim.pop_back();
+  d_varsToRegister.clear();
+
+  // The fixed literals stay fixed in CaDiCaL and are not notified again, but
+  // the theories forgot the ones asserted at the popped level.
+  Assert(d_fixedUserLevel.size() == d_trail.size());
+  for (size_t i = 0, n = d_trail.size(); i < n; ++i)
+  {
+    if (d_fixedUserLevel[i] > level)
+    {
+      d_fixedUserLevel[i] = level;
+      SatVariable var = d_trail[i].getSatVariable();
+      if (d_isActive[var] && d_isTheoryAtom[var])
+      {
+        d_proxy->enqueueTheoryLiteral(d_trail[i]);
+      }
+    }
+  }
+}
+
+void CadicalDPLLSatSolver::resetTrail() { backtrack(0); }
+
+bool CadicalDPLLSatSolver::properExplanation(SatLiteral lit,
+                                             SatLiteral expl) const
+{
+  SatVariable v = lit.getSatVariable();
+  SatVariable e = expl.getSatVariable();
+  return d_values[v] != SAT_VALUE_UNKNOWN && d_values[e] != SAT_VALUE_UNKNOWN
+         && d_trailPos[e] < d_trailPos[v];
+}
+
+void CadicalDPLLSatSolver::requirePhase(SatLiteral lit)
+{
+  CadicalLit clit = toCadicalLit(lit);
+  d_requiredPhase[lit.getSatVariable()] = clit;
+  d_solver->phase(clit);
+}
+
+bool CadicalDPLLSatSolver::isDecision(SatVariable decn) const
+{
+  return d_solver->is_decision(toCadicalVar(decn));
+}
+
+size_t CadicalDPLLSatSolver::getTrailSize() const { return d_trail.size(); }
+
+SatLiteral CadicalDPLLSatSolver::getTrailLiteral(size_t i) const
+{
+  return d_trail[i];
+}
+
+void CadicalDPLLSatSolver::backtrack(size_t level)
+{
+  if (level >= decisionLevel())
+  {
+    return;
+  }
+  size_t start = d_trailLim[level];
+  for (size_t i = start, n = d_trail.size(); i < n; ++i)
+  {
+    d_values[d_trail[i].getSatVariable()] = SAT_VALUE_UNKNOWN;
+  }
+  d_trail.resize(start);
+  while (decisionLevel() > level)
+  {
+    d_trailLim.pop_back();
+    d_context->pop();
+  }
+  d_propagations.clear();
+
+  // Register variables that have not been registered yet
+  for (size_t i = d_varsToRegister.size();
+       i-- > 0 && d_varsToRegister[i].second > level;)
+  {
+    d_varsToRegister[i].second = level;
+    d_proxy->variableNotify(d_varsToRegister[i].first);
+  }
+}
+
+void CadicalDPLLSatSolver::notify_assignment(const std::vector<int>& lits)
+{
+  for (CadicalLit lit : lits)
+  {
+    SatLiteral l = toSatLiteral(lit);
+    SatVariable var = l.getSatVariable();
+    if (!d_isActive[var] || d_values[var] != SAT_VALUE_UNKNOWN)
+    {
+      continue;
+    }
+    d_values[var] = l.isNegated() ? SAT_VALUE_FALSE : SAT_VALUE_TRUE;
+    d_trailPos[var] = d_trail.size();
+    d_trail.push_back(l);
+    if (decisionLevel() == 0)
+    {
+      d_fixedUserLevel.push_back(d_activationLits.size());
+    }
+    if (d_isTheoryAtom[var])
+    {
+      // Enqueue to the theory
+      d_proxy->enqueueTheoryLiteral(l);
+    }
+  }
+}
+
+void CadicalDPLLSatSolver::notify_new_decision_level()
+{
+  d_trailLim.push_back(d_trail.size());
+  d_context->push();
+}
+
+void CadicalDPLLSatSolver::notify_backtrack(size_t level)
+{
+  backtrack(level);
+}
+
+int CadicalDPLLSatSolver::cb_propagate()
+{
+  if (d_propagations.empty())
+  {
+    // let CaDiCaL pick up the pending lemmas before checking again
+    if (!d_pendingClauses.empty())
+    {
+      return 0;
+    }
+    d_proxy->theoryCheck(theory::Theory::EFFORT_STANDARD);
+    std::vector<SatLiteral> propagations;
+    d_proxy->theoryPropagate(propagations);
+    d_propagations.insert(
+        d_propagations.end(), propagations.begin(), propagations.end());
+  }
+  while (!d_propagations.empty())
+  {
+    SatLiteral l = d_propagations.front();
+    d_propagations.pop_front();
+    if (value(l) != SAT_VALUE_TRUE)
+    {
+      ++d_statistics.d_numTheoryPropagations;
+      return toCadicalLit(l);
+    }
+  }
+  return 0;
+}
+
+int CadicalDPLLSatSolver::cb_add_reason_clause_lit(int propagatedLit)
+{
+  if (d_reasonPos == 0)
+  {
+    SatClause explanation;
+    d_proxy->explainPropagation(toSatLiteral(propagatedLit), explanation);
+    Assert(!explanation.empty()
+           && toCadicalLit(explanation[0]) == propagatedLit);
+    d_reason.clear();
+    for (const SatLiteral& lit : explanation)
+    {
+      d_reason.push_back(toCadicalLit(lit));
+    }
+  }
+  if (d_reasonPos < d_reason.size())
+  {
+    return d_reason[d_reasonPos++];
+  }
+  d_reasonPos = 0;
+  return 0;
+}
+
+int CadicalDPLLSatSolver::cb_decide()
+{
+  // Theory requests
+  SatLiteral next = d_proxy->getNextTheoryDecisionRequest();
+  while (next != undefSatLiteral)
+  {
+    if (value(next) == SAT_VALUE_UNKNOWN)
+    {
+      ++d_statistics.d_numTheoryDecisions;
+      return toCadicalLit(next);
+    }
+    next = d_proxy->getNextTheoryDecisionRequest();
+  }
+
+  // DE requests.  CaDiCaL cannot stop the search early, so stopSearch only
+  // means that CaDiCaL makes the remaining decisions itself.
+  bool stopSearch = false;
+  next = d_proxy->getNextDecisionEngineRequest(stopSearch);
+  if (stopSearch || next == undefSatLiteral)
+  {
+    return 0;
+  }
+  Assert(value(next) == SAT_VALUE_UNKNOWN)
+      << "literal to decide already has value";
+  int phase = d_requiredPhase[next.getSatVariable()];
+  return phase != 0 ? phase : toCadicalLit(next);
+}
+
+bool CadicalDPLLSatSolver::cb_check_found_model(const std::vector<int>& model)
+{
+  do
+  {
+    ++d_statistics.d_numFinalChecks;
+    d_proxy->theoryCheck(theory::Theory::EFFORT_FULL);
+    // Every atom is assigned, so a propagation that is not already true
+    // is a conflict: hand it to CaDiCaL as its explanation clause.
+    std::vector<SatLiteral> propagations;
+    d_proxy->theoryPropagate(propagations);
+    for (const SatLiteral& l : propagations)
+    {
+      if (value(l) != SAT_VALUE_TRUE)
+      {
+        SatClause explanation;
+        d_proxy->explainPropagation(l, explanation);
+        addClause(explanation, true);
+      }
+    }
+    if (!d_pendingClauses.empty())
+    {
+      return false;
+    }
+  } while (d_proxy->theoryNeedCheck() && !d_interrupted);
+  return true;
+}
+
+bool CadicalDPLLSatSolver::cb_has_external_clause(bool& isForgettable)
+{
+  if (d_pendingClauses.empty())
+  {
+    return false;
+  }
+  isForgettable = d_pendingClauses.front().second;
+  return true;
+}
+
+int CadicalDPLLSatSolver::cb_add_external_clause_lit()
+{
+  Assert(!d_pendingClauses.empty());
+  const std::vector<CadicalLit>& clause = d_pendingClauses.front().first;
+  if (d_pendingClausePos < clause.size())
+  {
+    return clause[d_pendingClausePos++];
+  }
+  d_pendingClauses.pop_front();
+  d_pendingClausePos = 0;
+  return 0;
+}
+
+CadicalDPLLSatSolver::Statistics::Statistics(StatisticsRegistry* registry)
+    : d_registry(registry),
+      d_numSatCalls("prop::cadical::calls_to_solve", 0),
+      d_numVariables("prop::cadical::variables", 0),
+      d_numClauses("prop::cadical::clauses", 0),
+      d_numLemmas("prop::cadical::lemmas", 0),
+      d_numTheoryPropagations("prop::cadical::theory_propagations", 0),
+      d_numTheoryDecisions("prop::cadical::theory_decisions", 0),
+      d_numFinalChecks("prop::cadical::final_checks", 0),
+      d_solveTime("prop::cadical::solve_time")
+{
+  d_registry->registerStat(&d_numSatCalls);
+  d_registry->registerStat(&d_numVariables);
+  d_registry->registerStat(&d_numClauses);
+  d_registry->registerStat(&d_numLemmas);
+  d_registry->registerStat(&d_numTheoryPropagations);
+  d_registry->registerStat(&d_numTheoryDecisions);
+  d_registry->registerStat(&d_numFinalChecks);
+  d_registry->registerStat(&d_solveTime);
+}
+
+CadicalDPLLSatSolver::Statistics::~Statistics()
+{
+  d_registry->unregisterStat(&d_numSatCalls);
+  d_registry->unregisterStat(&d_numVariables);
+  d_registry->unregisterStat(&d_numClauses);
+  d_registry->unregisterStat(&d_numLemmas);
+  d_registry->unregisterStat(&d_numTheoryPropagations);
+  d_registry->unregisterStat(&d_numTheoryDecisions);
+  d_registry->unregisterStat(&d_numFinalChecks);
+  d_registry->unregisterStat(&d_solveTime);
+}
+
+#endif  // CVC4_USE_CADICAL_PROPAGATOR
+
 }  // namespace prop
 }  // namespace CVC4
 
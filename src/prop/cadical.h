@@ -11,7 +11,8 @@
  **
  ** \brief Wrapper for CaDiCaL SAT Solver.
  **
- ** Implementation of the CaDiCaL SAT solver for CVC4 (bitvectors).
+ ** Implementation of the CaDiCaL SAT solver for CVC4 (bitvectors), and of
+ ** CaDiCaL as the DPLL(T) solver of the PropEngine.
  **/
 
 #include "cvc4_private.h"
@@ -21,6 +22,10 @@
 
 #ifdef CVC4_USE_CADICAL
 
+#include <deque>
+#include <utility>
+#include <vector>
+
 #include "prop/sat_solver.h"
 
 #include <cadical.hpp>
@@ -83,6 +88,215 @@ class CadicalSolver : public SatSolver
   Statistics d_statistics;
 };
 
+#ifdef CVC4_USE_CADICAL_PROPAGATOR
+
+/**
+ * CaDiCaL as the DPLL(T) SAT solver of the PropEngine.
+ *
+ * The theories are connected through CaDiCaL's external propagator interface
+ * (IPASIR-UP): assignments of theory atoms are forwarded to the TheoryProxy,
+ * decision levels are mirrored by pushing and popping the SAT context, theory
+ * propagations and their explanations are handed back on demand, and lemmas
+ * added during search are buffered until CaDiCaL asks for external clauses.
+ *
+ * CaDiCaL cannot remove clauses, so user-level push/pop is implemented with
+ * one activation literal per user level: clauses added at a level > 0 are
+ * guarded by the negated activation literal, the activation literals of all
+ * open levels are assumed on solve(), and pop() disables the guarded clauses
+ * with a unit clause.  Literals fixed at decision level 0 are independent of
+ * the assumptions and therefore stay fixed across pops; they are re-asserted
+ * to the theories after each pop since the theories forget them.
+ */
+class CadicalDPLLSatSolver : public DPLLSatSolverInterface,
+                             private CaDiCaL::ExternalPropagator,
+                             private CaDiCaL::Learner,
+                             private CaDiCaL::Terminator
+{
+ public:
+  CadicalDPLLSatSolver(StatisticsRegistry* registry);
+
+  ~CadicalDPLLSatSolver() override;
+
+  /* SatSolver interface */
+
+  ClauseId addClause(SatClause& clause, bool removable) override;
+
+  ClauseId addXorClause(SatClause& clause, bool rhs, bool removable) override;
+
+  SatVariable newVar(bool isTheoryAtom = false,
+                     bool preRegister = false,
+                     bool canErase = true) override;
+
+  SatVariable trueVar() override { return d_true; }
+
+  SatVariable falseVar() override { return d_false; }
+
+  SatValue solve() override;
+  SatValue solve(long unsigned int&) override;
+  SatValue solve(const std::vector<SatLiteral>& assumptions) override;
+
+  void interrupt() override;
+
+  SatValue value(SatLiteral l) override;
+
+  SatValue modelValue(SatLiteral l) override;
+
+  unsigned getAssertionLevel() const override;
+
+  bool ok() const override { return d_okay; }
+
+  /* DPLLSatSolverInterface */
+
+  void initialize(context::Context* context, TheoryProxy* theoryProxy) override;
+
+  void push() override;
+
+  void pop() override;
+
+  void resetTrail() override;
+
+  bool properExplanation(SatLiteral lit, SatLiteral expl) const override;
+
+  void requirePhase(SatLiteral lit) override;
+
+  bool isDecision(SatVariable decn) const override;
+
+  size_t getTrailSize() const override;
+
+  SatLiteral getTrailLiteral(size_t i) const override;
+
+ private:
+  /* CaDiCaL::ExternalPropagator */
+
+  void notify_assignment(const std::vector<int>& lits) override;
+
+  void notify_new_decision_level() override;
+
+  void notify_backtrack(size_t level) override;
+
+  bool cb_check_found_model(const std::vector<int>& model) override;
+
+  int cb_decide() override;
+
+  int cb_propagate() override;
+
+  int cb_add_reason_clause_lit(int propagatedLit) override;
+
+  bool cb_has_external_clause(bool& isForgettable) override;
+
+  int cb_add_external_clause_lit() override;
+
+  /* CaDiCaL::Learner */
+
+  /**
+   * Called by CaDiCaL for each learnt clause, i.e. once per conflict.
+   * Charges a conflict step to the resource manager and declines the
+   * literals of the clause.
+   */
+  bool learning(int size) override;
+
+  void learn(int lit) override {}
+
+  /* CaDiCaL::Terminator */
+
+  bool terminate() override;
+
+  /** Allocate a fresh variable, observed by the propagator iff observe. */
+  SatVariable allocateVar(bool observe, bool isTheoryAtom);
+
+  /**
+   * Undo the assignments above decision level, popping the SAT context once
+   * per level.  Does nothing if we are already at or below level.
+   */
+  void backtrack(size_t level);
+
+  /** Solve under the activation literals and the given assumptions. */
+  SatValue doSolve(const std::vector<SatLiteral>& assumptions);
+
+  /** Add the clauses buffered during search that CaDiCaL did not pick up. */
+  void flushPendingClauses();
+
+  /** The current decision level */
+  size_t decisionLevel() const { return d_trailLim.size(); }
+
+  std::unique_ptr<CaDiCaL::Solver> d_solver;
+
+  /** The SAT context, one level per decision level and user level */
+  context::Context* d_context;
+  /** The connection to the theories and the decision engine */
+  TheoryProxy* d_proxy;
+
+  unsigned d_nextVarIdx;
+  SatVariable d_true;
+  SatVariable d_false;
+
+  /** The current value of each variable, as notified by CaDiCaL */
+  std::vector<SatValue> d_values;
+  /** The values of the last satisfying assignment */
+  std::vector<SatValue> d_model;
+  /** Whether the variable is a theory atom */
+  std::vector<bool> d_isTheoryAtom;
+  /** Whether the variable is observed, i.e. was not popped with a user level */
+  std::vector<bool> d_isActive;
+  /** The position of each assigned variable on d_trail */
+  std::vector<size_t> d_trailPos;
+  /** The phase required by requirePhase(), 0 if there is none */
+  std::vector<int> d_requiredPhase;
+
+  /** The assigned literals, in assignment order */
+  std::vector<SatLiteral> d_trail;
+  /** The start of each decision level > 0 on d_trail */
+  std::vector<size_t> d_trailLim;
+  /** The user level at which each literal fixed at decision level 0 was
+   * asserted to the theories (parallel to the level 0 prefix of d_trail) */
+  std::vector<unsigned> d_fixedUserLevel;
+
+  /** Pre-registered variables and the decision level they were added at */
+  std::vector<std::pair<SatVariable, size_t>> d_varsToRegister;
+
+  /** The activation literal of each user level > 0 */
+  std::vector<int> d_activationLits;
+  /** The value of d_nextVarIdx when each user level was pushed */
+  std::vector<unsigned> d_varsLim;
+
+  /** Clauses added during search, with their removable flag */
+  std::deque<std::pair<std::vector<int>, bool>> d_pendingClauses;
+  /** The next literal of d_pendingClauses.front() to hand out */
+  size_t d_pendingClausePos;
+  /** Theory propagations not yet handed to CaDiCaL */
+  std::deque<SatLiteral> d_propagations;
+  /** The reason clause being handed out to CaDiCaL */
+  std::vector<int> d_reason;
+  /** The next literal of d_reason to hand out */
+  size_t d_reasonPos;
+
+  /** Whether we are inside CaDiCaL's solve() */
+  bool d_inSearch;
+  /** Set by interrupt(), polled by CaDiCaL through terminate() */
+  bool d_interrupted;
+  /** False iff the last call to solve() returned unsat */
+  bool d_okay;
+
+  struct Statistics
+  {
+    StatisticsRegistry* d_registry;
+    IntStat d_numSatCalls;
+    IntStat d_numVariables;
+    IntStat d_numClauses;
+    IntStat d_numLemmas;
+    IntStat d_numTheoryPropagations;
+    IntStat d_numTheoryDecisions;
+    IntStat d_numFinalChecks;
+    TimerStat d_solveTime;
+    Statistics(StatisticsRegistry* registry);
+    ~Statistics();
+  };
+
+  Statistics d_statistics;
+};
+
+#endif  // CVC4_USE_CADICAL_PROPAGATOR
+
 }  // namespace prop
 }  // namespace CVC4
 
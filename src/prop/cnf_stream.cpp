@@ -42,6 +42,26 @@ using namespace CVC4::kind;
 namespace CVC4 {
 namespace prop {
 
+namespace {
+
+/** Whether node is Boolean structure that is translated to a gate */
+bool isConnective(TNode node)
+{
+  switch (node.getKind())
+  {
+    case NOT:
+    case XOR:
+    case ITE:
+    case IMPLIES:
+    case OR:
+    case AND: return true;
+    case EQUAL: return node[0].getType().isBoolean();
+    default: return false;
+  }
+}
+
+}  // namespace
+
 CnfStream::CnfStream(SatSolver* satSolver, Registrar* registrar,
                      context::Context* context, bool fullLitToNodeMap,
                      std::string name)
@@ -57,14 +77,43 @@ CnfStream::CnfStream(SatSolver* satSolver, Registrar* registrar,
       d_removable(false) {
 }
 
-TseitinCnfStream::TseitinCnfStream(SatSolver* satSolver, Registrar* registrar,
+TseitinCnfStream::TseitinCnfStream(SatSolver* satSolver,
+                                   Registrar* registrar,
                                    context::Context* context,
-                                   bool fullLitToNodeMap, std::string name)
-  : CnfStream(satSolver, registrar, context, fullLitToNodeMap, name)
-{}
+                                   bool fullLitToNodeMap,
+                                   std::string name,
+                                   bool polarity)
+    : CnfStream(satSolver, registrar, context, fullLitToNodeMap, name),
+      d_polarity(polarity),
+      d_gatePolarities(context)
+{
+}
+
+bool CnfStream::batchClauses() const
+{
+  return !(PROOF_ON() && d_cnfProof) && !Dump.isOn("clauses");
+}
+
+void CnfStream::flushClauses()
+{
+  if (d_clauseEnds.empty())
+  {
+    return;
+  }
+  Debug("cnf") << "Flushing " << d_clauseEnds.size() << " clauses" << endl;
+  d_satSolver->addClauses(d_clauseLits, d_clauseEnds, d_removable);
+  d_clauseLits.clear();
+  d_clauseEnds.clear();
+}
 
 void CnfStream::assertClause(TNode node, SatClause& c) {
   Debug("cnf") << "Inserting into stream " << c << " node = " << node << endl;
+  if (batchClauses())
+  {
+    d_clauseLits.insert(d_clauseLits.end(), c.begin(), c.end());
+    d_clauseEnds.push_back(d_clauseLits.size());
+    return;
+  }
   if(Dump.isOn("clauses")) {
     if(c.size() == 1) {
       Dump("clauses") << AssertCommand(Expr(getNode(c[0]).toExpr()));
@@ -98,12 +147,29 @@ void CnfStream::assertClause(TNode node, SatClause& c) {
 }
 
 void CnfStream::assertClause(TNode node, SatLiteral a) {
+  if (batchClauses())
+  {
+    Debug("cnf") << "Inserting into stream [" << a << "] node = " << node
+                 << endl;
+    d_clauseLits.push_back(a);
+    d_clauseEnds.push_back(d_clauseLits.size());
+    return;
+  }
   SatClause clause(1);
   clause[0] = a;
   assertClause(node, clause);
 }
 
 void CnfStream::assertClause(TNode node, SatLiteral a, SatLiteral b) {
+  if (batchClauses())
+  {
+    Debug("cnf") << "Inserting into stream [" << a << ", " << b
+                 << "] node = " << node << endl;
+    d_clauseLits.push_back(a);
+    d_clauseLits.push_back(b);
+    d_clauseEnds.push_back(d_clauseLits.size());
+    return;
+  }
   SatClause clause(2);
   clause[0] = a;
   clause[1] = b;
@@ -111,6 +177,16 @@ void CnfStream::assertClause(TNode node, SatLiteral a, SatLiteral b) {
 }
 
 void CnfStream::assertClause(TNode node, SatLiteral a, SatLiteral b, SatLiteral c) {
+  if (batchClauses())
+  {
+    Debug("cnf") << "Inserting into stream [" << a << ", " << b << ", " << c
+                 << "] node = " << node << endl;
+    d_clauseLits.push_back(a);
+    d_clauseLits.push_back(b);
+    d_clauseLits.push_back(c);
+    d_clauseEnds.push_back(d_clauseLits.size());
+    return;
+  }
   SatClause clause(3);
   clause[0] = a;
   clause[1] = b;
@@ -124,6 +200,8 @@ bool CnfStream::hasLiteral(TNode n) const {
 }
 
 void TseitinCnfStream::ensureLiteral(TNode n, bool noPreregistration) {
+  // We may be re-entered from a conversion, its clauses keep its flag
+  flushClauses();
   // These are not removable and have no proof ID
   d_removable = false;
 
@@ -160,7 +238,8 @@ void TseitinCnfStream::ensureLiteral(TNode n, bool noPreregistration) {
     // If we were called with something other than a theory atom (or
     // Boolean variable), we get a SatLiteral that is definitionally
     // equal to it.
-    lit = toCNF(n, false);
+    lit = toCNF(n, false, POLARITY_BOTH);
+    flushClauses();
 
     // Store backward-mappings
     // These may already exist
@@ -181,7 +260,8 @@ SatLiteral CnfStream::newLiteral(TNode node, bool isTheoryAtom, bool preRegister
 
   // Get the literal for this node
   SatLiteral lit;
-  if (!hasLiteral(node)) {
+  NodeToLiteralMap::const_iterator find = d_nodeToLiteralMap.find(node);
+  if (find == d_nodeToLiteralMap.end()) {
     // If no literal, we'll make one
     if (node.getKind() == kind::CONST_BOOLEAN) {
       if (node.getConst<bool>()) {
@@ -195,7 +275,7 @@ SatLiteral CnfStream::newLiteral(TNode node, bool isTheoryAtom, bool preRegister
     d_nodeToLiteralMap.insert(node, lit);
     d_nodeToLiteralMap.insert(node.notNode(), ~lit);
   } else {
-    lit = getLiteral(node);
+    lit = (*find).second;
   }
 
   // If it's a theory literal, need to store it for back queries
@@ -471,53 +551,88 @@ SatLiteral TseitinCnfStream::handleIte(TNode iteNode) {
 }
 
 
+SatLiteral TseitinCnfStream::translate(TNode node) {
+  // Handle each Boolean operator case
+  switch(node.getKind()) {
+  case NOT:
+    return handleNot(node);
+  case XOR:
+    return handleXor(node);
+  case ITE:
+    return handleIte(node);
+  case IMPLIES:
+    return handleImplies(node);
+  case OR:
+    return handleOr(node);
+  case AND:
+    return handleAnd(node);
+  case EQUAL:
+    if(node[0].getType().isBoolean()) {
+      return handleIff(node);
+    }
+    return convertAtom(node);
+  default:
+    //TODO make sure this does not contain any boolean substructure
+    return convertAtom(node);
+  }
+}
+
 SatLiteral TseitinCnfStream::toCNF(TNode node, bool negated) {
+  return toCNF(node, negated, negated ? POLARITY_NEG : POLARITY_POS);
+}
+
+SatLiteral TseitinCnfStream::toCNF(TNode node,
+                                   bool negated,
+                                   unsigned polarity)
+{
   Debug("cnf") << "toCNF(" << node << ", negated = " << (negated ? "true" : "false") << ")" << endl;
 
   SatLiteral nodeLit;
-  Node negatedNode = node.notNode();
+
+  if (d_polarity)
+  {
+    nodeLit = define(node, polarity);
+    return negated ? ~nodeLit : nodeLit;
+  }
 
   // If the non-negated node has already been translated, get the translation
-  if(hasLiteral(node)) {
+  NodeToLiteralMap::const_iterator find = d_nodeToLiteralMap.find(node);
+  if (find != d_nodeToLiteralMap.end()) {
     Debug("cnf") << "toCNF(): already translated" << endl;
-    nodeLit = getLiteral(node);
+    nodeLit = (*find).second;
   } else {
-    // Handle each Boolean operator case
-    switch(node.getKind()) {
-    case NOT:
-      nodeLit = handleNot(node);
-      break;
-    case XOR:
-      nodeLit = handleXor(node);
-      break;
-    case ITE:
-      nodeLit = handleIte(node);
-      break;
-    case IMPLIES:
-      nodeLit = handleImplies(node);
-      break;
-    case OR:
-      nodeLit = handleOr(node);
-      break;
-    case AND:
-      nodeLit = handleAnd(node);
-      break;
-    case EQUAL:
-      if(node[0].getType().isBoolean()) {
-        nodeLit = handleIff(node);
-      } else {
-        nodeLit = convertAtom(node);
+    // Translate the Boolean structure bottom-up with an explicit stack, deep
+    // formulas would overflow the call stack.  The handlers then find the
+    // literals of the children in the translation cache.  Each entry is a
+    // node and whether its children have been pushed.
+    std::vector<std::pair<TNode, bool>> visit;
+    visit.push_back(std::make_pair(node, false));
+    while (!visit.empty()) {
+      TNode current = visit.back().first;
+      if (visit.back().second) {
+        visit.pop_back();
+        // A NOT is cached with its child, the root may already have one
+        if (visit.empty()) {
+          nodeLit = hasLiteral(current) ? getLiteral(current)
+                                        : translate(current);
+        } else if (!hasLiteral(current)) {
+          translate(current);
+        }
+        continue;
       }
-      break;
-    default:
-      {
-        //TODO make sure this does not contain any boolean substructure
-        nodeLit = convertAtom(node);
-        //Unreachable();
-        //Node atomic = handleNonAtomicNode(node);
-        //return isCached(atomic) ? lookupInCache(atomic) : convertAtom(atomic);
+      if (visit.size() > 1 && hasLiteral(current)) {
+        visit.pop_back();
+        continue;
+      }
+      visit.back().second = true;
+      if (isConnective(current)) {
+        // Last child first, so that they are translated in order
+        for (size_t i = current.getNumChildren(); i > 0; --i) {
+          if (!hasLiteral(current[i - 1])) {
+            visit.push_back(std::make_pair(current[i - 1], false));
+          }
+        }
       }
-      break;
     }
   }
 
@@ -526,6 +641,219 @@ SatLiteral TseitinCnfStream::toCNF(TNode node, bool negated) {
   else return ~nodeLit;
 }
 
+SatLiteral TseitinCnfStream::gateLiteral(TNode node)
+{
+  NodeToLiteralMap::const_iterator find = d_nodeToLiteralMap.find(node);
+  if (find != d_nodeToLiteralMap.end())
+  {
+    return (*find).second;
+  }
+  bool negated = false;
+  while (node.getKind() == NOT)
+  {
+    node = node[0];
+    negated = !negated;
+  }
+  SatLiteral lit;
+  if (hasLiteral(node))
+  {
+    lit = getLiteral(node);
+  }
+  else if (isConnective(node))
+  {
+    lit = newLiteral(node);
+  }
+  else
+  {
+    lit = convertAtom(node);
+  }
+  return negated ? ~lit : lit;
+}
+
+SatLiteral TseitinCnfStream::define(TNode node, unsigned polarity)
+{
+  Assert(d_polarity);
+  SatLiteral nodeLit = gateLiteral(node);
+
+  // The definitions of the gates may be needed by later formulas, they must
+  // not be removed with a lemma
+  bool removable = d_removable;
+  if (removable)
+  {
+    flushClauses();
+    d_removable = false;
+  }
+
+  std::vector<std::pair<TNode, unsigned>> visit;
+  visit.push_back(std::make_pair(node, polarity));
+  while (!visit.empty())
+  {
+    TNode current = visit.back().first;
+    unsigned pol = visit.back().second;
+    visit.pop_back();
+    while (current.getKind() == NOT)
+    {
+      current = current[0];
+      pol = ((pol & POLARITY_POS) ? POLARITY_NEG : 0)
+            | ((pol & POLARITY_NEG) ? POLARITY_POS : 0);
+    }
+    if (!isConnective(current))
+    {
+      continue;
+    }
+    unsigned done = 0;
+    GatePolarityMap::const_iterator find = d_gatePolarities.find(current);
+    if (find != d_gatePolarities.end())
+    {
+      done = (*find).second;
+    }
+    unsigned missing = pol & ~done;
+    if (missing == 0)
+    {
+      continue;
+    }
+    d_gatePolarities.insert(current, done | missing);
+    bool pos = (missing & POLARITY_POS) != 0;
+    bool neg = (missing & POLARITY_NEG) != 0;
+    Debug("cnf") << "define(" << current << ", pos = " << pos
+                 << ", neg = " << neg << ")" << endl;
+
+    SatLiteral lit = gateLiteral(current);
+    switch (current.getKind())
+    {
+      case AND:
+      {
+        unsigned n = current.getNumChildren();
+        SatClause clause(n + 1);
+        for (unsigned i = 0; i < n; ++i)
+        {
+          clause[i] = ~gateLiteral(current[i]);
+          // lit -> a_i
+          if (pos)
+          {
+            assertClause(current.negate(), ~lit, ~clause[i]);
+          }
+          visit.push_back(std::make_pair(current[i], missing));
+        }
+        // lit | ~a_1 | ~a_2 | ... | ~a_n
+        if (neg)
+        {
+          clause[n] = lit;
+          assertClause(current, clause);
+        }
+        break;
+      }
+      case OR:
+      {
+        unsigned n = current.getNumChildren();
+        SatClause clause(n + 1);
+        for (unsigned i = 0; i < n; ++i)
+        {
+          clause[i] = gateLiteral(current[i]);
+          // a_i -> lit
+          if (neg)
+          {
+            assertClause(current, lit, ~clause[i]);
+          }
+          visit.push_back(std::make_pair(current[i], missing));
+        }
+        // ~lit | a_1 | a_2 | ... | a_n
+        if (pos)
+        {
+          clause[n] = ~lit;
+          assertClause(current.negate(), clause);
+        }
+        break;
+      }
+      case IMPLIES:
+      {
+        SatLiteral a = gateLiteral(current[0]);
+        SatLiteral b = gateLiteral(current[1]);
+        if (pos)
+        {
+          assertClause(current.negate(), ~lit, ~a, b);
+          visit.push_back(std::make_pair(current[0], POLARITY_NEG));
+          visit.push_back(std::make_pair(current[1], POLARITY_POS));
+        }
+        if (neg)
+        {
+          assertClause(current, a, lit);
+          assertClause(current, ~b, lit);
+          visit.push_back(std::make_pair(current[0], POLARITY_POS));
+          visit.push_back(std::make_pair(current[1], POLARITY_NEG));
+        }
+        break;
+      }
+      case XOR:
+      {
+        SatLiteral a = gateLiteral(current[0]);
+        SatLiteral b = gateLiteral(current[1]);
+        if (pos)
+        {
+          assertClause(current.negate(), a, b, ~lit);
+          assertClause(current.negate(), ~a, ~b, ~lit);
+        }
+        if (neg)
+        {
+          assertClause(current, a, ~b, lit);
+          assertClause(current, ~a, b, lit);
+        }
+        visit.push_back(std::make_pair(current[0], POLARITY_BOTH));
+        visit.push_back(std::make_pair(current[1], POLARITY_BOTH));
+        break;
+      }
+      case EQUAL:
+      {
+        SatLiteral a = gateLiteral(current[0]);
+        SatLiteral b = gateLiteral(current[1]);
+        if (pos)
+        {
+          assertClause(current.negate(), ~a, b, ~lit);
+          assertClause(current.negate(), a, ~b, ~lit);
+        }
+        if (neg)
+        {
+          assertClause(current, ~a, ~b, lit);
+          assertClause(current, a, b, lit);
+        }
+        visit.push_back(std::make_pair(current[0], POLARITY_BOTH));
+        visit.push_back(std::make_pair(current[1], POLARITY_BOTH));
+        break;
+      }
+      case ITE:
+      {
+        SatLiteral c = gateLiteral(current[0]);
+        SatLiteral t = gateLiteral(current[1]);
+        SatLiteral e = gateLiteral(current[2]);
+        if (pos)
+        {
+          assertClause(current.negate(), ~lit, t, e);
+          assertClause(current.negate(), ~lit, ~c, t);
+          assertClause(current.negate(), ~lit, c, e);
+        }
+        if (neg)
+        {
+          assertClause(current, lit, ~t, ~e);
+          assertClause(current, lit, ~c, ~t);
+          assertClause(current, lit, c, ~e);
+        }
+        visit.push_back(std::make_pair(current[0], POLARITY_BOTH));
+        visit.push_back(std::make_pair(current[1], missing));
+        visit.push_back(std::make_pair(current[2], missing));
+        break;
+      }
+      default: Unreachable();
+    }
+  }
+
+  if (removable)
+  {
+    flushClauses();
+    d_removable = true;
+  }
+  return nodeLit;
+}
+
 void TseitinCnfStream::convertAndAssertAnd(TNode node, bool negated) {
   Assert(node.getKind() == AND);
   if (!negated) {
@@ -575,8 +903,8 @@ void TseitinCnfStream::convertAndAssertOr(TNode node, bool negated) {
 void TseitinCnfStream::convertAndAssertXor(TNode node, bool negated) {
   if (!negated) {
     // p XOR q
-    SatLiteral p = toCNF(node[0], false);
-    SatLiteral q = toCNF(node[1], false);
+    SatLiteral p = toCNF(node[0], false, POLARITY_BOTH);
+    SatLiteral q = toCNF(node[1], false, POLARITY_BOTH);
     // Construct the clauses (p => !q) and (!q => p)
     SatClause clause1(2);
     clause1[0] = ~p;
@@ -588,8 +916,8 @@ void TseitinCnfStream::convertAndAssertXor(TNode node, bool negated) {
     assertClause(node, clause2);
   } else {
     // !(p XOR q) is the same as p <=> q
-    SatLiteral p = toCNF(node[0], false);
-    SatLiteral q = toCNF(node[1], false);
+    SatLiteral p = toCNF(node[0], false, POLARITY_BOTH);
+    SatLiteral q = toCNF(node[1], false, POLARITY_BOTH);
     // Construct the clauses (p => q) and (q => p)
     SatClause clause1(2);
     clause1[0] = ~p;
@@ -605,8 +933,8 @@ void TseitinCnfStream::convertAndAssertXor(TNode node, bool negated) {
 void TseitinCnfStream::convertAndAssertIff(TNode node, bool negated) {
   if (!negated) {
     // p <=> q
-    SatLiteral p = toCNF(node[0], false);
-    SatLiteral q = toCNF(node[1], false);
+    SatLiteral p = toCNF(node[0], false, POLARITY_BOTH);
+    SatLiteral q = toCNF(node[1], false, POLARITY_BOTH);
     // Construct the clauses (p => q) and (q => p)
     SatClause clause1(2);
     clause1[0] = ~p;
@@ -618,8 +946,8 @@ void TseitinCnfStream::convertAndAssertIff(TNode node, bool negated) {
     assertClause(node, clause2);
   } else {
     // !(p <=> q) is the same as p XOR q
-    SatLiteral p = toCNF(node[0], false);
-    SatLiteral q = toCNF(node[1], false);
+    SatLiteral p = toCNF(node[0], false, POLARITY_BOTH);
+    SatLiteral q = toCNF(node[1], false, POLARITY_BOTH);
     // Construct the clauses (p => !q) and (!q => p)
     SatClause clause1(2);
     clause1[0] = ~p;
@@ -635,7 +963,7 @@ void TseitinCnfStream::convertAndAssertIff(TNode node, bool negated) {
 void TseitinCnfStream::convertAndAssertImplies(TNode node, bool negated) {
   if (!negated) {
     // p => q
-    SatLiteral p = toCNF(node[0], false);
+    SatLiteral p = toCNF(node[0], false, POLARITY_NEG);
     SatLiteral q = toCNF(node[1], false);
     // Construct the clause ~p || q
     SatClause clause(2);
@@ -653,7 +981,7 @@ void TseitinCnfStream::convertAndAssertImplies(TNode node, bool negated) {
 
 void TseitinCnfStream::convertAndAssertIte(TNode node, bool negated) {
   // ITE(p, q, r)
-  SatLiteral p = toCNF(node[0], false);
+  SatLiteral p = toCNF(node[0], false, POLARITY_BOTH);
   SatLiteral q = toCNF(node[1], negated);
   SatLiteral r = toCNF(node[2], negated);
   // Construct the clauses:
@@ -683,6 +1011,8 @@ void TseitinCnfStream::convertAndAssert(TNode node,
   Debug("cnf") << "convertAndAssert(" << node
                << ", removable = " << (removable ? "true" : "false")
                << ", negated = " << (negated ? "true" : "false") << ")" << endl;
+  // We may be re-entered from a conversion, its clauses keep its flag
+  flushClauses();
   d_removable = removable;
   PROOF
     (if (d_cnfProof) {
@@ -700,6 +1030,7 @@ void TseitinCnfStream::convertAndAssert(TNode node,
     });
 
   convertAndAssert(node, negated);
+  flushClauses();
   PROOF
     (if (d_cnfProof) {
       d_cnfProof->popCurrentAssertion();
@@ -25,6 +25,7 @@
 #ifndef CVC4__PROP__CNF_STREAM_H
 #define CVC4__PROP__CNF_STREAM_H
 
+#include "context/cdhashmap.h"
 #include "context/cdinsert_hashmap.h"
 #include "context/cdlist.h"
 #include "expr/node.h"
@@ -103,6 +104,24 @@ class CnfStream {
    */
   bool d_removable;
 
+  /**
+   * The converted clauses that are not asserted yet, stored back to back:
+   * clause i ends before d_clauseLits[d_clauseEnds[i]].  Buffering them
+   * saves allocating a SatClause per clause, they are handed to the SAT
+   * solver at once by flushClauses() when a conversion is done.
+   */
+  SatClause d_clauseLits;
+  std::vector<size_t> d_clauseEnds;
+
+  /**
+   * Whether clauses are buffered.  They are asserted right away if they are
+   * recorded in a proof or dumped, which needs the node giving rise to each.
+   */
+  bool batchClauses() const;
+
+  /** Asserts the buffered clauses to the sat solver. */
+  void flushClauses();
+
   /**
    * Asserts the given clause to the sat solver.
    * @param node the node giving rise to this clause
@@ -243,7 +262,15 @@ class CnfStream {
  * formula, then substitute the new literal for the formula, and so on,
  * recursively.
  *
- * This implementation does this in a single recursive pass. [??? -Chris]
+ * This implementation does this in a single bottom-up pass over each
+ * asserted formula, buffering the clauses and asserting them at once when
+ * the formula is done.
+ *
+ * With polarities (see --cnf-polarity) it instead follows Plaisted and
+ * Greenbaum: a literal only implies its formula if it occurs positively,
+ * and is only implied by it if it occurs negatively.  The directions that a
+ * gate is defined in are remembered, a later formula using it with another
+ * polarity adds the missing one.
  */
 class TseitinCnfStream : public CnfStream {
  public:
@@ -255,10 +282,15 @@ class TseitinCnfStream : public CnfStream {
    * @param context the context that the CNF should respect.
    * @param fullLitToNodeMap maintain a full SAT-literal-to-Node mapping,
    * even for non-theory literals
+   * @param name string identifier to distinguish between different instances
+   * @param polarity only define the gates in the directions they are used in
    */
-  TseitinCnfStream(SatSolver* satSolver, Registrar* registrar,
-                   context::Context* context, bool fullLitToNodeMap = false,
-                   std::string name = "");
+  TseitinCnfStream(SatSolver* satSolver,
+                   Registrar* registrar,
+                   context::Context* context,
+                   bool fullLitToNodeMap = false,
+                   std::string name = "",
+                   bool polarity = false);
 
   /**
    * Convert a given formula to CNF and assert it to the SAT solver.
@@ -273,6 +305,26 @@ class TseitinCnfStream : public CnfStream {
                         TNode from = TNode::null()) override;
 
  private:
+  /** The directions a gate can be defined in */
+  enum
+  {
+    /** The literal of the gate implies its formula */
+    POLARITY_POS = 1,
+    /** The formula of the gate implies its literal */
+    POLARITY_NEG = 2,
+    /** The literal of the gate is equivalent to its formula */
+    POLARITY_BOTH = POLARITY_POS | POLARITY_NEG
+  };
+
+  /** Map from gates to the directions they are defined in */
+  typedef context::CDHashMap<Node, unsigned, NodeHashFunction> GatePolarityMap;
+
+  /** Whether only the needed directions of the gates are defined */
+  const bool d_polarity;
+
+  /** The directions the gates are defined in, if d_polarity */
+  GatePolarityMap d_gatePolarities;
+
   /**
    * Same as above, except that removable is remembered.
    */
@@ -304,13 +356,40 @@ class TseitinCnfStream : public CnfStream {
   void convertAndAssertIte(TNode node, bool negated);
 
   /**
-   * Transforms the node into CNF recursively.
+   * Transforms the node into CNF, translating the nodes below it that are
+   * not in the translation cache bottom-up.
    * @param node the formula to transform
    * @param negated whether the literal is negated
    * @return the literal representing the root of the formula
    */
   SatLiteral toCNF(TNode node, bool negated = false);
 
+  /**
+   * Same as above, with the directions the formula needs to be defined in
+   * (POLARITY_POS if the returned literal is asserted, POLARITY_NEG if its
+   * negation is).  Only matters with d_polarity.
+   */
+  SatLiteral toCNF(TNode node, bool negated, unsigned polarity);
+
+  /**
+   * Defines the gates below node in the directions they need to be in for
+   * node to be defined in the given ones, with d_polarity.
+   * @return the literal representing node
+   */
+  SatLiteral define(TNode node, unsigned polarity);
+
+  /**
+   * Returns the literal of a node, which is allocated without defining it if
+   * it is a gate, with d_polarity.
+   */
+  SatLiteral gateLiteral(TNode node);
+
+  /**
+   * Translates a node that is not in the translation cache with the handler
+   * for its kind, or as an atom.
+   */
+  SatLiteral translate(TNode node);
+
   void ensureLiteral(TNode n, bool noPreregistration = false) override;
 
 }; /* class TseitinCnfStream */
@@ -0,0 +1,230 @@
+/*********************                                                        */
+/*! \file cube_generator.cpp
+ ** \verbatim
+ ** Top contributors (to current version):
+ **
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2019 by the authors listed in the file AUTHORS
+ ** in the top-level source directory) and their institutional affiliations.
+ ** All rights reserved.  See the file COPYING in the top-level source
+ ** directory for licensing information.\endverbatim
+ **
+ ** \brief Lookahead-based cube generation for cube-and-conquer
+ **
+ ** Lookahead-based generation of cubes, conjunctions of literals that split
+ ** the search space of a problem into parts that can be solved independently
+ ** (see --cubes).
+ **/
+
+#include "prop/cube_generator.h"
+
+#include <algorithm>
+#include <deque>
+#include <unordered_set>
+
+#include "decision/justification_heuristic.h"
+#include "expr/node_algorithm.h"
+#include "options/prop_options.h"
+#include "prop/cnf_stream.h"
+#include "prop/sat_solver.h"
+#include "smt/smt_statistics_registry.h"
+
+namespace CVC4 {
+namespace prop {
+
+CubeGenerator::CubeGenerator(DPLLSatSolverInterface* satSolver,
+                             CnfStream* cnfStream)
+    : d_satSolver(satSolver),
+      d_cnfStream(cnfStream),
+      d_statCubes("prop::cubes::generated", 0),
+      d_statLookaheads("prop::cubes::lookaheads", 0),
+      d_statTime("prop::cubes::time")
+{
+  AlwaysAssert(satSolver->supportsLookahead())
+      << "Cube generation needs a SAT solver that supports lookahead";
+  smtStatisticsRegistry()->registerStat(&d_statCubes);
+  smtStatisticsRegistry()->registerStat(&d_statLookaheads);
+  smtStatisticsRegistry()->registerStat(&d_statTime);
+}
+
+CubeGenerator::~CubeGenerator()
+{
+  smtStatisticsRegistry()->unregisterStat(&d_statCubes);
+  smtStatisticsRegistry()->unregisterStat(&d_statLookaheads);
+  smtStatisticsRegistry()->unregisterStat(&d_statTime);
+}
+
+void CubeGenerator::collectCandidates()
+{
+  d_candidates.clear();
+  const CnfStream::NodeToLiteralMap& cache = d_cnfStream->getTranslationCache();
+  for (CnfStream::NodeToLiteralMap::key_iterator it = cache.key_begin();
+       it != cache.key_end();
+       ++it)
+  {
+    TNode atom = *it;
+    switch (atom.getKind())
+    {
+      case kind::CONST_BOOLEAN:
+      case kind::NOT:
+      case kind::XOR:
+      case kind::ITE:
+      case kind::IMPLIES:
+      case kind::OR:
+      case kind::AND: continue;
+      case kind::EQUAL:
+        if (atom[0].getType().isBoolean())
+        {
+          continue;
+        }
+        break;
+      default: break;
+    }
+    if (expr::hasBoundVar(atom))
+    {
+      continue;
+    }
+    std::unordered_set<Node, NodeHashFunction> syms;
+    expr::getSymbols(atom, syms);
+    bool userSymbols = true;
+    for (const Node& s : syms)
+    {
+      userSymbols = userSymbols && s.getKind() == kind::VARIABLE;
+    }
+    if (!userSymbols)
+    {
+      continue;
+    }
+    Candidate c;
+    c.d_lit = d_cnfStream->getLiteral(atom);
+    c.d_weight = options::cubeUseWeight()
+                     ? decision::JustificationHeuristic::getWeight(atom)
+                     : 0;
+    c.d_score = lookahead(c.d_lit);
+    if (c.d_score > 0)
+    {
+      d_candidates.push_back(c);
+    }
+  }
+  std::stable_sort(d_candidates.begin(),
+                   d_candidates.end(),
+                   [](const Candidate& a, const Candidate& b) {
+                     return a.d_weight != b.d_weight ? a.d_weight > b.d_weight
+                                                     : a.d_score > b.d_score;
+                   });
+  Debug("cubes") << "cubes: " << d_candidates.size() << " candidate atoms"
+                 << std::endl;
+}
+
+uint64_t CubeGenerator::lookahead(SatLiteral lit)
+{
+  if (d_satSolver->value(lit) != SAT_VALUE_UNKNOWN)
+  {
+    return 0;
+  }
+  uint64_t base = d_satSolver->getNumAssigned();
+  uint64_t propagated[2];
+  for (unsigned i = 0; i < 2; ++i)
+  {
+    ++d_statLookaheads;
+    bool ok = d_satSolver->lookaheadPush(i == 0 ? lit : ~lit);
+    propagated[i] = d_satSolver->getNumAssigned() - base;
+    d_satSolver->lookaheadPop();
+    if (!ok)
+    {
+      return 0;
+    }
+  }
+  // prefer balanced splits, break ties by the total
+  return (propagated[0] * propagated[1] << 10) + propagated[0]
+         + propagated[1];
+}
+
+bool CubeGenerator::split(const Cube& cube, SatLiteral& lit)
+{
+  size_t levels = 0;
+  bool conflict = false;
+  for (const SatLiteral& l : cube)
+  {
+    ++levels;
+    if (!d_satSolver->lookaheadPush(l))
+    {
+      conflict = true;
+      break;
+    }
+  }
+
+  uint64_t best = 0;
+  if (!conflict)
+  {
+    // look ahead on the best atoms at level 0 that are still unassigned
+    unsigned evaluated = 0;
+    for (const Candidate& c : d_candidates)
+    {
+      if (evaluated >= options::cubeCandidates())
+      {
+        break;
+      }
+      if (d_satSolver->value(c.d_lit) != SAT_VALUE_UNKNOWN)
+      {
+        continue;
+      }
+      ++evaluated;
+      uint64_t score = lookahead(c.d_lit);
+      if (score > best)
+      {
+        best = score;
+        lit = c.d_lit;
+      }
+    }
+  }
+
+  for (; levels > 0; --levels)
+  {
+    d_satSolver->lookaheadPop();
+  }
+  return best > 0;
+}
+
+void CubeGenerator::generate(unsigned numCubes,
+                             std::vector<std::vector<Node>>& cubes)
+{
+  TimerStat::CodeTimer codeTimer(d_statTime);
+  collectCandidates();
+
+  // split the oldest cube until there are enough
+  std::vector<Cube> leaves;
+  std::deque<Cube> open(1);
+  while (!open.empty() && open.size() + leaves.size() < numCubes)
+  {
+    Cube cube = open.front();
+    open.pop_front();
+    SatLiteral lit;
+    if (!split(cube, lit))
+    {
+      leaves.push_back(cube);
+      continue;
+    }
+    Debug("cubes") << "cubes: splitting a cube of size " << cube.size()
+                   << " on " << d_cnfStream->getNode(lit) << std::endl;
+    cube.push_back(lit);
+    open.push_back(cube);
+    cube.back() = ~lit;
+    open.push_back(cube);
+  }
+  leaves.insert(leaves.end(), open.begin(), open.end());
+
+  cubes.clear();
+  for (const Cube& cube : leaves)
+  {
+    cubes.emplace_back();
+    for (const SatLiteral& l : cube)
+    {
+      cubes.back().push_back(d_cnfStream->getNode(l));
+    }
+  }
+  d_statCubes += cubes.size();
+}
+
+}  // namespace prop
+}  // namespace CVC4
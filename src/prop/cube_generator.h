@@ -0,0 +1,120 @@
+/*********************                                                        */
+/*! \file cube_generator.h
+ ** \verbatim
+ ** Top contributors (to current version):
+ **
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2019 by the authors listed in the file AUTHORS
+ ** in the top-level source directory) and their institutional affiliations.
+ ** All rights reserved.  See the file COPYING in the top-level source
+ ** directory for licensing information.\endverbatim
+ **
+ ** \brief Lookahead-based cube generation for cube-and-conquer
+ **
+ ** Lookahead-based generation of cubes, conjunctions of literals that split
+ ** the search space of a problem into parts that can be solved independently
+ ** (see --cubes).
+ **/
+
+#include "cvc4_private.h"
+
+#ifndef CVC4__PROP__CUBE_GENERATOR_H
+#define CVC4__PROP__CUBE_GENERATOR_H
+
+#include <cstdint>
+#include <vector>
+
+#include "expr/node.h"
+#include "prop/sat_solver_types.h"
+#include "util/statistics_registry.h"
+
+namespace CVC4 {
+namespace prop {
+
+class CnfStream;
+class DPLLSatSolverInterface;
+
+/**
+ * Generates cubes by lookahead on the SAT solver.
+ *
+ * Starting from the empty cube, the oldest cube is split on the atom with
+ * the best lookahead score under it until there are enough cubes.  The score
+ * of an atom is the product of the numbers of literals that deciding it
+ * either way propagates, as in march.  Atoms for which one of the decisions
+ * fails are not split on, one of the cubes would be trivial.
+ *
+ * A split covers both polarities of its atom, so the disjunction of the
+ * cubes is valid whatever the atoms mean.  This is why cubes that lead to a
+ * conflict here are kept: another solver instance that preprocesses the
+ * problem differently may still need to solve them.
+ */
+class CubeGenerator
+{
+ public:
+  /** satSolver must support lookahead, see supportsLookahead() */
+  CubeGenerator(DPLLSatSolverInterface* satSolver, CnfStream* cnfStream);
+  ~CubeGenerator();
+
+  /**
+   * Generate numCubes cubes over the atoms of the problem in the SAT solver,
+   * fewer if there are not enough atoms to split on.  The SAT solver must
+   * be at decision level 0.
+   */
+  void generate(unsigned numCubes, std::vector<std::vector<Node>>& cubes);
+
+ private:
+  /** A cube, as SAT literals */
+  typedef std::vector<SatLiteral> Cube;
+
+  /** An atom to split on */
+  struct Candidate
+  {
+    /** The positive literal of the atom */
+    SatLiteral d_lit;
+    /** Its decision weight, see --cube-use-weight */
+    uint64_t d_weight;
+    /** Its lookahead score at decision level 0 */
+    uint64_t d_score;
+  };
+
+  /**
+   * Collect the atoms to split on: those over user-declared symbols, which
+   * mean the same in every solver instance.
+   */
+  void collectCandidates();
+
+  /**
+   * The lookahead score of lit under the current assignment, 0 if it is
+   * assigned or deciding it either way fails.
+   */
+  uint64_t lookahead(SatLiteral lit);
+
+  /**
+   * Split cube into cube + lit and cube + ~lit for the best atom, return
+   * false if it has to stay a cube.
+   */
+  bool split(const Cube& cube, SatLiteral& lit);
+
+  /** The SAT solver */
+  DPLLSatSolverInterface* d_satSolver;
+
+  /** The CNF stream translating the atoms */
+  CnfStream* d_cnfStream;
+
+  /** The atoms to split on, best first */
+  std::vector<Candidate> d_candidates;
+
+  /** Statistic: the number of cubes generated */
+  IntStat d_statCubes;
+
+  /** Statistic: the number of lookaheads */
+  IntStat d_statLookaheads;
+
+  /** Statistic: time spent generating cubes */
+  TimerStat d_statTime;
+}; /* class CubeGenerator */
+
+}  // namespace prop
+}  // namespace CVC4
+
+#endif /* CVC4__PROP__CUBE_GENERATOR_H */
@@ -167,6 +167,18 @@ Solver::Solver(CVC4::prop::TheoryProxy* proxy, CVC4::context::Context* context,
   , garbage_frac     (opt_garbage_frac)
   , restart_first    (opt_restart_first)
   , restart_inc      (opt_restart_inc)
+  , ema_restart      (false)
+  , restart_margin   (1.25)
+  , restart_min_confl(50)
+  , restart_block    (1.4)
+  , lbd_tiers        (false)
+  , lbd_core         (2)
+  , lbd_mid          (6)
+  , share_max_size   (8)
+  , share_max_lbd    (3)
+  , reduce_first     (2000)
+  , reduce_inc       (300)
+  , trace_interval   (0)
 
     // Parameters (the rest):
     //
@@ -181,11 +193,14 @@ Solver::Solver(CVC4::prop::TheoryProxy* proxy, CVC4::context::Context* context,
     //
   , solves(0), starts(0), decisions(0), rnd_decisions(0), propagations(0), conflicts(0), resources_consumed(0)
   , dec_vars(0), clauses_literals(0), learnts_literals(0), max_literals(0), tot_literals(0)
+  , reductions(0), blocked_restarts(0)
+  , theory_conflicts(0), theory_propagations(0)
 
   , ok                 (true)
   , cla_inc            (1)
   , var_inc            (1)
   , watches            (WatcherDeleted(ca))
+  , watches_bin        (BinWatcherDeleted(ca))
   , qhead              (0)
   , simpDB_assigns     (-1)
   , simpDB_props       (0)
@@ -193,6 +208,12 @@ Solver::Solver(CVC4::prop::TheoryProxy* proxy, CVC4::context::Context* context,
   , progress_estimate  (0)
   , remove_satisfied   (!enable_incremental)
 
+  , lbd_counter        (0)
+  , next_reduce        (0)
+  , lbd_ema_fast       (0)
+  , lbd_ema_slow       (0)
+  , trail_ema          (0)
+
     // Resource constraints:
     //
   , conflict_budget    (-1)
@@ -235,8 +256,11 @@ Var Solver::newVar(bool sign, bool dvar, bool isTheoryAtom, bool preRegister, bo
 
     watches  .init(mkLit(v, false));
     watches  .init(mkLit(v, true ));
+    watches_bin.init(mkLit(v, false));
+    watches_bin.init(mkLit(v, true ));
     assigns  .push(l_Undef);
     vardata  .push(VarData(CRef_Undef, -1, -1, assertionLevel, -1));
+    implied_by.push(ImpliedBy());
     activity .push(rnd_init_act ? drand(random_seed) * 0.00001 : 0);
     seen     .push(0);
     polarity .push(sign);
@@ -265,10 +289,12 @@ void Solver::resizeVars(int newSize) {
 
     // Resize watches up to the negated last literal
     watches.resizeTo(mkLit(newSize-1, true));
+    watches_bin.resizeTo(mkLit(newSize-1, true));
 
     // Resize all info arrays
     assigns.shrink(shrinkSize);
     vardata.shrink(shrinkSize);
+    implied_by.shrink(shrinkSize);
     activity.shrink(shrinkSize);
     seen.shrink(shrinkSize);
     polarity.shrink(shrinkSize);
@@ -381,6 +407,7 @@ CRef Solver::reason(Var x) {
           // added (see issue #2137).
           ProofManager::getCnfProof()->popCurrentAssertion(););
     vardata[x] = VarData(real_reason, level(x), user_level(x), intro_level(x), trail_index(x));
+    if (explanation.size() == 2) implied_by[x] = ImpliedBy(explanation[1], explLevel);
     clauses_removable.push(real_reason);
     attachClause(real_reason);
 
@@ -547,8 +574,13 @@ void Solver::attachClause(CRef cr) {
     const Clause& c = ca[cr];
     Debug("minisat") << "Solver::attachClause(" << c << "): level " << c.level() << std::endl;
     Assert(c.size() > 1);
-    watches[~c[0]].push(Watcher(cr, c[1]));
-    watches[~c[1]].push(Watcher(cr, c[0]));
+    if (c.size() == 2){
+        watches_bin[~c[0]].push(BinWatcher(cr, c[1], c.level()));
+        watches_bin[~c[1]].push(BinWatcher(cr, c[0], c.level()));
+    }else{
+        watches[~c[0]].push(Watcher(cr, c[1]));
+        watches[~c[1]].push(Watcher(cr, c[0]));
+    }
     if (c.removable()) learnts_literals += c.size();
     else            clauses_literals += c.size();
 }
@@ -561,12 +593,22 @@ void Solver::detachClause(CRef cr, bool strict) {
     assert(c.size() > 1);
 
     if (strict){
-        remove(watches[~c[0]], Watcher(cr, c[1]));
-        remove(watches[~c[1]], Watcher(cr, c[0]));
+        if (c.size() == 2){
+            remove(watches_bin[~c[0]], BinWatcher(cr, c[1], c.level()));
+            remove(watches_bin[~c[1]], BinWatcher(cr, c[0], c.level()));
+        }else{
+            remove(watches[~c[0]], Watcher(cr, c[1]));
+            remove(watches[~c[1]], Watcher(cr, c[0]));
+        }
     }else{
         // Lazy detaching: (NOTE! Must clean all watcher lists before garbage collecting this clause)
-        watches.smudge(~c[0]);
-        watches.smudge(~c[1]);
+        if (c.size() == 2){
+            watches_bin.smudge(~c[0]);
+            watches_bin.smudge(~c[1]);
+        }else{
+            watches.smudge(~c[0]);
+            watches.smudge(~c[1]);
+        }
     }
 
     if (c.removable()) learnts_literals -= c.size();
@@ -578,7 +620,11 @@ void Solver::removeClause(CRef cr) {
     Debug("minisat::remove-clause") << "Solver::removeClause(" << c << ")" << std::endl;
     detachClause(cr);
     // Don't leave pointers to free'd memory!
-    if (locked(c)) vardata[var(c[0])].reason = CRef_Undef;
+    Lit p = propagatedLit(c);
+    if (p != lit_Undef) {
+        vardata[var(p)].reason = CRef_Undef;
+        implied_by[var(p)] = ImpliedBy();
+    }
     c.mark(1);
     ca.free(cr);
 }
@@ -631,6 +677,20 @@ void Solver::cancelUntil(int level) {
 
 void Solver::resetTrail() { cancelUntil(0); }
 
+bool Solver::lookaheadPush(Lit p)
+{
+    newDecisionLevel();
+    if (!ok || value(p) == l_False) return false;
+    if (value(p) == l_Undef) uncheckedEnqueue(p);
+    return propagate(CHECK_WITHOUT_THEORY) == CRef_Undef;
+}
+
+void Solver::lookaheadPop()
+{
+    assert(decisionLevel() > 0);
+    cancelUntil(decisionLevel() - 1);
+}
+
 //=================================================================================================
 // Major methods:
 
@@ -774,6 +834,23 @@ Lit Solver::pickBranchLit()
 }
 
 
+template<class Lits>
+int Solver::computeLBD(const Lits& lits)
+{
+    lbd_stamp.growTo(decisionLevel() + 1, 0);
+    lbd_counter++;
+    int lbd = 0;
+    for (int i = 0; i < lits.size(); i++){
+        int l = level(var(lits[i]));
+        assert(value(lits[i]) != l_Undef && l <= decisionLevel());
+        if (lbd_stamp[l] != lbd_counter){
+            lbd_stamp[l] = lbd_counter;
+            lbd++; }
+    }
+    return lbd;
+}
+
+
 /*_________________________________________________________________________________________________
 |
 |  analyze : (confl : Clause*) (out_learnt : vec<Lit>&) (out_btlevel : int&)  ->  [void]
@@ -805,10 +882,45 @@ int Solver::analyze(CRef confl, vec<Lit>& out_learnt, int& out_btlevel)
     int max_resolution_level = 0; // Maximal level of the resolved clauses
 
     PROOF( ProofManager::getSatProof()->startResChain(confl); )
+    // Account for the antecedent q of the literal being resolved
+    auto analyzeLit = [&](Lit q) {
+        if (!seen[var(q)] && level(var(q)) > 0)
+        {
+          varBumpActivity(var(q));
+          seen[var(q)] = 1;
+          if (level(var(q)) >= decisionLevel())
+            pathC++;
+          else
+            out_learnt.push(q);
+        }
+        else
+        {
+          // We could be resolving a literal propagated by a clause/theory
+          // using information from a higher level
+          if (!seen[var(q)] && level(var(q)) == 0)
+          {
+            max_resolution_level =
+                std::max(max_resolution_level, user_level(var(q)));
+          }
+
+          // FIXME: can we do it lazily if we actually need the proof?
+          if (level(var(q)) == 0)
+          {
+            PROOF(ProofManager::getSatProof()->resolveOutUnit(q);)
+          }
+        }
+    };
+
     do{
         assert(confl != CRef_Undef); // (otherwise should be UIP)
 
-        {
+        // Binary reasons are resolved through the implication graph without
+        // touching the clause.
+        ImpliedBy imp = p == lit_Undef ? ImpliedBy() : implied_by[var(p)];
+        if (imp.lit != lit_Undef) {
+          max_resolution_level = std::max(max_resolution_level, imp.level);
+          analyzeLit(imp.lit);
+        } else {
           // ! IMPORTANT !
           // It is not safe to use c after this block of code because
           // resolveOutUnit() below may lead to clauses being allocated, which
@@ -816,39 +928,22 @@ int Solver::analyze(CRef confl, vec<Lit>& out_learnt, int& out_btlevel)
           Clause& c = ca[confl];
           max_resolution_level = std::max(max_resolution_level, c.level());
 
-          if (c.removable()) claBumpActivity(c);
-        }
-
-        for (int j = (p == lit_Undef) ? 0 : 1, size = ca[confl].size();
-             j < size;
-             j++)
-        {
-          Lit q = ca[confl][j];
-
-          if (!seen[var(q)] && level(var(q)) > 0)
-          {
-            varBumpActivity(var(q));
-            seen[var(q)] = 1;
-            if (level(var(q)) >= decisionLevel())
-              pathC++;
-            else
-              out_learnt.push(q);
-          }
-          else
-          {
-            // We could be resolving a literal propagated by a clause/theory
-            // using information from a higher level
-            if (!seen[var(q)] && level(var(q)) == 0)
-            {
-              max_resolution_level =
-                  std::max(max_resolution_level, user_level(var(q)));
+          if (c.removable()) {
+            claBumpActivity(c);
+            if (lbd_tiers && c.lbd() > lbd_core) {
+              // Move the clause to a better tier if its LBD improved, and
+              // protect it from the next reduction
+              int lbd = computeLBD(c);
+              if (lbd < c.lbd()) c.lbd(lbd);
+              c.used(true);
             }
+          }
 
-            // FIXME: can we do it lazily if we actually need the proof?
-            if (level(var(q)) == 0)
-            {
-              PROOF(ProofManager::getSatProof()->resolveOutUnit(q);)
-            }
+          for (int j = (p == lit_Undef) ? 0 : 1, size = ca[confl].size();
+               j < size;
+               j++)
+          {
+            analyzeLit(ca[confl][j]);
           }
         }
 
@@ -944,16 +1039,18 @@ bool Solver::litRedundant(Lit p, uint32_t abstract_levels)
     analyze_stack.clear(); analyze_stack.push(p);
     int top = analyze_toclear.size();
     while (analyze_stack.size() > 0){
-        CRef c_reason = reason(var(analyze_stack.last()));
+        Var x = var(analyze_stack.last());
+        CRef c_reason = reason(x);
         assert(c_reason != CRef_Undef);
-        Clause& c = ca[c_reason];
-        int c_size = c.size();
         analyze_stack.pop();
+        // Binary reasons come from the implication graph
+        Lit imp = implied_by[x].lit;
+        int c_size = imp != lit_Undef ? 2 : ca[c_reason].size();
 
         // Since calling reason might relocate to resize, c is not necesserily the right reference, we must
         // use the allocator each time
         for (int i = 1; i < c_size; i++){
-            Lit p  = ca[c_reason][i];
+            Lit p  = imp != lit_Undef ? imp : ca[c_reason][i];
             if (!seen[var(p)] && level(var(p)) > 0){
                 if (reason(var(p)) != CRef_Undef && (abstractLevel(var(p)) & abstract_levels) != 0){
                     seen[var(p)] = 1;
@@ -998,6 +1095,9 @@ void Solver::analyzeFinal(Lit p, vec<Lit>& out_conflict)
             if (reason(x) == CRef_Undef){
                 assert(level(x) > 0);
                 out_conflict.push(~trail[i]);
+            }else if (implied_by[x].lit != lit_Undef){
+                if (level(var(implied_by[x].lit)) > 0)
+                    seen[var(implied_by[x].lit)] = 1;
             }else{
                 Clause& c = ca[reason(x)];
                 for (int j = 1; j < c.size(); j++)
@@ -1019,6 +1119,7 @@ void Solver::uncheckedEnqueue(Lit p, CRef from)
     assert(var(p) < nVars());
     assigns[var(p)] = lbool(!sign(p));
     vardata[var(p)] = VarData(from, decisionLevel(), assertionLevel, intro_level(var(p)), trail.size());
+    implied_by[var(p)] = ImpliedBy();
     trail.push_(p);
     if (theory[var(p)]) {
       // Enqueue to the theory
@@ -1129,6 +1230,7 @@ void Solver::propagateTheory() {
     Lit p = propagatedLiterals[i];
     if (value(p) == l_Undef) {
       uncheckedEnqueue(p, CRef_Lazy);
+      theory_propagations++;
     } else {
       if (value(p) == l_False) {
         Debug("minisat") << "Conflict in theory propagation" << std::endl;
@@ -1177,6 +1279,7 @@ CRef Solver::propagateBool()
     CRef    confl     = CRef_Undef;
     int     num_props = 0;
     watches.cleanAll();
+    watches_bin.cleanAll();
 
     while (qhead < trail.size()){
         Lit            p   = trail[qhead++];     // 'p' is enqueued fact to propagate.
@@ -1190,6 +1293,24 @@ CRef Solver::propagateBool()
           dtviewBoolPropagationHelper(decisionLevel(), p, proxy);
         }
 
+        // Binary clauses first: the other literal is the blocker, so the clause
+        // itself is never inspected.
+        vec<BinWatcher>& wbin = watches_bin[p];
+        for (int k = 0; k < wbin.size(); k++){
+            Lit imp = wbin[k].blocker;
+            if (value(imp) == l_Undef){
+                uncheckedEnqueue(imp, wbin[k].cref);
+                implied_by[var(imp)] = ImpliedBy(~p, wbin[k].level);
+            }else if (value(imp) == l_False){
+                confl = wbin[k].cref;
+                break;
+            }
+        }
+        if (confl != CRef_Undef){
+            qhead = trail.size();
+            break;
+        }
+
         for (i = j = (Watcher*)ws, end = i + ws.size();  i != end;){
             // Try to avoid inspecting the clause:
             Lit blocker = i->blocker;
@@ -1257,6 +1378,12 @@ struct reduceDB_lt {
 };
 void Solver::reduceDB()
 {
+    reductions++;
+    if (lbd_tiers) {
+        reduceDBTiered();
+        return;
+    }
+
     int     i, j;
     double  extra_lim = cla_inc / clauses_removable.size();    // Remove any clause below this activity
 
@@ -1274,6 +1401,59 @@ void Solver::reduceDB()
     checkGarbage();
 }
 
+/*_________________________________________________________________________________________________
+|
+|  reduceDBTiered : ()  ->  [void]
+|
+|  Description:
+|    Glucose-style reduction. Learnt clauses with LBD at most 'lbd_core' are kept. Clauses with LBD
+|    at most 'lbd_mid' are kept if they took part in a conflict since the last reduction. Of the
+|    remaining (local) clauses, the worse half by LBD and then activity is removed, except for
+|    binary, locked and recently used clauses.
+|________________________________________________________________________________________________@*/
+struct reduceDBTiered_lt {
+    ClauseAllocator& ca;
+    reduceDBTiered_lt(ClauseAllocator& ca_) : ca(ca_) {}
+    bool operator () (CRef x, CRef y) {
+        if (ca[x].lbd() != ca[y].lbd()) return ca[x].lbd() > ca[y].lbd();
+        return ca[x].activity() < ca[y].activity(); }
+};
+void Solver::reduceDBTiered()
+{
+    int       i, j;
+    vec<CRef> local;
+    for (i = j = 0; i < clauses_removable.size(); i++){
+        Clause& c = ca[clauses_removable[i]];
+        if (c.size() <= 2 || c.lbd() <= lbd_core)
+            clauses_removable[j++] = clauses_removable[i];
+        else if (c.lbd() <= lbd_mid && c.used()){
+            c.used(false);
+            clauses_removable[j++] = clauses_removable[i];
+        }else
+            local.push(clauses_removable[i]);
+    }
+    clauses_removable.shrink(i - j);
+
+    sort(local, reduceDBTiered_lt(ca));
+    for (i = 0; i < local.size(); i++){
+        Clause& c = ca[local[i]];
+        if (i < local.size() / 2 && !locked(c) && !c.used())
+            removeClause(local[i]);
+        else{
+            c.used(false);
+            clauses_removable.push(local[i]);
+        }
+    }
+    next_reduce = conflicts + reduce_first + reduce_inc * reductions;
+    checkGarbage();
+}
+
+bool Solver::reduceDue() const
+{
+    if (lbd_tiers) return conflicts >= next_reduce;
+    return clauses_removable.size() - nAssigns() >= max_learnts;
+}
+
 
 void Solver::removeSatisfied(vec<CRef>& cs)
 {
@@ -1283,7 +1463,7 @@ void Solver::removeSatisfied(vec<CRef>& cs)
         if (satisfied(c)) {
           if (locked(c)) {
             // store a resolution of the literal c propagated
-            PROOF( ProofManager::getSatProof()->storeUnitResolution(c[0]); )
+            PROOF( ProofManager::getSatProof()->storeUnitResolution(propagatedLit(c)); )
           }
             removeClause(cs[i]);
         }
@@ -1371,6 +1551,9 @@ lbool Solver::search(int nof_conflicts)
     vec<Lit>    learnt_clause;
     starts++;
 
+    // Short learnt clauses of user level 0 are shared with the portfolio
+    bool share_clauses = share_max_size > 0 && proxy->isSharingClauses();
+
     TheoryCheckType check_type = CHECK_WITH_THEORY;
     for (;;) {
 
@@ -1381,6 +1564,11 @@ lbool Solver::search(int nof_conflicts)
         if (confl != CRef_Undef) {
 
             conflicts++; conflictC++;
+            if (theoryConflict) theory_conflicts++;
+            if (trace_interval > 0 && conflicts % trace_interval == 0) {
+              proxy->traceSearch(conflicts, decisions, propagations,
+                                 theory_conflicts, theory_propagations);
+            }
 
             if (decisionLevel() == 0) {
                 PROOF( ProofManager::getSatProof()->finalizeProof(confl); )
@@ -1390,6 +1578,11 @@ lbool Solver::search(int nof_conflicts)
             // Analyze the conflict
             learnt_clause.clear();
             int max_level = analyze(confl, learnt_clause, backtrack_level);
+            int lbd = learnt_clause.size();
+            if (lbd_tiers || ema_restart || share_clauses) {
+                lbd = computeLBD(learnt_clause);
+                updateRestartAverages(lbd);
+            }
             cancelUntil(backtrack_level);
 
             // Assert the conflict clause and the asserting literal
@@ -1406,6 +1599,7 @@ lbool Solver::search(int nof_conflicts)
               clauses_removable.push(cr);
               attachClause(cr);
               claBumpActivity(ca[cr]);
+              ca[cr].lbd(lbd);
               uncheckedEnqueue(learnt_clause[0], cr);
               PROOF(ClauseId id =
                         ProofManager::getSatProof()->registerClause(cr, LEARNT);
@@ -1418,6 +1612,16 @@ lbool Solver::search(int nof_conflicts)
                             ->endResChain(id););
             }
 
+            if (share_clauses && learnt_clause.size() <= share_max_size
+                && lbd <= share_max_lbd
+                && (assertionLevelOnly() ? assertionLevel : max_level) == 0)
+            {
+              SatClause shared;
+              for (int i = 0; i < learnt_clause.size(); ++i)
+                shared.push_back(MinisatSatSolver::toSatLiteral(learnt_clause[i]));
+              proxy->exportClause(shared);
+            }
+
             varDecayActivity();
             claDecayActivity();
 
@@ -1460,7 +1664,7 @@ lbool Solver::search(int nof_conflicts)
               check_type = CHECK_WITH_THEORY;
             }
 
-            if ((nof_conflicts >= 0 && conflictC >= nof_conflicts)
+            if (restartDue(nof_conflicts, conflictC)
                 || !withinBudget(ResourceManager::Resource::SatConflictStep))
             {
               // Reached bound on number of conflicts:
@@ -1477,7 +1681,7 @@ lbool Solver::search(int nof_conflicts)
                 return l_False;
             }
 
-            if (clauses_removable.size()-nAssigns() >= max_learnts) {
+            if (reduceDue()) {
                 // Reduce the set of learnt clauses:
                 reduceDB();
             }
@@ -1565,6 +1769,33 @@ static double luby(double y, int x){
     return pow(y, seq);
 }
 
+// Update an exponential moving average with smoothing factor 'alpha'. The first 1/alpha values are
+// averaged uniformly instead, so that the average is not biased towards its initial value.
+static inline void emaUpdate(double& ema, double x, double alpha, uint64_t n){
+    double a = std::max(alpha, 1.0 / n);
+    ema += a * (x - ema);
+}
+
+void Solver::updateRestartAverages(int lbd)
+{
+    // Postpone restarts while the trail is much larger than usual: the solver may be close to a
+    // model (restart blocking as in Glucose).
+    if (ema_restart && conflicts > 10000 && trail.size() > restart_block * trail_ema){
+        lbd_ema_fast = lbd_ema_slow;
+        blocked_restarts++;
+    }
+    emaUpdate(trail_ema,    trail.size(), 1.0 / 5000,  conflicts);
+    emaUpdate(lbd_ema_fast, lbd,          1.0 / 32,    conflicts);
+    emaUpdate(lbd_ema_slow, lbd,          1.0 / 10000, conflicts);
+}
+
+bool Solver::restartDue(int nof_conflicts, int conflictC) const
+{
+    if (ema_restart)
+        return conflictC >= restart_min_confl && lbd_ema_fast > restart_margin * lbd_ema_slow;
+    return nof_conflicts >= 0 && conflictC >= nof_conflicts;
+}
+
 // NOTE: assumptions passed in member-variable 'assumptions'.
 lbool Solver::solve_()
 {
@@ -1597,9 +1828,11 @@ lbool Solver::solve_()
 
     // Search:
     int curr_restarts = 0;
+    if (next_reduce == 0) next_reduce = conflicts + reduce_first;
     while (status == l_Undef){
         double rest_base = luby_restart ? luby(restart_inc, curr_restarts) : pow(restart_inc, curr_restarts);
-        status = search(rest_base * restart_first);
+        // EMA restarts are decided by 'search()' itself
+        status = search(ema_restart ? -1 : rest_base * restart_first);
         if (!withinBudget(ResourceManager::Resource::SatConflictStep))
           break;  // FIXME add restart option?
         curr_restarts++;
@@ -1712,6 +1945,7 @@ void Solver::relocAll(ClauseAllocator& to)
     //
     // for (int i = 0; i < watches.size(); i++)
     watches.cleanAll();
+    watches_bin.cleanAll();
     for (int v = 0; v < nVars(); v++)
         for (int s = 0; s < 2; s++){
             Lit p = mkLit(v, s);
@@ -1719,6 +1953,9 @@ void Solver::relocAll(ClauseAllocator& to)
             vec<Watcher>& ws = watches[p];
             for (int j = 0; j < ws.size(); j++)
               ca.reloc(ws[j].cref, to, NULLPROOF(ProofManager::getSatProof()));
+            vec<BinWatcher>& wbin = watches_bin[p];
+            for (int j = 0; j < wbin.size(); j++)
+              ca.reloc(wbin[j].cref, to, NULLPROOF(ProofManager::getSatProof()));
         }
 
     // All reasons:
@@ -1987,6 +2224,8 @@ void ClauseAllocator::reloc(CRef& cr,
   // Copy extra data-fields:
   // (This could be cleaned-up. Generalize Clause-constructor to be applicable here instead?)
   to[cr].mark(c.mark());
+  to[cr].lbd(c.lbd());
+  to[cr].used(c.used());
   if (to[cr].removable())         to[cr].activity() = c.activity();
   else if (to[cr].has_extra()) to[cr].calcAbstraction();
 }
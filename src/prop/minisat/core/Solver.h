@@ -174,6 +174,12 @@ public:
      * level.
      */
     void resetTrail();
+
+    // Lookahead outside of solve(): decide p at a new decision level and propagate without the
+    // theories, return false on a conflict. lookaheadPop() undoes the last lookaheadPush().
+    bool    lookaheadPush (Lit p);
+    void    lookaheadPop  ();
+
     // addClause returns the ClauseId corresponding to the clause added in the
     // reference parameter id.
     bool    addClause (const vec<Lit>& ps, bool removable, ClauseId& id);  // Add a clause to the solver.
@@ -219,6 +225,7 @@ public:
     lbool   modelValue (Var x) const;       // The value of a variable in the last model. The last call to solve must have been satisfiable.
     lbool   modelValue (Lit p) const;       // The value of a literal in the last model. The last call to solve must have been satisfiable.
     int     nAssigns   ()      const;       // The current number of assigned literals.
+    Lit     trailLit   (int i) const;       // The i-th assigned literal.
     int     nClauses   ()      const;       // The current number of original clauses.
     int     nLearnts   ()      const;       // The current number of learnt clauses.
     int     nVars      ()      const;       // The current number of variables.
@@ -265,6 +272,18 @@ public:
 
     int       restart_first;      // The initial restart limit.                                                                (default 100)
     double    restart_inc;        // The factor with which the restart limit is multiplied in each restart.                    (default 1.5)
+    bool      ema_restart;        // Restart dynamically on the LBD of learnt clauses instead of by a fixed sequence.
+    double    restart_margin;     // EMA restarts happen when the fast LBD average exceeds the slow one by this factor.        (default 1.25)
+    int       restart_min_confl;  // The minimum number of conflicts between two EMA restarts.                                (default 50)
+    double    restart_block;      // EMA restarts are postponed when the trail exceeds its average by this factor.            (default 1.4)
+    bool      lbd_tiers;          // Reduce the learnt clauses in tiers by LBD instead of by activity only.
+    int       lbd_core;           // Learnt clauses with at most this LBD are never reduced.                                   (default 2)
+    int       lbd_mid;            // Learnt clauses with at most this LBD are kept while used in conflicts.                    (default 6)
+    int       share_max_size;     // Learnt clauses with at most this many literals are shared with the portfolio.         (default 8)
+    int       share_max_lbd;      // Learnt clauses with at most this LBD are shared with the portfolio.                       (default 3)
+    int       reduce_first;       // The number of conflicts before the first tiered reduction.                               (default 2000)
+    int       reduce_inc;         // The increment of the interval between two tiered reductions.                             (default 300)
+    int       trace_interval;     // Every this many conflicts a sample of the search counters is traced (0 to disable).    (default 0)
     double    learntsize_factor;  // The intitial limit for learnt clauses is a factor of the original clauses.                (default 1 / 3)
     double    learntsize_inc;     // The limit for learnt clauses is multiplied with this factor each restart.                 (default 1.1)
 
@@ -275,6 +294,8 @@ public:
     //
     uint64_t solves, starts, decisions, rnd_decisions, propagations, conflicts, resources_consumed;
     uint64_t dec_vars, clauses_literals, learnts_literals, max_literals, tot_literals;
+    uint64_t reductions, blocked_restarts;
+    uint64_t theory_conflicts, theory_propagations;
 
 protected:
 
@@ -316,6 +337,31 @@ protected:
         bool operator()(const Watcher& w) const { return ca[w.cref].mark() == 1; }
     };
 
+    // A watcher of a binary clause, which carries everything propagation and
+    // conflict analysis need to know about the clause.
+    struct BinWatcher {
+        CRef cref;
+        Lit  blocker;  // The other literal of the clause.
+        int  level;    // The assertion level of the clause.
+        BinWatcher(CRef cr, Lit p, int l) : cref(cr), blocker(p), level(l) {}
+        bool operator==(const BinWatcher& w) const { return cref == w.cref; }
+        bool operator!=(const BinWatcher& w) const { return cref != w.cref; }
+    };
+
+    struct BinWatcherDeleted
+    {
+        const ClauseAllocator& ca;
+        BinWatcherDeleted(const ClauseAllocator& _ca) : ca(_ca) {}
+        bool operator()(const BinWatcher& w) const { return ca[w.cref].mark() == 1; }
+    };
+
+    // The binary reason of an implied literal.
+    struct ImpliedBy {
+        Lit lit;    // The false literal of the reason clause, lit_Undef if the reason is not binary.
+        int level;  // The assertion level of the reason clause.
+        ImpliedBy(Lit l = lit_Undef, int lvl = 0) : lit(l), level(lvl) {}
+    };
+
     struct VarOrderLt {
         const vec<double>&  activity;
         bool operator () (Var x, Var y) const { return activity[x] > activity[y]; }
@@ -332,6 +378,8 @@ protected:
     double              var_inc;            // Amount to bump next variable with.
     OccLists<Lit, vec<Watcher>, WatcherDeleted>
                         watches;            // 'watches[lit]' is a list of constraints watching 'lit' (will go there if literal becomes true).
+    OccLists<Lit, vec<BinWatcher>, BinWatcherDeleted>
+                        watches_bin;        // Like 'watches' for binary clauses.
     vec<lbool>          assigns;            // The current assignments.
     vec<int>            assigns_lim;        // The size by levels of the current assignment
     vec<char>           polarity;           // The preferred polarity of each variable (bit 0) and whether it's locked (bit 1).
@@ -341,6 +389,7 @@ protected:
     vec<int>            trail_lim;          // Separator indices for different decision levels in 'trail'.
     vec<bool>           trail_ok;           // Stack of "whether we're in conflict" flags.
     vec<VarData>        vardata;            // Stores reason and level for each variable.
+    vec<ImpliedBy>      implied_by;         // The binary implication graph: the binary reason of each variable, if any.
     int                 qhead;              // Head of queue (as index into the trail -- no more explicit propagation queue in MiniSat).
     int                 simpDB_assigns;     // Number of top-level assignments since last execution of 'simplify()'.
     int64_t             simpDB_props;       // Remaining number of propagations that must be made before next execution of 'simplify()'.
@@ -377,6 +426,13 @@ protected:
     double              learntsize_adjust_confl;
     int                 learntsize_adjust_cnt;
 
+    vec<uint64_t>       lbd_stamp;          // Per decision level, the last 'lbd_counter' value that counted it.
+    uint64_t            lbd_counter;
+    uint64_t            next_reduce;        // Conflict count at which the next tiered reduction is due.
+    double              lbd_ema_fast;       // Short-term average of the LBD of learnt clauses.
+    double              lbd_ema_slow;       // Long-term average of the LBD of learnt clauses.
+    double              trail_ema;          // Long-term average of the trail size at conflicts.
+
     // Resource contraints:
     //
     int64_t             conflict_budget;    // -1 means no budget.
@@ -403,6 +459,12 @@ protected:
     lbool    search           (int nof_conflicts);                                     // Search for a given number of conflicts.
     lbool    solve_           ();                                                      // Main solve method (assumptions given in 'assumptions').
     void     reduceDB         ();                                                      // Reduce the set of learnt clauses.
+    void     reduceDBTiered   ();                                                      // Reduce the set of learnt clauses by LBD tiers.
+    bool     reduceDue        ()      const;                                           // Is it time to reduce the set of learnt clauses?
+    template<class Lits>
+    int      computeLBD       (const Lits& lits);                                      // Number of distinct decision levels of 'lits'.
+    void     updateRestartAverages(int lbd);                                           // Account for a learnt clause of the given LBD.
+    bool     restartDue       (int nof_conflicts, int conflictC) const;                // Should 'search()' restart now?
     void     removeSatisfied  (vec<CRef>& cs);                                         // Shrink 'cs' to contain only non-satisfied clauses.
     void     rebuildOrderHeap ();
 
@@ -420,6 +482,7 @@ protected:
     void     detachClause     (CRef cr, bool strict = false); // Detach a clause to watcher lists.
     void     removeClause     (CRef cr);               // Detach and free a clause.
     bool     locked           (const Clause& c) const; // Returns TRUE if a clause is a reason for some implication in the current state.
+    Lit      propagatedLit    (const Clause& c) const; // The literal implied by the clause in the current state, or lit_Undef if it is not locked.
     bool     satisfied        (const Clause& c) const; // Returns TRUE if a clause is satisfied in the current state.
 
     void     relocAll         (ClauseAllocator& to);
@@ -468,7 +531,7 @@ inline bool Solver::hasReasonClause(Var x) const { return vardata[x].reason != C
 
 inline bool Solver::isPropagated(Var x) const { return vardata[x].reason != CRef_Undef; }
 
-inline bool Solver::isPropagatedBy(Var x, const Clause& c) const { return vardata[x].reason != CRef_Undef && vardata[x].reason != CRef_Lazy && ca.lea(vardata[var(c[0])].reason) == &c; }
+inline bool Solver::isPropagatedBy(Var x, const Clause& c) const { return vardata[x].reason != CRef_Undef && vardata[x].reason != CRef_Lazy && ca.lea(vardata[x].reason) == &c; }
 
 inline bool Solver::isDecision(Var x) const { Debug("minisat") << "var " << x << " is a decision iff " << (vardata[x].reason == CRef_Undef) << " && " << level(x) << " > 0" << std::endl; return vardata[x].reason == CRef_Undef && level(x) > 0; }
 
@@ -521,7 +584,12 @@ inline bool     Solver::addClause       (Lit p, Lit q, bool removable, ClauseId&
                                                                 { add_tmp.clear(); add_tmp.push(p); add_tmp.push(q); return addClause_(add_tmp, removable, id); }
 inline bool     Solver::addClause       (Lit p, Lit q, Lit r, bool removable, ClauseId& id)
                                                                 { add_tmp.clear(); add_tmp.push(p); add_tmp.push(q); add_tmp.push(r); return addClause_(add_tmp, removable, id); }
-inline bool     Solver::locked          (const Clause& c) const { return value(c[0]) == l_True && isPropagatedBy(var(c[0]), c); }
+inline bool     Solver::locked          (const Clause& c) const { return propagatedLit(c) != lit_Undef; }
+inline Lit      Solver::propagatedLit   (const Clause& c) const {
+    if (value(c[0]) == l_True && isPropagatedBy(var(c[0]), c)) return c[0];
+    // binary clauses are propagated through 'watches_bin' without moving the implied literal first
+    if (c.size() == 2 && value(c[1]) == l_True && isPropagatedBy(var(c[1]), c)) return c[1];
+    return lit_Undef; }
 inline void     Solver::newDecisionLevel()                      { trail_lim.push(trail.size()); flipped.push(false); context->push(); if(Dump.isOn("state")) { Dump("state") << CVC4::PushCommand(); } }
 
 inline int      Solver::decisionLevel ()      const   { return trail_lim.size(); }
@@ -531,6 +599,7 @@ inline lbool    Solver::value         (Lit p) const   { assert(var(p) < nVars())
 inline lbool    Solver::modelValue    (Var x) const   { return model[x]; }
 inline lbool    Solver::modelValue    (Lit p) const   { return model[var(p)] ^ sign(p); }
 inline int      Solver::nAssigns      ()      const   { return trail.size(); }
+inline Lit      Solver::trailLit      (int i) const   { return trail[i]; }
 inline int      Solver::nClauses      ()      const   { return clauses_persistent.size(); }
 inline int      Solver::nLearnts      ()      const   { return clauses_removable.size(); }
 inline int      Solver::nVars         ()      const   { return vardata.size(); }
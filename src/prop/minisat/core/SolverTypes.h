@@ -193,7 +193,9 @@ class Clause {
         unsigned has_extra : 1;
         unsigned reloced   : 1;
         unsigned size      : 27;
-        unsigned level     : 32; }                            header;
+        unsigned level     : 24;
+        unsigned lbd       : 7;
+        unsigned used      : 1; }                             header;
     union { Lit lit; float act; uint32_t abs; CRef rel; } data[0];
 
     friend class ClauseAllocator;
@@ -207,6 +209,9 @@ class Clause {
         header.reloced   = 0;
         header.size      = ps.size();
         header.level     = level;
+        header.lbd       = ps.size() > 127 ? 127 : ps.size();
+        header.used      = 0;
+        assert(level < (1 << 24));
 
         for (int i = 0; i < ps.size(); i++) 
             data[i].lit = ps[i];
@@ -237,6 +242,13 @@ public:
     void         mark        (uint32_t m)    { header.mark = m; }
     const Lit&   last        ()      const   { return data[header.size-1].lit; }
 
+    // Literal block distance (number of distinct decision levels) of a removable clause, saturated at 127.
+    int          lbd         ()      const   { return header.lbd; }
+    void         lbd         (int l)         { header.lbd = l > 127 ? 127 : l; }
+    // Whether a removable clause took part in conflict analysis since the last reduction.
+    bool         used        ()      const   { return header.used; }
+    void         used        (bool u)        { header.used = u; }
+
     bool         reloced     ()      const   { return header.reloced; }
     CRef         relocation  ()      const   { return data[0].rel; }
     void         relocate    (CRef c)        { header.reloced = 1; data[0].rel = c; }
@@ -142,6 +142,18 @@ void MinisatSatSolver::setupOptions() {
   d_minisat->clause_decay = options::satClauseDecay();
   d_minisat->restart_first = options::satRestartFirst();
   d_minisat->restart_inc = options::satRestartInc();
+  d_minisat->luby_restart =
+      options::satRestartMode() == options::SatRestartMode::LUBY;
+  d_minisat->ema_restart =
+      options::satRestartMode() == options::SatRestartMode::EMA;
+  d_minisat->restart_margin = options::satRestartEmaMargin();
+  d_minisat->lbd_tiers =
+      options::satClauseDbMode() == options::SatClauseDbMode::LBD;
+  d_minisat->lbd_core = options::satLbdCoreTier();
+  d_minisat->lbd_mid = options::satLbdMidTier();
+  d_minisat->share_max_size = options::satShareMaxSize();
+  d_minisat->share_max_lbd = options::satShareMaxLbd();
+  d_minisat->trace_interval = options::satTraceInterval();
 }
 
 ClauseId MinisatSatSolver::addClause(SatClause& clause, bool removable) {
@@ -158,6 +170,29 @@ ClauseId MinisatSatSolver::addClause(SatClause& clause, bool removable) {
   return clause_id;
 }
 
+void MinisatSatSolver::addClauses(const SatClause& lits,
+                                  const std::vector<size_t>& ends,
+                                  bool removable)
+{
+  Minisat::vec<Minisat::Lit> minisat_clause;
+  ClauseId clause_id = ClauseIdError;
+  size_t start = 0;
+  for (size_t end : ends)
+  {
+    if (!ok())
+    {
+      return;
+    }
+    minisat_clause.clear();
+    for (size_t i = start; i < end; ++i)
+    {
+      minisat_clause.push(toMinisatLit(lits[i]));
+    }
+    d_minisat->addClause(minisat_clause, removable, clause_id);
+    start = end;
+  }
+}
+
 SatVariable MinisatSatSolver::newVar(bool isTheoryAtom, bool preRegister, bool canErase) {
   return d_minisat->newVar(true, true, isTheoryAtom, preRegister, canErase);
 }
@@ -182,6 +217,8 @@ SatValue MinisatSatSolver::solve(unsigned long& resource) {
 SatValue MinisatSatSolver::solve() {
   setupOptions();
   d_minisat->budgetOff();
+  // an interrupt meant for an earlier search must not stop this one
+  d_minisat->clearInterrupt();
   return toSatLiteralValue(d_minisat->solve());
 }
 
@@ -232,6 +269,29 @@ void MinisatSatSolver::pop() {
 
 void MinisatSatSolver::resetTrail() { d_minisat->resetTrail(); }
 
+size_t MinisatSatSolver::getTrailSize() const
+{
+  return d_minisat->nAssigns();
+}
+
+SatLiteral MinisatSatSolver::getTrailLiteral(size_t i) const
+{
+  return toSatLiteral(d_minisat->trailLit(i));
+}
+
+bool MinisatSatSolver::lookaheadPush(SatLiteral lit)
+{
+  Assert(!d_minisat->isEliminated(lit.getSatVariable()));
+  return d_minisat->lookaheadPush(toMinisatLit(lit));
+}
+
+void MinisatSatSolver::lookaheadPop() { d_minisat->lookaheadPop(); }
+
+unsigned MinisatSatSolver::getNumAssigned() const
+{
+  return d_minisat->nAssigns();
+}
+
 /// Statistics for MinisatSatSolver
 
 MinisatSatSolver::Statistics::Statistics(StatisticsRegistry* registry) :
@@ -244,7 +304,11 @@ MinisatSatSolver::Statistics::Statistics(StatisticsRegistry* registry) :
     d_statClausesLiterals("sat::clauses_literals"),
     d_statLearntsLiterals("sat::learnts_literals"),
     d_statMaxLiterals("sat::max_literals"),
-    d_statTotLiterals("sat::tot_literals")
+    d_statTotLiterals("sat::tot_literals"),
+    d_statReductions("sat::reductions"),
+    d_statBlockedRestarts("sat::blocked_restarts"),
+    d_statTheoryConflicts("sat::theory_conflicts"),
+    d_statTheoryPropagations("sat::theory_propagations")
 {
   d_registry->registerStat(&d_statStarts);
   d_registry->registerStat(&d_statDecisions);
@@ -255,6 +319,10 @@ MinisatSatSolver::Statistics::Statistics(StatisticsRegistry* registry) :
   d_registry->registerStat(&d_statLearntsLiterals);
   d_registry->registerStat(&d_statMaxLiterals);
   d_registry->registerStat(&d_statTotLiterals);
+  d_registry->registerStat(&d_statReductions);
+  d_registry->registerStat(&d_statBlockedRestarts);
+  d_registry->registerStat(&d_statTheoryConflicts);
+  d_registry->registerStat(&d_statTheoryPropagations);
 }
 
 MinisatSatSolver::Statistics::~Statistics() {
@@ -267,6 +335,10 @@ MinisatSatSolver::Statistics::~Statistics() {
   d_registry->unregisterStat(&d_statLearntsLiterals);
   d_registry->unregisterStat(&d_statMaxLiterals);
   d_registry->unregisterStat(&d_statTotLiterals);
+  d_registry->unregisterStat(&d_statReductions);
+  d_registry->unregisterStat(&d_statBlockedRestarts);
+  d_registry->unregisterStat(&d_statTheoryConflicts);
+  d_registry->unregisterStat(&d_statTheoryPropagations);
 }
 
 void MinisatSatSolver::Statistics::init(Minisat::SimpSolver* d_minisat){
@@ -279,6 +351,10 @@ void MinisatSatSolver::Statistics::init(Minisat::SimpSolver* d_minisat){
   d_statLearntsLiterals.setData(d_minisat->learnts_literals);
   d_statMaxLiterals.setData(d_minisat->max_literals);
   d_statTotLiterals.setData(d_minisat->tot_literals);
+  d_statReductions.setData(d_minisat->reductions);
+  d_statBlockedRestarts.setData(d_minisat->blocked_restarts);
+  d_statTheoryConflicts.setData(d_minisat->theory_conflicts);
+  d_statTheoryPropagations.setData(d_minisat->theory_propagations);
 }
 
 } /* namespace CVC4::prop */
@@ -42,6 +42,9 @@ public:
   void initialize(context::Context* context, TheoryProxy* theoryProxy) override;
 
   ClauseId addClause(SatClause& clause, bool removable) override;
+  void addClauses(const SatClause& lits,
+                  const std::vector<size_t>& ends,
+                  bool removable) override;
   ClauseId addXorClause(SatClause& clause, bool rhs, bool removable) override
   {
     Unreachable() << "Minisat does not support native XOR reasoning";
@@ -80,6 +83,18 @@ public:
 
   bool isDecision(SatVariable decn) const override;
 
+  size_t getTrailSize() const override;
+
+  SatLiteral getTrailLiteral(size_t i) const override;
+
+  bool supportsLookahead() const override { return true; }
+
+  bool lookaheadPush(SatLiteral lit) override;
+
+  void lookaheadPop() override;
+
+  unsigned getNumAssigned() const override;
+
  private:
 
   /** The SatSolver used */
@@ -98,6 +113,8 @@ public:
     ReferenceStat<uint64_t> d_statConflicts, d_statClausesLiterals;
     ReferenceStat<uint64_t> d_statLearntsLiterals,  d_statMaxLiterals;
     ReferenceStat<uint64_t> d_statTotLiterals;
+    ReferenceStat<uint64_t> d_statReductions, d_statBlockedRestarts;
+    ReferenceStat<uint64_t> d_statTheoryConflicts, d_statTheoryPropagations;
   public:
     Statistics(StatisticsRegistry* registry);
     ~Statistics();
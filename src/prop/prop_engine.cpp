@@ -28,9 +28,11 @@
 #include "options/decision_options.h"
 #include "options/main_options.h"
 #include "options/options.h"
+#include "options/prop_options.h"
 #include "options/smt_options.h"
 #include "proof/proof_manager.h"
 #include "prop/cnf_stream.h"
+#include "prop/cube_generator.h"
 #include "prop/sat_solver.h"
 #include "prop/sat_solver_factory.h"
 #include "prop/theory_proxy.h"
@@ -88,17 +90,31 @@ PropEngine::PropEngine(TheoryEngine* te,
       d_satSolver(NULL),
       d_registrar(NULL),
       d_cnfStream(NULL),
+      d_cubeGenerator(NULL),
       d_interrupted(false),
-      d_resourceManager(NodeManager::currentResourceManager())
+      d_resourceManager(NodeManager::currentResourceManager()),
+      d_searchTime("prop::PropEngine::searchTime")
 {
+  smtStatisticsRegistry()->registerStat(&d_searchTime);
 
   Debug("prop") << "Constructing the PropEngine" << endl;
 
-  d_satSolver = SatSolverFactory::createDPLLMinisat(smtStatisticsRegistry());
+  if (options::satSolver() == options::PropSatSolverMode::CADICAL)
+  {
+    d_satSolver = SatSolverFactory::createDPLLCadical(smtStatisticsRegistry());
+  }
+  else
+  {
+    d_satSolver = SatSolverFactory::createDPLLMinisat(smtStatisticsRegistry());
+  }
 
   d_registrar = new theory::TheoryRegistrar(d_theoryEngine);
-  d_cnfStream = new CVC4::prop::TseitinCnfStream(
-      d_satSolver, d_registrar, userContext, true);
+  d_cnfStream = new CVC4::prop::TseitinCnfStream(d_satSolver,
+                                                  d_registrar,
+                                                  userContext,
+                                                  true,
+                                                  "",
+                                                  options::cnfPolarity());
 
   d_theoryProxy = new TheoryProxy(this,
                                   d_theoryEngine,
@@ -118,10 +134,12 @@ PropEngine::PropEngine(TheoryEngine* te,
 
 PropEngine::~PropEngine() {
   Debug("prop") << "Destructing the PropEngine" << endl;
+  delete d_cubeGenerator;
   delete d_cnfStream;
   delete d_registrar;
   delete d_satSolver;
   delete d_theoryProxy;
+  smtStatisticsRegistry()->unregisterStat(&d_searchTime);
 }
 
 void PropEngine::assertFormula(TNode node) {
@@ -194,7 +212,11 @@ Result PropEngine::checkSat() {
   d_interrupted = false;
 
   // Check the problem
-  SatValue result = d_satSolver->solve();
+  SatValue result;
+  {
+    TimerStat::CodeTimer searchTimer(d_searchTime);
+    result = d_satSolver->solve();
+  }
 
   if( result == SAT_VALUE_UNKNOWN ) {
 
@@ -218,6 +240,23 @@ Result PropEngine::checkSat() {
   return Result(result == SAT_VALUE_TRUE ? Result::SAT : Result::UNSAT);
 }
 
+bool PropEngine::supportsCubes() const
+{
+  return d_satSolver->supportsLookahead();
+}
+
+void PropEngine::getCubes(unsigned numCubes,
+                          std::vector<std::vector<Node>>& cubes)
+{
+  Assert(!d_inCheckSat) << "Sat solver in solve()!";
+  Debug("prop") << "PropEngine::getCubes(" << numCubes << ")" << endl;
+  if (d_cubeGenerator == NULL)
+  {
+    d_cubeGenerator = new CubeGenerator(d_satSolver, d_cnfStream);
+  }
+  d_cubeGenerator->generate(numCubes, cubes);
+}
+
 Node PropEngine::getValue(TNode node) const {
   Assert(node.getType().isBoolean());
   Assert(d_cnfStream->hasLiteral(node));
@@ -275,6 +314,7 @@ void PropEngine::push() {
 void PropEngine::pop() {
   Assert(!d_inCheckSat) << "Sat solver in solve()!";
   d_satSolver->pop();
+  d_theoryProxy->notifyPop();
   Debug("prop") << "pop()" << endl;
 }
 
@@ -30,6 +30,7 @@
 #include "proof/proof_manager.h"
 #include "util/resource_manager.h"
 #include "util/result.h"
+#include "util/statistics_registry.h"
 #include "util/unsafe_interrupt_exception.h"
 
 namespace CVC4 {
@@ -45,6 +46,7 @@ namespace theory {
 namespace prop {
 
 class CnfStream;
+class CubeGenerator;
 class DPLLSatSolverInterface;
 
 class PropEngine;
@@ -85,11 +87,20 @@ class PropEngine {
   /** The CNF converter in use */
   CnfStream* d_cnfStream;
 
+  /** The cube generator, created on the first call to getCubes() */
+  CubeGenerator* d_cubeGenerator;
+
   /** Whether we were just interrupted (or not) */
   bool d_interrupted;
   /** Pointer to resource manager for associated SmtEngine */
   ResourceManager* d_resourceManager;
 
+  /**
+   * Statistic: time spent in the SAT search, compare with
+   * decision::jh::time for the part spent choosing decisions
+   */
+  TimerStat d_searchTime;
+
   /** Dump out the satisfying assignment (after SAT result) */
   void printSatisfyingAssignment();
 
@@ -166,6 +177,15 @@ class PropEngine {
    */
   Result checkSat();
 
+  /** Whether the SAT solver supports the lookahead of getCubes() */
+  bool supportsCubes() const;
+
+  /**
+   * Split the search space of the current assertions into at most numCubes
+   * cubes by lookahead, see CubeGenerator.  Only if supportsCubes().
+   */
+  void getCubes(unsigned numCubes, std::vector<std::vector<Node>>& cubes);
+
   /**
    * Get the value of a boolean variable.
    *
@@ -22,6 +22,7 @@
 #include <stdint.h>
 
 #include <string>
+#include <vector>
 
 #include "context/cdlist.h"
 #include "context/context.h"
@@ -53,6 +54,25 @@ public:
   virtual ClauseId addClause(SatClause& clause,
                              bool removable) = 0;
 
+  /**
+   * Assert the clauses stored back to back in lits, clause i ending before
+   * lits[ends[i]].  Solvers that don't override this get them one by one
+   * through addClause(), so no clause ids are returned.
+   */
+  virtual void addClauses(const SatClause& lits,
+                          const std::vector<size_t>& ends,
+                          bool removable)
+  {
+    SatClause clause;
+    size_t start = 0;
+    for (size_t end : ends)
+    {
+      clause.assign(lits.begin() + start, lits.begin() + end);
+      addClause(clause, removable);
+      start = end;
+    }
+  }
+
   /** Return true if the solver supports native xor resoning */
   virtual bool nativeXor() { return false; }
 
@@ -152,6 +172,43 @@ public:
   virtual void requirePhase(SatLiteral lit) = 0;
 
   virtual bool isDecision(SatVariable decn) const = 0;
+
+  /** The number of assigned literals on the trail */
+  virtual size_t getTrailSize() const = 0;
+
+  /**
+   * The literal at position i of the trail, the assigned literals in the
+   * order of their assignment.  Backtracking shrinks the trail.
+   */
+  virtual SatLiteral getTrailLiteral(size_t i) const = 0;
+
+  /**
+   * Whether the solver supports lookahead outside of solve(), see
+   * lookaheadPush().
+   */
+  virtual bool supportsLookahead() const { return false; }
+
+  /**
+   * Decide lit at a new decision level and propagate it without the
+   * theories, for lookahead outside of solve().  Return false if this leads
+   * to a conflict.  Undo with lookaheadPop().  Only if supportsLookahead().
+   */
+  virtual bool lookaheadPush(SatLiteral lit)
+  {
+    Unreachable() << "Lookahead not supported by this SAT solver";
+  }
+
+  /** Undo the last lookaheadPush() */
+  virtual void lookaheadPop()
+  {
+    Unreachable() << "Lookahead not supported by this SAT solver";
+  }
+
+  /** The number of assigned literals, only if supportsLookahead() */
+  virtual unsigned getNumAssigned() const
+  {
+    Unreachable() << "Lookahead not supported by this SAT solver";
+  }
 };/* class DPLLSatSolverInterface */
 
 inline std::ostream& operator <<(std::ostream& out, prop::SatLiteral lit) {
@@ -38,6 +38,16 @@ DPLLSatSolverInterface* SatSolverFactory::createDPLLMinisat(
   return new MinisatSatSolver(registry);
 }
 
+DPLLSatSolverInterface* SatSolverFactory::createDPLLCadical(
+    StatisticsRegistry* registry)
+{
+#ifdef CVC4_USE_CADICAL_PROPAGATOR
+  return new CadicalDPLLSatSolver(registry);
+#else
+  Unreachable() << "CVC4 was not compiled with CaDiCaL propagator support.";
+#endif
+}
+
 SatSolver* SatSolverFactory::createCryptoMinisat(StatisticsRegistry* registry,
                                                  const std::string& name)
 {
@@ -16,10 +16,17 @@
  **/
 #include "prop/theory_proxy.h"
 
+#include <algorithm>
+#include <sstream>
+
 #include "context/context.h"
 #include "decision/decision_engine.h"
 #include "expr/expr_stream.h"
+#include "expr/node_manager_attributes.h"
+#include "options/base_options.h"
 #include "options/decision_options.h"
+#include "options/prop_options.h"
+#include "options/set_language.h"
 #include "prop/cnf_stream.h"
 #include "prop/prop_engine.h"
 #include "proof/cnf_proof.h"
@@ -33,6 +40,88 @@
 namespace CVC4 {
 namespace prop {
 
+namespace {
+
+/** The maximal length of the key of a shared atom */
+const std::streamoff s_maxSharedKeyLength = 1024;
+
+/**
+ * Write the key of the term n to out: the term structure, with constants
+ * printed and variables given by their name and type.  Return false if n
+ * has no key that means the same in every instance of the portfolio.
+ */
+bool writeSharedKey(TNode n, std::ostringstream& out)
+{
+  if (out.tellp() > s_maxSharedKeyLength)
+  {
+    return false;
+  }
+  Kind k = n.getKind();
+  if (theory::kindToTheoryId(k) == theory::THEORY_DATATYPES
+      || k == kind::UNINTERPRETED_CONSTANT)
+  {
+    // refer to the datatypes and abstract values of an ExprManager by index
+    return false;
+  }
+  if (n.isConst())
+  {
+    out << k << '{' << n << '}';
+    return true;
+  }
+  if (n.isVar())
+  {
+    // skolems, bound variables and unnamed variables don't mean the same in
+    // other instances
+    std::string name;
+    if (k != kind::VARIABLE || !n.getAttribute(expr::VarNameAttr(), name))
+    {
+      return false;
+    }
+    out << name.size() << ':' << name << ':' << n.getType();
+    return true;
+  }
+  out << '(' << k;
+  if (n.getMetaKind() == kind::metakind::PARAMETERIZED)
+  {
+    out << ' ';
+    if (!writeSharedKey(n.getOperator(), out))
+    {
+      return false;
+    }
+  }
+  for (TNode c : n)
+  {
+    out << ' ';
+    if (!writeSharedKey(c, out))
+    {
+      return false;
+    }
+  }
+  out << ')';
+  return true;
+}
+
+/**
+ * Whether n is an atom of the CNF stream, i.e. not a Boolean connective
+ * that is translated to clauses.
+ */
+bool isCnfAtom(TNode n)
+{
+  switch (n.getKind())
+  {
+    case kind::NOT:
+    case kind::XOR:
+    case kind::ITE:
+    case kind::IMPLIES:
+    case kind::OR:
+    case kind::AND: return false;
+    case kind::EQUAL: return !n[0].getType().isBoolean();
+    default: return true;
+  }
+}
+
+}  // namespace
+
 TheoryProxy::TheoryProxy(PropEngine* propEngine,
                          TheoryEngine* theoryEngine,
                          DecisionEngine* decisionEngine,
@@ -47,14 +136,31 @@ TheoryProxy::TheoryProxy(PropEngine* propEngine,
       d_replayLog(replayLog),
       d_replayStream(replayStream),
       d_queue(context),
-      d_replayedDecisions("prop::theoryproxy::replayedDecisions", 0)
+      d_exchange(options::satShareMaxSize() > 0 ? options::satClauseExchange()
+                                                : nullptr),
+      d_participant(0),
+      d_numSharedAtomsKnown(0),
+      d_replayedDecisions("prop::theoryproxy::replayedDecisions", 0),
+      d_exportedClauses("prop::theoryproxy::exportedClauses", 0),
+      d_importedClauses("prop::theoryproxy::importedClauses", 0)
 {
+  if (d_exchange != nullptr)
+  {
+    d_participant = d_exchange->join();
+  }
   smtStatisticsRegistry()->registerStat(&d_replayedDecisions);
+  smtStatisticsRegistry()->registerStat(&d_exportedClauses);
+  smtStatisticsRegistry()->registerStat(&d_importedClauses);
 }
 
 TheoryProxy::~TheoryProxy() {
-  /* nothing to do for now */
+  if (d_exchange != nullptr)
+  {
+    d_exchange->leave(d_participant);
+  }
   smtStatisticsRegistry()->unregisterStat(&d_replayedDecisions);
+  smtStatisticsRegistry()->unregisterStat(&d_exportedClauses);
+  smtStatisticsRegistry()->unregisterStat(&d_importedClauses);
 }
 
 void TheoryProxy::variableNotify(SatVariable var) {
@@ -148,6 +254,143 @@ TNode TheoryProxy::getNode(SatLiteral lit) {
 void TheoryProxy::notifyRestart() {
   d_propEngine->spendResource(ResourceManager::Resource::RestartStep);
   d_theoryEngine->notifyRestart();
+  if (d_exchange != nullptr)
+  {
+    importClauses();
+  }
+}
+
+void TheoryProxy::notifyPop()
+{
+  // the atoms that are still there are rediscovered on the next import
+  d_numSharedAtomsKnown = 0;
+}
+
+uint32_t TheoryProxy::getSharedAtomId(TNode atom)
+{
+  std::unordered_map<Node, uint32_t, NodeHashFunction>::const_iterator it =
+      d_sharedAtomIds.find(atom);
+  if (it != d_sharedAtomIds.end())
+  {
+    return it->second;
+  }
+  uint32_t id = s_noAtomId;
+  std::ostringstream key;
+  key << language::SetLanguage(language::output::LANG_SMTLIB_V2_6);
+  if (isCnfAtom(atom) && writeSharedKey(atom, key))
+  {
+    id = d_exchange->getAtomId(key.str());
+  }
+  d_sharedAtomIds[atom] = id;
+  return id;
+}
+
+Node TheoryProxy::mkSharedClause(std::vector<Node>& lits) const
+{
+  if (lits.size() == 1)
+  {
+    return lits[0];
+  }
+  std::sort(lits.begin(), lits.end());
+  return NodeManager::currentNM()->mkNode(kind::OR, lits);
+}
+
+void TheoryProxy::exportClause(const SatClause& clause)
+{
+  Assert(d_exchange != nullptr);
+  ClauseExchange::Clause shared;
+  std::vector<Node> lits;
+  for (const SatLiteral& l : clause)
+  {
+    TNode lit = d_cnfStream->getNode(l);
+    bool negated = lit.getKind() == kind::NOT;
+    uint32_t id = getSharedAtomId(negated ? lit[0] : lit);
+    if (id == s_noAtomId)
+    {
+      return;
+    }
+    shared.push_back(ClauseExchange::Literal(id, negated));
+    lits.push_back(lit);
+  }
+  Node n = mkSharedClause(lits);
+  if (d_shared.insert(n).second)
+  {
+    Debug("shared") << "export " << n << std::endl;
+    d_exchange->publish(d_participant, shared);
+    ++d_exportedClauses;
+  }
+}
+
+void TheoryProxy::traceSearch(uint64_t conflicts,
+                              uint64_t decisions,
+                              uint64_t propagations,
+                              uint64_t theoryConflicts,
+                              uint64_t theoryPropagations)
+{
+  std::ostream& out = *options::err();
+  out << "(sat-trace :conflicts " << conflicts << " :decisions " << decisions
+      << " :propagations " << propagations << " :theory-conflicts "
+      << theoryConflicts << " :theory-propagations " << theoryPropagations;
+  d_theoryEngine->traceStatistics(out);
+  out << ")" << std::endl;
+}
+
+void TheoryProxy::importClauses()
+{
+  std::vector<ClauseExchange::Clause> clauses;
+  d_exchange->collect(d_participant, clauses);
+  if (clauses.empty())
+  {
+    return;
+  }
+
+  // look up the atoms the CNF stream has introduced since the last import
+  const CnfStream::NodeToLiteralMap& cache = d_cnfStream->getTranslationCache();
+  CnfStream::NodeToLiteralMap::key_iterator it = cache.key_begin();
+  std::advance(it, std::min(d_numSharedAtomsKnown, cache.size()));
+  for (; it != cache.key_end(); ++it)
+  {
+    if ((*it).getKind() != kind::NOT)
+    {
+      uint32_t id = getSharedAtomId(*it);
+      if (id != s_noAtomId)
+      {
+        d_sharedAtoms[id] = *it;
+      }
+    }
+  }
+  d_numSharedAtomsKnown = cache.size();
+
+  for (const ClauseExchange::Clause& clause : clauses)
+  {
+    std::vector<Node> lits;
+    for (const ClauseExchange::Literal& l : clause)
+    {
+      std::unordered_map<uint32_t, Node>::const_iterator a =
+          d_sharedAtoms.find(l.first);
+      if (a == d_sharedAtoms.end() || !d_cnfStream->hasLiteral(a->second))
+      {
+        break;
+      }
+      lits.push_back(l.second ? a->second.notNode() : a->second);
+    }
+    if (lits.size() < clause.size())
+    {
+      Debug("shared") << "drop new, an atom is unknown" << std::endl;
+      continue;
+    }
+    Node lemma = mkSharedClause(lits);
+    if (d_shared.insert(lemma).second)
+    {
+      Debug("shared") << "import " << lemma << std::endl;
+      d_propEngine->assertLemma(lemma, false, true, RULE_INVALID);
+      ++d_importedClauses;
+    }
+    else
+    {
+      Debug("shared") << "drop new " << lemma << std::endl;
+    }
+  }
 }
 
 SatLiteral TheoryProxy::getNextReplayDecision() {
@@ -23,14 +23,18 @@
 // Optional blocks below will be unconditionally included
 #define CVC4_USE_MINISAT
 
+#include <cstdint>
 #include <iosfwd>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "context/cdqueue.h"
 #include "expr/expr_stream.h"
 #include "expr/node.h"
 #include "prop/sat_solver.h"
 #include "theory/theory.h"
+#include "util/clause_exchange.h"
 #include "util/resource_manager.h"
 #include "util/statistics_registry.h"
 
@@ -83,6 +87,39 @@ class TheoryProxy
 
   void notifyRestart();
 
+  /**
+   * Notify that the SAT solver has popped a user level.  The SAT literals of
+   * the atoms introduced at that level are gone.
+   */
+  void notifyPop();
+
+  /**
+   * Whether learnt clauses are shared with the other instances of the
+   * portfolio (see --portfolio).
+   */
+  bool isSharingClauses() const { return d_exchange != nullptr; }
+
+  /**
+   * Share a clause learnt by the SAT solver with the other instances of the
+   * portfolio.  The clause must follow from the assertions of user level 0.
+   * It is only shared if all its literals are shareable atoms (see
+   * getSharedAtomId()), the other instances import it at their next
+   * restart.
+   */
+  void exportClause(const SatClause& clause);
+
+  /**
+   * Prints a sample of the search counters of the SAT solver, followed by
+   * the conflicts, propagations and explanations of each theory (see
+   * --sat-trace).  The counters are cumulative, so consecutive samples give
+   * a time series of the search.
+   */
+  void traceSearch(uint64_t conflicts,
+                   uint64_t decisions,
+                   uint64_t propagations,
+                   uint64_t theoryConflicts,
+                   uint64_t theoryPropagations);
+
   SatLiteral getNextReplayDecision();
 
   void logDecision(SatLiteral lit);
@@ -99,6 +136,27 @@ class TheoryProxy
   void dumpStatePop();
 
  private:
+  /** The atom id of atoms that can't be shared */
+  static const uint32_t s_noAtomId = UINT32_MAX;
+
+  /**
+   * Get the id of atom in d_exchange, or s_noAtomId if it can't be shared.
+   * Atoms are identified across instances by a structural key built from
+   * the names and types of their variables, so atoms containing skolems,
+   * bound or unnamed variables or datatype terms can't be shared.
+   */
+  uint32_t getSharedAtomId(TNode atom);
+
+  /**
+   * Assert the clauses the other instances of the portfolio have shared
+   * since the last call as removable lemmas.  Clauses over atoms for which
+   * we have no SAT literal are dropped.
+   */
+  void importClauses();
+
+  /** Build the Node of a shared clause, with a canonical literal order */
+  Node mkSharedClause(std::vector<Node>& lits) const;
+
   /** The prop engine we are using. */
   PropEngine* d_propEngine;
 
@@ -126,11 +184,35 @@ class TheoryProxy
    */
   std::unordered_set<Node, NodeHashFunction> d_shared;
 
+  /** The exchange of learnt clauses of the portfolio, NULL if not sharing */
+  ClauseExchange* d_exchange;
+
+  /** Our participant id in d_exchange */
+  unsigned d_participant;
+
+  /** The ids of the atoms we looked up in d_exchange */
+  std::unordered_map<Node, uint32_t, NodeHashFunction> d_sharedAtomIds;
+
+  /** Our atoms with a SAT literal, by their id in d_exchange */
+  std::unordered_map<uint32_t, Node> d_sharedAtoms;
+
+  /**
+   * The number of entries of the CNF stream's translation cache that have
+   * been added to d_sharedAtoms
+   */
+  size_t d_numSharedAtomsKnown;
+
   /**
    * Statistic: the number of replayed decisions (via --replay).
    */
   IntStat d_replayedDecisions;
 
+  /** Statistic: the number of learnt clauses shared with the portfolio */
+  IntStat d_exportedClauses;
+
+  /** Statistic: the number of clauses imported from the portfolio */
+  IntStat d_importedClauses;
+
 }; /* class SatSolver */
 
 }/* CVC4::prop namespace */
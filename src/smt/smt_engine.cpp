@@ -56,6 +56,7 @@
 #include "options/bv_options.h"
 #include "options/datatypes_options.h"
 #include "options/decision_options.h"
+#include "options/expr_options.h"
 #include "options/language.h"
 #include "options/main_options.h"
 #include "options/open_ostream.h"
@@ -877,15 +878,21 @@ SmtEngine::SmtEngine(ExprManager* em)
       d_replayStream(NULL),
       d_private(NULL),
       d_statisticsRegistry(NULL),
-      d_stats(NULL)
+      d_stats(NULL),
+      d_rewriterState(NULL)
 {
   SmtScope smts(this);
   d_originalOptions.copyValues(em->getOptions());
   d_private = new smt::SmtEnginePrivate(*this);
   d_statisticsRegistry = new StatisticsRegistry();
   d_stats = new SmtEngineStatistics();
+  d_rewriterState = new theory::RewriterState(d_statisticsRegistry);
   d_stats->d_resourceUnitsUsed.setData(
       d_private->getResourceManager()->getResourceUsage());
+  d_context->getCMM()->registerStatistics(
+      *d_statisticsRegistry, "context::ContextMemoryManager::sat::");
+  d_userContext->getCMM()->registerStatistics(
+      *d_statisticsRegistry, "context::ContextMemoryManager::user::");
 
   // The ProofManager is constructed before any other proof objects such as
   // SatProof and TheoryProofs. The TheoryProofEngine and the SatProof are
@@ -933,6 +940,10 @@ void SmtEngine::finishInit()
   // ensure that our heuristics are properly set up
   setDefaults();
 
+  size_t contextMemoryCache = size_t(options::contextMemoryCache()) << 20;
+  d_context->getCMM()->setMaxFreeBytes(contextMemoryCache);
+  d_userContext->getCMM()->setMaxFreeBytes(contextMemoryCache);
+
   Trace("smt-debug") << "Making decision engine..." << std::endl;
 
   d_decisionEngine = new DecisionEngine(d_context, d_userContext);
@@ -1097,6 +1108,10 @@ SmtEngine::~SmtEngine()
 
     delete d_stats;
     d_stats = NULL;
+    delete d_rewriterState;
+    d_rewriterState = NULL;
+    d_context->getCMM()->unregisterStatistics();
+    d_userContext->getCMM()->unregisterStatistics();
     delete d_statisticsRegistry;
     d_statisticsRegistry = NULL;
 
@@ -1226,6 +1241,13 @@ void SmtEngine::setDefaults() {
     }
   }
 
+  if (options::satSolver() == options::PropSatSolverMode::CADICAL
+      && (options::proof() || options::unsatCores()))
+  {
+    throw OptionException(
+        "--sat-solver=cadical does not support proofs or unsat cores.");
+  }
+
   // set options about ackermannization
   if (options::ackermann() && options::produceModels()
       && (d_logic.isTheoryEnabled(THEORY_ARRAYS)
@@ -1563,6 +1585,24 @@ void SmtEngine::setDefaults() {
     }
   }
 
+  if (options::cnfPolarity())
+  {
+    if (options::proof() || options::unsatCores())
+    {
+      throw OptionException(
+          "--cnf-polarity does not support proofs or unsat cores.");
+    }
+    // quantifiers and sygus query the SAT values of Boolean structure,
+    // which only have their meaning with both directions of the gates
+    if (d_logic.isQuantified() || is_sygus)
+    {
+      Notice() << "SmtEngine: turning off cnf-polarity to support quantified "
+                  "logics"
+               << endl;
+      options::cnfPolarity.set(false);
+    }
+  }
+
   // cases where we need produce models
   if (!options::produceModels()
       && (options::produceAssignments() || options::sygusRewSynthCheck()
@@ -2406,6 +2446,37 @@ void SmtEngine::setDefaults() {
                  << endl;
     options::stringProcessLoopMode.set(options::ProcessLoopMode::SIMPLE);
   }
+
+  if (options::satClauseExchange() != nullptr)
+  {
+    // Clauses learned by another instance follow from the assertions, so
+    // they can only be shared if preprocessing preserves equivalence and
+    // nothing needs to justify them.
+    const char* reason = nullptr;
+    if (options::satSolver() != options::PropSatSolverMode::MINISAT)
+    {
+      reason = "the SAT solver";
+    }
+    else if (options::proof() || options::unsatCores())
+    {
+      reason = "proofs and unsat cores";
+    }
+    else if (options::unconstrainedSimp() || options::sortInference()
+             || options::ufSymmetryBreaker() || options::symmetryBreakerExp()
+             || options::globalNegate() || options::sygusInference()
+             || options::solveIntAsBV() > 0 || options::solveBVAsInt() > 0
+             || options::solveRealAsInt() || options::bvAbstraction()
+             || options::arithMLTrick() || options::ackermann())
+    {
+      reason = "satisfiability-preserving preprocessing";
+    }
+    if (reason != nullptr)
+    {
+      Notice() << "SmtEngine: not sharing learnt clauses with the portfolio "
+               << "because of " << reason << endl;
+      options::satClauseExchange.set(nullptr);
+    }
+  }
 }
 
 void SmtEngine::setProblemExtended()
@@ -3763,6 +3834,13 @@ Result SmtEngine::checkSatisfiability(const vector<Expr>& assumptions,
     finalOptionsAreSet();
     doPendingPops();
 
+    // Drain the zombies left behind by incremental garbage collection
+    // before the solver starts working.
+    if (options::incrementalGc())
+    {
+      d_nodeManager->reclaimAllZombies();
+    }
+
     Trace("smt") << "SmtEngine::" << (isQuery ? "query" : "checkSat") << "("
                  << assumptions << ")" << endl;
 
@@ -3920,6 +3998,34 @@ Result SmtEngine::checkSatisfiability(const vector<Expr>& assumptions,
   }
 }
 
+vector<vector<Expr>> SmtEngine::getCubes(unsigned numCubes)
+{
+  SmtScope smts(this);
+  finalOptionsAreSet();
+  doPendingPops();
+  Trace("smt") << "SMT getCubes(" << numCubes << ")" << endl;
+  if (!d_propEngine->supportsCubes())
+  {
+    throw ModalException(
+        "Cannot get cubes, the SAT solver doesn't support lookahead");
+  }
+
+  // Make sure the prop layer has all of the assertions
+  d_private->processAssertions();
+  vector<vector<Node>> cubes;
+  d_propEngine->getCubes(numCubes, cubes);
+
+  vector<vector<Expr>> result(cubes.size());
+  for (size_t i = 0; i < cubes.size(); ++i)
+  {
+    for (const Node& lit : cubes[i])
+    {
+      result[i].push_back(lit.toExpr());
+    }
+  }
+  return result;
+}
+
 vector<Expr> SmtEngine::getUnsatAssumptions(void)
 {
   Trace("smt") << "SMT getUnsatAssumptions()" << endl;
@@ -85,6 +85,13 @@ namespace prop {
 
 /* -------------------------------------------------------------------------- */
 
+namespace theory {
+  class RewriterState;
+  class TheoryModel;
+}/* CVC4::theory namespace */
+
+/* -------------------------------------------------------------------------- */
+
 namespace smt {
   /**
    * Representation of a defined function.  We keep these around in
@@ -100,6 +107,7 @@ namespace smt {
   class BooleanTermConverter;
 
   ProofManager* currentProofManager();
+  theory::RewriterState* currentRewriterState();
 
   struct CommandCleanup;
   typedef context::CDList<Command*, CommandCleanup> CommandList;
@@ -107,10 +115,6 @@ namespace smt {
 
 /* -------------------------------------------------------------------------- */
 
-namespace theory {
-  class TheoryModel;
-}/* CVC4::theory namespace */
-
 // TODO: SAT layer (esp. CNF- versus non-clausal solvers under the
 // hood): use a type parameter and have check() delegate, or subclass
 // SmtEngine and override check()?
@@ -132,6 +136,7 @@ class CVC4_PUBLIC SmtEngine
   friend class ::CVC4::smt::SmtScope;
   friend class ::CVC4::smt::BooleanTermConverter;
   friend ProofManager* ::CVC4::smt::currentProofManager();
+  friend theory::RewriterState* ::CVC4::smt::currentRewriterState();
   friend class ::CVC4::LogicRequest;
   friend class ::CVC4::Model;  // to access d_modelCommands
   friend class ::CVC4::theory::TheoryModel;
@@ -328,6 +333,18 @@ class CVC4_PUBLIC SmtEngine
   Result checkSat(const std::vector<Expr>& assumptions,
                   bool inUnsatCore = true);
 
+  /**
+   * Split the search space of the current assertions into at most numCubes
+   * cubes by lookahead on the SAT solver (see --cubes).  The cubes are
+   * conjunctions of literals over the declared symbols whose disjunction is
+   * valid, so the assertions are satisfiable iff they are satisfiable under
+   * one of the cubes.  Fewer cubes are returned if the search space can't
+   * be split further.
+   *
+   * @throw ModalException if the SAT solver doesn't support lookahead
+   */
+  std::vector<std::vector<Expr>> getCubes(unsigned numCubes);
+
   /**
    * Returns a set of so-called "failed" assumptions.
    *
@@ -1240,6 +1257,9 @@ class CVC4_PUBLIC SmtEngine
 
   smt::SmtEngineStatistics* d_stats;
 
+  /** The state of the rewrite caches, see theory::Rewriter */
+  theory::RewriterState* d_rewriterState;
+
   /*---------------------------- sygus commands  ---------------------------*/
 
   /**
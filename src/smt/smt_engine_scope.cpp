@@ -46,6 +46,12 @@ ProofManager* currentProofManager() {
 #endif /* IS_PROOFS_BUILD */
 }
 
+theory::RewriterState* currentRewriterState()
+{
+  return s_smtEngine_current == NULL ? NULL
+                                     : s_smtEngine_current->d_rewriterState;
+}
+
 SmtScope::SmtScope(const SmtEngine* smt)
     : NodeManagerScope(smt->d_nodeManager),
       d_oldSmtEngine(s_smtEngine_current) {
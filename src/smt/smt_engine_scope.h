@@ -28,6 +28,10 @@ class ProofManager;
 class SmtEngine;
 class StatisticsRegistry;
 
+namespace theory {
+class RewriterState;
+}/* CVC4::theory namespace */
+
 namespace smt {
 
 SmtEngine* currentSmtEngine();
@@ -36,6 +40,12 @@ bool smtEngineInScope();
 // FIXME: Maybe move into SmtScope?
 ProofManager* currentProofManager();
 
+/**
+ * The state of the rewrite caches of the SmtEngine in scope, or NULL if no
+ * SmtEngine is in scope.
+ */
+theory::RewriterState* currentRewriterState();
+
 class SmtScope : public NodeManagerScope {
   /** The old NodeManager, to be restored on destruction. */
   SmtEngine* d_oldSmtEngine;
@@ -19,6 +19,7 @@
 #include <math.h>
 #include <cfloat>
 #include <cmath>
+#include <limits>
 #include <unordered_set>
 
 #include "base/output.h"
@@ -28,6 +29,7 @@
 #include "theory/arith/cut_log.h"
 #include "theory/arith/matrix.h"
 #include "theory/arith/normal_form.h"
+#include "theory/arith/tableau.h"
 
 using namespace std;
 
@@ -153,6 +155,8 @@ ApproximateStatistics::ApproximateStatistics()
   ,  d_gaussianElimConstructTime("z::approx::gaussianElimConstruct::time")
   ,  d_gaussianElimConstruct("z::approx::gaussianElimConstruct::calls",0)
   ,  d_averageGuesses("z::approx::averageGuesses")
+  ,  d_floatPivots("z::approx::float::pivots",0)
+  ,  d_floatBoundFlips("z::approx::float::boundFlips",0)
 {
   smtStatisticsRegistry()->registerStat(&d_branchMaxDepth);
   smtStatisticsRegistry()->registerStat(&d_branchesMaxOnAVar);
@@ -161,6 +165,9 @@ ApproximateStatistics::ApproximateStatistics()
   smtStatisticsRegistry()->registerStat(&d_gaussianElimConstruct);
 
   smtStatisticsRegistry()->registerStat(&d_averageGuesses);
+
+  smtStatisticsRegistry()->registerStat(&d_floatPivots);
+  smtStatisticsRegistry()->registerStat(&d_floatBoundFlips);
 }
 
 ApproximateStatistics::~ApproximateStatistics(){
@@ -171,6 +178,9 @@ ApproximateStatistics::~ApproximateStatistics(){
   smtStatisticsRegistry()->unregisterStat(&d_gaussianElimConstruct);
 
   smtStatisticsRegistry()->unregisterStat(&d_averageGuesses);
+
+  smtStatisticsRegistry()->unregisterStat(&d_floatPivots);
+  smtStatisticsRegistry()->unregisterStat(&d_floatBoundFlips);
 }
 
 Integer ApproximateSimplex::s_defaultMaxDenom(1<<26);
@@ -327,6 +337,54 @@ Maybe<Rational> ApproximateSimplex::estimateWithCFE(double d)
   return estimateWithCFE(d, s_defaultMaxDenom);
 }
 
+DeltaRational ApproximateSimplex::estimateAssignment(ArithVar v,
+                                                     double value) const
+{
+  if (d_vars.hasLowerBound(v)
+      && roughlyEqual(value, d_vars.getLowerBound(v).approx(SMALL_FIXED_DELTA)))
+  {
+    return d_vars.getLowerBound(v);
+  }
+  else if (d_vars.hasUpperBound(v)
+           && roughlyEqual(value,
+                           d_vars.getUpperBound(v).approx(SMALL_FIXED_DELTA)))
+  {
+    return d_vars.getUpperBound(v);
+  }
+
+  double rounded = round(value);
+  if (roughlyEqual(value, rounded))
+  {
+    value = rounded;
+  }
+
+  const DeltaRational& oldAssign = d_vars.getAssignment(v);
+  DeltaRational proposal;
+  if (roughlyEqual(value, oldAssign.approx(SMALL_FIXED_DELTA)))
+  {
+    proposal = oldAssign;
+  }
+  else if (Maybe<Rational> maybe_new = estimateWithCFE(value))
+  {
+    proposal = maybe_new.value();
+  }
+  else
+  {
+    // failed to estimate the old value. defaulting to the current.
+    proposal = oldAssign;
+  }
+
+  if (d_vars.strictlyLessThanLowerBound(v, proposal))
+  {
+    proposal = d_vars.getLowerBound(v);
+  }
+  else if (d_vars.strictlyGreaterThanUpperBound(v, proposal))
+  {
+    proposal = d_vars.getUpperBound(v);
+  }
+  return proposal;
+}
+
 class ApproxNoOp : public ApproximateSimplex {
 public:
   ApproxNoOp(const ArithVariables& v, TreeLog& l, ApproximateStatistics& s)
@@ -362,6 +420,491 @@ public:
   double sumInfeasibilities(bool mip) const override { return 0.0; }
 };
 
+/**
+ * A bounded primal simplex over doubles. It copies the rows of the tableau
+ * and the current assignment, and pivots to minimize the sum of the bound
+ * violations of the basic variables. The ratio test stops at the first
+ * breakpoint, and pricing switches to Bland's rule after a run of degenerate
+ * steps. The basis it ends in is only a guess for the exact simplex.
+ */
+class ApproxFloat : public ApproximateSimplex {
+ public:
+  ApproxFloat(const ArithVariables& v,
+              const Tableau& t,
+              TreeLog& l,
+              ApproximateStatistics& s);
+  ~ApproxFloat() {}
+
+  LinResult solveRelaxation() override;
+  Solution extractRelaxation() const override;
+
+  ArithRatPairVec heuristicOptCoeffs() const override
+  {
+    return ArithRatPairVec();
+  }
+
+  MipResult solveMIP(bool al) override { return MipUnknown; }
+  Solution extractMIP() const override { return Solution(); }
+
+  void setOptCoeffs(const ArithRatPairVec& ref) override {}
+
+  void tryCut(int nid, CutInfo& cut) override {}
+
+  std::vector<const CutInfo*> getValidCuts(const NodeLog& node) override
+  {
+    return std::vector<const CutInfo*>();
+  }
+
+  ArithVar getBranchVar(const NodeLog& nl) const override
+  {
+    return ARITHVAR_SENTINEL;
+  }
+
+  double sumInfeasibilities(bool mip) const override;
+
+ private:
+  struct Entry
+  {
+    ArithVar d_var;
+    double d_coeff;
+    Entry(ArithVar v, double c) : d_var(v), d_coeff(c) {}
+  };
+  /** A row is the sum defining its basic variable over nonbasic variables. */
+  typedef std::vector<Entry> Row;
+
+  static const int s_noRow = -1;
+
+  /** Returns the absolute tolerance used for comparisons against bound. */
+  static double tolerance(double bound)
+  {
+    return SMALL_FIXED_DELTA * std::max(1.0, std::abs(bound));
+  }
+
+  /**
+   * Returns how far v is above its upper bound (positive) or below its lower
+   * bound (negative), or 0 if it is within its bounds up to tolerance.
+   */
+  double violation(ArithVar v) const;
+
+  /** Returns the coefficient of v in the row, or 0 if it does not occur. */
+  double coefficient(int row, ArithVar v) const;
+
+  /** Recomputes the values of the basic variables to limit rounding drift. */
+  void recomputeBasicValues();
+
+  /** Makes entering the basic variable of row, which must contain it. */
+  void pivot(int row, ArithVar entering);
+
+  std::vector<Row> d_rows;
+  std::vector<ArithVar> d_basic;
+  /** The row of each basic variable, s_noRow for nonbasic ones. */
+  std::vector<int> d_rowOf;
+  /**
+   * The rows each nonbasic variable may occur in. Entries are not removed
+   * when a coefficient cancels, so they may be stale or repeated.
+   */
+  std::vector<std::vector<int> > d_columns;
+
+  std::vector<double> d_values;
+  std::vector<double> d_lower;
+  std::vector<double> d_upper;
+
+  /** Scratch space indexed by variables, used by pricing and pivots. */
+  std::vector<double> d_dense;
+  std::vector<bool> d_inDense;
+
+  /** Marks the rows visited since d_stamp was last incremented. */
+  std::vector<unsigned> d_rowStamps;
+  unsigned d_stamp;
+
+  bool d_solved;
+};
+
+const int ApproxFloat::s_noRow;
+
+ApproxFloat::ApproxFloat(const ArithVariables& v,
+                         const Tableau& t,
+                         TreeLog& l,
+                         ApproximateStatistics& s)
+    : ApproximateSimplex(v, l, s), d_stamp(0), d_solved(false)
+{
+  const double inf = std::numeric_limits<double>::infinity();
+  ArithVar numVars = d_vars.getNumberOfVariables();
+  d_rowOf.assign(numVars, s_noRow);
+  d_columns.resize(numVars);
+  d_values.assign(numVars, 0.0);
+  d_lower.assign(numVars, -inf);
+  d_upper.assign(numVars, inf);
+  d_dense.assign(numVars, 0.0);
+  d_inDense.assign(numVars, false);
+
+  for (ArithVariables::var_iterator vi = d_vars.var_begin(),
+                                    vi_end = d_vars.var_end();
+       vi != vi_end;
+       ++vi)
+  {
+    ArithVar x = *vi;
+    d_values[x] = d_vars.getAssignment(x).approx(SMALL_FIXED_DELTA);
+    if (d_vars.hasLowerBound(x))
+    {
+      d_lower[x] = d_vars.getLowerBound(x).approx(SMALL_FIXED_DELTA);
+    }
+    if (d_vars.hasUpperBound(x))
+    {
+      d_upper[x] = d_vars.getUpperBound(x).approx(SMALL_FIXED_DELTA);
+    }
+  }
+
+  for (Tableau::BasicIterator bi = t.beginBasic(), bi_end = t.endBasic();
+       bi != bi_end;
+       ++bi)
+  {
+    ArithVar basic = *bi;
+    int row = d_rows.size();
+    d_rows.push_back(Row());
+    d_basic.push_back(basic);
+    d_rowOf[basic] = row;
+
+    // The tableau row is sum c_j x_j = 0, and c_basic is normally -1
+    const Rational& basicCoeff = t.basicFindEntry(basic, basic).getCoefficient();
+    Row& r = d_rows.back();
+    r.reserve(t.basicRowLength(basic) - 1);
+    for (Tableau::RowIterator ri = t.basicRowIterator(basic); !ri.atEnd();
+         ++ri)
+    {
+      const Tableau::Entry& entry = *ri;
+      ArithVar x = entry.getColVar();
+      if (x != basic)
+      {
+        double coeff = basicCoeff.isNegativeOne()
+                           ? entry.getCoefficient().getDouble()
+                           : -(entry.getCoefficient() / basicCoeff).getDouble();
+        r.push_back(Entry(x, coeff));
+        d_columns[x].push_back(row);
+      }
+    }
+  }
+  d_rowStamps.assign(d_rows.size(), 0);
+  recomputeBasicValues();
+}
+
+double ApproxFloat::violation(ArithVar v) const
+{
+  double x = d_values[v];
+  if (x < d_lower[v] - tolerance(d_lower[v]))
+  {
+    return x - d_lower[v];
+  }
+  else if (x > d_upper[v] + tolerance(d_upper[v]))
+  {
+    return x - d_upper[v];
+  }
+  return 0.0;
+}
+
+double ApproxFloat::coefficient(int row, ArithVar v) const
+{
+  for (const Entry& e : d_rows[row])
+  {
+    if (e.d_var == v)
+    {
+      return e.d_coeff;
+    }
+  }
+  return 0.0;
+}
+
+void ApproxFloat::recomputeBasicValues()
+{
+  for (size_t i = 0, N = d_rows.size(); i < N; ++i)
+  {
+    double sum = 0.0;
+    for (const Entry& e : d_rows[i])
+    {
+      sum += e.d_coeff * d_values[e.d_var];
+    }
+    d_values[d_basic[i]] = sum;
+  }
+}
+
+void ApproxFloat::pivot(int row, ArithVar entering)
+{
+  static const double dropTolerance = 1e-12;
+
+  ArithVar leaving = d_basic[row];
+  double a = coefficient(row, entering);
+  Assert(a != 0.0);
+
+  // Solve the row for entering
+  Row solved;
+  solved.reserve(d_rows[row].size());
+  solved.push_back(Entry(leaving, 1.0 / a));
+  for (const Entry& e : d_rows[row])
+  {
+    if (e.d_var != entering)
+    {
+      solved.push_back(Entry(e.d_var, -e.d_coeff / a));
+    }
+  }
+  d_rows[row].swap(solved);
+  d_basic[row] = entering;
+  d_rowOf[entering] = row;
+  d_rowOf[leaving] = s_noRow;
+  d_columns[leaving].push_back(row);
+
+  // Substitute it into the other rows containing entering
+  const Row& pivotRow = d_rows[row];
+  ++d_stamp;
+  d_rowStamps[row] = d_stamp;
+  const std::vector<int>& column = d_columns[entering];
+  for (size_t k = 0; k < column.size(); ++k)
+  {
+    int i = column[k];
+    if (d_rowStamps[i] == d_stamp)
+    {
+      continue;
+    }
+    d_rowStamps[i] = d_stamp;
+
+    Row& r = d_rows[i];
+    for (const Entry& e : r)
+    {
+      d_dense[e.d_var] = e.d_coeff;
+      d_inDense[e.d_var] = true;
+    }
+    double c = d_inDense[entering] ? d_dense[entering] : 0.0;
+    if (c != 0.0)
+    {
+      d_dense[entering] = 0.0;
+      for (const Entry& e : pivotRow)
+      {
+        if (!d_inDense[e.d_var])
+        {
+          d_dense[e.d_var] = 0.0;
+          d_inDense[e.d_var] = true;
+          r.push_back(Entry(e.d_var, 0.0));
+          d_columns[e.d_var].push_back(i);
+        }
+        d_dense[e.d_var] += c * e.d_coeff;
+      }
+    }
+    size_t kept = 0;
+    for (const Entry& e : r)
+    {
+      double coeff = d_dense[e.d_var];
+      d_inDense[e.d_var] = false;
+      if (std::abs(coeff) > dropTolerance)
+      {
+        r[kept++] = Entry(e.d_var, coeff);
+      }
+    }
+    r.resize(kept, Entry(ARITHVAR_SENTINEL, 0.0));
+  }
+  d_columns[entering].clear();
+}
+
+LinResult ApproxFloat::solveRelaxation()
+{
+  Assert(!d_solved);
+  static const double pricingTolerance = 1e-9;
+  static const double pivotTolerance = 1e-7;
+  static const int recomputePeriod = 100;
+  static const int degenerateLimit = 50;
+
+  std::vector<ArithVar> candidates;
+  std::vector<std::pair<int, double> > entries;
+  int iterations = 0;
+  int degenerate = 0;
+  while (true)
+  {
+    // Price the nonbasic variables by the sum of the violations
+    candidates.clear();
+    bool feasible = true;
+    for (size_t i = 0, N = d_rows.size(); i < N; ++i)
+    {
+      double v = violation(d_basic[i]);
+      if (v == 0.0)
+      {
+        continue;
+      }
+      feasible = false;
+      double sgn = v < 0.0 ? -1.0 : 1.0;
+      for (const Entry& e : d_rows[i])
+      {
+        if (!d_inDense[e.d_var])
+        {
+          d_dense[e.d_var] = 0.0;
+          d_inDense[e.d_var] = true;
+          candidates.push_back(e.d_var);
+        }
+        d_dense[e.d_var] += sgn * e.d_coeff;
+      }
+    }
+    if (feasible)
+    {
+      d_solved = true;
+      return LinFeasible;
+    }
+
+    bool bland = degenerate >= degenerateLimit;
+    ArithVar entering = ARITHVAR_SENTINEL;
+    double dir = 0.0;
+    double best = 0.0;
+    for (ArithVar x : candidates)
+    {
+      double d = d_dense[x];
+      d_inDense[x] = false;
+      if (std::abs(d) <= pricingTolerance)
+      {
+        continue;
+      }
+      double xdir = d < 0.0 ? 1.0 : -1.0;
+      double room = xdir > 0.0 ? d_upper[x] - d_values[x]
+                               : d_values[x] - d_lower[x];
+      if (room <= tolerance(d_values[x]))
+      {
+        continue;
+      }
+      if (bland ? (entering == ARITHVAR_SENTINEL || x < entering)
+                : std::abs(d) > best)
+      {
+        entering = x;
+        dir = xdir;
+        best = std::abs(d);
+      }
+    }
+    if (entering == ARITHVAR_SENTINEL)
+    {
+      d_solved = true;
+      return LinInfeasible;
+    }
+    if (iterations >= d_pivotLimit)
+    {
+      return LinExhausted;
+    }
+    ++iterations;
+
+    // Ratio test, stopping at the first breakpoint
+    double step = dir > 0.0 ? d_upper[entering] - d_values[entering]
+                            : d_values[entering] - d_lower[entering];
+    int leavingRow = s_noRow;
+    double leavingValue = 0.0;
+    double leavingCoeff = 0.0;
+    entries.clear();
+    ++d_stamp;
+    for (int i : d_columns[entering])
+    {
+      if (d_rowStamps[i] == d_stamp)
+      {
+        continue;
+      }
+      d_rowStamps[i] = d_stamp;
+      double a = coefficient(i, entering);
+      if (a == 0.0)
+      {
+        continue;
+      }
+      entries.push_back(std::make_pair(i, a));
+      if (std::abs(a) < pivotTolerance)
+      {
+        continue;
+      }
+      ArithVar basic = d_basic[i];
+      double rate = a * dir;
+      double x = d_values[basic];
+      double lb = d_lower[basic];
+      double ub = d_upper[basic];
+      double bound;
+      if (rate > 0.0)
+      {
+        if (x > ub + tolerance(ub))
+        {
+          continue;
+        }
+        bound = x < lb - tolerance(lb) ? lb : ub;
+      }
+      else
+      {
+        if (x < lb - tolerance(lb))
+        {
+          continue;
+        }
+        bound = x > ub + tolerance(ub) ? ub : lb;
+      }
+      if (std::isinf(bound))
+      {
+        continue;
+      }
+      double limit = std::max(0.0, (bound - x) / rate);
+      if (limit < step
+          || (limit == step && leavingRow != s_noRow
+              && std::abs(a) > std::abs(leavingCoeff)))
+      {
+        step = limit;
+        leavingRow = i;
+        leavingValue = bound;
+        leavingCoeff = a;
+      }
+    }
+    if (std::isinf(step))
+    {
+      return LinUnknown;
+    }
+
+    d_values[entering] += dir * step;
+    for (const std::pair<int, double>& p : entries)
+    {
+      d_values[d_basic[p.first]] += p.second * dir * step;
+    }
+    degenerate = step <= tolerance(d_values[entering]) ? degenerate + 1 : 0;
+    if (leavingRow == s_noRow)
+    {
+      d_values[entering] = dir > 0.0 ? d_upper[entering] : d_lower[entering];
+      ++(d_stats.d_floatBoundFlips);
+    }
+    else
+    {
+      ArithVar leaving = d_basic[leavingRow];
+      pivot(leavingRow, entering);
+      d_values[leaving] = leavingValue;
+      ++(d_stats.d_floatPivots);
+    }
+    if (iterations % recomputePeriod == 0)
+    {
+      recomputeBasicValues();
+    }
+  }
+}
+
+ApproximateSimplex::Solution ApproxFloat::extractRelaxation() const
+{
+  Assert(d_solved);
+  Solution sol;
+  for (ArithVariables::var_iterator vi = d_vars.var_begin(),
+                                    vi_end = d_vars.var_end();
+       vi != vi_end;
+       ++vi)
+  {
+    ArithVar x = *vi;
+    if (d_rowOf[x] != s_noRow)
+    {
+      sol.newBasis.add(x);
+    }
+    sol.newValues.set(x, estimateAssignment(x, d_values[x]));
+  }
+  return sol;
+}
+
+double ApproxFloat::sumInfeasibilities(bool mip) const
+{
+  double infeas = 0.0;
+  for (ArithVar basic : d_basic)
+  {
+    infeas += std::abs(violation(basic));
+  }
+  return infeas;
+}
+
 }/* CVC4::theory::arith namespace */
 }/* CVC4::theory namespace */
 }/* CVC4 namespace */
@@ -547,6 +1090,14 @@ ApproximateSimplex* ApproximateSimplex::mkApproximateSimplexSolver(const ArithVa
   return new ApproxNoOp(vars, l, s);
 #endif
 }
+ApproximateSimplex* ApproximateSimplex::mkFloatSimplexSolver(
+    const ArithVariables& vars,
+    const Tableau& tableau,
+    TreeLog& l,
+    ApproximateStatistics& s)
+{
+  return new ApproxFloat(vars, tableau, l, s);
+}
 bool ApproximateSimplex::enabled() {
 #ifdef CVC4_USE_GLPK
   return true;
@@ -1056,56 +1607,7 @@ ApproximateSimplex::Solution ApproxGLPK::extractSolution(bool mip) const
         newAssign = (isAux ? glp_get_row_prim(prob, glpk_index)
                      :  glp_get_col_prim(prob, glpk_index));
       }
-      const DeltaRational& oldAssign = d_vars.getAssignment(vi);
-
-
-      if(d_vars.hasLowerBound(vi) &&
-         roughlyEqual(newAssign, d_vars.getLowerBound(vi).approx(SMALL_FIXED_DELTA))){
-        //Message() << "  to lb" << endl;
-
-        newValues.set(vi, d_vars.getLowerBound(vi));
-      }else if(d_vars.hasUpperBound(vi) &&
-               roughlyEqual(newAssign, d_vars.getUpperBound(vi).approx(SMALL_FIXED_DELTA))){
-        newValues.set(vi, d_vars.getUpperBound(vi));
-        // Message() << "  to ub" << endl;
-      }else{
-
-        double rounded = round(newAssign);
-        if(roughlyEqual(newAssign, rounded)){
-          // Message() << "roughly equal " << rounded << " " << newAssign << " " << oldAssign << endl;
-          newAssign = rounded;
-        }else{
-          // Message() << "not roughly equal " << rounded << " " << newAssign << " " << oldAssign << endl;
-        }
-
-        DeltaRational proposal;
-        if (Maybe<Rational> maybe_new = estimateWithCFE(newAssign))
-        {
-          proposal = maybe_new.value();
-        }
-        else
-        {
-          // failed to estimate the old value. defaulting to the current.
-          proposal = d_vars.getAssignment(vi);
-        }
-
-        if(roughlyEqual(newAssign, oldAssign.approx(SMALL_FIXED_DELTA))){
-          // Message() << "  to prev value" << newAssign << " " << oldAssign << endl;
-          proposal = d_vars.getAssignment(vi);
-        }
-
-
-        if(d_vars.strictlyLessThanLowerBound(vi, proposal)){
-          //Message() << "  round to lb " << d_vars.getLowerBound(vi) << endl;
-          proposal = d_vars.getLowerBound(vi);
-        }else if(d_vars.strictlyGreaterThanUpperBound(vi, proposal)){
-          //Message() << "  round to ub " << d_vars.getUpperBound(vi) << endl;
-          proposal = d_vars.getUpperBound(vi);
-        }else{
-          //Message() << "  use proposal" << proposal << " " << oldAssign  << endl;
-        }
-        newValues.set(vi, proposal);
-      }
+      newValues.set(vi, estimateAssignment(vi, newAssign));
     }
   }
   return sol;
@@ -60,6 +60,9 @@ class ApproximateStatistics {
   TimerStat d_gaussianElimConstructTime;
   IntStat d_gaussianElimConstruct;
   AverageStat d_averageGuesses;
+
+  IntStat d_floatPivots;
+  IntStat d_floatBoundFlips;
 };
 
 
@@ -68,6 +71,7 @@ class TreeLog;
 class ArithVariables;
 class CutInfo;
 class RowsDeleted;
+class Tableau;
 
 class ApproximateSimplex{
  public:
@@ -78,6 +82,16 @@ class ApproximateSimplex{
    * If glpk is disabled, return a subclass that does nothing.
    */
   static ApproximateSimplex* mkApproximateSimplexSolver(const ArithVariables& vars, TreeLog& l, ApproximateStatistics& s);
+
+  /**
+   * Returns the built-in floating point simplex. It does not need glpk and
+   * only supports solveRelaxation() and extractRelaxation(). It starts from
+   * the basis of the tableau.
+   */
+  static ApproximateSimplex* mkFloatSimplexSolver(const ArithVariables& vars,
+                                                  const Tableau& tableau,
+                                                  TreeLog& l,
+                                                  ApproximateStatistics& s);
   ApproximateSimplex(const ArithVariables& v, TreeLog& l, ApproximateStatistics& s);
   virtual ~ApproximateSimplex(){}
 
@@ -147,6 +161,14 @@ class ApproximateSimplex{
   virtual double sumInfeasibilities(bool mip) const = 0;
 
  protected:
+  /**
+   * Converts the value v has in the approximate solution back into an exact
+   * assignment. Values roughly at a bound of v are snapped to the bound,
+   * values roughly equal to the current assignment keep it, and the rest
+   * are estimated using continued fractions and clamped to the bounds.
+   */
+  DeltaRational estimateAssignment(ArithVar v, double value) const;
+
   const ArithVariables& d_vars;
   TreeLog& d_log;
   ApproximateStatistics& d_stats;
@@ -351,6 +351,9 @@ TheoryArithPrivate::Statistics::Statistics()
   , d_boundComputationTime("theory::arith::bound::time")
   , d_boundComputations("theory::arith::bound::boundComputations",0)
   , d_boundPropagations("theory::arith::bound::boundPropagations",0)
+  , d_propRowsVisited("theory::arith::prop::rows::visited", 0)
+  , d_propRowsSkipped("theory::arith::prop::rows::skipped", 0)
+  , d_propRowPropagations("theory::arith::prop::rows::propagations", 0)
   , d_unknownChecks("theory::arith::status::unknowns", 0)
   , d_maxUnknownsInARow("theory::arith::status::maxUnknownsInARow", 0)
   , d_avgUnknownsInARow("theory::arith::status::avgUnknownsInARow")
@@ -406,6 +409,13 @@ TheoryArithPrivate::Statistics::Statistics()
   , d_mipProofsAttempted("theory::arith::z::mip::proofs::attempted", 0)
   , d_mipProofsSuccessful("theory::arith::z::mip::proofs::successful", 0)
   , d_numBranchesFailed("theory::arith::z::mip::branch::proof::failed", 0)
+  , d_floatCalls("theory::arith::float::calls", 0)
+  , d_floatFeasible("theory::arith::float::feasible", 0)
+  , d_floatFeasibleFailures("theory::arith::float::feasible::failures", 0)
+  , d_floatInfeasible("theory::arith::float::infeasible", 0)
+  , d_floatInfeasibleFailures("theory::arith::float::infeasible::failures", 0)
+  , d_floatOthers("theory::arith::float::other", 0)
+  , d_floatTimer("theory::arith::float::timer")
 {
   smtStatisticsRegistry()->registerStat(&d_statAssertUpperConflicts);
   smtStatisticsRegistry()->registerStat(&d_statAssertLowerConflicts);
@@ -430,6 +440,9 @@ TheoryArithPrivate::Statistics::Statistics()
   smtStatisticsRegistry()->registerStat(&d_boundComputationTime);
   smtStatisticsRegistry()->registerStat(&d_boundComputations);
   smtStatisticsRegistry()->registerStat(&d_boundPropagations);
+  smtStatisticsRegistry()->registerStat(&d_propRowsVisited);
+  smtStatisticsRegistry()->registerStat(&d_propRowsSkipped);
+  smtStatisticsRegistry()->registerStat(&d_propRowPropagations);
 
   smtStatisticsRegistry()->registerStat(&d_unknownChecks);
   smtStatisticsRegistry()->registerStat(&d_maxUnknownsInARow);
@@ -497,6 +510,14 @@ TheoryArithPrivate::Statistics::Statistics()
   smtStatisticsRegistry()->registerStat(&d_mipProofsAttempted);
   smtStatisticsRegistry()->registerStat(&d_mipProofsSuccessful);
   smtStatisticsRegistry()->registerStat(&d_numBranchesFailed);
+
+  smtStatisticsRegistry()->registerStat(&d_floatCalls);
+  smtStatisticsRegistry()->registerStat(&d_floatFeasible);
+  smtStatisticsRegistry()->registerStat(&d_floatFeasibleFailures);
+  smtStatisticsRegistry()->registerStat(&d_floatInfeasible);
+  smtStatisticsRegistry()->registerStat(&d_floatInfeasibleFailures);
+  smtStatisticsRegistry()->registerStat(&d_floatOthers);
+  smtStatisticsRegistry()->registerStat(&d_floatTimer);
 }
 
 TheoryArithPrivate::Statistics::~Statistics(){
@@ -523,6 +544,9 @@ TheoryArithPrivate::Statistics::~Statistics(){
   smtStatisticsRegistry()->unregisterStat(&d_boundComputationTime);
   smtStatisticsRegistry()->unregisterStat(&d_boundComputations);
   smtStatisticsRegistry()->unregisterStat(&d_boundPropagations);
+  smtStatisticsRegistry()->unregisterStat(&d_propRowsVisited);
+  smtStatisticsRegistry()->unregisterStat(&d_propRowsSkipped);
+  smtStatisticsRegistry()->unregisterStat(&d_propRowPropagations);
 
   smtStatisticsRegistry()->unregisterStat(&d_unknownChecks);
   smtStatisticsRegistry()->unregisterStat(&d_maxUnknownsInARow);
@@ -591,6 +615,14 @@ TheoryArithPrivate::Statistics::~Statistics(){
   smtStatisticsRegistry()->unregisterStat(&d_mipProofsAttempted);
   smtStatisticsRegistry()->unregisterStat(&d_mipProofsSuccessful);
   smtStatisticsRegistry()->unregisterStat(&d_numBranchesFailed);
+
+  smtStatisticsRegistry()->unregisterStat(&d_floatCalls);
+  smtStatisticsRegistry()->unregisterStat(&d_floatFeasible);
+  smtStatisticsRegistry()->unregisterStat(&d_floatFeasibleFailures);
+  smtStatisticsRegistry()->unregisterStat(&d_floatInfeasible);
+  smtStatisticsRegistry()->unregisterStat(&d_floatInfeasibleFailures);
+  smtStatisticsRegistry()->unregisterStat(&d_floatOthers);
+  smtStatisticsRegistry()->unregisterStat(&d_floatTimer);
 }
 
 bool complexityBelow(const DenseMap<Rational>& row, uint32_t cap){
@@ -626,6 +658,14 @@ void TheoryArithPrivate::clearUpdates(){
   d_updatedBounds.purge();
 }
 
+void TheoryArithPrivate::noteUpdatedBound(ArithVar x, BoundCounts sides){
+  if(d_updatedBounds.isKey(x)){
+    d_updatedBounds.get(x) += sides;
+  }else{
+    d_updatedBounds.set(x, sides);
+  }
+}
+
 // void TheoryArithPrivate::raiseConflict(ConstraintCP a, ConstraintCP b){
 //   ConstraintCPVec v;
 //   v.push_back(a);
@@ -795,7 +835,7 @@ bool TheoryArithPrivate::AssertLower(ConstraintP constraint){
     }
   }
 
-  d_updatedBounds.softAdd(x_i);
+  noteUpdatedBound(x_i, BoundCounts(1, 0));
 
   if(Debug.isOn("model")) {
     Debug("model") << "before" << endl;
@@ -935,7 +975,7 @@ bool TheoryArithPrivate::AssertUpper(ConstraintP constraint){
     }
   }
 
-  d_updatedBounds.softAdd(x_i);
+  noteUpdatedBound(x_i, BoundCounts(0, 1));
 
   if(Debug.isOn("model")) {
     Debug("model") << "before" << endl;
@@ -1027,7 +1067,7 @@ bool TheoryArithPrivate::AssertEquality(ConstraintP constraint){
     }
   }
 
-  d_updatedBounds.softAdd(x_i);
+  noteUpdatedBound(x_i, BoundCounts(1, 1));
 
   if(Debug.isOn("model")) {
     Debug("model") << "before" << endl;
@@ -3315,6 +3355,59 @@ bool TheoryArithPrivate::solveRelaxationOrPanic(Theory::Effort effortLevel){
   return false;
 }
 
+void TheoryArithPrivate::solveFloatRelaxation(){
+  static const int32_t floatPivotLimit = 100000;
+  static const uint32_t minViolations = 8;
+
+  const Tableau& tableau = d_linEq.getTableau();
+  uint32_t violations = 0;
+  for(Tableau::BasicIterator i = tableau.beginBasic(), i_end = tableau.endBasic();
+      i != i_end && violations < minViolations; ++i){
+    ArithVar b = *i;
+    if(!d_partialModel.assignmentIsConsistent(b)){
+      ++violations;
+    }
+  }
+  if(violations < minViolations){ return; }
+
+  ++d_statistics.d_floatCalls;
+  ApproximateSimplex* floatSolver = ApproximateSimplex::mkFloatSimplexSolver(
+      d_partialModel, tableau, getTreeLog(), getApproxStats());
+  floatSolver->setPivotLimit(floatPivotLimit);
+
+  LinResult floatRes = LinUnknown;
+  ApproximateSimplex::Solution floatSolution;
+  {
+    TimerStat::CodeTimer codeTimer(d_statistics.d_floatTimer);
+    floatRes = floatSolver->solveRelaxation();
+    if(floatRes == LinFeasible || floatRes == LinInfeasible){
+      floatSolution = floatSolver->extractRelaxation();
+    }
+  }
+  delete floatSolver;
+
+  Debug("solveFloatRelaxation") << "float result " << floatRes << endl;
+  switch(floatRes){
+  case LinFeasible:
+    ++d_statistics.d_floatFeasible;
+    importSolution(floatSolution);
+    if(d_qflraStatus != Result::SAT){
+      ++d_statistics.d_floatFeasibleFailures;
+    }
+    break;
+  case LinInfeasible:
+    ++d_statistics.d_floatInfeasible;
+    importSolution(floatSolution);
+    if(d_qflraStatus != Result::UNSAT){
+      ++d_statistics.d_floatInfeasibleFailures;
+    }
+    break;
+  default:
+    ++d_statistics.d_floatOthers;
+    break;
+  }
+}
+
 bool TheoryArithPrivate::solveRealRelaxation(Theory::Effort effortLevel){
   TimerStat::CodeTimer codeTimer(d_statistics.d_solveRealRelaxTimer);
   Assert(d_qflraStatus != Result::SAT);
@@ -3339,8 +3432,17 @@ bool TheoryArithPrivate::solveRealRelaxation(Theory::Effort effortLevel){
     << " " << safeToCallApprox()
     << endl;
   
+  // pass0: float-first
+  bool useFloat = options::arithFloatSimplex() && safeToCallApprox();
+  if(useFloat){
+    d_qflraStatus = Result::SAT_UNKNOWN;
+    solveFloatRelaxation();
+  }
+
   bool noPivotLimitPass1 = noPivotLimit && !useApprox;
-  d_qflraStatus = simplex.findModel(noPivotLimitPass1);
+  if(!useFloat || d_qflraStatus == Result::SAT_UNKNOWN){
+    d_qflraStatus = simplex.findModel(noPivotLimitPass1);
+  }
 
   Debug("TheoryArithPrivate::solveRealRelaxation")
     << "solveRealRelaxation()" << " pass1 " << d_qflraStatus << endl;
@@ -4682,8 +4784,8 @@ void TheoryArithPrivate::propagateCandidates(){
 
   if(d_updatedBounds.empty()){ return; }
 
-  DenseSet::const_iterator i = d_updatedBounds.begin();
-  DenseSet::const_iterator end = d_updatedBounds.end();
+  DenseMap<BoundCounts>::const_iterator i = d_updatedBounds.begin();
+  DenseMap<BoundCounts>::const_iterator end = d_updatedBounds.end();
   for(; i != end; ++i){
     ArithVar var = *i;
     if(d_tableau.isBasic(var) &&
@@ -4734,18 +4836,19 @@ void TheoryArithPrivate::propagateCandidatesNew(){
 
   Assert(d_qflraStatus == Result::SAT);
   if(d_updatedBounds.empty()){ return; }
+
+  // The row filter reads the bound counts, so bring them up to date first
+  UpdateTrackingCallback utcb(&d_linEq);
+  d_partialModel.processBoundsQueue(utcb);
+
   dumpUpdatedBoundsToRows();
   Assert(d_updatedBounds.empty());
 
-  if(!d_candidateRows.empty()){
-    UpdateTrackingCallback utcb(&d_linEq);
-    d_partialModel.processBoundsQueue(utcb);
-  }
-
   while(!d_candidateRows.empty()){
     RowIndex candidate = d_candidateRows.back();
+    BoundCounts directions = d_candidateRows[candidate];
     d_candidateRows.pop_back();
-    propagateCandidateRow(candidate);
+    propagateCandidateRow(candidate, directions);
   }
   Debug("arith::prop") << "propagateCandidatesNew end" << endl << endl << endl;
 }
@@ -4859,9 +4962,10 @@ bool TheoryArithPrivate::tryToPropagate(RowIndex ridx, bool rowUp, ArithVar v, b
     ConstraintType t = vUb ? UpperBound : LowerBound;
 
     ConstraintP implied = d_constraintDatabase.getBestImpliedBound(v, t, bound);
-    if(implied != NullConstraint){
-      
-      return rowImplicationCanBeApplied(ridx, rowUp, implied);
+    if(implied != NullConstraint
+       && rowImplicationCanBeApplied(ridx, rowUp, implied)){
+      ++d_statistics.d_propRowPropagations;
+      return true;
     }
   }
   return false;
@@ -4970,7 +5074,8 @@ bool TheoryArithPrivate::rowImplicationCanBeApplied(RowIndex ridx, bool rowUp, C
   return false;
 }
 
-bool TheoryArithPrivate::propagateCandidateRow(RowIndex ridx){
+bool TheoryArithPrivate::propagateCandidateRow(RowIndex ridx,
+                                               BoundCounts directions){
   BoundCounts hasCount = d_linEq.hasBoundCount(ridx);
   uint32_t rowLength = d_tableau.getRowLength(ridx);
 
@@ -4987,36 +5092,61 @@ bool TheoryArithPrivate::propagateCandidateRow(RowIndex ridx){
   {
     return false;
   }
+  ++d_statistics.d_propRowsVisited;
 
-  if(hasCount.lowerBoundCount() == rowLength){
-    success |= attemptFull(ridx, false);
-  }else if(hasCount.lowerBoundCount() + 1 == rowLength){
-    success |= attemptSingleton(ridx, false);
+  if(directions.lowerBoundCount() > 0){
+    if(hasCount.lowerBoundCount() == rowLength){
+      success |= attemptFull(ridx, false);
+    }else if(hasCount.lowerBoundCount() + 1 == rowLength){
+      success |= attemptSingleton(ridx, false);
+    }
   }
 
-  if(hasCount.upperBoundCount() == rowLength){
-    success |= attemptFull(ridx, true);
-  }else if(hasCount.upperBoundCount() + 1 == rowLength){
-    success |= attemptSingleton(ridx, true);
+  if(directions.upperBoundCount() > 0){
+    if(hasCount.upperBoundCount() == rowLength){
+      success |= attemptFull(ridx, true);
+    }else if(hasCount.upperBoundCount() + 1 == rowLength){
+      success |= attemptSingleton(ridx, true);
+    }
   }
   return success;
 }
 
 void TheoryArithPrivate::dumpUpdatedBoundsToRows(){
   Assert(d_candidateRows.empty());
-  DenseSet::const_iterator i = d_updatedBounds.begin();
-  DenseSet::const_iterator end = d_updatedBounds.end();
+  DenseMap<BoundCounts>::const_iterator i = d_updatedBounds.begin();
+  DenseMap<BoundCounts>::const_iterator end = d_updatedBounds.end();
   for(; i != end; ++i){
     ArithVar var = *i;
-    if(d_tableau.isBasic(var)){
-      RowIndex ridx = d_tableau.basicToRowIndex(var);
-      d_candidateRows.softAdd(ridx);
-    }else{
-      Tableau::ColIterator basicIter = d_tableau.colIterator(var);
-      for(; !basicIter.atEnd(); ++basicIter){
-        const Tableau::Entry& entry = *basicIter;
-        RowIndex ridx = entry.getRowIndex();
-        d_candidateRows.softAdd(ridx);
+    BoundCounts sides = d_updatedBounds[var];
+    // A basic variable only occurs in its own row.
+    Tableau::ColIterator colIter = d_tableau.colIterator(var);
+    for(; !colIter.atEnd(); ++colIter){
+      const Tableau::Entry& entry = *colIter;
+      RowIndex ridx = entry.getRowIndex();
+
+      // With a positive coefficient, the lower bound of var is used by the
+      // lower bound the row implies and the upper bound by the upper one.
+      // A negative coefficient swaps them.
+      BoundCounts directions =
+        sides.multiplyBySgn(entry.getCoefficient().sgn());
+
+      // A row propagates in a direction only if at most one of its
+      // variables lacks a bound in that direction.
+      BoundCounts hasCount = d_linEq.hasBoundCount(ridx);
+      uint32_t rowLength = d_tableau.getRowLength(ridx);
+      BoundCounts useful(
+        (directions.lowerBoundCount() > 0
+         && hasCount.lowerBoundCount() + 1 >= rowLength) ? 1 : 0,
+        (directions.upperBoundCount() > 0
+         && hasCount.upperBoundCount() + 1 >= rowLength) ? 1 : 0);
+
+      if(useful.isZero()){
+        ++d_statistics.d_propRowsSkipped;
+      }else if(d_candidateRows.isKey(ridx)){
+        d_candidateRows.get(ridx) += useful;
+      }else{
+        d_candidateRows.set(ridx, useful);
       }
     }
   }
@@ -379,6 +379,14 @@ private:
 
   bool solveRealRelaxation(Theory::Effort effortLevel);
 
+  /**
+   * Runs the floating point simplex from the current tableau and imports the
+   * basis it ends in, which the exact simplex then verifies and repairs.
+   * Sets d_qflraStatus, and does nothing if few basic variables violate
+   * their bounds.
+   */
+  void solveFloatRelaxation();
+
   /* Returns true if this is heuristically a good time to try
    * to solve the integers.
    */
@@ -561,12 +569,22 @@ private:
   bool AssertEquality(ConstraintP constraint);
   bool AssertDisequality(ConstraintP constraint);
 
-  /** Tracks the bounds that were updated in the current round. */
-  DenseSet d_updatedBounds;
+  /**
+   * Tracks the bounds that were updated in the current round, counting the
+   * lower and upper bound updates of each variable.
+   */
+  DenseMap<BoundCounts> d_updatedBounds;
+  void noteUpdatedBound(ArithVar x, BoundCounts sides);
 
   /** Tracks the basic variables where propagation might be possible. */
   DenseSet d_candidateBasics;
-  DenseSet d_candidateRows;
+
+  /**
+   * Tracks the rows where propagation might be possible. A nonzero lower
+   * (upper) count means the lower (upper) bound the row implies has changed
+   * and the row has enough bounds in that direction to propagate.
+   */
+  DenseMap<BoundCounts> d_candidateRows;
 
   bool hasAnyUpdates() { return !d_updatedBounds.empty(); }
   void clearUpdates();
@@ -574,8 +592,13 @@ private:
   void revertOutOfConflict();
 
   void propagateCandidatesNew();
+  /**
+   * Moves the updated bounds to the rows whose implied bounds they change.
+   * Rows are filtered using the bound counts of d_rowTracking, which the
+   * linear equality module maintains across pivots, so no row is scanned.
+   */
   void dumpUpdatedBoundsToRows();
-  bool propagateCandidateRow(RowIndex rid);
+  bool propagateCandidateRow(RowIndex rid, BoundCounts directions);
   bool propagateMightSucceed(ArithVar v, bool ub) const;
   /** Attempt to perform a row propagation where there is at most 1 possible variable.*/
   bool attemptSingleton(RowIndex ridx, bool rowUp);
@@ -750,6 +773,7 @@ private:
 
     TimerStat d_boundComputationTime;
     IntStat d_boundComputations, d_boundPropagations;
+    IntStat d_propRowsVisited, d_propRowsSkipped, d_propRowPropagations;
 
     IntStat d_unknownChecks;
     IntStat d_maxUnknownsInARow;
@@ -820,6 +844,13 @@ private:
 
     IntStat d_numBranchesFailed;
 
+    IntStat d_floatCalls;
+    IntStat d_floatFeasible;
+    IntStat d_floatFeasibleFailures;
+    IntStat d_floatInfeasible;
+    IntStat d_floatInfeasibleFailures;
+    IntStat d_floatOthers;
+    TimerStat d_floatTimer;
 
 
     Statistics();
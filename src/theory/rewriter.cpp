@@ -17,11 +17,16 @@
 
 #include "theory/rewriter.h"
 
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
 #include "options/theory_options.h"
 #include "smt/smt_engine_scope.h"
 #include "smt/smt_statistics_registry.h"
 #include "theory/rewriter_tables.h"
 #include "theory/theory.h"
+#include "util/rational.h"
 #include "util/resource_manager.h"
 
 using namespace std;
@@ -42,45 +47,6 @@ static TheoryId theoryOf(TNode node) {
   return kindToTheoryId(node.getKind());
 }
 
-/**
- * TheoryEngine::rewrite() keeps a stack of things that are being pre-
- * and post-rewritten.  Each element of the stack is a
- * RewriteStackElement.
- */
-struct RewriteStackElement {
-  /**
-   * Construct a fresh stack element.
-   */
-  RewriteStackElement(TNode node, TheoryId theoryId)
-      : node(node),
-        original(node),
-        theoryId(theoryId),
-        originalTheoryId(theoryId),
-        nextChild(0)
-  {
-  }
-
-  TheoryId getTheoryId() { return static_cast<TheoryId>(theoryId); }
-
-  TheoryId getOriginalTheoryId()
-  {
-    return static_cast<TheoryId>(originalTheoryId);
-  }
-
-  /** The node we're currently rewriting */
-  Node node;
-  /** Original node */
-  Node original;
-  /** Id of the theory that's currently rewriting this node */
-  unsigned theoryId         : 8;
-  /** Id of the original theory that started the rewrite */
-  unsigned originalTheoryId : 8;
-  /** Index of the child this node is done rewriting */
-  unsigned nextChild        : 32;
-  /** Builder for this node */
-  NodeBuilder<> builder;
-};
-
 Node Rewriter::rewrite(TNode node) {
   if (node.getNumChildren() == 0)
   {
@@ -98,6 +64,45 @@ Rewriter& Rewriter::getInstance()
   return rewriter;
 }
 
+RewriterState& Rewriter::getState()
+{
+  RewriterState* state = smt::currentRewriterState();
+  if (state != NULL)
+  {
+    return *state;
+  }
+  // the caches used outside of an SmtEngine are not reported
+  thread_local static RewriterState threadState(NULL);
+  return threadState;
+}
+
+Node Rewriter::buildRewritten(TNode node, size_t childrenBegin)
+{
+  Assert(d_rewrittenChildren.size() - childrenBegin == node.getNumChildren());
+  // Avoid the NodeManager lookup if no child changed
+  bool changed = false;
+  for (size_t i = 0, n = node.getNumChildren(); i < n && !changed; ++i)
+  {
+    changed = d_rewrittenChildren[childrenBegin + i] != node[i];
+  }
+  Node rewritten = node;
+  if (changed)
+  {
+    NodeBuilder<> builder(node.getKind());
+    if (node.getMetaKind() == kind::metakind::PARAMETERIZED)
+    {
+      builder << node.getOperator();
+    }
+    for (size_t i = childrenBegin, n = d_rewrittenChildren.size(); i < n; ++i)
+    {
+      builder << d_rewrittenChildren[i];
+    }
+    rewritten = builder;
+  }
+  d_rewrittenChildren.resize(childrenBegin);
+  return rewritten;
+}
+
 Node Rewriter::rewriteTo(theory::TheoryId theoryId, Node node) {
 
 #ifdef CVC4_ASSERTIONS
@@ -111,15 +116,42 @@ Node Rewriter::rewriteTo(theory::TheoryId theoryId, Node node) {
 
   Trace("rewriter") << "Rewriter::rewriteTo(" << theoryId << "," << node << ")"<< std::endl;
 
+  d_profiling = options::rewriteProfile();
+
   // Check if it's been cached already
-  Node cached = getPostRewriteCache(theoryId, node);
+  Node cached = lookupPostRewriteCache(theoryId, node);
   if (!cached.isNull()) {
     return cached;
   }
 
+  // This call may be nested in another one (when changing theories, or when
+  // a theory rewriter rewrites subterms), so it only uses the part of the
+  // work stack and of the rewritten children above that of its callers.
+  // That part is released on exit, also if a theory rewriter throws.
+  struct WorkStackScope
+  {
+    WorkStackScope(Rewriter& rewriter)
+        : d_rewriter(rewriter),
+          d_stackBase(rewriter.d_workStack.size()),
+          d_childrenBase(rewriter.d_rewrittenChildren.size())
+    {
+    }
+    ~WorkStackScope()
+    {
+      d_rewriter.d_workStack.resize(d_stackBase,
+                                    RewriteStackElement(Node::null(),
+                                                        THEORY_BUILTIN,
+                                                        0));
+      d_rewriter.d_rewrittenChildren.resize(d_childrenBase);
+    }
+    Rewriter& d_rewriter;
+    const size_t d_stackBase;
+    const size_t d_childrenBase;
+  } scope(*this);
+
   // Put the node on the stack in order to start the "recursive" rewrite
-  vector<RewriteStackElement> rewriteStack;
-  rewriteStack.push_back(RewriteStackElement(node, theoryId));
+  d_workStack.push_back(
+      RewriteStackElement(node, theoryId, d_rewrittenChildren.size()));
 
   ResourceManager* rm = NULL;
   bool hasSmtEngine = smt::smtEngineInScope();
@@ -135,109 +167,109 @@ Node Rewriter::rewriteTo(theory::TheoryId theoryId, Node node) {
       d_iterationCount = 0;
     }
 
-    // Get the top of the recursion stack
-    RewriteStackElement& rewriteStackTop = rewriteStack.back();
+    // Get the top of the recursion stack.  The theory rewriters may rewrite
+    // recursively and grow the work stack, so this is refreshed after each
+    // call to them.
+    RewriteStackElement* top = &d_workStack.back();
 
-    Trace("rewriter") << "Rewriter::rewriting: "
-                      << rewriteStackTop.getTheoryId() << ","
-                      << rewriteStackTop.node << std::endl;
+    Trace("rewriter") << "Rewriter::rewriting: " << top->getTheoryId() << ","
+                      << top->node << std::endl;
 
     // Before rewriting children we need to do a pre-rewrite of the node
-    if (rewriteStackTop.nextChild == 0) {
+    if (top->nextChild == 0) {
 
       // Check if the pre-rewrite has already been done (it's in the cache)
-      Node cached = getPreRewriteCache(rewriteStackTop.getTheoryId(),
-                                       rewriteStackTop.node);
+      Node cached = lookupPreRewriteCache(top->getTheoryId(), top->node);
       if (cached.isNull()) {
+        if (d_profiling)
+        {
+          ++getProfileEntry(top->getTheoryId(), top->node.getKind())
+                .d_rewrites;
+        }
         // Rewrite until fix-point is reached
         for(;;) {
           // Perform the pre-rewrite
           RewriteResponse response =
-              d_theoryRewriters[rewriteStackTop.getTheoryId()]->preRewrite(
-                  rewriteStackTop.node);
+              callPreRewrite(top->getTheoryId(), top->node);
+          top = &d_workStack.back();
           // Put the rewritten node to the top of the stack
-          rewriteStackTop.node = response.node;
-          TheoryId newTheory = theoryOf(rewriteStackTop.node);
+          top->node = response.node;
+          TheoryId newTheory = theoryOf(top->node);
           // In the pre-rewrite, if changing theories, we just call the other theories pre-rewrite
-          if (newTheory == rewriteStackTop.getTheoryId()
+          if (newTheory == top->getTheoryId()
               && response.status == REWRITE_DONE)
           {
             break;
           }
-          rewriteStackTop.theoryId = newTheory;
+          top->theoryId = newTheory;
         }
         // Cache the rewrite
-        setPreRewriteCache(rewriteStackTop.getOriginalTheoryId(),
-                           rewriteStackTop.original,
-                           rewriteStackTop.node);
+        storePreRewriteCache(
+            top->getOriginalTheoryId(), top->original, top->node);
       }
       // Otherwise we're have already been pre-rewritten (in pre-rewrite cache)
       else {
         // Continue with the cached version
-        rewriteStackTop.node = cached;
-        rewriteStackTop.theoryId = theoryOf(cached);
+        top->node = cached;
+        top->theoryId = theoryOf(cached);
       }
     }
 
-    rewriteStackTop.original =rewriteStackTop.node;
+    top->original = top->node;
     // Now it's time to rewrite the children, check if this has already been done
-    Node cached = getPostRewriteCache(rewriteStackTop.getTheoryId(),
-                                      rewriteStackTop.node);
+    Node cached = lookupPostRewriteCache(top->getTheoryId(), top->node);
     // If not, go through the children
     if(cached.isNull()) {
 
       // The child we need to rewrite
-      unsigned child = rewriteStackTop.nextChild++;
-
-      // To build the rewritten expression we set up the builder
-      if(child == 0) {
-        if (rewriteStackTop.node.getNumChildren() > 0) {
-          // The children will add themselves to the builder once they're done
-          rewriteStackTop.builder << rewriteStackTop.node.getKind();
-          kind::MetaKind metaKind = rewriteStackTop.node.getMetaKind();
-          if (metaKind == kind::metakind::PARAMETERIZED) {
-            rewriteStackTop.builder << rewriteStackTop.node.getOperator();
-          }
-        }
-      }
+      unsigned child = top->nextChild++;
 
       // Process the next child
-      if(child < rewriteStackTop.node.getNumChildren()) {
+      if (child < top->node.getNumChildren())
+      {
         // The child node
-        Node childNode = rewriteStackTop.node[child];
-        // Push the rewrite request to the stack (NOTE: rewriteStackTop might be a bad reference now)
-        rewriteStack.push_back(RewriteStackElement(childNode, theoryOf(childNode)));
+        Node childNode = top->node[child];
+        // Push the rewrite request to the stack (NOTE: top might be a bad
+        // pointer now)
+        d_workStack.push_back(RewriteStackElement(
+            childNode, theoryOf(childNode), d_rewrittenChildren.size()));
         // Go on with the rewriting
         continue;
       }
 
       // Incorporate the children if necessary
-      if (rewriteStackTop.node.getNumChildren() > 0) {
-        Node rewritten = rewriteStackTop.builder;
-        rewriteStackTop.node = rewritten;
-        rewriteStackTop.theoryId = theoryOf(rewriteStackTop.node);
+      if (top->node.getNumChildren() > 0)
+      {
+        top->node = buildRewritten(top->node, top->childrenBegin);
+        top->theoryId = theoryOf(top->node);
       }
 
+      if (d_profiling)
+      {
+        ++getProfileEntry(top->getTheoryId(), top->node.getKind())
+              .d_rewrites;
+      }
       // Done with all pre-rewriting, so let's do the post rewrite
       for(;;) {
         // Do the post-rewrite
         RewriteResponse response =
-            d_theoryRewriters[rewriteStackTop.getTheoryId()]->postRewrite(
-                rewriteStackTop.node);
+            callPostRewrite(top->getTheoryId(), top->node);
+        top = &d_workStack.back();
         // We continue with the response we got
         TheoryId newTheoryId = theoryOf(response.node);
-        if (newTheoryId != rewriteStackTop.getTheoryId()
+        if (newTheoryId != top->getTheoryId()
             || response.status == REWRITE_AGAIN_FULL)
         {
           // In the post rewrite if we've changed theories, we must do a full rewrite
-          Assert(response.node != rewriteStackTop.node);
+          Assert(response.node != top->node);
           //TODO: this is not thread-safe - should make this assertion dependent on sequential build
 #ifdef CVC4_ASSERTIONS
           Assert(d_rewriteStack->find(response.node) == d_rewriteStack->end());
           d_rewriteStack->insert(response.node);
 #endif
           Node rewritten = rewriteTo(newTheoryId, response.node);
-          rewriteStackTop.node = rewritten;
+          top = &d_workStack.back();
+          top->node = rewritten;
 #ifdef CVC4_ASSERTIONS
           d_rewriteStack->erase(response.node);
 #endif
@@ -249,38 +281,42 @@ Node Rewriter::rewriteTo(theory::TheoryId theoryId, Node node) {
           RewriteResponse r2 =
               d_theoryRewriters[newTheoryId]->postRewrite(response.node);
           Assert(r2.node == response.node);
+          top = &d_workStack.back();
 #endif
-	  rewriteStackTop.node = response.node;
+          top->node = response.node;
           break;
         }
         // Check for trivial rewrite loops of size 1 or 2
-        Assert(response.node != rewriteStackTop.node);
-        Assert(d_theoryRewriters[rewriteStackTop.getTheoryId()]
-                   ->postRewrite(response.node)
-                   .node
-               != rewriteStackTop.node);
-        rewriteStackTop.node = response.node;
+        Assert(response.node != top->node);
+#ifdef CVC4_ASSERTIONS
+        Node again = d_theoryRewriters[top->getTheoryId()]
+                         ->postRewrite(response.node)
+                         .node;
+        top = &d_workStack.back();
+        Assert(again != top->node);
+#endif
+        top->node = response.node;
       }
       // We're done with the post rewrite, so we add to the cache
-      setPostRewriteCache(rewriteStackTop.getOriginalTheoryId(),
-                          rewriteStackTop.original,
-                          rewriteStackTop.node);
+      storePostRewriteCache(
+          top->getOriginalTheoryId(), top->original, top->node);
     } else {
       // We were already in cache, so just remember it
-      rewriteStackTop.node = cached;
-      rewriteStackTop.theoryId = theoryOf(cached);
+      top->node = cached;
+      top->theoryId = theoryOf(cached);
     }
 
     // If this is the last node, just return
-    if (rewriteStack.size() == 1) {
-      Assert(!isEquality || rewriteStackTop.node.getKind() == kind::EQUAL
-             || rewriteStackTop.node.isConst());
-      return rewriteStackTop.node;
+    if (d_workStack.size() == scope.d_stackBase + 1)
+    {
+      Assert(!isEquality || top->node.getKind() == kind::EQUAL
+             || top->node.isConst());
+      return top->node;
     }
 
-    // We're done with this node, append it to the parent
-    rewriteStack[rewriteStack.size() - 2].builder << rewriteStackTop.node;
-    rewriteStack.pop_back();
+    // We're done with this node, append it to the parent's children
+    d_rewrittenChildren.push_back(top->node);
+    d_workStack.pop_back();
   }
 
   Unreachable();
@@ -296,5 +332,327 @@ void Rewriter::clearCaches() {
   rewriter.clearCachesInternal();
 }
 
+RewriteResponse Rewriter::callPreRewrite(TheoryId theoryId, TNode node)
+{
+  if (!d_profiling)
+  {
+    return d_theoryRewriters[theoryId]->preRewrite(node);
+  }
+  ProfileEntry& entry = getProfileEntry(theoryId, node.getKind());
+  ++entry.d_iterations;
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  RewriteResponse response = d_theoryRewriters[theoryId]->preRewrite(node);
+  entry.d_time += std::chrono::steady_clock::now() - start;
+  return response;
+}
+
+RewriteResponse Rewriter::callPostRewrite(TheoryId theoryId, TNode node)
+{
+  if (!d_profiling)
+  {
+    return d_theoryRewriters[theoryId]->postRewrite(node);
+  }
+  ProfileEntry& entry = getProfileEntry(theoryId, node.getKind());
+  ++entry.d_iterations;
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  RewriteResponse response = d_theoryRewriters[theoryId]->postRewrite(node);
+  entry.d_time += std::chrono::steady_clock::now() - start;
+  return response;
+}
+
+Rewriter::ProfileEntry& Rewriter::getProfileEntry(TheoryId theoryId, Kind k)
+{
+  std::vector<ProfileEntry>& profile = getState().d_profile;
+  if (profile.empty())
+  {
+    profile.resize(THEORY_LAST * kind::LAST_KIND);
+  }
+  return profile[theoryId * kind::LAST_KIND + k];
+}
+
+Node Rewriter::lookupPreRewriteCache(TheoryId theoryId, TNode node)
+{
+  RewriterState& state = getState();
+  Node cached = getPreRewriteCache(theoryId, node, state.d_current);
+  if (cached.isNull() && state.d_hasOld)
+  {
+    const unsigned old = 1 - state.d_current;
+    cached = getPreRewriteCache(theoryId, node, old);
+    if (!cached.isNull())
+    {
+      // the entry is in use, move it to the current generation so that it
+      // survives the next eviction
+      --state.d_entries[theoryId][old];
+      setPreRewriteCache(theoryId, node, cached, state.d_current);
+      addedCacheEntry(state, theoryId);
+    }
+  }
+  CacheCounters& counters = state.d_cacheCounters[theoryId];
+  if (cached.isNull())
+  {
+    ++counters.d_misses;
+  }
+  else
+  {
+    ++counters.d_hits;
+    if (d_profiling)
+    {
+      ++getProfileEntry(theoryId, node.getKind()).d_cacheHits;
+    }
+  }
+  return cached;
+}
+
+Node Rewriter::lookupPostRewriteCache(TheoryId theoryId, TNode node)
+{
+  RewriterState& state = getState();
+  Node cached = getPostRewriteCache(theoryId, node, state.d_current);
+  if (cached.isNull() && state.d_hasOld)
+  {
+    const unsigned old = 1 - state.d_current;
+    cached = getPostRewriteCache(theoryId, node, old);
+    if (!cached.isNull())
+    {
+      // the entry is in use, move it to the current generation so that it
+      // survives the next eviction
+      --state.d_entries[theoryId][old];
+      setPostRewriteCache(theoryId, node, cached, state.d_current);
+      addedCacheEntry(state, theoryId);
+    }
+  }
+  CacheCounters& counters = state.d_cacheCounters[theoryId];
+  if (cached.isNull())
+  {
+    ++counters.d_misses;
+  }
+  else
+  {
+    ++counters.d_hits;
+    if (d_profiling)
+    {
+      ++getProfileEntry(theoryId, node.getKind()).d_cacheHits;
+    }
+  }
+  return cached;
+}
+
+void Rewriter::storePreRewriteCache(TheoryId theoryId, TNode node, TNode cache)
+{
+  RewriterState& state = getState();
+  // overwriting an entry does not add one
+  bool added = getPreRewriteCache(theoryId, node, state.d_current).isNull();
+  setPreRewriteCache(theoryId, node, cache, state.d_current);
+  if (added)
+  {
+    addedCacheEntry(state, theoryId);
+  }
+}
+
+void Rewriter::storePostRewriteCache(TheoryId theoryId,
+                                     TNode node,
+                                     TNode cache)
+{
+  RewriterState& state = getState();
+  // overwriting an entry does not add one
+  bool added = getPostRewriteCache(theoryId, node, state.d_current).isNull();
+  setPostRewriteCache(theoryId, node, cache, state.d_current);
+  if (added)
+  {
+    addedCacheEntry(state, theoryId);
+  }
+}
+
+void Rewriter::addedCacheEntry(RewriterState& state, TheoryId theoryId)
+{
+  ++state.d_entries[theoryId][state.d_current];
+  const uint64_t limit = options::rewriteCacheLimit();
+  if (limit == 0 || ++state.d_size < (limit + 1) / 2)
+  {
+    return;
+  }
+  // The current generation is full.  The entries of the previous generation
+  // that were used since have been moved to the current one, so evict the
+  // remaining ones and reuse the previous generation as the new one.
+  const unsigned old = 1 - state.d_current;
+  Trace("rewriter-cache") << "Rewriter: evicting cache generation " << old
+                          << std::endl;
+  clearCacheGeneration(old);
+  for (unsigned i = 0; i < THEORY_LAST; ++i)
+  {
+    state.d_evictions[i] += state.d_entries[i][old];
+    state.d_entries[i][old] = 0;
+  }
+  state.d_current = old;
+  state.d_size = 0;
+  state.d_hasOld = true;
+}
+
+void Rewriter::clearCacheGeneration(unsigned generation)
+{
+  std::vector<expr::attr::AttributeUniqueId> ids;
+  getCacheAttributeIds(generation, ids);
+  std::vector<const expr::attr::AttributeUniqueId*> idPtrs;
+  for (const expr::attr::AttributeUniqueId& id : ids)
+  {
+    idPtrs.push_back(&id);
+  }
+  NodeManager::currentNM()->deleteAttributes(idPtrs);
+}
+
+void Rewriter::clearCachesInternal()
+{
+  RewriterState& state = getState();
+  clearCacheGeneration(0);
+  clearCacheGeneration(1);
+  for (unsigned i = 0; i < THEORY_LAST; ++i)
+  {
+    state.d_entries[i][0] = 0;
+    state.d_entries[i][1] = 0;
+  }
+  state.d_current = 0;
+  state.d_size = 0;
+  state.d_hasOld = false;
+}
+
+/**
+ * The statistic reporting the profile of a RewriterState, as a list of the
+ * (theory, kind) pairs that were rewritten, sorted by decreasing time.
+ */
+class RewriteProfileStat : public Stat
+{
+ public:
+  RewriteProfileStat(const std::string& name,
+                     const std::vector<Rewriter::ProfileEntry>& profile)
+      : Stat(name), d_profile(profile)
+  {
+  }
+
+  void flushInformation(std::ostream& out) const override
+  {
+    std::vector<size_t> order = getSortedEntries();
+    out << "[";
+    for (size_t i = 0, n = order.size(); i < n; ++i)
+    {
+      const Rewriter::ProfileEntry& e = d_profile[order[i]];
+      out << (i == 0 ? "" : ", ") << "(" << getTheoryId(order[i]) << " "
+          << getKind(order[i]) << " : rewrites=" << e.d_rewrites
+          << " iterations=" << e.d_iterations
+          << " cacheHits=" << e.d_cacheHits << " time=" << getSeconds(e)
+          << ")";
+    }
+    out << "]";
+  }
+
+  void safeFlushInformation(int fd) const override
+  {
+    // sorting the entries is not safe in a signal handler
+    safe_print(fd, "<unsupported>");
+  }
+
+  SExpr getValue() const override
+  {
+    std::vector<SExpr> entries;
+    for (size_t i : getSortedEntries())
+    {
+      const Rewriter::ProfileEntry& e = d_profile[i];
+      std::stringstream theory, kind;
+      theory << getTheoryId(i);
+      kind << getKind(i);
+      std::vector<SExpr> entry;
+      entry.push_back(SExpr(theory.str()));
+      entry.push_back(SExpr(kind.str()));
+      entry.push_back(SExpr(static_cast<long int>(e.d_rewrites)));
+      entry.push_back(SExpr(static_cast<long int>(e.d_iterations)));
+      entry.push_back(SExpr(static_cast<long int>(e.d_cacheHits)));
+      entry.push_back(SExpr(Rational::fromDecimal(getSeconds(e))));
+      entries.push_back(SExpr(entry));
+    }
+    return SExpr(entries);
+  }
+
+ private:
+  static TheoryId getTheoryId(size_t i)
+  {
+    return static_cast<TheoryId>(i / kind::LAST_KIND);
+  }
+
+  static Kind getKind(size_t i)
+  {
+    return static_cast<Kind>(i % kind::LAST_KIND);
+  }
+
+  /** The time of e in seconds, as a decimal string */
+  static std::string getSeconds(const Rewriter::ProfileEntry& e)
+  {
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(9)
+       << std::chrono::duration<double>(e.d_time).count();
+    return ss.str();
+  }
+
+  /** The indices of the non-empty entries, by decreasing time */
+  std::vector<size_t> getSortedEntries() const
+  {
+    std::vector<size_t> order;
+    for (size_t i = 0, n = d_profile.size(); i < n; ++i)
+    {
+      if (d_profile[i].d_rewrites > 0 || d_profile[i].d_cacheHits > 0)
+      {
+        order.push_back(i);
+      }
+    }
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+      return d_profile[a].d_time > d_profile[b].d_time;
+    });
+    return order;
+  }
+
+  const std::vector<Rewriter::ProfileEntry>& d_profile;
+}; /* class RewriteProfileStat */
+
+RewriterState::RewriterState(StatisticsRegistry* registry)
+    : d_registry(registry)
+{
+  if (d_registry == NULL)
+  {
+    return;
+  }
+  for (unsigned i = 0; i < THEORY_LAST; ++i)
+  {
+    TheoryId theoryId = static_cast<TheoryId>(i);
+    addStat(theoryId, "cacheHits", d_cacheCounters[i].d_hits);
+    addStat(theoryId, "cacheMisses", d_cacheCounters[i].d_misses);
+    addStat(theoryId, "cacheEvictions", d_evictions[i]);
+  }
+  d_profileStat.reset(
+      new RewriteProfileStat("theory::Rewriter::profile", d_profile));
+  d_registry->registerStat(d_profileStat.get());
+}
+
+RewriterState::~RewriterState()
+{
+  if (d_registry == NULL)
+  {
+    return;
+  }
+  for (const std::unique_ptr<ReferenceStat<int64_t>>& stat : d_stats)
+  {
+    d_registry->unregisterStat(stat.get());
+  }
+  d_registry->unregisterStat(d_profileStat.get());
+}
+
+void RewriterState::addStat(TheoryId theoryId,
+                            const char* name,
+                            const int64_t& counter)
+{
+  std::stringstream ss;
+  ss << "theory::Rewriter::" << theoryId << "::" << name;
+  d_stats.emplace_back(new ReferenceStat<int64_t>(ss.str(), counter));
+  d_registry->registerStat(d_stats.back().get());
+}
+
 }/* CVC4::theory namespace */
 }/* CVC4 namespace */
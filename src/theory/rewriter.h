@@ -18,19 +18,30 @@
 
 #pragma once
 
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "expr/attribute_unique_id.h"
 #include "expr/node.h"
 #include "theory/theory_rewriter.h"
+#include "util/statistics_registry.h"
 #include "util/unsafe_interrupt_exception.h"
 
 namespace CVC4 {
 namespace theory {
 
 class RewriterInitializer;
+class RewriteProfileStat;
+class RewriterState;
 
 /**
  * The main rewriter class.
  */
 class Rewriter {
+  friend class RewriteProfileStat;
+  friend class RewriterState;
+
  public:
   Rewriter();
 
@@ -53,17 +64,141 @@ class Rewriter {
    */
   static Rewriter& getInstance();
 
+  /**
+   * Get the state of the rewrite caches of the SmtEngine in scope, or of
+   * the calling thread if no SmtEngine is in scope.
+   */
+  static RewriterState& getState();
+
+  /** Counters of the rewrite caches of one theory */
+  struct CacheCounters
+  {
+    /** Lookups that found an entry */
+    int64_t d_hits = 0;
+    /** Lookups that did not find an entry */
+    int64_t d_misses = 0;
+  };
+
+  /**
+   * The profile of the rewrites of the nodes of one kind by one theory
+   * rewriter, collected with --rewrite-profile.
+   */
+  struct ProfileEntry
+  {
+    /** The number of nodes rewritten to a fixpoint (pre or post) */
+    int64_t d_rewrites = 0;
+    /** The number of calls to the pre- and post-rewriter */
+    int64_t d_iterations = 0;
+    /** The number of nodes found in the rewrite caches */
+    int64_t d_cacheHits = 0;
+    /** The time spent in the rewriter calls, including nested rewrites */
+    std::chrono::steady_clock::duration d_time =
+        std::chrono::steady_clock::duration::zero();
+  };
+
+  /**
+   * rewriteTo() keeps a stack of the nodes that are being pre- and
+   * post-rewritten.  Each element of the stack is a RewriteStackElement.
+   */
+  struct RewriteStackElement
+  {
+    /**
+     * Construct a fresh stack element, whose rewritten children will be
+     * appended to d_rewrittenChildren from index childrenBegin on.
+     */
+    RewriteStackElement(TNode node, TheoryId theoryId, size_t childrenBegin)
+        : node(node),
+          original(node),
+          theoryId(theoryId),
+          originalTheoryId(theoryId),
+          nextChild(0),
+          childrenBegin(childrenBegin)
+    {
+    }
+
+    TheoryId getTheoryId() { return static_cast<TheoryId>(theoryId); }
+
+    TheoryId getOriginalTheoryId()
+    {
+      return static_cast<TheoryId>(originalTheoryId);
+    }
+
+    /** The node we're currently rewriting */
+    Node node;
+    /** Original node */
+    Node original;
+    /** Id of the theory that's currently rewriting this node */
+    unsigned theoryId : 8;
+    /** Id of the original theory that started the rewrite */
+    unsigned originalTheoryId : 8;
+    /** Index of the child this node is done rewriting */
+    unsigned nextChild : 32;
+    /** Index of the first rewritten child in d_rewrittenChildren */
+    size_t childrenBegin;
+  };
+
+  /**
+   * Builds node with the rewritten children d_rewrittenChildren[childrenBegin]
+   * on, which are removed.  Returns node itself if no child changed.
+   */
+  Node buildRewritten(TNode node, size_t childrenBegin);
+
+  /** Returns the profile entry of the given theory and kind */
+  ProfileEntry& getProfileEntry(theory::TheoryId theoryId, Kind k);
+
   /** Returns the appropriate cache for a node */
-  Node getPreRewriteCache(theory::TheoryId theoryId, TNode node);
+  Node getPreRewriteCache(theory::TheoryId theoryId,
+                          TNode node,
+                          unsigned generation);
 
   /** Returns the appropriate cache for a node */
-  Node getPostRewriteCache(theory::TheoryId theoryId, TNode node);
+  Node getPostRewriteCache(theory::TheoryId theoryId,
+                           TNode node,
+                           unsigned generation);
 
   /** Sets the appropriate cache for a node */
-  void setPreRewriteCache(theory::TheoryId theoryId, TNode node, TNode cache);
+  void setPreRewriteCache(theory::TheoryId theoryId,
+                          TNode node,
+                          TNode cache,
+                          unsigned generation);
 
   /** Sets the appropriate cache for a node */
-  void setPostRewriteCache(theory::TheoryId theoryId, TNode node, TNode cache);
+  void setPostRewriteCache(theory::TheoryId theoryId,
+                           TNode node,
+                           TNode cache,
+                           unsigned generation);
+
+  /** Adds the ids of the cache attributes of the given generation to ids */
+  static void getCacheAttributeIds(
+      unsigned generation, std::vector<expr::attr::AttributeUniqueId>& ids);
+
+  /**
+   * Looks up node in the pre-rewrite cache, returns the null node if it is
+   * not cached.  An entry found in the previous generation is copied to the
+   * current one.
+   */
+  Node lookupPreRewriteCache(theory::TheoryId theoryId, TNode node);
+
+  /** Like lookupPreRewriteCache(), for the post-rewrite cache */
+  Node lookupPostRewriteCache(theory::TheoryId theoryId, TNode node);
+
+  /** Adds an entry to the current generation of the pre-rewrite cache */
+  void storePreRewriteCache(theory::TheoryId theoryId, TNode node, TNode cache);
+
+  /** Adds an entry to the current generation of the post-rewrite cache */
+  void storePostRewriteCache(theory::TheoryId theoryId,
+                             TNode node,
+                             TNode cache);
+
+  /**
+   * Accounts for a new entry of the current cache generation of state.  If
+   * the generation holds half of --rewrite-cache-limit entries, the previous
+   * generation is evicted and replaced by a new, empty one.
+   */
+  void addedCacheEntry(RewriterState& state, theory::TheoryId theoryId);
+
+  /** Deletes the cache entries of the given generation */
+  void clearCacheGeneration(unsigned generation);
 
   /**
    * Rewrites the node using the given theory rewriter.
@@ -88,11 +223,74 @@ class Rewriter {
 
   unsigned long d_iterationCount = 0;
 
+  /**
+   * The work stack of rewriteTo(), kept across calls so that its storage is
+   * only allocated once.  Nested calls use the part above their caller's.
+   */
+  std::vector<RewriteStackElement> d_workStack;
+  /**
+   * The rewritten children of the nodes on d_workStack, each node's
+   * children are a contiguous range starting at its childrenBegin.
+   */
+  std::vector<Node> d_rewrittenChildren;
+
+  /** Whether --rewrite-profile was enabled for the current rewrite */
+  bool d_profiling = false;
+
 #ifdef CVC4_ASSERTIONS
   std::unique_ptr<std::unordered_set<Node, NodeHashFunction>> d_rewriteStack =
       nullptr;
 #endif /* CVC4_ASSERTIONS */
 };/* class Rewriter */
 
+/**
+ * The state of the bounded rewrite caches of an SmtEngine.  The caches are
+ * attributes of the NodeManager, split into two generations, see
+ * Rewriter::addedCacheEntry().  The state keeps track of the generations,
+ * and counts the hits, misses and evictions of the caches per theory and
+ * the profile collected with --rewrite-profile, which are reported as
+ * statistics of the SmtEngine.
+ */
+class RewriterState
+{
+  friend class Rewriter;
+
+ public:
+  /**
+   * Construct the state of fresh caches, whose statistics are registered
+   * with registry unless it is NULL.
+   */
+  RewriterState(StatisticsRegistry* registry);
+  ~RewriterState();
+
+ private:
+  /** Register a statistic named after theoryId and name */
+  void addStat(TheoryId theoryId, const char* name, const int64_t& counter);
+
+  /** The generation new entries are added to */
+  unsigned d_current = 0;
+  /** The number of entries added to the current generation */
+  uint64_t d_size = 0;
+  /** Whether the previous generation may hold entries */
+  bool d_hasOld = false;
+  /** The number of entries in each generation, per theory */
+  int64_t d_entries[THEORY_LAST][2] = {};
+  /** The number of entries evicted, per theory */
+  int64_t d_evictions[THEORY_LAST] = {};
+  /** Counters of the lookups in the rewrite caches, per theory */
+  Rewriter::CacheCounters d_cacheCounters[THEORY_LAST];
+  /**
+   * The profile, indexed by theoryId * kind::LAST_KIND + kind, allocated
+   * on first use.
+   */
+  std::vector<Rewriter::ProfileEntry> d_profile;
+
+  /** The registry of the statistics below, or NULL */
+  StatisticsRegistry* d_registry;
+  std::vector<std::unique_ptr<ReferenceStat<int64_t>>> d_stats;
+  /** The rewrite profile, see Rewriter::ProfileEntry */
+  std::unique_ptr<Stat> d_profileStat;
+}; /* class RewriterState */
+
 }/* CVC4::theory namespace */
 }/* CVC4 namespace */
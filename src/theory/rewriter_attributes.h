@@ -18,28 +18,43 @@
 
 #pragma once
 
+#include <vector>
+
 #include "expr/attribute.h"
 
 namespace CVC4 {
 namespace theory {
 
-template <bool pre, theory::TheoryId theoryId>
+template <bool pre, theory::TheoryId theoryId, unsigned generation>
 struct RewriteCacheTag {};
 
+/**
+ * The pre- and post-rewrite caches of a theory.  Each cache is split in
+ * two generations, which the Rewriter uses to bound the number of cached
+ * entries (see Rewriter::addedCacheEntry()).
+ */
 template <theory::TheoryId theoryId>
 struct RewriteAttibute {
 
-  typedef expr::Attribute< RewriteCacheTag<true, theoryId>, Node> pre_rewrite;
-  typedef expr::Attribute< RewriteCacheTag<false, theoryId>, Node> post_rewrite;
+  typedef expr::DenseAttribute<RewriteCacheTag<true, theoryId, 0>, Node>
+      pre_rewrite;
+  typedef expr::DenseAttribute<RewriteCacheTag<false, theoryId, 0>, Node>
+      post_rewrite;
+  typedef expr::DenseAttribute<RewriteCacheTag<true, theoryId, 1>, Node>
+      pre_rewrite_gen1;
+  typedef expr::DenseAttribute<RewriteCacheTag<false, theoryId, 1>, Node>
+      post_rewrite_gen1;
 
   /**
-   * Get the value of the pre-rewrite cache.
+   * Get the value of the given cache attribute, i.e. the rewritten node,
+   * or the null node if node is not in the cache.
    */
-  static Node getPreRewriteCache(TNode node)
+  template <class AttrKind>
+  static Node getCache(TNode node)
   {
     Node cache;
-    if (node.hasAttribute(pre_rewrite())) {
-      node.getAttribute(pre_rewrite(), cache);
+    if (node.hasAttribute(AttrKind())) {
+      node.getAttribute(AttrKind(), cache);
     } else {
       return Node::null();
     }
@@ -51,49 +66,78 @@ struct RewriteAttibute {
   }
 
   /**
-   * Set the value of the pre-rewrite cache.
+   * Set the value of the given cache attribute.  cache cannot be a null
+   * Node.
    */
-  static void setPreRewriteCache(TNode node, TNode cache)
+  template <class AttrKind>
+  static void setCache(TNode node, TNode cache)
   {
-    Trace("rewriter") << "setting pre-rewrite of " << node << " to " << cache << std::endl;
     Assert(!cache.isNull());
     if (node == cache) {
-      node.setAttribute(pre_rewrite(), Node::null());
+      node.setAttribute(AttrKind(), Node::null());
     } else {
-      node.setAttribute(pre_rewrite(), cache);
+      node.setAttribute(AttrKind(), cache);
     }
   }
 
   /**
-   * Get the value of the post-rewrite cache.
-   * none).
+   * Get the value of the pre-rewrite cache of the given generation.
    */
-  static Node getPostRewriteCache(TNode node)
+  static Node getPreRewriteCache(TNode node, unsigned generation)
   {
-    Node cache;
-    if (node.hasAttribute(post_rewrite())) {
-      node.getAttribute(post_rewrite(), cache);
+    return generation == 0 ? getCache<pre_rewrite>(node)
+                           : getCache<pre_rewrite_gen1>(node);
+  }
+
+  /**
+   * Set the value of the pre-rewrite cache of the given generation.
+   */
+  static void setPreRewriteCache(TNode node, TNode cache, unsigned generation)
+  {
+    Trace("rewriter") << "setting pre-rewrite of " << node << " to " << cache << std::endl;
+    if (generation == 0) {
+      setCache<pre_rewrite>(node, cache);
     } else {
-      return Node::null();
+      setCache<pre_rewrite_gen1>(node, cache);
     }
-    if (cache.isNull()) {
-      return node;
+  }
+
+  /**
+   * Get the value of the post-rewrite cache of the given generation (or
+   * the null node if none).
+   */
+  static Node getPostRewriteCache(TNode node, unsigned generation)
+  {
+    return generation == 0 ? getCache<post_rewrite>(node)
+                           : getCache<post_rewrite_gen1>(node);
+  }
+
+  /**
+   * Set the value of the post-rewrite cache of the given generation.
+   */
+  static void setPostRewriteCache(TNode node, TNode cache, unsigned generation)
+  {
+    Trace("rewriter") << "setting rewrite of " << node << " to " << cache << std::endl;
+    if (generation == 0) {
+      setCache<post_rewrite>(node, cache);
     } else {
-      return cache;
+      setCache<post_rewrite_gen1>(node, cache);
     }
   }
 
   /**
-   * Set the value of the post-rewrite cache.  v cannot be a null Node.
+   * Add the ids of the cache attributes of the given generation to ids.
    */
-  static void setPostRewriteCache(TNode node, TNode cache)
+  static void getAttributeIds(unsigned generation,
+                              std::vector<expr::attr::AttributeUniqueId>& ids)
   {
-    Assert(!cache.isNull());
-    Trace("rewriter") << "setting rewrite of " << node << " to " << cache << std::endl;
-    if (node == cache) {
-      node.setAttribute(post_rewrite(), Node::null());
+    typedef expr::attr::AttributeManager AttributeManager;
+    if (generation == 0) {
+      ids.push_back(AttributeManager::getAttributeId(pre_rewrite()));
+      ids.push_back(AttributeManager::getAttributeId(post_rewrite()));
     } else {
-      node.setAttribute(post_rewrite(), cache);
+      ids.push_back(AttributeManager::getAttributeId(pre_rewrite_gen1()));
+      ids.push_back(AttributeManager::getAttributeId(post_rewrite_gen1()));
     }
   }
 };/* struct RewriteAttribute */
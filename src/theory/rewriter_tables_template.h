@@ -29,7 +29,9 @@ ${rewriter_includes}
 namespace CVC4 {
 namespace theory {
 
-Node Rewriter::getPreRewriteCache(theory::TheoryId theoryId, TNode node) {
+Node Rewriter::getPreRewriteCache(theory::TheoryId theoryId,
+                                  TNode node,
+                                  unsigned generation) {
   switch(theoryId) {
 ${pre_rewrite_get_cache}
   default:
@@ -37,7 +39,9 @@ ${pre_rewrite_get_cache}
   }
 }
 
-Node Rewriter::getPostRewriteCache(theory::TheoryId theoryId, TNode node) {
+Node Rewriter::getPostRewriteCache(theory::TheoryId theoryId,
+                                   TNode node,
+                                   unsigned generation) {
   switch(theoryId) {
 ${post_rewrite_get_cache}
     default:
@@ -45,7 +49,10 @@ ${post_rewrite_get_cache}
   }
 }
 
-void Rewriter::setPreRewriteCache(theory::TheoryId theoryId, TNode node, TNode cache) {
+void Rewriter::setPreRewriteCache(theory::TheoryId theoryId,
+                                  TNode node,
+                                  TNode cache,
+                                  unsigned generation) {
   switch(theoryId) {
 ${pre_rewrite_set_cache}
   default:
@@ -53,7 +60,10 @@ ${pre_rewrite_set_cache}
   }
 }
 
-void Rewriter::setPostRewriteCache(theory::TheoryId theoryId, TNode node, TNode cache) {
+void Rewriter::setPostRewriteCache(theory::TheoryId theoryId,
+                                   TNode node,
+                                   TNode cache,
+                                   unsigned generation) {
   switch(theoryId) {
 ${post_rewrite_set_cache}
   default:
@@ -66,22 +76,9 @@ Rewriter::Rewriter()
 ${rewrite_init}
 }
 
-void Rewriter::clearCachesInternal() {
-  typedef CVC4::expr::attr::AttributeUniqueId AttributeUniqueId;
-  std::vector<AttributeUniqueId> preids;
-  ${pre_rewrite_attribute_ids}
-
-  std::vector<AttributeUniqueId> postids;
-  ${post_rewrite_attribute_ids}
-
-  std::vector<const AttributeUniqueId*> allids;
-  for(unsigned i = 0; i < preids.size(); ++i){
-    allids.push_back(&preids[i]);
-  }
-  for(unsigned i = 0; i < postids.size(); ++i){
-    allids.push_back(&postids[i]);
-  }
-  NodeManager::currentNM()->deleteAttributes(allids);
+void Rewriter::getCacheAttributeIds(
+    unsigned generation, std::vector<expr::attr::AttributeUniqueId>& ids) {
+${rewrite_attribute_ids}
 }
 
 }/* CVC4::theory namespace */
@@ -1658,7 +1658,7 @@ Node TheoryEngine::getExplanationAndRecipe(TNode node, LemmaProofRecipe* proofRe
                              << " Responsible theory is: "
                              << theoryOf(atom)->getId() << std::endl;
 
-    Node explanation = theoryOf(atom)->explain(node);
+    Node explanation = explainIn(theoryOf(atom)->getId(), node);
     Debug("theory::explain") << "TheoryEngine::getExplanation(" << node << ") => " << explanation << endl;
     PROOF({
         if(proofRecipe) {
@@ -2126,7 +2126,7 @@ void TheoryEngine::getExplanation(std::vector<NodeTheoryPair>& explanationVector
       explanation = d_sharedTerms.explain(toExplain.node);
       Debug("theory::explain") << "\tTerm was propagated by THEORY_BUILTIN. Explanation: " << explanation << std::endl;
     } else {
-      explanation = theoryOf(toExplain.theory)->explain(toExplain.node);
+      explanation = explainIn(toExplain.theory, toExplain.node);
       Debug("theory::explain") << "\tTerm was propagated by owner theory: "
                                << theoryOf(toExplain.theory)->getId()
                                << ". Explanation: " << explanation << std::endl;
@@ -2330,18 +2330,50 @@ bool TheoryEngine::useTheoryAlternative(const std::string& name) {
 }
 
 
+Node TheoryEngine::explainIn(theory::TheoryId theoryId, TNode node)
+{
+  Statistics& stats = d_theoryOut[theoryId]->d_statistics;
+  ++stats.explanations;
+  // only the outermost explanation of a theory is timed
+  TimerStat::CodeTimer explainTimer(stats.explainTime,
+                                    /* allow_reentrant = */ true);
+  return theoryOf(theoryId)->explain(node);
+}
+
+void TheoryEngine::traceStatistics(std::ostream& out) const
+{
+  for (TheoryId theoryId = theory::THEORY_FIRST;
+       theoryId != theory::THEORY_LAST;
+       ++theoryId)
+  {
+    if (d_theoryOut[theoryId] == NULL)
+    {
+      continue;
+    }
+    const Statistics& stats = d_theoryOut[theoryId]->d_statistics;
+    out << " (" << theoryId << " :conflicts " << stats.conflicts.getData()
+        << " :propagations " << stats.propagations.getData()
+        << " :explanations " << stats.explanations.getData()
+        << " :explain-time " << stats.explainTime.getData() << ")";
+  }
+}
+
 TheoryEngine::Statistics::Statistics(theory::TheoryId theory):
     conflicts(getStatsPrefix(theory) + "::conflicts", 0),
     propagations(getStatsPrefix(theory) + "::propagations", 0),
     lemmas(getStatsPrefix(theory) + "::lemmas", 0),
     requirePhase(getStatsPrefix(theory) + "::requirePhase", 0),
-    restartDemands(getStatsPrefix(theory) + "::restartDemands", 0)
+    restartDemands(getStatsPrefix(theory) + "::restartDemands", 0),
+    explanations(getStatsPrefix(theory) + "::explanations", 0),
+    explainTime(getStatsPrefix(theory) + "::explainTime")
 {
   smtStatisticsRegistry()->registerStat(&conflicts);
   smtStatisticsRegistry()->registerStat(&propagations);
   smtStatisticsRegistry()->registerStat(&lemmas);
   smtStatisticsRegistry()->registerStat(&requirePhase);
   smtStatisticsRegistry()->registerStat(&restartDemands);
+  smtStatisticsRegistry()->registerStat(&explanations);
+  smtStatisticsRegistry()->registerStat(&explainTime);
 }
 
 TheoryEngine::Statistics::~Statistics() {
@@ -2350,6 +2382,8 @@ TheoryEngine::Statistics::~Statistics() {
   smtStatisticsRegistry()->unregisterStat(&lemmas);
   smtStatisticsRegistry()->unregisterStat(&requirePhase);
   smtStatisticsRegistry()->unregisterStat(&restartDemands);
+  smtStatisticsRegistry()->unregisterStat(&explanations);
+  smtStatisticsRegistry()->unregisterStat(&explainTime);
 }
 
 }/* CVC4 namespace */
@@ -252,6 +252,10 @@ class TheoryEngine {
 
    public:
     IntStat conflicts, propagations, lemmas, requirePhase, restartDemands;
+    /** The number of propagations explained by the theory */
+    IntStat explanations;
+    /** The time spent by the theory in explaining propagations */
+    TimerStat explainTime;
 
     Statistics(theory::TheoryId theory);
     ~Statistics();
@@ -607,6 +611,12 @@ class TheoryEngine {
    */
   void getExplanation(std::vector<NodeTheoryPair>& explanationVector, LemmaProofRecipe* lemmaProofRecipe);
 
+  /**
+   * Asks the given theory to explain node, accounting for it in the
+   * theory's statistics.
+   */
+  Node explainIn(theory::TheoryId theoryId, TNode node);
+
 public:
 
   /**
@@ -734,6 +744,12 @@ public:
    */
   Node getExplanationAndRecipe(TNode node, LemmaProofRecipe* proofRecipe);
 
+  /**
+   * Prints, for each theory, the number of conflicts, propagations and
+   * explanations and the time spent explaining (see --sat-trace).
+   */
+  void traceStatistics(std::ostream& out) const;
+
   /**
    * collect model info
    */
@@ -27,12 +27,16 @@ EqualityEngine::Statistics::Statistics(std::string name)
     : mergesCount(name + "::mergesCount", 0),
       termsCount(name + "::termsCount", 0),
       functionTermsCount(name + "::functionTermsCount", 0),
-      constantTermsCount(name + "::constantTermsCount", 0)
+      constantTermsCount(name + "::constantTermsCount", 0),
+      explanationCacheHits(name + "::explanationCacheHits", 0),
+      explanationSize(name + "::explanationSize")
 {
   smtStatisticsRegistry()->registerStat(&mergesCount);
   smtStatisticsRegistry()->registerStat(&termsCount);
   smtStatisticsRegistry()->registerStat(&functionTermsCount);
   smtStatisticsRegistry()->registerStat(&constantTermsCount);
+  smtStatisticsRegistry()->registerStat(&explanationCacheHits);
+  smtStatisticsRegistry()->registerStat(&explanationSize);
 }
 
 EqualityEngine::Statistics::~Statistics() {
@@ -40,6 +44,8 @@ EqualityEngine::Statistics::~Statistics() {
   smtStatisticsRegistry()->unregisterStat(&termsCount);
   smtStatisticsRegistry()->unregisterStat(&functionTermsCount);
   smtStatisticsRegistry()->unregisterStat(&constantTermsCount);
+  smtStatisticsRegistry()->unregisterStat(&explanationCacheHits);
+  smtStatisticsRegistry()->unregisterStat(&explanationSize);
 }
 
 /**
@@ -121,6 +127,8 @@ EqualityEngine::EqualityEngine(context::Context* context, std::string name, bool
 , d_triggerTermSetUpdatesSize(context, 0)
 , d_deducedDisequalitiesSize(context, 0)
 , d_deducedDisequalityReasonsSize(context, 0)
+, d_explanationCacheKeysSize(context, 0)
+, d_explanationCacheReasonsSize(context, 0)
 , d_propagatedDisequalities(context)
 , d_name(name)
 {
@@ -146,6 +154,8 @@ EqualityEngine::EqualityEngine(EqualityEngineNotify& notify, context::Context* c
 , d_triggerTermSetUpdatesSize(context, 0)
 , d_deducedDisequalitiesSize(context, 0)
 , d_deducedDisequalityReasonsSize(context, 0)
+, d_explanationCacheKeysSize(context, 0)
+, d_explanationCacheReasonsSize(context, 0)
 , d_propagatedDisequalities(context)
 , d_name(name)
 {
@@ -215,7 +225,7 @@ EqualityNodeId EqualityEngine::newNode(TNode node) {
 
   // Register the new id of the term
   EqualityNodeId newId = d_nodes.size();
-  d_nodeIds[node] = newId;
+  d_nodeIds.insert(node, newId);
   // Add the node to it's position
   d_nodes.push_back(node);
   // Note if this is an application or not
@@ -371,12 +381,13 @@ void EqualityEngine::addTermInternal(TNode t, bool isOperator) {
 }
 
 bool EqualityEngine::hasTerm(TNode t) const {
-  return d_nodeIds.find(t) != d_nodeIds.end();
+  return d_nodeIds.find(t) != null_id;
 }
 
 EqualityNodeId EqualityEngine::getNodeId(TNode node) const {
-  Assert(hasTerm(node)) << node;
-  return (*d_nodeIds.find(node)).second;
+  EqualityNodeId id = d_nodeIds.find(node);
+  Assert(id != null_id) << node;
+  return id;
 }
 
 EqualityNode& EqualityEngine::getEqualityNode(TNode t) {
@@ -896,6 +907,14 @@ void EqualityEngine::backtrack() {
     d_deducedDisequalities.resize(d_deducedDisequalitiesSize);
   }
 
+  if (d_explanationCacheKeys.size() > d_explanationCacheKeysSize) {
+    for(int i = d_explanationCacheKeys.size() - 1, i_end = (int)d_explanationCacheKeysSize; i >= i_end; -- i) {
+      d_explanationCache.erase(d_explanationCacheKeys[i]);
+    }
+    d_explanationCacheKeys.resize(d_explanationCacheKeysSize);
+    d_explanationCacheReasons.resize(d_explanationCacheReasonsSize);
+  }
+
 }
 
 void EqualityEngine::addGraphEdge(EqualityNodeId t1, EqualityNodeId t2, unsigned type, TNode reason) {
@@ -946,7 +965,12 @@ void EqualityEngine::explainEquality(TNode t1, TNode t2, bool polarity,
   std::map<std::pair<EqualityNodeId, EqualityNodeId>, EqProof*> cache;
   if (polarity) {
     // Get the explanation
+    size_t start = equalities.size();
     getExplanation(t1Id, t2Id, equalities, cache, eqp);
+    if (!eqp) {
+      cacheExplanation(t1Id, t2Id, equalities, start);
+    }
+    d_stats.explanationSize.addEntry(equalities.size() - start);
   } else {
     if (eqp) {
       eqp->d_id = eq::MERGED_THROUGH_TRANS;
@@ -1042,8 +1066,34 @@ void EqualityEngine::explainPredicate(TNode p, bool polarity,
   Assert(hasTerm(p));
   std::map<std::pair<EqualityNodeId, EqualityNodeId>, EqProof*> cache;
   // Get the explanation
-  getExplanation(
-      getNodeId(p), polarity ? d_trueId : d_falseId, assertions, cache, eqp);
+  EqualityNodeId pId = getNodeId(p);
+  EqualityNodeId valueId = polarity ? d_trueId : d_falseId;
+  size_t start = assertions.size();
+  getExplanation(pId, valueId, assertions, cache, eqp);
+  if (!eqp) {
+    cacheExplanation(pId, valueId, assertions, start);
+  }
+  d_stats.explanationSize.addEntry(assertions.size() - start);
+}
+
+void EqualityEngine::cacheExplanation(EqualityNodeId t1Id,
+                                      EqualityNodeId t2Id,
+                                      const std::vector<TNode>& equalities,
+                                      size_t start) const
+{
+  EqualityPair key = std::minmax(t1Id, t2Id);
+  if (t1Id == t2Id || d_explanationCache.count(key) > 0) {
+    return;
+  }
+  ExplanationRef ref(d_explanationCacheReasons.size(), 0);
+  d_explanationCacheReasons.insert(d_explanationCacheReasons.end(),
+                                   equalities.begin() + start,
+                                   equalities.end());
+  ref.reasonsEnd = d_explanationCacheReasons.size();
+  d_explanationCacheReasonsSize = d_explanationCacheReasons.size();
+  d_explanationCacheKeys.push_back(key);
+  d_explanationCacheKeysSize = d_explanationCacheKeys.size();
+  d_explanationCache[key] = ref;
 }
 
 void EqualityEngine::getExplanation(
@@ -1069,6 +1119,20 @@ void EqualityEngine::getExplanation(
     {
       return;
     }
+    // We may have explained it in an earlier call in this context
+    ExplanationCacheMap::const_iterator cached =
+        d_explanationCache.find(cacheKey);
+    if (cached != d_explanationCache.end())
+    {
+      ++d_stats.explanationCacheHits;
+      cache[cacheKey] = nullptr;
+      const ExplanationRef& ref = cached->second;
+      equalities.insert(
+          equalities.end(),
+          d_explanationCacheReasons.begin() + ref.reasonsStart,
+          d_explanationCacheReasons.begin() + ref.reasonsEnd);
+      return;
+    }
   }
   else
   {
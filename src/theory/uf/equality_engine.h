@@ -218,6 +218,10 @@ public:
     IntStat functionTermsCount;
     /** Number of constant terms managed by the system */
     IntStat constantTermsCount;
+    /** Number of explanations taken from the explanation cache */
+    IntStat explanationCacheHits;
+    /** Average number of assertions in an explanation */
+    AverageStat explanationSize;
 
     Statistics(std::string name);
 
@@ -251,7 +255,7 @@ private:
   std::map<unsigned, const PathReconstructionNotify*> d_pathReconstructionTriggers;
 
   /** Map from nodes to their ids */
-  std::unordered_map<TNode, EqualityNodeId, TNodeHashFunction> d_nodeIds;
+  NodeIdTable d_nodeIds;
 
   /** Map from function applications to their ids */
   typedef std::unordered_map<FunctionApplication, EqualityNodeId, FunctionApplicationHashFunction> ApplicationIdsMap;
@@ -494,8 +498,8 @@ private:
    */
   void addTriggerToList(EqualityNodeId nodeId, TriggerId triggerId);
 
-  /** Statistics */
-  Statistics d_stats;
+  /** Statistics (mutable, since they are updated when explaining) */
+  mutable Statistics d_stats;
 
   /** Add a new function application node to the database, i.e APP t1 t2 */
   EqualityNodeId newApplicationNode(TNode original, EqualityNodeId t1, EqualityNodeId t2, FunctionApplicationType type);
@@ -535,6 +539,15 @@ private:
       std::map<std::pair<EqualityNodeId, EqualityNodeId>, EqProof*>& cache,
       EqProof* eqp) const;
 
+  /**
+   * Stores the reasons in equalities from index start on as the explanation
+   * of t1 = t2 in the explanation cache.
+   */
+  void cacheExplanation(EqualityNodeId t1Id,
+                        EqualityNodeId t2Id,
+                        const std::vector<TNode>& equalities,
+                        size_t start) const;
+
   /**
    * Print the equality graph.
    */
@@ -666,6 +679,38 @@ private:
    */
   context::CDO<size_t> d_deducedDisequalityReasonsSize;
 
+  typedef std::unordered_map<EqualityPair, ExplanationRef, EqualityPairHashFunction> ExplanationCacheMap;
+
+  /**
+   * A map from pairs of equal terms, ordered by id, to the reasons of their
+   * explanation.  Explanations only use edges of the proof forest that were
+   * added before them, so they stay valid until we backtrack, when the
+   * entries of the popped levels are removed.  The cache is only used when
+   * no proof is being constructed.
+   */
+  mutable ExplanationCacheMap d_explanationCache;
+
+  /**
+   * The pairs in the explanation cache, in order of insertion.
+   */
+  mutable std::vector<EqualityPair> d_explanationCacheKeys;
+
+  /**
+   * Context dependent size of the explanation cache keys.
+   */
+  mutable context::CDO<size_t> d_explanationCacheKeysSize;
+
+  /**
+   * The reasons of the cached explanations.  They are kept alive by the
+   * edges of the proof forest they come from.
+   */
+  mutable std::vector<TNode> d_explanationCacheReasons;
+
+  /**
+   * Size of the memory for the cached reasons.
+   */
+  mutable context::CDO<size_t> d_explanationCacheReasonsSize;
+
   /**
    * Map from equalities to the tags that have received the notification.
    */
@@ -23,7 +23,10 @@
 #include <string>
 #include <iostream>
 #include <sstream>
+#include <vector>
 
+#include "base/check.h"
+#include "expr/node.h"
 #include "util/hash.h"
 
 namespace CVC4 {
@@ -127,6 +130,16 @@ struct DisequalityReasonRef {
   : mergesStart(mergesStart), mergesEnd(mergesEnd) {}
 };
 
+/**
+ * An index range into the reasons of the explanation cache.
+ */
+struct ExplanationRef {
+  DefaultSizeType reasonsStart;
+  DefaultSizeType reasonsEnd;
+  ExplanationRef(DefaultSizeType reasonsStart = 0, DefaultSizeType reasonsEnd = 0)
+  : reasonsStart(reasonsStart), reasonsEnd(reasonsEnd) {}
+};
+
 /**
  * We maintain uselist where a node appears in, and this is the node
  * of such a list.
@@ -356,6 +369,127 @@ struct TriggerInfo {
       : trigger(trigger), polarity(polarity) {}
 };
 
+/**
+ * A flat map from terms to their ids in the equality engine.  The entries live
+ * in one open-addressing table with linear probing, so a lookup touches a
+ * short run of contiguous slots instead of the bucket lists of an
+ * std::unordered_map.  The table is kept at most half full and erase() shifts
+ * back the rest of the probe sequence, so no tombstones are needed when the
+ * equality engine removes terms on backtracking.
+ */
+class NodeIdTable {
+ public:
+  NodeIdTable() : d_size(0), d_shift(64) {}
+
+  /** Returns the id of the term, or null_id if it is not in the table */
+  EqualityNodeId find(TNode node) const {
+    if (d_size == 0) {
+      return null_id;
+    }
+    size_t mask = d_entries.size() - 1;
+    for (size_t i = slotOf(node);; i = (i + 1) & mask) {
+      const Entry& entry = d_entries[i];
+      if (entry.id == null_id) {
+        return null_id;
+      }
+      if (entry.node == node) {
+        return entry.id;
+      }
+    }
+  }
+
+  /**
+   * Maps the term to the given id.  The intermediate nodes of a curried
+   * application share its term, so the term may already be in the table, in
+   * which case its id is replaced.
+   */
+  void insert(TNode node, EqualityNodeId id) {
+    Assert(id != null_id);
+    if (2 * (d_size + 1) > d_entries.size()) {
+      grow();
+    }
+    size_t mask = d_entries.size() - 1;
+    size_t i = slotOf(node);
+    while (d_entries[i].id != null_id) {
+      if (d_entries[i].node == node) {
+        d_entries[i].id = id;
+        return;
+      }
+      i = (i + 1) & mask;
+    }
+    d_entries[i].node = node;
+    d_entries[i].id = id;
+    ++ d_size;
+  }
+
+  /** Removes the term from the table, if it is there */
+  void erase(TNode node) {
+    if (d_size == 0) {
+      return;
+    }
+    size_t mask = d_entries.size() - 1;
+    size_t i = slotOf(node);
+    while (d_entries[i].node != node) {
+      if (d_entries[i].id == null_id) {
+        return;
+      }
+      i = (i + 1) & mask;
+    }
+    // Move back the entries whose probe sequence passes through the hole
+    for (size_t j = (i + 1) & mask; d_entries[j].id != null_id; j = (j + 1) & mask) {
+      size_t home = slotOf(d_entries[j].node);
+      bool stays = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+      if (!stays) {
+        d_entries[i] = d_entries[j];
+        i = j;
+      }
+    }
+    d_entries[i] = Entry();
+    -- d_size;
+  }
+
+  /** Number of terms in the table */
+  size_t size() const {
+    return d_size;
+  }
+
+ private:
+  struct Entry {
+    TNode node;
+    EqualityNodeId id;
+    Entry() : id(null_id) {}
+  };
+
+  /** The first slot to probe for the term (Fibonacci hashing of its id) */
+  size_t slotOf(TNode node) const {
+    return (size_t)((node.getId() * 0x9E3779B97F4A7C15ULL) >> d_shift);
+  }
+
+  /** Doubles the number of slots and reinserts the entries */
+  void grow() {
+    std::vector<Entry> old;
+    old.swap(d_entries);
+    d_entries.resize(old.empty() ? 16 : 2 * old.size());
+    d_shift = 64;
+    for (size_t n = d_entries.size(); n > 1; n >>= 1) {
+      -- d_shift;
+    }
+    d_size = 0;
+    for (const Entry& entry : old) {
+      if (entry.id != null_id) {
+        insert(entry.node, entry.id);
+      }
+    }
+  }
+
+  /** The slots, a power of two of them */
+  std::vector<Entry> d_entries;
+  /** The number of terms in the table */
+  size_t d_size;
+  /** 64 minus the log of the number of slots */
+  unsigned d_shift;
+};/* class NodeIdTable */
+
 } // namespace eq
 } // namespace theory
 } // namespace CVC4
@@ -0,0 +1,88 @@
+/*********************                                                        */
+/*! \file clause_exchange.cpp
+ ** \verbatim
+ ** Top contributors (to current version):
+ **
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2019 by the authors listed in the file AUTHORS
+ ** in the top-level source directory) and their institutional affiliations.
+ ** All rights reserved.  See the file COPYING in the top-level source
+ ** directory for licensing information.\endverbatim
+ **
+ ** \brief A channel for exchanging learned clauses between solver instances
+ **
+ ** A channel for exchanging learned clauses between solver instances that
+ ** solve the same problem in parallel (see --portfolio).
+ **/
+
+#include "util/clause_exchange.h"
+
+#include "base/check.h"
+
+namespace CVC4 {
+
+ClauseExchange::ClauseExchange(size_t capacity) : d_capacity(capacity) {}
+
+unsigned ClauseExchange::join()
+{
+  std::lock_guard<std::mutex> lock(d_mutex);
+  // reuse the id of a participant that left
+  for (size_t i = 0; i < d_queues.size(); ++i)
+  {
+    if (!d_queues[i].d_active)
+    {
+      d_queues[i].d_active = true;
+      return i;
+    }
+  }
+  d_queues.emplace_back();
+  d_queues.back().d_active = true;
+  return d_queues.size() - 1;
+}
+
+void ClauseExchange::leave(unsigned participant)
+{
+  std::lock_guard<std::mutex> lock(d_mutex);
+  Assert(participant < d_queues.size() && d_queues[participant].d_active);
+  d_queues[participant].d_active = false;
+  std::vector<Clause>().swap(d_queues[participant].d_clauses);
+}
+
+uint32_t ClauseExchange::getAtomId(const std::string& key)
+{
+  std::lock_guard<std::mutex> lock(d_mutex);
+  return d_atomIds.emplace(key, d_atomIds.size()).first->second;
+}
+
+void ClauseExchange::publish(unsigned from, const Clause& clause)
+{
+  std::lock_guard<std::mutex> lock(d_mutex);
+  for (size_t i = 0; i < d_queues.size(); ++i)
+  {
+    Queue& q = d_queues[i];
+    if (i != from && q.d_active && q.d_clauses.size() < d_capacity)
+    {
+      q.d_clauses.push_back(clause);
+    }
+  }
+}
+
+void ClauseExchange::collect(unsigned participant,
+                             std::vector<Clause>& clauses)
+{
+  clauses.clear();
+  std::lock_guard<std::mutex> lock(d_mutex);
+  Assert(participant < d_queues.size() && d_queues[participant].d_active);
+  clauses.swap(d_queues[participant].d_clauses);
+}
+
+void ClauseExchange::clear()
+{
+  std::lock_guard<std::mutex> lock(d_mutex);
+  for (Queue& q : d_queues)
+  {
+    q.d_clauses.clear();
+  }
+}
+
+}  // namespace CVC4
@@ -0,0 +1,110 @@
+/*********************                                                        */
+/*! \file clause_exchange.h
+ ** \verbatim
+ ** Top contributors (to current version):
+ **
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2019 by the authors listed in the file AUTHORS
+ ** in the top-level source directory) and their institutional affiliations.
+ ** All rights reserved.  See the file COPYING in the top-level source
+ ** directory for licensing information.\endverbatim
+ **
+ ** \brief A channel for exchanging learned clauses between solver instances
+ **
+ ** A channel for exchanging learned clauses between solver instances that
+ ** solve the same problem in parallel (see --portfolio).
+ **/
+
+#include "cvc4_public.h"
+
+#ifndef CVC4__UTIL__CLAUSE_EXCHANGE_H
+#define CVC4__UTIL__CLAUSE_EXCHANGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace CVC4 {
+
+/**
+ * A channel for exchanging learned clauses between solver instances.
+ *
+ * Each instance has its own ExprManager, so clauses can't be exchanged as
+ * Nodes.  Instead, each instance identifies its atoms by a key that is the
+ * same for equal atoms in all instances (see prop::TheoryProxy), and the
+ * exchange maps these keys to atom ids shared by all instances.  A clause
+ * is a list of (atom id, negated) pairs.
+ *
+ * An instance joins the exchange, publishes the clauses it learns and
+ * collects the ones published by the other instances since it last
+ * collected.  All methods may be called concurrently.
+ */
+class CVC4_PUBLIC ClauseExchange
+{
+ public:
+  /** A literal of an exchanged clause, an atom id and whether it is negated */
+  typedef std::pair<uint32_t, bool> Literal;
+  /** An exchanged clause */
+  typedef std::vector<Literal> Clause;
+
+  /**
+   * Create an exchange that keeps at most capacity uncollected clauses per
+   * instance.  Further clauses are dropped until the instance collects.
+   */
+  ClauseExchange(size_t capacity = 1 << 16);
+
+  /** Join the exchange, returns the participant id of the instance */
+  unsigned join();
+
+  /** Leave the exchange, dropping the uncollected clauses of participant */
+  void leave(unsigned participant);
+
+  /** Get the atom id of the atom with the given key */
+  uint32_t getAtomId(const std::string& key);
+
+  /** Publish clause to all participants but from */
+  void publish(unsigned from, const Clause& clause);
+
+  /**
+   * Move the clauses published to participant since its last call to
+   * clauses.
+   */
+  void collect(unsigned participant, std::vector<Clause>& clauses);
+
+  /**
+   * Drop all uncollected clauses, e.g. when the assertions they follow from
+   * are reset.
+   */
+  void clear();
+
+ private:
+  /** The pending clauses of a participant */
+  struct Queue
+  {
+    Queue() : d_active(false) {}
+    /** Whether the participant is in the exchange */
+    bool d_active;
+    /** The clauses published to it since it last collected */
+    std::vector<Clause> d_clauses;
+  };
+
+  /** Protects all members */
+  std::mutex d_mutex;
+
+  /** The maximal number of uncollected clauses per participant */
+  size_t d_capacity;
+
+  /** The atom ids, by key */
+  std::unordered_map<std::string, uint32_t> d_atomIds;
+
+  /** The queues, by participant id */
+  std::vector<Queue> d_queues;
+}; /* class ClauseExchange */
+
+}  // namespace CVC4
+
+#endif /* CVC4__UTIL__CLAUSE_EXCHANGE_H */
@@ -91,11 +91,89 @@ Maybe<Rational> Rational::fromDouble(double d)
 {
   using namespace std;
   if(isfinite(d)){
-    Rational q;
-    mpq_set_d(q.d_value.get_mpq_t(), d);
-    return q;
+    mpq_class value;
+    mpq_set_d(value.get_mpq_t(), d);
+    return Rational(value);
   }
   return Maybe<Rational>();
 }
 
+void Rational::assign(const mpq_class& val) {
+  mpq_srcptr q = val.get_mpq_t();
+  if(mpz_fits_slong_p(mpq_numref(q)) && mpz_fits_slong_p(mpq_denref(q))){
+    long n = mpz_get_si(mpq_numref(q));
+    if(n != LONG_MIN){
+      setSmall(n, mpz_get_si(mpq_denref(q)));
+      return;
+    }
+  }
+  if(d_big == NULL){
+    d_big = new mpq_class(val);
+  }else{
+    *d_big = val;
+  }
+}
+
+void Rational::assign(mpq_class&& val) {
+  mpq_srcptr q = val.get_mpq_t();
+  if(mpz_fits_slong_p(mpq_numref(q)) && mpz_fits_slong_p(mpq_denref(q))){
+    long n = mpz_get_si(mpq_numref(q));
+    if(n != LONG_MIN){
+      setSmall(n, mpz_get_si(mpq_denref(q)));
+      return;
+    }
+  }
+  if(d_big == NULL){
+    d_big = new mpq_class();
+  }
+  mpq_swap(d_big->get_mpq_t(), val.get_mpq_t());
+}
+
+Rational Rational::addBig(const Rational& y) const {
+  mpq_class tmp1, tmp2, result;
+  mpq_add(result.get_mpq_t(),
+          getMpq(tmp1).get_mpq_t(),
+          y.getMpq(tmp2).get_mpq_t());
+  Rational q;
+  q.assign(std::move(result));
+  return q;
+}
+
+Rational Rational::subBig(const Rational& y) const {
+  mpq_class tmp1, tmp2, result;
+  mpq_sub(result.get_mpq_t(),
+          getMpq(tmp1).get_mpq_t(),
+          y.getMpq(tmp2).get_mpq_t());
+  Rational q;
+  q.assign(std::move(result));
+  return q;
+}
+
+Rational Rational::mulBig(const Rational& y) const {
+  mpq_class tmp1, tmp2, result;
+  mpq_mul(result.get_mpq_t(),
+          getMpq(tmp1).get_mpq_t(),
+          y.getMpq(tmp2).get_mpq_t());
+  Rational q;
+  q.assign(std::move(result));
+  return q;
+}
+
+Rational Rational::divBig(const Rational& y) const {
+  mpq_class tmp1, tmp2, result;
+  mpq_div(result.get_mpq_t(),
+          getMpq(tmp1).get_mpq_t(),
+          y.getMpq(tmp2).get_mpq_t());
+  Rational q;
+  q.assign(std::move(result));
+  return q;
+}
+
+int Rational::cmpBig(const Rational& y) const {
+  //Don't use mpq_class's cmp() function.
+  //The name ends up conflicting with this function.
+  mpq_class tmp1, tmp2;
+  return mpq_cmp(getMpq(tmp1).get_mpq_t(), y.getMpq(tmp2).get_mpq_t());
+}
+
 } /* namespace CVC4 */
@@ -28,7 +28,9 @@
 #include <cstddef>
 
 #include <gmp.h>
+#include <climits>
 #include <string>
+#include <utility>
 
 #include "base/exception.h"
 #include "util/integer.h"
@@ -45,6 +47,13 @@ namespace CVC4 {
  ** literature.) A consequence is that that the numerator and denominator may be
  ** different than the values used to construct the Rational.
  **
+ ** Most rationals met in practice are small, so a rational whose numerator and
+ ** denominator fit in a long is stored inline and the arithmetic on two such
+ ** rationals is done on machine words, checking for overflow.  Only the values
+ ** that do not fit, and the results that overflow, are stored in a GMP
+ ** rational.  Every value that fits is stored inline, so the representation of
+ ** a value is unique.
+ **
  ** NOTE: The correct way to create a Rational from an int is to use one of the
  ** int numerator/int denominator constructors with the denominator 1.  Trying
  ** to construct a Rational with a single int, e.g., Rational(0), will put you
@@ -54,10 +63,14 @@ namespace CVC4 {
 class CVC4_PUBLIC Rational {
 private:
   /**
-   * Stores the value of the rational is stored in a C++ GMP rational class.
-   * Using this instead of mpq_t allows for easier destruction.
+   * If d_big is null, the value is d_num / d_den where d_den > 0,
+   * gcd(d_num, d_den) = 1 and d_num != LONG_MIN (so that negating it cannot
+   * overflow).  Otherwise the value is *d_big, which is canonical and does not
+   * satisfy these conditions.
    */
-  mpq_class d_value;
+  long d_num;
+  long d_den;
+  mpq_class* d_big;
 
   /**
    * Constructs a Rational from a mpq_class object.
@@ -65,7 +78,111 @@ private:
    * Assumes that the value is in canonical form, and thus does not
    * have to call canonicalize() on the value.
    */
-  Rational(const mpq_class& val) : d_value(val) {  }
+  Rational(const mpq_class& val) : d_num(0), d_den(1), d_big(NULL) {
+    assign(val);
+  }
+
+  /** Sets the value to the canonical val. */
+  void assign(const mpq_class& val);
+
+  /** Sets the value to the canonical val, given in canonical form. */
+  void assign(mpq_class&& val);
+
+  /** Sets the value to n/d, which must be in the inline form. */
+  void setSmall(long n, long d) {
+    if(d_big != NULL){
+      delete d_big;
+      d_big = NULL;
+    }
+    d_num = n;
+    d_den = d;
+  }
+
+  /**
+   * Returns the value as a GMP rational: *d_big, or tmp set to the inline
+   * value.
+   */
+  const mpq_class& getMpq(mpq_class& tmp) const {
+    if(d_big != NULL){
+      return *d_big;
+    }
+    mpz_set_si(tmp.get_num_mpz_t(), d_num);
+    mpz_set_si(tmp.get_den_mpz_t(), d_den);
+    return tmp;
+  }
+
+  /** The gcd of two nonnegative longs, gcd(0, 0) = 0. */
+  static long gcd(long a, long b) {
+    while(b != 0){
+      long t = a % b;
+      a = b;
+      b = t;
+    }
+    return a;
+  }
+
+  /**
+   * Sets result to the inline rational n1/d1 + n2/d2 and returns true, or
+   * returns false if it does not fit.
+   */
+  static bool addSmall(long n1, long d1, long n2, long d2, Rational& result) {
+    long num, den;
+    if(d1 == 1 && d2 == 1){
+      if(__builtin_add_overflow(n1, n2, &num)){ return false; }
+      den = 1;
+    }else{
+      // As mpq_add: with g = gcd(d1, d2), the sum is
+      // (n1 * (d2 / g) + n2 * (d1 / g)) / (d1 * d2 / g), to be reduced by g.
+      long g = gcd(d1, d2);
+      long t1, t2, t;
+      if(__builtin_mul_overflow(n1, d2 / g, &t1) ||
+         __builtin_mul_overflow(n2, d1 / g, &t2) ||
+         __builtin_add_overflow(t1, t2, &t)){
+        return false;
+      }
+      if(t == LONG_MIN){ return false; }
+      long g2 = g == 1 ? 1 : gcd(t < 0 ? -t : t, g);
+      if(__builtin_mul_overflow(d1 / g, d2 / g2, &den)){ return false; }
+      num = t / g2;
+    }
+    if(num == LONG_MIN){ return false; }
+    if(num == 0){ den = 1; }
+    result.setSmall(num, den);
+    return true;
+  }
+
+  /**
+   * Sets result to the inline rational (n1/d1) * (n2/d2) and returns true, or
+   * returns false if it does not fit.
+   */
+  static bool mulSmall(long n1, long d1, long n2, long d2, Rational& result) {
+    if(n1 == 0 || n2 == 0){
+      result.setSmall(0, 1);
+      return true;
+    }
+    long num, den;
+    if(d1 == 1 && d2 == 1){
+      if(__builtin_mul_overflow(n1, n2, &num)){ return false; }
+      den = 1;
+    }else{
+      long g1 = gcd(n1 < 0 ? -n1 : n1, d2);
+      long g2 = gcd(n2 < 0 ? -n2 : n2, d1);
+      if(__builtin_mul_overflow(n1 / g1, n2 / g2, &num) ||
+         __builtin_mul_overflow(d1 / g2, d2 / g1, &den)){
+        return false;
+      }
+    }
+    if(num == LONG_MIN){ return false; }
+    result.setSmall(num, den);
+    return true;
+  }
+
+  /** The slow paths of the arithmetic, on GMP rationals. */
+  Rational addBig(const Rational& y) const;
+  Rational subBig(const Rational& y) const;
+  Rational mulBig(const Rational& y) const;
+  Rational divBig(const Rational& y) const;
+  int cmpBig(const Rational& y) const;
 
 public:
 
@@ -78,9 +195,7 @@ public:
   static Rational fromDecimal(const std::string& dec);
 
   /** Constructs a rational with the value 0/1. */
-  Rational() : d_value(0){
-    d_value.canonicalize();
-  }
+  Rational() : d_num(0), d_den(1), d_big(NULL) {}
 
   /**
    * Constructs a Rational from a C string in a given base (defaults to 10).
@@ -89,88 +204,126 @@ public:
    * For more information about what is a valid rational string,
    * see GMP's documentation for mpq_set_str().
    */
-  explicit Rational(const char* s, unsigned base = 10): d_value(s, base) {
-    d_value.canonicalize();
+  explicit Rational(const char* s, unsigned base = 10)
+    : d_num(0), d_den(1), d_big(NULL) {
+    mpq_class value(s, base);
+    value.canonicalize();
+    assign(std::move(value));
   }
-  Rational(const std::string& s, unsigned base = 10) : d_value(s, base) {
-    d_value.canonicalize();
+  Rational(const std::string& s, unsigned base = 10)
+    : d_num(0), d_den(1), d_big(NULL) {
+    mpq_class value(s, base);
+    value.canonicalize();
+    assign(std::move(value));
   }
 
   /**
    * Creates a Rational from another Rational, q, by performing a deep copy.
    */
-  Rational(const Rational& q) : d_value(q.d_value) {
-    d_value.canonicalize();
+  Rational(const Rational& q)
+    : d_num(q.d_num), d_den(q.d_den),
+      d_big(q.d_big == NULL ? NULL : new mpq_class(*q.d_big)) {}
+
+  Rational(Rational&& q) noexcept
+    : d_num(q.d_num), d_den(q.d_den), d_big(q.d_big) {
+    q.d_big = NULL;
   }
 
   /**
    * Constructs a canonical Rational from a numerator.
    */
-  Rational(signed int n) : d_value(n,1) {
-    d_value.canonicalize();
-  }
-  Rational(unsigned int n) : d_value(n,1) {
-    d_value.canonicalize();
+  Rational(signed int n) : d_num(n), d_den(1), d_big(NULL) {}
+  Rational(unsigned int n) : d_num(n), d_den(1), d_big(NULL) {
+    if(sizeof(unsigned int) >= sizeof(long)){
+      assign(mpq_class(n, 1u));
+    }
   }
-  Rational(signed long int n) : d_value(n,1) {
-    d_value.canonicalize();
+  Rational(signed long int n) : d_num(n), d_den(1), d_big(NULL) {
+    if(n == LONG_MIN){
+      assign(mpq_class(n, 1l));
+    }
   }
-  Rational(unsigned long int n) : d_value(n,1) {
-    d_value.canonicalize();
+  Rational(unsigned long int n) : d_num(n), d_den(1), d_big(NULL) {
+    if(n > (unsigned long)LONG_MAX){
+      assign(mpq_class(n, 1ul));
+    }
   }
 
 #ifdef CVC4_NEED_INT64_T_OVERLOADS
-  Rational(int64_t n) : d_value(static_cast<long>(n), 1) {
-    d_value.canonicalize();
+  Rational(int64_t n) : d_num(0), d_den(1), d_big(NULL) {
+    assign(mpq_class(static_cast<long>(n), 1));
   }
-  Rational(uint64_t n) : d_value(static_cast<unsigned long>(n), 1) {
-    d_value.canonicalize();
+  Rational(uint64_t n) : d_num(0), d_den(1), d_big(NULL) {
+    assign(mpq_class(static_cast<unsigned long>(n), 1));
   }
 #endif /* CVC4_NEED_INT64_T_OVERLOADS */
 
   /**
    * Constructs a canonical Rational from a numerator and denominator.
    */
-  Rational(signed int n, signed int d) : d_value(n,d) {
-    d_value.canonicalize();
+  Rational(signed int n, signed int d) : d_num(0), d_den(1), d_big(NULL) {
+    mpq_class value(n, d);
+    value.canonicalize();
+    assign(std::move(value));
   }
-  Rational(unsigned int n, unsigned int d) : d_value(n,d) {
-    d_value.canonicalize();
+  Rational(unsigned int n, unsigned int d) : d_num(0), d_den(1), d_big(NULL) {
+    mpq_class value(n, d);
+    value.canonicalize();
+    assign(std::move(value));
   }
-  Rational(signed long int n, signed long int d) : d_value(n,d) {
-    d_value.canonicalize();
+  Rational(signed long int n, signed long int d)
+    : d_num(0), d_den(1), d_big(NULL) {
+    mpq_class value(n, d);
+    value.canonicalize();
+    assign(std::move(value));
   }
-  Rational(unsigned long int n, unsigned long int d) : d_value(n,d) {
-    d_value.canonicalize();
+  Rational(unsigned long int n, unsigned long int d)
+    : d_num(0), d_den(1), d_big(NULL) {
+    mpq_class value(n, d);
+    value.canonicalize();
+    assign(std::move(value));
   }
 
 #ifdef CVC4_NEED_INT64_T_OVERLOADS
-  Rational(int64_t n, int64_t d) : d_value(static_cast<long>(n), static_cast<long>(d)) {
-    d_value.canonicalize();
+  Rational(int64_t n, int64_t d) : d_num(0), d_den(1), d_big(NULL) {
+    mpq_class value(static_cast<long>(n), static_cast<long>(d));
+    value.canonicalize();
+    assign(std::move(value));
   }
-  Rational(uint64_t n, uint64_t d) : d_value(static_cast<unsigned long>(n), static_cast<unsigned long>(d)) {
-    d_value.canonicalize();
+  Rational(uint64_t n, uint64_t d) : d_num(0), d_den(1), d_big(NULL) {
+    mpq_class value(static_cast<unsigned long>(n),
+                    static_cast<unsigned long>(d));
+    value.canonicalize();
+    assign(std::move(value));
   }
 #endif /* CVC4_NEED_INT64_T_OVERLOADS */
 
-  Rational(const Integer& n, const Integer& d) :
-    d_value(n.get_mpz(), d.get_mpz())
-  {
-    d_value.canonicalize();
+  Rational(const Integer& n, const Integer& d)
+    : d_num(0), d_den(1), d_big(NULL) {
+    mpq_class value(n.get_mpz(), d.get_mpz());
+    value.canonicalize();
+    assign(std::move(value));
+  }
+  Rational(const Integer& n) : d_num(0), d_den(1), d_big(NULL) {
+    if(mpz_fits_slong_p(n.get_mpz().get_mpz_t())){
+      d_num = mpz_get_si(n.get_mpz().get_mpz_t());
+      if(d_num != LONG_MIN){
+        return;
+      }
+    }
+    assign(mpq_class(n.get_mpz()));
   }
-  Rational(const Integer& n) :
-    d_value(n.get_mpz())
-  {
-    d_value.canonicalize();
+  ~Rational() {
+    delete d_big;
   }
-  ~Rational() {}
 
   /**
-   * Returns a copy of d_value to enable public access of GMP data.
+   * Returns a copy of the value to enable public access of GMP data.
    */
   mpq_class getValue() const
   {
-    return d_value;
+    mpq_class tmp;
+    return getMpq(tmp);
   }
 
   /**
@@ -178,7 +331,10 @@ public:
    * Note that this makes a deep copy of the numerator.
    */
   Integer getNumerator() const {
-    return Integer(d_value.get_num());
+    if(d_big == NULL){
+      return Integer(d_num);
+    }
+    return Integer(d_big->get_num());
   }
 
   /**
@@ -186,7 +342,10 @@ public:
    * Note that this makes a deep copy of the denominator.
    */
   Integer getDenominator() const {
-    return Integer(d_value.get_den());
+    if(d_big == NULL){
+      return Integer(d_den);
+    }
+    return Integer(d_big->get_den());
   }
 
   static Maybe<Rational> fromDouble(double d);
@@ -197,21 +356,42 @@ public:
    * infinity, and underflow may result in zero.
    */
   double getDouble() const {
-    return d_value.get_d();
+    mpq_class tmp;
+    return getMpq(tmp).get_d();
   }
 
   Rational inverse() const {
+    if(d_big == NULL && d_num != 0){
+      Rational inv;
+      if(d_num < 0){
+        inv.setSmall(-d_den, -d_num);
+      }else{
+        inv.setSmall(d_den, d_num);
+      }
+      return inv;
+    }
     return Rational(getDenominator(), getNumerator());
   }
 
   int cmp(const Rational& x) const {
-    //Don't use mpq_class's cmp() function.
-    //The name ends up conflicting with this function.
-    return mpq_cmp(d_value.get_mpq_t(), x.d_value.get_mpq_t());
+    if(d_big == NULL && x.d_big == NULL){
+      if(d_den == x.d_den){
+        return d_num < x.d_num ? -1 : (d_num == x.d_num ? 0 : 1);
+      }
+      long l, r;
+      if(!__builtin_mul_overflow(d_num, x.d_den, &l) &&
+         !__builtin_mul_overflow(x.d_num, d_den, &r)){
+        return l < r ? -1 : (l == r ? 0 : 1);
+      }
+    }
+    return cmpBig(x);
   }
 
   int sgn() const {
-    return mpq_sgn(d_value.get_mpq_t());
+    if(d_big == NULL){
+      return d_num < 0 ? -1 : (d_num == 0 ? 0 : 1);
+    }
+    return mpq_sgn(d_big->get_mpq_t());
   }
 
   bool isZero() const {
@@ -219,11 +399,11 @@ public:
   }
 
   bool isOne() const {
-    return mpq_cmp_si(d_value.get_mpq_t(), 1, 1) == 0;
+    return d_big == NULL && d_num == 1 && d_den == 1;
   }
 
   bool isNegativeOne() const {
-    return mpq_cmp_si(d_value.get_mpq_t(), -1, 1) == 0;
+    return d_big == NULL && d_num == -1 && d_den == 1;
   }
 
   Rational abs() const {
@@ -235,14 +415,23 @@ public:
   }
 
   Integer floor() const {
+    if(d_big == NULL){
+      // d_den > 1 means the division is not exact, and truncates towards 0
+      long q = d_num / d_den;
+      return Integer(d_den > 1 && d_num < 0 ? q - 1 : q);
+    }
     mpz_class q;
-    mpz_fdiv_q(q.get_mpz_t(), d_value.get_num_mpz_t(), d_value.get_den_mpz_t());
+    mpz_fdiv_q(q.get_mpz_t(), d_big->get_num_mpz_t(), d_big->get_den_mpz_t());
     return Integer(q);
   }
 
   Integer ceiling() const {
+    if(d_big == NULL){
+      long q = d_num / d_den;
+      return Integer(d_den > 1 && d_num > 0 ? q + 1 : q);
+    }
     mpz_class q;
-    mpz_cdiv_q(q.get_mpz_t(), d_value.get_num_mpz_t(), d_value.get_den_mpz_t());
+    mpz_cdiv_q(q.get_mpz_t(), d_big->get_num_mpz_t(), d_big->get_den_mpz_t());
     return Integer(q);
   }
 
@@ -252,78 +441,138 @@ public:
 
   Rational& operator=(const Rational& x){
     if(this == &x) return *this;
-    d_value = x.d_value;
+    if(x.d_big == NULL){
+      setSmall(x.d_num, x.d_den);
+    }else if(d_big == NULL){
+      d_big = new mpq_class(*x.d_big);
+    }else{
+      *d_big = *x.d_big;
+    }
+    return *this;
+  }
+
+  Rational& operator=(Rational&& x) noexcept {
+    if(this == &x) return *this;
+    delete d_big;
+    d_num = x.d_num;
+    d_den = x.d_den;
+    d_big = x.d_big;
+    x.d_big = NULL;
     return *this;
   }
 
   Rational operator-() const{
-    return Rational(-(d_value));
+    if(d_big == NULL){
+      Rational neg;
+      neg.setSmall(-d_num, d_den);
+      return neg;
+    }
+    return Rational(mpq_class(-(*d_big)));
   }
 
   bool operator==(const Rational& y) const {
-    return d_value == y.d_value;
+    if(d_big == NULL || y.d_big == NULL){
+      // The representation is unique
+      return d_big == y.d_big && d_num == y.d_num && d_den == y.d_den;
+    }
+    return *d_big == *y.d_big;
   }
 
   bool operator!=(const Rational& y) const {
-    return d_value != y.d_value;
+    return !(*this == y);
   }
 
   bool operator< (const Rational& y) const {
-    return d_value < y.d_value;
+    return cmp(y) < 0;
   }
 
   bool operator<=(const Rational& y) const {
-    return d_value <= y.d_value;
+    return cmp(y) <= 0;
   }
 
   bool operator> (const Rational& y) const {
-    return d_value > y.d_value;
+    return cmp(y) > 0;
   }
 
   bool operator>=(const Rational& y) const {
-    return d_value >= y.d_value;
+    return cmp(y) >= 0;
   }
 
   Rational operator+(const Rational& y) const{
-    return Rational( d_value + y.d_value );
+    Rational result;
+    if(d_big == NULL && y.d_big == NULL &&
+       addSmall(d_num, d_den, y.d_num, y.d_den, result)){
+      return result;
+    }
+    return addBig(y);
   }
   Rational operator-(const Rational& y) const {
-    return Rational( d_value - y.d_value );
+    Rational result;
+    if(d_big == NULL && y.d_big == NULL &&
+       addSmall(d_num, d_den, -y.d_num, y.d_den, result)){
+      return result;
+    }
+    return subBig(y);
   }
 
   Rational operator*(const Rational& y) const {
-    return Rational( d_value * y.d_value );
+    Rational result;
+    if(d_big == NULL && y.d_big == NULL &&
+       mulSmall(d_num, d_den, y.d_num, y.d_den, result)){
+      return result;
+    }
+    return mulBig(y);
   }
   Rational operator/(const Rational& y) const {
-    return Rational( d_value / y.d_value );
+    Rational result;
+    if(d_big == NULL && y.d_big == NULL && y.d_num != 0 &&
+       mulSmall(d_num, d_den,
+                y.d_num < 0 ? -y.d_den : y.d_den,
+                y.d_num < 0 ? -y.d_num : y.d_num,
+                result)){
+      return result;
+    }
+    return divBig(y);
   }
 
   Rational& operator+=(const Rational& y){
-    d_value += y.d_value;
-    return (*this);
+    if(d_big == NULL && y.d_big == NULL &&
+       addSmall(d_num, d_den, y.d_num, y.d_den, *this)){
+      return *this;
+    }
+    return *this = addBig(y);
   }
   Rational& operator-=(const Rational& y){
-    d_value -= y.d_value;
-    return (*this);
+    if(d_big == NULL && y.d_big == NULL &&
+       addSmall(d_num, d_den, -y.d_num, y.d_den, *this)){
+      return *this;
+    }
+    return *this = subBig(y);
   }
 
   Rational& operator*=(const Rational& y){
-    d_value *= y.d_value;
-    return (*this);
+    if(d_big == NULL && y.d_big == NULL &&
+       mulSmall(d_num, d_den, y.d_num, y.d_den, *this)){
+      return *this;
+    }
+    return *this = mulBig(y);
   }
 
   Rational& operator/=(const Rational& y){
-    d_value /= y.d_value;
-    return (*this);
+    return *this = *this / y;
   }
 
   bool isIntegral() const{
-    return getDenominator() == 1;
+    if(d_big == NULL){
+      return d_den == 1;
+    }
+    return mpz_cmp_ui(d_big->get_den_mpz_t(), 1) == 0;
   }
 
   /** Returns a string representing the rational in the given base. */
   std::string toString(int base = 10) const {
-    return d_value.get_str(base);
+    mpq_class tmp;
+    return getMpq(tmp).get_str(base);
   }
 
   /**
@@ -331,8 +580,14 @@ public:
    * denominator.
    */
   size_t hash() const {
-    size_t numeratorHash = gmpz_hash(d_value.get_num_mpz_t());
-    size_t denominatorHash = gmpz_hash(d_value.get_den_mpz_t());
+    if(d_big == NULL){
+      // As gmpz_hash() of the single limb magnitudes
+      size_t numeratorHash = d_num < 0 ? -(unsigned long)d_num : d_num;
+      size_t denominatorHash = d_den;
+      return numeratorHash xor denominatorHash;
+    }
+    size_t numeratorHash = gmpz_hash(d_big->get_num_mpz_t());
+    size_t denominatorHash = gmpz_hash(d_big->get_den_mpz_t());
 
     return numeratorHash xor denominatorHash;
   }
@@ -0,0 +1,26 @@
+; COMMAND-LINE: --incremental --float-simplex
+; EXPECT: sat
+; EXPECT: unsat
+(set-logic QF_LRA)
+(declare-fun x1 () Real)
+(declare-fun x2 () Real)
+(declare-fun x3 () Real)
+(declare-fun x4 () Real)
+(declare-fun x5 () Real)
+(declare-fun x6 () Real)
+(declare-fun x7 () Real)
+(declare-fun x8 () Real)
+(declare-fun x9 () Real)
+(declare-fun x10 () Real)
+(assert (and (<= 0 x1) (<= x1 20) (<= 0 x2) (<= x2 20) (<= 0 x3) (<= x3 20)
+             (<= 0 x4) (<= x4 20) (<= 0 x5) (<= x5 20) (<= 0 x6) (<= x6 20)
+             (<= 0 x7) (<= x7 20) (<= 0 x8) (<= x8 20) (<= 0 x9) (<= x9 20)
+             (<= 0 x10) (<= x10 20)))
+(assert (and (>= (+ x1 x2) 3) (>= (+ x2 x3) 5) (>= (+ x3 x4) 7)
+             (>= (+ x4 x5) 9) (>= (+ x5 x6) 11) (>= (+ x6 x7) 13)
+             (>= (+ x7 x8) 15) (>= (+ x8 x9) 17) (>= (+ x9 x10) 19)
+             (<= (+ x1 x10) 11) (>= (+ x1 (* 2 x5)) 11) (>= (+ x3 x7) 10)
+             (>= (- x10 x1) 9)))
+(check-sat)
+(assert (<= (+ x1 x2 x3 x4 x5 x6 x7 x8 x9 x10) 40))
+(check-sat)
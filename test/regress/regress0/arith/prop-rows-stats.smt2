@@ -0,0 +1,19 @@
+; REQUIRES: statistics
+; COMMAND-LINE: --simplification=none --stats
+; ERROR-SCRUBBER: sed -n -E -e 's/^(theory::arith::prop::rows::(propagations|visited)), [1-9][0-9]*$/\1 > 0/p'
+; EXPECT: sat
+; EXPECT-ERROR: theory::arith::prop::rows::propagations > 0
+; EXPECT-ERROR: theory::arith::prop::rows::visited > 0
+; The bounds of x and y reach the row of x - y through coefficients of both
+; signs, and the equality on z updates both bounds of z in the row of x + z.
+; Without simplification, z = 2 is asserted as a bound instead of being
+; substituted.
+(set-logic QF_LRA)
+(declare-fun x () Real)
+(declare-fun y () Real)
+(declare-fun z () Real)
+(assert (and (<= 0 x) (<= x 4) (<= 1 y) (<= y 3)))
+(assert (= z 2))
+(assert (or (<= (- x y) 3) (>= (+ x z) 9)))
+(assert (or (>= (+ x z) 2) (< (+ x y) 0)))
+(check-sat)
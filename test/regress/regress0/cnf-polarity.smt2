@@ -0,0 +1,22 @@
+; COMMAND-LINE: --incremental --cnf-polarity
+; EXPECT: sat
+; EXPECT: unsat
+; EXPECT: sat
+(set-logic QF_LIA)
+(declare-fun x () Int)
+(declare-fun y () Int)
+(declare-fun p () Bool)
+(declare-fun q () Bool)
+(define-fun g () Bool (and (> x 0) (or p (< y x))))
+(assert (or g (= x y)))
+(check-sat)
+(push 1)
+; g occurred positively only, this needs that g holds when its formula does
+(assert (> x 0))
+(assert p)
+(assert (or (not g) q))
+(assert (not q))
+(check-sat)
+(pop 1)
+(assert (or (not g) q))
+(check-sat)
@@ -0,0 +1,21 @@
+; COMMAND-LINE: --portfolio=2 --cubes=4
+; EXPECT: sat
+; EXPECT: unsat
+(set-logic QF_LIA)
+(declare-fun a () Int)
+(declare-fun b () Int)
+(declare-fun c () Int)
+(declare-fun p () Bool)
+(declare-fun q () Bool)
+(assert (and (<= 0 a) (<= a 3)))
+(assert (and (<= 0 b) (<= b 3)))
+(assert (and (<= 0 c) (<= c 3)))
+(assert (distinct a b c))
+(assert (=> p (< a b)))
+(assert (=> q (< b c)))
+(assert (or p q))
+(check-sat)
+(push 1)
+(assert (and (<= a 1) (<= b 1) (<= c 1)))
+(check-sat)
+(pop 1)
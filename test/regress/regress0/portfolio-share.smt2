@@ -0,0 +1,13 @@
+; COMMAND-LINE: --portfolio=2 --sat-share-size=8 --restart-int-base=10
+; EXPECT: unsat
+(set-logic QF_LIA)
+(declare-fun a () Int)
+(declare-fun b () Int)
+(declare-fun c () Int)
+(declare-fun d () Int)
+(assert (and (<= 0 a) (<= a 2)))
+(assert (and (<= 0 b) (<= b 2)))
+(assert (and (<= 0 c) (<= c 2)))
+(assert (and (<= 0 d) (<= d 2)))
+(assert (distinct a b c d))
+(check-sat)
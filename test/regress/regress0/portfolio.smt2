@@ -0,0 +1,21 @@
+; COMMAND-LINE: --incremental --portfolio=3 --thread2="--decision=justification --random-seed=7"
+; EXPECT: sat
+; EXPECT: ((x 4))
+; EXPECT: unsat
+; EXPECT: sat
+(set-option :produce-models true)
+(set-logic QF_UFLIA)
+(declare-fun f (Int) Int)
+(declare-fun x () Int)
+(declare-fun y () Int)
+(assert (> x 3))
+(assert (< x 5))
+(check-sat)
+(get-value (x))
+(push 1)
+(assert (= (f x) (+ (f y) 1)))
+(assert (= x y))
+(check-sat)
+(pop 1)
+(assert (distinct (f x) (f y)))
+(check-sat)
@@ -0,0 +1,25 @@
+; REQUIRES: cadical-propagator
+; COMMAND-LINE: --incremental --sat-solver=cadical
+; EXPECT: sat
+; EXPECT: unsat
+; EXPECT: sat
+; EXPECT: unsat
+(set-logic QF_UFLIA)
+(declare-fun f (Int) Int)
+(declare-fun x () Int)
+(declare-fun y () Int)
+(declare-fun p () Bool)
+(assert (or p (> x 3)))
+(assert (=> p (= (f x) (f y))))
+(assert (<= x y))
+(push 1)
+(assert (not (= (f x) (f y))))
+(check-sat)
+(assert (<= y 3))
+(check-sat)
+(pop 1)
+(assert (= x y))
+(assert (not p))
+(check-sat)
+(assert (< y 2))
+(check-sat)
@@ -0,0 +1,17 @@
+; COMMAND-LINE: --sat-trace=1
+; EXPECT: unsat
+; ERROR-SCRUBBER: sed -n -e '1s/ [0-9][0-9.]*/ N/gp'
+; EXPECT-ERROR: (sat-trace :conflicts N :decisions N :propagations N :theory-conflicts N :theory-propagations N (THEORY_BUILTIN :conflicts N :propagations N :explanations N :explain-time N) (THEORY_BOOL :conflicts N :propagations N :explanations N :explain-time N) (THEORY_UF :conflicts N :propagations N :explanations N :explain-time N) (THEORY_ARITH :conflicts N :propagations N :explanations N :explain-time N) (THEORY_BV :conflicts N :propagations N :explanations N :explain-time N) (THEORY_FP :conflicts N :propagations N :explanations N :explain-time N) (THEORY_ARRAYS :conflicts N :propagations N :explanations N :explain-time N) (THEORY_DATATYPES :conflicts N :propagations N :explanations N :explain-time N) (THEORY_SEP :conflicts N :propagations N :explanations N :explain-time N) (THEORY_SETS :conflicts N :propagations N :explanations N :explain-time N) (THEORY_STRINGS :conflicts N :propagations N :explanations N :explain-time N) (THEORY_QUANTIFIERS :conflicts N :propagations N :explanations N :explain-time N))
+(set-logic QF_UFLIA)
+(declare-fun f (Int) Int)
+(declare-fun x () Int)
+(declare-fun y () Int)
+(declare-fun a () Bool)
+(declare-fun b () Bool)
+(assert (or (and a (= x y)) (and b (= x (+ y 1)))))
+(assert (or (not a) (not (= (f x) (f y)))))
+(assert (or (not b) (< (f x) 0)))
+(assert (or (not b) (> (f (- x 1)) 0)))
+(assert (or (not b) (= (- x 1) y)))
+(assert (or (not b) (= (f x) (f y))))
+(check-sat)
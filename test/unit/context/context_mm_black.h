@@ -93,5 +93,74 @@ private:
 #endif /* __CVC4__CONTEXT__CONTEXT_MM_H */
   }
 
+  void testLargeObjects()
+  {
+#ifndef CVC4_DEBUG_CONTEXT_MEMORY_MANAGER
+    // Requests larger than any chunk are served separately
+    d_cmm->push();
+    size_t len = 1 << 22;
+    char* big = (char*)d_cmm->newData(len);
+    memset(big, 'b', len);
+    char* small = (char*)d_cmm->newData(16);
+    memset(small, 's', 16);
+    TS_ASSERT_EQUALS(big[len - 1], 'b');
+    TS_ASSERT_EQUALS(d_cmm->getBytesAllocated(1), int64_t(len + 16));
+    d_cmm->pop();
+
+    // The counts of a level are reset when it is popped
+    TS_ASSERT_EQUALS(d_cmm->getBytesAllocated(1), 0);
+    d_cmm->push();
+    d_cmm->newData(8);
+    TS_ASSERT_EQUALS(d_cmm->getBytesAllocated(1), 8);
+    TS_ASSERT_EQUALS(d_cmm->getBytesAllocated(2), 0);
+    d_cmm->pop();
+    TS_ASSERT_EQUALS(d_cmm->getBytesAllocated(1), 0);
+
+    // Requests larger than the first chunk get a chunk that fits them, which
+    // is reused after a pop
+    int64_t chunkBytes = d_cmm->getChunkBytes();
+    len = 64 << 10;
+    for (unsigned p = 0; p < 2; ++p)
+    {
+      d_cmm->push();
+      char* mid = (char*)d_cmm->newData(len);
+      memset(mid, 'm', len);
+      TS_ASSERT_EQUALS(d_cmm->getChunkBytes(), chunkBytes + int64_t(len));
+      d_cmm->pop();
+    }
+#endif /* CVC4_DEBUG_CONTEXT_MEMORY_MANAGER */
+  }
+
+  void testFreeChunkCache()
+  {
+#ifndef CVC4_DEBUG_CONTEXT_MEMORY_MANAGER
+    // Fill many chunks, which grow in size
+    d_cmm->push();
+    for (unsigned i = 0; i < 10000; ++i)
+    {
+      d_cmm->newData(1024);
+    }
+    d_cmm->pop();
+    int64_t chunkBytes = d_cmm->getChunkBytes();
+    TS_ASSERT_LESS_THAN(int64_t(10000 * 1024), chunkBytes);
+    TS_ASSERT_EQUALS(int64_t(d_cmm->getFreeBytes()), chunkBytes - 16384);
+
+    // A second round is served from the free chunks
+    d_cmm->push();
+    for (unsigned i = 0; i < 10000; ++i)
+    {
+      d_cmm->newData(1024);
+    }
+    TS_ASSERT_EQUALS(d_cmm->getChunkBytes(), chunkBytes);
+    TS_ASSERT_EQUALS(d_cmm->getFreeBytes(), 0u);
+    d_cmm->pop();
+
+    // Shrinking the cache releases free chunks
+    d_cmm->setMaxFreeBytes(0);
+    TS_ASSERT_EQUALS(d_cmm->getFreeBytes(), 0u);
+    TS_ASSERT_EQUALS(d_cmm->getChunkBytes(), 16384);
+#endif /* CVC4_DEBUG_CONTEXT_MEMORY_MANAGER */
+  }
+
   void tearDown() override { delete d_cmm; }
 };
@@ -0,0 +1,161 @@
+/*********************                                                        */
+/*! \file justification_heuristic_black.h
+ ** \verbatim
+ ** Top contributors (to current version):
+ **
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2019 by the authors listed in the file AUTHORS
+ ** in the top-level source directory) and their institutional affiliations.
+ ** All rights reserved.  See the file COPYING in the top-level source
+ ** directory for licensing information.\endverbatim
+ **
+ ** \brief Black box testing of the justification heuristic
+ **
+ ** Black box testing of the justification heuristic (--decision=justification)
+ ** through SmtEngine, against the results of the SAT solver's own decisions.
+ **/
+
+#include <cxxtest/TestSuite.h>
+
+#include <sstream>
+#include <vector>
+
+#include "expr/expr.h"
+#include "expr/expr_manager.h"
+#include "smt/smt_engine.h"
+#include "util/random.h"
+#include "util/result.h"
+
+using namespace CVC4;
+using namespace CVC4::kind;
+
+class JustificationHeuristicBlack : public CxxTest::TestSuite
+{
+ public:
+  void setUp() override
+  {
+    d_em = new ExprManager;
+    Type boolType = d_em->booleanType();
+    Type intType = d_em->integerType();
+    for (unsigned i = 0; i < 8; ++i)
+    {
+      std::stringstream ss;
+      ss << "p" << i;
+      d_atoms.push_back(d_em->mkVar(ss.str(), boolType));
+    }
+    Expr x = d_em->mkVar("x", intType);
+    Expr y = d_em->mkVar("y", intType);
+    for (int i = 0; i < 4; ++i)
+    {
+      d_atoms.push_back(d_em->mkExpr(LEQ, x, d_em->mkConst(Rational(i))));
+      d_atoms.push_back(d_em->mkExpr(
+          GEQ, d_em->mkExpr(PLUS, x, y), d_em->mkConst(Rational(2 * i))));
+    }
+  }
+
+  void tearDown() override
+  {
+    d_atoms.clear();
+    delete d_em;
+  }
+
+  /** A random and/or/not formula of the given depth over d_atoms */
+  Expr mkFormula(Random& rnd, unsigned depth)
+  {
+    if (depth == 0 || rnd.pickWithProb(0.2))
+    {
+      Expr atom = d_atoms[rnd.pick(0, d_atoms.size() - 1)];
+      return rnd.pickWithProb(0.5) ? atom.notExpr() : atom;
+    }
+    std::vector<Expr> children;
+    for (unsigned i = 0, n = rnd.pick(2, 5); i < n; ++i)
+    {
+      children.push_back(mkFormula(rnd, depth - 1));
+    }
+    Expr f = d_em->mkExpr(rnd.pickWithProb(0.5) ? AND : OR, children);
+    return rnd.pickWithProb(0.2) ? f.notExpr() : f;
+  }
+
+  /** Check the assertions with the given decision mode */
+  Result check(const std::vector<Expr>& assertions, const std::string& mode)
+  {
+    SmtEngine smt(d_em);
+    smt.setOption("decision", SExpr(mode));
+    smt.setOption("produce-models", SExpr("true"));
+    smt.setLogic("QF_LIA");
+    for (const Expr& a : assertions)
+    {
+      smt.assertFormula(a);
+    }
+    Result r = smt.checkSat();
+    if (r.isSat() == Result::SAT)
+    {
+      for (const Expr& a : assertions)
+      {
+        TS_ASSERT_EQUALS(smt.getValue(a), d_em->mkConst(true));
+      }
+    }
+    return r;
+  }
+
+  void testWatchedAnd()
+  {
+    // deciding either conjunction justifies its children one by one
+    std::vector<Expr> conj1(d_atoms.begin(), d_atoms.begin() + 4);
+    std::vector<Expr> conj2(d_atoms.begin() + 4, d_atoms.begin() + 8);
+    Expr f = d_em->mkExpr(
+        OR, d_em->mkExpr(AND, conj1), d_em->mkExpr(AND, conj2));
+
+    SmtEngine smt(d_em);
+    smt.setOption("decision", SExpr("justification"));
+    smt.setLogic("QF_LIA");
+    smt.assertFormula(f);
+    TS_ASSERT_EQUALS(smt.checkSat().isSat(), Result::SAT);
+    SExpr watchJustified = smt.getStatistic("decision::jh::watchJustified");
+    TS_ASSERT(watchJustified.isInteger());
+    TS_ASSERT(watchJustified.getIntegerValue() > 0);
+  }
+
+  void testIncremental()
+  {
+    Expr p0 = d_atoms[0];
+    Expr p1 = d_atoms[1];
+    Expr p2 = d_atoms[2];
+    SmtEngine smt(d_em);
+    smt.setOption("decision", SExpr("justification"));
+    smt.setOption("incremental", SExpr("true"));
+    smt.setLogic("QF_LIA");
+    smt.assertFormula(d_em->mkExpr(OR, d_em->mkExpr(AND, p0, p1, p2),
+                                   d_em->mkExpr(AND, p0.notExpr(), p1)));
+    TS_ASSERT_EQUALS(smt.checkSat().isSat(), Result::SAT);
+    smt.push();
+    smt.assertFormula(p1.notExpr());
+    TS_ASSERT_EQUALS(smt.checkSat().isSat(), Result::UNSAT);
+    smt.pop();
+    smt.push();
+    smt.assertFormula(p2.notExpr());
+    TS_ASSERT_EQUALS(smt.checkSat().isSat(), Result::SAT);
+    smt.pop();
+    TS_ASSERT_EQUALS(smt.checkSat().isSat(), Result::SAT);
+  }
+
+  void testRandom()
+  {
+    Random rnd(23);
+    for (unsigned i = 0; i < 40; ++i)
+    {
+      std::vector<Expr> assertions;
+      for (unsigned j = 0, n = rnd.pick(1, 4); j < n; ++j)
+      {
+        assertions.push_back(mkFormula(rnd, 4));
+      }
+      TS_ASSERT_EQUALS(check(assertions, "justification").isSat(),
+                       check(assertions, "internal").isSat());
+    }
+  }
+
+ private:
+  ExprManager* d_em;
+  /** Boolean variables and arithmetic atoms */
+  std::vector<Expr> d_atoms;
+};
@@ -53,6 +53,10 @@ typedef Attribute<Test3, bool> TestFlag3;
 typedef Attribute<Test4, bool> TestFlag4;
 typedef Attribute<Test5, bool> TestFlag5;
 
+typedef DenseAttribute<Test1, Node> TestDenseNodeAttr1;
+typedef DenseAttribute<Test2, Node> TestDenseNodeAttr2;
+typedef DenseAttribute<Test1, uint64_t> TestDenseIntAttr;
+
 class AttributeWhite : public CxxTest::TestSuite {
 
   ExprManager* d_em;
@@ -135,8 +139,78 @@ class AttributeWhite : public CxxTest::TestSuite {
 //    TS_ASSERT_DIFFERS(theory::PostRewriteCache::s_id, theory::PostRewriteCacheTop::s_id);
 //    TS_ASSERT_DIFFERS(theory::PreRewriteCacheTop::s_id, theory::PostRewriteCacheTop::s_id);
 
-    lastId = attr::LastAttributeId<TypeNode, false>::getId();
+    lastId = attr::LastAttributeId<DenseAttrTable<TypeNode>, false>::getId();
     TS_ASSERT_LESS_THAN(TypeAttr::s_id, lastId);
+
+    lastId = attr::LastAttributeId<DenseAttrTable<Node>, false>::getId();
+    TS_ASSERT_LESS_THAN(TestDenseNodeAttr1::s_id, lastId);
+    TS_ASSERT_LESS_THAN(TestDenseNodeAttr2::s_id, lastId);
+    TS_ASSERT_DIFFERS(TestDenseNodeAttr1::s_id, TestDenseNodeAttr2::s_id);
+  }
+
+  void testDenseAttributes() {
+    AttributeManager* am = d_nm->d_attrManager;
+    const size_t initialSize = am->d_denseNodes.size();
+
+    // enough nodes to span several pages of the dense tables
+    std::vector<Node> vars;
+    for (unsigned i = 0; i < 2000; ++i)
+    {
+      vars.push_back(d_nm->mkVar(*d_booleanType));
+    }
+    Node t = d_nm->mkConst(true);
+
+    for (unsigned i = 0; i < vars.size(); i += 2)
+    {
+      vars[i].setAttribute(TestDenseNodeAttr1(), vars[i + 1]);
+      vars[i].setAttribute(TestDenseIntAttr(), i);
+    }
+    vars[1].setAttribute(TestDenseNodeAttr2(), Node::null());
+    TS_ASSERT_EQUALS(am->d_denseNodes.size(), initialSize + 1001);
+
+    for (unsigned i = 0; i < vars.size(); ++i)
+    {
+      TS_ASSERT_EQUALS(vars[i].hasAttribute(TestDenseNodeAttr1()), i % 2 == 0);
+      Node v;
+      if (i % 2 == 0)
+      {
+        TS_ASSERT(vars[i].getAttribute(TestDenseNodeAttr1(), v));
+        TS_ASSERT_EQUALS(v, vars[i + 1]);
+        TS_ASSERT_EQUALS(vars[i].getAttribute(TestDenseIntAttr()), i);
+      }
+      else
+      {
+        TS_ASSERT(!vars[i].getAttribute(TestDenseNodeAttr1(), v));
+        TS_ASSERT(vars[i].getAttribute(TestDenseNodeAttr1()).isNull());
+      }
+    }
+    // a null value is still a value
+    TS_ASSERT(vars[1].hasAttribute(TestDenseNodeAttr2()));
+    TS_ASSERT(!vars[0].hasAttribute(TestDenseNodeAttr2()));
+    TS_ASSERT(!t.hasAttribute(TestDenseNodeAttr1()));
+
+    // overwriting a value doesn't add an entry
+    vars[0].setAttribute(TestDenseNodeAttr1(), t);
+    TS_ASSERT_EQUALS(vars[0].getAttribute(TestDenseNodeAttr1()), t);
+    TS_ASSERT_EQUALS(am->d_denseNodes.size(), initialSize + 1001);
+
+    // deleting the attributes of a node removes it from all dense tables
+    am->deleteAllAttributes(vars[2].d_nv);
+    TS_ASSERT(!vars[2].hasAttribute(TestDenseNodeAttr1()));
+    TS_ASSERT(!vars[2].hasAttribute(TestDenseIntAttr()));
+    TS_ASSERT(vars[4].hasAttribute(TestDenseNodeAttr1()));
+    TS_ASSERT_EQUALS(am->d_denseNodes.size(), initialSize + 1000);
+
+    // deleting an attribute kind leaves the others alone
+    AttributeUniqueId id1 = AttributeManager::getAttributeId(TestDenseNodeAttr1());
+    TS_ASSERT_EQUALS(id1.getTableId(), AttrTableDenseNode);
+    AttributeManager::AttrIdVec ids;
+    ids.push_back(&id1);
+    am->deleteAttributes(ids);
+    TS_ASSERT(!vars[0].hasAttribute(TestDenseNodeAttr1()));
+    TS_ASSERT(vars[1].hasAttribute(TestDenseNodeAttr2()));
+    TS_ASSERT(vars[0].hasAttribute(TestDenseIntAttr()));
+    TS_ASSERT_EQUALS(am->d_denseNodes.size(), initialSize + 1);
   }
 
   void testAttributes() {
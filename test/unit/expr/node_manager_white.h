@@ -17,10 +17,14 @@
 #include <cxxtest/TestSuite.h>
 
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "expr/node_manager.h"
+#include "options/expr_options.h"
 #include "test_utils.h"
 #include "util/integer.h"
+#include "util/random.h"
 #include "util/rational.h"
 
 using namespace CVC4;
@@ -91,4 +95,124 @@ class NodeManagerWhite : public CxxTest::TestSuite {
       TS_ASSERT_EQUALS(NodeManager::TopologicalSort(roots), result);
     }
   }
+
+  void testNodeValueAllocator()
+  {
+    NodeValueAllocator* alloc = d_nm->d_nvAllocator;
+    int64_t blockSize = NodeValueAllocator::getBlockSize(2);
+    int64_t bytesBefore = alloc->d_classes[2].d_bytesInUse;
+
+    TypeNode boolType = d_nm->booleanType();
+    Node x = d_nm->mkSkolem("x", boolType);
+    Node n = x;
+    for (unsigned i = 0; i < 20000; ++i)
+    {
+      n = d_nm->mkNode(kind::AND, n, x);
+    }
+    TS_ASSERT_EQUALS(alloc->d_classes[2].d_bytesInUse,
+                     bytesBefore + 20000 * blockSize);
+
+    // releasing the top of the chain zombifies all of it
+    n = Node::null();
+    d_nm->reclaimAllZombies();
+    TS_ASSERT_EQUALS(alloc->d_classes[2].d_bytesInUse, bytesBefore);
+    TS_ASSERT_LESS_THAN(0, alloc->d_chunksReleased);
+
+    // freed blocks are reused
+    Node m = d_nm->mkNode(kind::AND, x, x);
+    TS_ASSERT_EQUALS(alloc->d_classes[2].d_bytesInUse,
+                     bytesBefore + blockSize);
+  }
+
+  void testIncrementalGc()
+  {
+    d_nm->getOptions().set(options::incrementalGc, true);
+    d_nm->getOptions().set(options::incrementalGcBudget, 100u);
+
+    TypeNode boolType = d_nm->booleanType();
+    Node x = d_nm->mkSkolem("x", boolType);
+    std::vector<Node> nodes;
+    for (unsigned i = 0; i < 6000; ++i)
+    {
+      nodes.push_back(d_nm->mkNode(kind::AND, x, d_nm->mkSkolem("y", boolType)));
+    }
+    nodes.clear();
+
+    // every round past the threshold only reclaims a bounded number of
+    // zombies, so some are left for the next safe point
+    TS_ASSERT(!d_nm->d_zombies.empty());
+    TS_ASSERT_LESS_THAN_EQUALS(d_nm->d_zombies.size(), 5001u);
+
+    d_nm->reclaimAllZombies();
+    TS_ASSERT(d_nm->d_zombies.empty());
+  }
+
+  void testConcurrentConstruction()
+  {
+#ifdef CVC4_CONCURRENT_NODE_MANAGER
+    const unsigned numThreads = 8;
+    const unsigned numTerms = 5000;
+    TypeNode intType = d_nm->integerType();
+    std::vector<Node> vars;
+    for (unsigned i = 0; i < 16; ++i)
+    {
+      vars.push_back(d_nm->mkSkolem("x", intType));
+    }
+    size_t poolSize = d_nm->poolSize();
+
+    std::vector<std::vector<Node>> terms(numThreads);
+    // the number of terms of each thread that got a wrong type, checked on
+    // this thread after the workers are joined
+    std::vector<unsigned> illTyped(numThreads, 0);
+    {
+      NodeManager::ConcurrentScope concurrent(d_nm);
+      TS_ASSERT(d_nm->isConcurrent());
+      std::vector<std::thread> threads;
+      for (unsigned t = 0; t < numThreads; ++t)
+      {
+        threads.emplace_back([&, t]() {
+          NodeManagerScope nms(d_nm);
+          std::vector<Node>& mine = terms[t];
+          mine = vars;
+          Node c = d_nm->mkConst(Rational(t));
+          // the same sequence of shared terms in every thread
+          Random rnd(1);
+          while (mine.size() < numTerms)
+          {
+            const Node& a = mine[rnd.pick(0, mine.size() - 1)];
+            const Node& b = mine[rnd.pick(0, mine.size() - 1)];
+            mine.push_back(d_nm->mkNode(
+                rnd.pickWithProb(0.5) ? kind::PLUS : kind::MULT, a, b));
+            // garbage private to this thread, with a concurrently computed
+            // type attribute
+            Node g = d_nm->mkNode(kind::MINUS, mine.back(), c);
+            if (g.getType() != intType)
+            {
+              ++illTyped[t];
+            }
+          }
+        });
+      }
+      for (std::thread& t : threads)
+      {
+        t.join();
+      }
+    }
+    TS_ASSERT(!d_nm->isConcurrent());
+
+    // hash-consing is shared by all threads
+    for (unsigned t = 0; t < numThreads; ++t)
+    {
+      TS_ASSERT_EQUALS(illTyped[t], 0u);
+      TS_ASSERT(terms[t] == terms[0]);
+    }
+    TS_ASSERT_LESS_THAN(poolSize, d_nm->poolSize());
+
+    // every node released by any thread is reclaimed
+    terms.clear();
+    d_nm->reclaimAllZombies();
+    TS_ASSERT(d_nm->d_zombies.empty());
+    TS_ASSERT_EQUALS(d_nm->poolSize(), poolSize);
+#endif /* CVC4_CONCURRENT_NODE_MANAGER */
+  }
 };
@@ -0,0 +1,212 @@
+/*********************                                                        */
+/*! \file node_value_pool_white.h
+ ** \verbatim
+ ** Top contributors (to current version):
+ **
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2019 by the authors listed in the file AUTHORS
+ ** in the top-level source directory) and their institutional affiliations.
+ ** All rights reserved.  See the file COPYING in the top-level source
+ ** directory for licensing information.\endverbatim
+ **
+ ** \brief White box testing of CVC4::expr::NodeValuePool.
+ **
+ ** White box testing of CVC4::expr::NodeValuePool, and a throughput
+ ** comparison against an std::unordered_set based pool on a large term DAG
+ ** that only runs with CVC4_UNIT_BENCHMARKS set.
+ **/
+
+#include <cxxtest/TestSuite.h>
+
+#include <chrono>
+#include <iostream>
+#include <unordered_set>
+#include <vector>
+
+#include "expr/node.h"
+#include "expr/node_manager.h"
+#include "expr/node_value_pool.h"
+#include "test_utils.h"
+#include "util/random.h"
+#include "util/rational.h"
+
+using namespace CVC4;
+using namespace CVC4::expr;
+
+class NodeValuePoolWhite : public CxxTest::TestSuite
+{
+  typedef std::unordered_set<NodeValue*,
+                             NodeValuePoolHashFunction,
+                             NodeValuePoolEq>
+      StdNodeValuePool;
+
+  NodeManager* d_nm;
+  NodeManagerScope* d_scope;
+
+  /**
+   * Build a DAG of n hash-consed terms over a few integer variables, where
+   * every term shares subterms with earlier ones.  The variables themselves
+   * are not returned, as they are never hash-consed.
+   */
+  std::vector<Node> mkDag(unsigned n)
+  {
+    static const unsigned numVars = 8;
+    TypeNode intType = d_nm->integerType();
+    std::vector<Node> terms;
+    for (unsigned i = 0; i < numVars; ++i)
+    {
+      terms.push_back(d_nm->mkSkolem("x", intType));
+    }
+    terms.push_back(d_nm->mkConst(Rational(1)));
+    Random rnd(1);
+    while (terms.size() < numVars + n)
+    {
+      const Node& a = terms[rnd.pick(0, terms.size() - 1)];
+      const Node& b = terms[rnd.pick(0, terms.size() - 1)];
+      Kind k = rnd.pickWithProb(0.5) ? kind::PLUS : kind::MULT;
+      Node t = d_nm->mkNode(k, a, b);
+      // skip terms that were hash-consed to an earlier one
+      if (t.getId() > terms.back().getId())
+      {
+        terms.push_back(t);
+      }
+    }
+    terms.erase(terms.begin(), terms.begin() + numVars);
+    return terms;
+  }
+
+ public:
+  void setUp() override
+  {
+    d_nm = new NodeManager(NULL);
+    d_scope = new NodeManagerScope(d_nm);
+  }
+
+  void tearDown() override
+  {
+    delete d_scope;
+    delete d_nm;
+  }
+
+  void testInsertFindErase()
+  {
+    std::vector<Node> terms = mkDag(2000);
+    NodeValuePool pool;
+    for (const Node& t : terms)
+    {
+      pool.insert(t.d_nv);
+    }
+    TS_ASSERT_EQUALS(pool.size(), terms.size());
+    for (const Node& t : terms)
+    {
+      TS_ASSERT_EQUALS(pool.find(t.d_nv), t.d_nv);
+    }
+
+    for (size_t i = 0; i < terms.size(); i += 2)
+    {
+      pool.erase(terms[i].d_nv);
+    }
+    TS_ASSERT_EQUALS(pool.size(), terms.size() / 2);
+    for (size_t i = 0; i < terms.size(); ++i)
+    {
+      NodeValue* expected = (i % 2 == 0) ? NULL : terms[i].d_nv;
+      TS_ASSERT_EQUALS(pool.find(terms[i].d_nv), expected);
+    }
+
+    size_t count = 0;
+    for (NodeValuePool::const_iterator it = pool.begin(); it != pool.end();
+         ++it)
+    {
+      TS_ASSERT_EQUALS(pool.find(*it), *it);
+      ++count;
+    }
+    TS_ASSERT_EQUALS(count, pool.size());
+  }
+
+  void testNonInlinedConstantLookup()
+  {
+    NodeValuePool pool;
+    Rational r(42);
+    Node c = d_nm->mkConst(r);
+    pool.insert(c.d_nv);
+
+    // the same shape as NodeManager::mkConst() uses for its lookup
+    NodeManager::NVStorage<1> nvStorage;
+    NodeValue& nvStack = reinterpret_cast<NodeValue&>(nvStorage);
+    nvStack.d_id = 0;
+    nvStack.d_kind = kind::CONST_RATIONAL;
+    nvStack.d_rc = 0;
+    nvStack.d_nchildren = 1;
+    nvStack.d_children[0] = reinterpret_cast<NodeValue*>(&r);
+    TS_ASSERT_EQUALS(pool.find(&nvStack), c.d_nv);
+  }
+
+  void testThroughput()
+  {
+    if (!runUnitBenchmarks())
+    {
+      return;
+    }
+    const unsigned n = 500000;
+    std::vector<Node> terms = mkDag(n);
+
+    std::chrono::duration<double> insPool, findPool, erasePool;
+    std::chrono::duration<double> insStd, findStd, eraseStd;
+    size_t found = 0;
+    {
+      NodeValuePool pool;
+      auto t0 = std::chrono::steady_clock::now();
+      for (const Node& t : terms)
+      {
+        pool.insert(t.d_nv);
+      }
+      auto t1 = std::chrono::steady_clock::now();
+      for (const Node& t : terms)
+      {
+        found += pool.find(t.d_nv) != NULL;
+      }
+      auto t2 = std::chrono::steady_clock::now();
+      for (const Node& t : terms)
+      {
+        pool.erase(t.d_nv);
+      }
+      auto t3 = std::chrono::steady_clock::now();
+      insPool = t1 - t0;
+      findPool = t2 - t1;
+      erasePool = t3 - t2;
+    }
+    {
+      StdNodeValuePool pool;
+      auto t0 = std::chrono::steady_clock::now();
+      for (const Node& t : terms)
+      {
+        pool.insert(t.d_nv);
+      }
+      auto t1 = std::chrono::steady_clock::now();
+      for (const Node& t : terms)
+      {
+        found += pool.find(t.d_nv) != pool.end();
+      }
+      auto t2 = std::chrono::steady_clock::now();
+      for (const Node& t : terms)
+      {
+        pool.erase(t.d_nv);
+      }
+      auto t3 = std::chrono::steady_clock::now();
+      insStd = t1 - t0;
+      findStd = t2 - t1;
+      eraseStd = t3 - t2;
+    }
+    TS_ASSERT_EQUALS(found, 2 * terms.size());
+
+    std::cout << std::endl
+              << "pool throughput on " << terms.size()
+              << " terms (Mops/s, insert/find/erase):" << std::endl
+              << "  NodeValuePool:      " << n / insPool.count() / 1e6 << " / "
+              << n / findPool.count() / 1e6 << " / "
+              << n / erasePool.count() / 1e6 << std::endl
+              << "  std::unordered_set: " << n / insStd.count() / 1e6 << " / "
+              << n / findStd.count() / 1e6 << " / "
+              << n / eraseStd.count() / 1e6 << std::endl;
+  }
+};
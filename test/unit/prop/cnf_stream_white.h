@@ -11,13 +11,19 @@
  **
  ** \brief White box testing of CVC4::prop::CnfStream.
  **
- ** White box testing of CVC4::prop::CnfStream.
+ ** White box testing of CVC4::prop::CnfStream, and a conversion throughput
+ ** benchmark on large random circuits that only runs with
+ ** CVC4_UNIT_BENCHMARKS set.
  **/
 
 #include <cxxtest/TestSuite.h>
 /* #include <gmock/gmock.h> */
 /* #include <gtest/gtest.h> */
 
+#include <chrono>
+#include <iostream>
+#include <vector>
+
 #include "base/check.h"
 #include "context/context.h"
 #include "expr/expr_manager.h"
@@ -27,12 +33,14 @@
 #include "prop/theory_proxy.h"
 #include "smt/smt_engine.h"
 #include "smt/smt_engine_scope.h"
+#include "test_utils.h"
 #include "theory/arith/theory_arith.h"
 #include "theory/booleans/theory_bool.h"
 #include "theory/builtin/theory_builtin.h"
 #include "theory/theory.h"
 #include "theory/theory_engine.h"
 #include "theory/theory_registrar.h"
+#include "util/random.h"
 
 using namespace CVC4;
 using namespace CVC4::context;
@@ -45,9 +53,12 @@ using namespace std;
 class FakeSatSolver : public SatSolver {
   SatVariable d_nextVar;
   bool d_addClauseCalled;
+  unsigned d_numClauses;
 
  public:
-  FakeSatSolver() : d_nextVar(0), d_addClauseCalled(false) {}
+  FakeSatSolver() : d_nextVar(0), d_addClauseCalled(false), d_numClauses(0)
+  {
+  }
 
   SatVariable newVar(bool theoryAtom, bool preRegister, bool canErase) override
   {
@@ -61,6 +72,7 @@ class FakeSatSolver : public SatSolver {
   ClauseId addClause(SatClause& c, bool lemma) override
   {
     d_addClauseCalled = true;
+    ++d_numClauses;
     return ClauseIdUndef;
   }
 
@@ -76,6 +88,10 @@ class FakeSatSolver : public SatSolver {
 
   unsigned int addClauseCalled() { return d_addClauseCalled; }
 
+  unsigned numClauses() const { return d_numClauses; }
+
+  unsigned numVars() const { return d_nextVar; }
+
   unsigned getAssertionLevel() const override { return 0; }
 
   bool isDecision(Node) const { return false; }
@@ -294,4 +310,137 @@ class CnfStreamWhite : public CxxTest::TestSuite {
     TS_ASSERT(d_satSolver->addClauseCalled());
     TS_ASSERT(d_cnfStream->hasLiteral(a_and_b));
   }
+
+  void testDeep() {
+    // deep enough to overflow the stack of a recursive conversion
+    NodeManagerScope nms(d_nodeManager);
+    Node a = d_nodeManager->mkVar(d_nodeManager->booleanType());
+    Node b = d_nodeManager->mkVar(d_nodeManager->booleanType());
+    std::vector<Node> gates(1, a);
+    for (unsigned i = 0; i < 200000; ++i) {
+      gates.push_back(d_nodeManager->mkNode(i % 2 == 0 ? kind::AND : kind::OR,
+                                            gates.back(), b));
+    }
+    d_cnfStream->convertAndAssert(gates.back(), false, false, RULE_INVALID,
+                                  Node::null());
+    TS_ASSERT(d_cnfStream->hasLiteral(gates[1]));
+    // 3 clauses per gate below the root, which is asserted as one clause
+    TS_ASSERT_EQUALS(d_satSolver->numClauses(), 3 * (gates.size() - 2) + 1);
+  }
+
+  void testPolarity() {
+    NodeManagerScope nms(d_nodeManager);
+    FakeSatSolver satSolver;
+    Context context;
+    TseitinCnfStream cnfStream(
+        &satSolver, d_cnfRegistrar, &context, false, "", true);
+    Node a = d_nodeManager->mkVar(d_nodeManager->booleanType());
+    Node b = d_nodeManager->mkVar(d_nodeManager->booleanType());
+    std::vector<Node> gates(1, a);
+    for (unsigned i = 0; i < 1000; ++i) {
+      gates.push_back(d_nodeManager->mkNode(i % 2 == 0 ? kind::AND : kind::OR,
+                                            gates.back(), b));
+    }
+    cnfStream.convertAndAssert(gates.back(), false, false, RULE_INVALID,
+                               Node::null());
+    d_cnfStream->convertAndAssert(gates.back(), false, false, RULE_INVALID,
+                                  Node::null());
+    // the gates only occur positively: 2 clauses per AND, 1 per OR, and
+    // the root is asserted as one clause
+    TS_ASSERT_EQUALS(satSolver.numClauses(), 3 * (gates.size() - 1) / 2);
+    TS_ASSERT_LESS_THAN(satSolver.numClauses(), d_satSolver->numClauses());
+  }
+
+  void testPolarityIncremental() {
+    NodeManagerScope nms(d_nodeManager);
+    FakeSatSolver satSolver;
+    Context context;
+    TseitinCnfStream cnfStream(
+        &satSolver, d_cnfRegistrar, &context, false, "", true);
+    Node a = d_nodeManager->mkVar(d_nodeManager->booleanType());
+    Node b = d_nodeManager->mkVar(d_nodeManager->booleanType());
+    Node c = d_nodeManager->mkVar(d_nodeManager->booleanType());
+    Node d = d_nodeManager->mkVar(d_nodeManager->booleanType());
+    Node ab = d_nodeManager->mkNode(kind::AND, a, b);
+    Node notAb = ab.notNode();
+
+    // the clause and lit -> a, lit -> b
+    cnfStream.convertAndAssert(d_nodeManager->mkNode(kind::OR, ab, c), false,
+                               false, RULE_INVALID, Node::null());
+    TS_ASSERT_EQUALS(satSolver.numClauses(), 3u);
+
+    // using the gate negatively adds lit | ~a | ~b, once
+    context.push();
+    cnfStream.convertAndAssert(d_nodeManager->mkNode(kind::OR, notAb, c), false,
+                               false, RULE_INVALID, Node::null());
+    TS_ASSERT_EQUALS(satSolver.numClauses(), 5u);
+    cnfStream.convertAndAssert(d_nodeManager->mkNode(kind::OR, notAb, d), false,
+                               false, RULE_INVALID, Node::null());
+    TS_ASSERT_EQUALS(satSolver.numClauses(), 6u);
+    cnfStream.convertAndAssert(d_nodeManager->mkNode(kind::OR, ab, d), false,
+                               false, RULE_INVALID, Node::null());
+    TS_ASSERT_EQUALS(satSolver.numClauses(), 7u);
+
+    // the definition is popped with the clauses of the level
+    context.pop();
+    cnfStream.convertAndAssert(d_nodeManager->mkNode(kind::OR, notAb, c), false,
+                               false, RULE_INVALID, Node::null());
+    TS_ASSERT_EQUALS(satSolver.numClauses(), 9u);
+
+    // literals for the theories are defined both ways
+    Node cd = d_nodeManager->mkNode(kind::OR, c, d);
+    cnfStream.ensureLiteral(cd);
+    TS_ASSERT_EQUALS(satSolver.numClauses(), 12u);
+  }
+
+  void testBenchmark() {
+    if (!runUnitBenchmarks()) {
+      return;
+    }
+    NodeManagerScope nms(d_nodeManager);
+    const unsigned numInputs = 1000;
+    const unsigned numGates = 500000;
+    std::vector<Node> nodes;
+    for (unsigned i = 0; i < numInputs; ++i) {
+      nodes.push_back(d_nodeManager->mkVar(d_nodeManager->booleanType()));
+    }
+    // a random circuit, each gate over recent nodes so that it is deep
+    Random rnd(1);
+    auto pick = [&]() {
+      unsigned window = std::min<unsigned>(nodes.size(), 2000);
+      return nodes[nodes.size() - 1 - rnd.pick(0, window - 1)];
+    };
+    const kind::Kind_t kinds[] = {kind::AND,
+                                  kind::OR,
+                                  kind::XOR,
+                                  kind::EQUAL,
+                                  kind::IMPLIES,
+                                  kind::ITE};
+    for (unsigned i = 0; i < numGates; ++i) {
+      kind::Kind_t k = kinds[i % 6];
+      if (k == kind::ITE) {
+        nodes.push_back(d_nodeManager->mkNode(k, pick(), pick(), pick()));
+      } else if (k == kind::AND || k == kind::OR) {
+        nodes.push_back(d_nodeManager->mkNode(k, pick(), pick(), pick()));
+      } else {
+        nodes.push_back(d_nodeManager->mkNode(k, pick(), pick()));
+      }
+    }
+    // assert the last gates, which cover most of the circuit
+    std::vector<Node> roots(nodes.end() - 100, nodes.end());
+    Node root = d_nodeManager->mkNode(kind::OR, roots);
+
+    auto start = std::chrono::steady_clock::now();
+    d_cnfStream->convertAndAssert(root, false, false, RULE_INVALID,
+                                  Node::null());
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    TS_ASSERT(d_satSolver->numClauses() > numGates);
+    std::cout << std::endl
+              << "cnf throughput: " << d_satSolver->numVars()
+              << " variables, " << d_satSolver->numClauses() << " clauses in "
+              << elapsed.count() << "s, "
+              << d_satSolver->numClauses() / elapsed.count() / 1e6
+              << " Mclauses/s" << std::endl;
+  }
 };
@@ -0,0 +1,152 @@
+/*********************                                                        */
+/*! \file cube_generator_black.h
+ ** \verbatim
+ ** Top contributors (to current version):
+ **
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2019 by the authors listed in the file AUTHORS
+ ** in the top-level source directory) and their institutional affiliations.
+ ** All rights reserved.  See the file COPYING in the top-level source
+ ** directory for licensing information.\endverbatim
+ **
+ ** \brief Black box testing of cube generation
+ **
+ ** Black box testing of cube generation through SmtEngine::getCubes().
+ **/
+
+#include <cxxtest/TestSuite.h>
+
+#include <sstream>
+#include <vector>
+
+#include "base/configuration.h"
+#include "base/modal_exception.h"
+#include "expr/expr.h"
+#include "expr/expr_manager.h"
+#include "options/options.h"
+#include "smt/smt_engine.h"
+#include "util/result.h"
+
+using namespace CVC4;
+using namespace CVC4::kind;
+
+class CubeGeneratorBlack : public CxxTest::TestSuite
+{
+ public:
+  void setUp() override
+  {
+    d_em = new ExprManager;
+    d_smt = new SmtEngine(d_em);
+    d_smt->setOption("incremental", SExpr("true"));
+    d_smt->setLogic("QF_LIA");
+
+    // a chain of implications over Booleans and integer bounds, so that
+    // deciding an atom either way propagates
+    Type boolType = d_em->booleanType();
+    Expr x = d_em->mkVar("x", d_em->integerType());
+    for (unsigned i = 0; i < 12; ++i)
+    {
+      std::stringstream ss;
+      ss << "p" << i;
+      d_vars.push_back(d_em->mkVar(ss.str(), boolType));
+    }
+    for (unsigned i = 0; i + 2 < d_vars.size(); ++i)
+    {
+      Expr bound = d_em->mkExpr(GEQ, x, d_em->mkConst(Rational(i)));
+      d_smt->assertFormula(d_em->mkExpr(
+          OR, d_vars[i], d_vars[i + 1], d_vars[i + 2].notExpr()));
+      d_smt->assertFormula(d_em->mkExpr(IMPLIES, d_vars[i], bound));
+      d_smt->assertFormula(
+          d_em->mkExpr(IMPLIES, bound.notExpr(), d_vars[i + 1].notExpr()));
+    }
+  }
+
+  void tearDown() override
+  {
+    d_vars.clear();
+    delete d_smt;
+    delete d_em;
+  }
+
+  /** Whether cube c1 contains a literal whose negation is in c2 */
+  bool disjoint(const std::vector<Expr>& c1, const std::vector<Expr>& c2)
+  {
+    for (const Expr& l1 : c1)
+    {
+      for (const Expr& l2 : c2)
+      {
+        if (l1 == l2.notExpr() || l1.notExpr() == l2)
+        {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  /** Solve the assertions under each cube, return how many are sat */
+  unsigned countSat(const std::vector<std::vector<Expr>>& cubes)
+  {
+    unsigned sat = 0;
+    for (const std::vector<Expr>& cube : cubes)
+    {
+      Result r = d_smt->checkSat(cube);
+      TS_ASSERT(!r.isUnknown());
+      sat += r.asSatisfiabilityResult().isSat() == Result::SAT ? 1 : 0;
+    }
+    return sat;
+  }
+
+  void testSplit()
+  {
+    std::vector<std::vector<Expr>> cubes = d_smt->getCubes(4);
+    TS_ASSERT(cubes.size() > 1);
+    TS_ASSERT(cubes.size() <= 4);
+    for (size_t i = 0; i < cubes.size(); ++i)
+    {
+      for (size_t j = i + 1; j < cubes.size(); ++j)
+      {
+        TS_ASSERT(disjoint(cubes[i], cubes[j]));
+      }
+    }
+    TS_ASSERT(countSat(cubes) > 0);
+  }
+
+  void testNoSplit()
+  {
+    std::vector<std::vector<Expr>> cubes = d_smt->getCubes(1);
+    TS_ASSERT_EQUALS(cubes.size(), 1u);
+    TS_ASSERT(cubes[0].empty());
+  }
+
+  void testUnsat()
+  {
+    for (const Expr& p : d_vars)
+    {
+      d_smt->assertFormula(p.notExpr());
+    }
+    d_smt->assertFormula(d_em->mkExpr(OR, d_vars[0], d_vars[1]));
+    std::vector<std::vector<Expr>> cubes = d_smt->getCubes(8);
+    TS_ASSERT(!cubes.empty());
+    TS_ASSERT_EQUALS(countSat(cubes), 0u);
+  }
+
+  void testNoLookahead()
+  {
+    if (!Configuration::isBuiltWithCadicalPropagator())
+    {
+      return;
+    }
+    ExprManager em;
+    SmtEngine smt(&em);
+    smt.setOption("sat-solver", SExpr("cadical"));
+    smt.setLogic("QF_UF");
+    smt.assertFormula(em.mkVar("p", em.booleanType()));
+    TS_ASSERT_THROWS(smt.getCubes(4), ModalException&);
+  }
+
+ private:
+  ExprManager* d_em;
+  SmtEngine* d_smt;
+  std::vector<Expr> d_vars;
+};
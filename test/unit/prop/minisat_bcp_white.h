@@ -0,0 +1,343 @@
+/*********************                                                        */
+/*! \file minisat_bcp_white.h
+ ** \verbatim
+ ** Top contributors (to current version):
+ **
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2019 by the authors listed in the file AUTHORS
+ ** in the top-level source directory) and their institutional affiliations.
+ ** All rights reserved.  See the file COPYING in the top-level source
+ ** directory for licensing information.\endverbatim
+ **
+ ** \brief White box testing of Boolean propagation in CVC4::Minisat::Solver.
+ **
+ ** White box testing of Boolean propagation in CVC4::Minisat::Solver, in
+ ** particular of the binary clause watchers and the binary implication graph,
+ ** and a propagation throughput benchmark that only runs with
+ ** CVC4_UNIT_BENCHMARKS set.  The benchmark reads the colon-separated DIMACS
+ ** files in $CVC4_BCP_DIMACS if it is set, and generates a random instance
+ ** otherwise.
+ **/
+
+#include <cxxtest/TestSuite.h>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "context/context.h"
+#include "expr/expr_manager.h"
+#include "prop/minisat/core/Dimacs.h"
+#include "prop/minisat/core/Solver.h"
+#include "smt/smt_engine.h"
+#include "smt/smt_engine_scope.h"
+#include "test_utils.h"
+#include "util/random.h"
+
+using namespace CVC4;
+using namespace CVC4::context;
+using namespace CVC4::Minisat;
+using namespace CVC4::smt;
+
+namespace {
+
+/**
+ * Adapter for parse_DIMACS_main(): Minisat::Solver reserves its first two
+ * variables for true and false and takes extra arguments in addClause_().
+ */
+class DimacsSink
+{
+ public:
+  DimacsSink(Solver& solver) : d_solver(solver) {}
+
+  int nVars() const { return d_solver.nVars() - 2; }
+
+  void newVar() { d_solver.newVar(); }
+
+  void addClause_(vec<Lit>& lits)
+  {
+    d_clauses.push_back(std::vector<Lit>());
+    for (int i = 0; i < lits.size(); ++i)
+    {
+      lits[i] = mkLit(var(lits[i]) + 2, sign(lits[i]));
+      d_clauses.back().push_back(lits[i]);
+    }
+    ClauseId id;
+    d_solver.addClause_(lits, false, id);
+  }
+
+  const std::vector<std::vector<Lit>>& clauses() const { return d_clauses; }
+
+ private:
+  Solver& d_solver;
+  std::vector<std::vector<Lit>> d_clauses;
+};
+
+}  // namespace
+
+class MinisatBcpWhite : public CxxTest::TestSuite
+{
+  ExprManager* d_exprManager;
+  SmtEngine* d_smt;
+  SmtScope* d_scope;
+  Context* d_context;
+
+  Random d_rnd{1};
+
+  /**
+   * Add a random CNF with numVars variables, numBin binary and numTer
+   * ternary clauses to solver, return the clauses.
+   */
+  std::vector<std::vector<Lit>> addRandomCnf(Solver& solver,
+                                             unsigned numVars,
+                                             unsigned numBin,
+                                             unsigned numTer)
+  {
+    DimacsSink sink(solver);
+    for (unsigned i = 0; i < numVars; ++i)
+    {
+      sink.newVar();
+    }
+    vec<Lit> lits;
+    for (unsigned i = 0; i < numBin + numTer; ++i)
+    {
+      unsigned size = i < numBin ? 2 : 3;
+      lits.clear();
+      while (static_cast<unsigned>(lits.size()) < size)
+      {
+        Var v = d_rnd.pick(0, numVars - 1);
+        bool fresh = true;
+        for (int l = 0; l < lits.size(); ++l)
+        {
+          fresh = fresh && var(lits[l]) != v;
+        }
+        if (fresh)
+        {
+          lits.push(mkLit(v, d_rnd.pickWithProb(0.5)));
+        }
+      }
+      sink.addClause_(lits);
+    }
+    return sink.clauses();
+  }
+
+  /** Load the DIMACS file into solver, return the parsed clauses. */
+  std::vector<std::vector<Lit>> loadDimacs(const std::string& file,
+                                           Solver& solver)
+  {
+    int fd = open(file.c_str(), O_RDONLY);
+    TS_ASSERT(fd >= 0);
+    // the buffer is too large for the stack
+    std::unique_ptr<StreamBuffer> in(new StreamBuffer(fd));
+    DimacsSink sink(solver);
+    parse_DIMACS_main(*in, sink);
+    close(fd);
+    return sink.clauses();
+  }
+
+  /** Decide on a random unassigned variable, false if there is none. */
+  bool decideRandom(Solver& solver)
+  {
+    for (unsigned tries = 0; tries < 64; ++tries)
+    {
+      Var v = d_rnd.pick(2, solver.nVars() - 1);
+      if (solver.value(v) == l_Undef)
+      {
+        solver.newDecisionLevel();
+        solver.uncheckedEnqueue(mkLit(v, d_rnd.pickWithProb(0.5)));
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Check that the assignment is closed under unit propagation: no clause
+   * is falsified or unit.
+   */
+  void checkFixpoint(Solver& solver,
+                     const std::vector<std::vector<Lit>>& clauses)
+  {
+    for (const std::vector<Lit>& c : clauses)
+    {
+      unsigned numUndef = 0;
+      bool sat = false;
+      for (Lit l : c)
+      {
+        sat = sat || solver.value(l) == l_True;
+        numUndef += solver.value(l) == l_Undef;
+      }
+      TS_ASSERT(sat || numUndef >= 2);
+    }
+  }
+
+  /**
+   * Check that the binary implication graph is consistent with the trail:
+   * the antecedent of a literal is false and assigned before it, and the
+   * level of the edge is that of the reason clause.
+   */
+  void checkImplicationGraph(Solver& solver)
+  {
+    for (int i = 0; i < solver.trail.size(); ++i)
+    {
+      Var x = var(solver.trail[i]);
+      Lit imp = solver.implied_by[x].lit;
+      if (imp != lit_Undef)
+      {
+        TS_ASSERT(solver.hasReasonClause(x));
+        TS_ASSERT_EQUALS(solver.value(imp), l_False);
+        TS_ASSERT_LESS_THAN(solver.trail_index(var(imp)), i);
+        TS_ASSERT_EQUALS(solver.implied_by[x].level,
+                         solver.ca[solver.reason(x)].level());
+      }
+    }
+  }
+
+ public:
+  void setUp() override
+  {
+    d_exprManager = new ExprManager();
+    d_smt = new SmtEngine(d_exprManager);
+    d_scope = new SmtScope(d_smt);
+    d_context = new Context();
+    d_rnd.setSeed(1);
+  }
+
+  void tearDown() override
+  {
+    delete d_context;
+    delete d_scope;
+    delete d_smt;
+    delete d_exprManager;
+  }
+
+  void testBinaryPropagation()
+  {
+    Solver solver(NULL, d_context);
+    std::vector<std::vector<Lit>> clauses =
+        addRandomCnf(solver, 2000, 1000, 5000);
+    TS_ASSERT(solver.okay());
+
+    unsigned conflicts = 0;
+    vec<Lit> learnt;
+    for (unsigned round = 0; round < 2000; ++round)
+    {
+      if (!decideRandom(solver))
+      {
+        solver.cancelUntil(0);
+        continue;
+      }
+      CRef confl = solver.propagate(Solver::CHECK_WITHOUT_THEORY);
+      checkImplicationGraph(solver);
+      if (confl == CRef_Undef)
+      {
+        checkFixpoint(solver, clauses);
+        continue;
+      }
+      ++conflicts;
+      const Clause& c = solver.ca[confl];
+      for (int i = 0; i < c.size(); ++i)
+      {
+        TS_ASSERT_EQUALS(solver.value(c[i]), l_False);
+      }
+      // the learnt clause is falsified and has exactly one literal at the
+      // conflict level
+      learnt.clear();
+      int btLevel;
+      solver.analyze(confl, learnt, btLevel);
+      TS_ASSERT_EQUALS(solver.level(var(learnt[0])), solver.decisionLevel());
+      for (int i = 0; i < learnt.size(); ++i)
+      {
+        TS_ASSERT_EQUALS(solver.value(learnt[i]), l_False);
+        TS_ASSERT(i == 0
+                  || solver.level(var(learnt[i])) < solver.decisionLevel());
+      }
+      solver.cancelUntil(0);
+    }
+    TS_ASSERT_LESS_THAN(0u, conflicts);
+  }
+
+  void testPropagationThroughput()
+  {
+    if (!runUnitBenchmarks())
+    {
+      return;
+    }
+    // the empty name stands for the generated instance
+    std::vector<std::string> files;
+    const char* env = getenv("CVC4_BCP_DIMACS");
+    if (env != NULL && *env != '\0')
+    {
+      std::stringstream ss(env);
+      std::string file;
+      while (std::getline(ss, file, ':'))
+      {
+        files.push_back(file);
+      }
+    }
+    else
+    {
+      files.push_back("");
+    }
+
+    std::cout << std::endl;
+    for (const std::string& file : files)
+    {
+      std::string name = file.empty() ? "random instance" : file;
+      Solver solver(NULL, d_context);
+      if (file.empty())
+      {
+        addRandomCnf(solver, 100000, 40000, 300000);
+      }
+      else
+      {
+        loadDimacs(file, solver);
+      }
+      if (!solver.okay())
+      {
+        std::cout << name << ": unsat at level 0, skipped" << std::endl;
+        continue;
+      }
+
+      uint64_t props = solver.propagations;
+      unsigned conflicts = 0;
+      vec<Lit> learnt;
+      auto start = std::chrono::steady_clock::now();
+      for (unsigned round = 0; round < 100000; ++round)
+      {
+        if (!decideRandom(solver))
+        {
+          solver.cancelUntil(0);
+          continue;
+        }
+        CRef confl = solver.propagate(Solver::CHECK_WITHOUT_THEORY);
+        if (confl != CRef_Undef)
+        {
+          ++conflicts;
+          learnt.clear();
+          int btLevel;
+          solver.analyze(confl, learnt, btLevel);
+          solver.cancelUntil(0);
+        }
+        else if (solver.decisionLevel() >= 100)
+        {
+          solver.cancelUntil(0);
+        }
+      }
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      props = solver.propagations - props;
+      std::cout << "bcp throughput on " << name << ": " << props
+                << " propagations, " << conflicts << " conflicts, "
+                << props / elapsed.count() / 1e6 << " Mprops/s" << std::endl;
+    }
+  }
+};
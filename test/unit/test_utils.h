@@ -16,6 +16,8 @@
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include <cstdlib>
+
 /**
  * Use TS_UTILS_EXPECT_ABORT if you expect the expression to abort() when a
  * AlwaysAssert or Assert is triggered.
@@ -35,3 +37,13 @@
     }                               \
     TS_ASSERT(WIFSIGNALED(status)); \
   } while (0)
+
+/**
+ * Whether to run the benchmarks in the unit tests.  They are opt-in, with the
+ * environment variable CVC4_UNIT_BENCHMARKS, and print their results to
+ * stdout.
+ */
+inline bool runUnitBenchmarks()
+{
+  return std::getenv("CVC4_UNIT_BENCHMARKS") != nullptr;
+}
@@ -0,0 +1,182 @@
+/*********************                                                        */
+/*! \file approx_simplex_white.h
+ ** \verbatim
+ ** Top contributors (to current version):
+ **
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2019 by the authors listed in the file AUTHORS
+ ** in the top-level source directory) and their institutional affiliations.
+ ** All rights reserved.  See the file COPYING in the top-level source
+ ** directory for licensing information.\endverbatim
+ **
+ ** \brief White box testing of the floating point simplex.
+ **
+ ** White box testing of the floating point simplex returned by
+ ** ApproximateSimplex::mkFloatSimplexSolver() on small tableaux.
+ **/
+
+#include <cxxtest/TestSuite.h>
+
+#include <memory>
+#include <vector>
+
+#include "expr/expr_manager.h"
+#include "expr/node_manager.h"
+#include "smt/smt_engine.h"
+#include "smt/smt_engine_scope.h"
+#include "theory/arith/approx_simplex.h"
+#include "theory/arith/callbacks.h"
+#include "theory/arith/constraint.h"
+#include "theory/arith/cut_log.h"
+#include "theory/arith/partial_model.h"
+#include "theory/arith/tableau.h"
+#include "theory/arith/theory_arith.h"
+#include "theory/theory_engine.h"
+#include "util/rational.h"
+
+using namespace CVC4;
+using namespace CVC4::smt;
+using namespace CVC4::theory;
+using namespace CVC4::theory::arith;
+
+class ApproxSimplexWhite : public CxxTest::TestSuite
+{
+  ExprManager* d_em;
+  NodeManager* d_nm;
+  SmtEngine* d_smt;
+  SmtScope* d_scope;
+
+  ArithVariables* d_vars;
+  Tableau* d_tableau;
+  TreeLog* d_treeLog;
+  ApproximateStatistics* d_stats;
+  /** The bounds set on d_vars, deleted after it */
+  std::vector<ConstraintP> d_bounds;
+
+  /** Allocates a real variable with no bounds and assignment 0. */
+  ArithVar mkVar()
+  {
+    ArithVar x = d_vars->allocate(d_nm->mkSkolem("x", d_nm->realType()), false);
+    d_tableau->increaseSizeTo(d_vars->getNumberOfVariables());
+    return x;
+  }
+
+  void setLowerBound(ArithVar x, int b)
+  {
+    d_bounds.push_back(new Constraint(x, LowerBound, DeltaRational(b)));
+    d_vars->setLowerBoundConstraint(d_bounds.back());
+  }
+
+  void setUpperBound(ArithVar x, int b)
+  {
+    d_bounds.push_back(new Constraint(x, UpperBound, DeltaRational(b)));
+    d_vars->setUpperBoundConstraint(d_bounds.back());
+  }
+
+  /**
+   * Returns a basic variable s = a * x + b * y with the lower bound slb, where
+   * x and y are fresh nonbasic variables in [0, xub] and [0, yub].
+   */
+  ArithVar mkRow(int a, int b, int xub, int yub, int slb)
+  {
+    ArithVar x = mkVar();
+    ArithVar y = mkVar();
+    ArithVar s = mkVar();
+    std::vector<Rational> coeffs = {Rational(a), Rational(b)};
+    std::vector<ArithVar> vars = {x, y};
+    d_tableau->addRow(s, coeffs, vars);
+    setLowerBound(x, 0);
+    setUpperBound(x, xub);
+    setLowerBound(y, 0);
+    setUpperBound(y, yub);
+    setLowerBound(s, slb);
+    return s;
+  }
+
+  std::unique_ptr<ApproximateSimplex> mkSolver()
+  {
+    return std::unique_ptr<ApproximateSimplex>(
+        ApproximateSimplex::mkFloatSimplexSolver(
+            *d_vars, *d_tableau, *d_treeLog, *d_stats));
+  }
+
+ public:
+  void setUp() override
+  {
+    d_em = new ExprManager();
+    d_nm = NodeManager::fromExprManager(d_em);
+    d_smt = new SmtEngine(d_em);
+    d_scope = new SmtScope(d_smt);
+    d_smt->finalOptionsAreSet();
+
+    TheoryArith* arith = static_cast<TheoryArith*>(
+        d_smt->d_theoryEngine->d_theoryTable[THEORY_ARITH]);
+    d_vars = new ArithVariables(d_smt->d_context,
+                                DeltaComputeCallback(*arith->d_internal));
+    d_tableau = new Tableau();
+    d_treeLog = new TreeLog();
+    d_stats = new ApproximateStatistics();
+  }
+
+  void tearDown() override
+  {
+    delete d_stats;
+    delete d_treeLog;
+    delete d_tableau;
+    delete d_vars;
+    for (ConstraintP c : d_bounds)
+    {
+      delete c;
+    }
+    d_bounds.clear();
+    delete d_scope;
+    delete d_smt;
+    delete d_em;
+  }
+
+  void testFeasible()
+  {
+    // s = x + y >= 3 with x, y in [0, 10]: one pivot brings s to 3
+    ArithVar s = mkRow(1, 1, 10, 10, 3);
+    std::unique_ptr<ApproximateSimplex> approx = mkSolver();
+    TS_ASSERT_EQUALS(approx->solveRelaxation(), LinFeasible);
+    TS_ASSERT_EQUALS(d_stats->d_floatPivots.getData(), 1);
+    TS_ASSERT_EQUALS(d_stats->d_floatBoundFlips.getData(), 0);
+    TS_ASSERT_EQUALS(approx->sumInfeasibilities(false), 0.0);
+
+    ApproximateSimplex::Solution sol = approx->extractRelaxation();
+    TS_ASSERT(!sol.newBasis.isMember(s));
+    TS_ASSERT_EQUALS(sol.newValues[s], DeltaRational(3));
+  }
+
+  void testBoundFlip()
+  {
+    // s = 2x + y >= 4 with x in [0, 1]: x has the best price but reaches its
+    // upper bound before s reaches 4, so it flips, and then y enters
+    ArithVar s = mkRow(2, 1, 1, 10, 4);
+    ArithVar x = s - 2;
+    ArithVar y = s - 1;
+    std::unique_ptr<ApproximateSimplex> approx = mkSolver();
+    TS_ASSERT_EQUALS(approx->solveRelaxation(), LinFeasible);
+    TS_ASSERT_EQUALS(d_stats->d_floatBoundFlips.getData(), 1);
+    TS_ASSERT_EQUALS(d_stats->d_floatPivots.getData(), 1);
+
+    ApproximateSimplex::Solution sol = approx->extractRelaxation();
+    TS_ASSERT(!sol.newBasis.isMember(x));
+    TS_ASSERT(sol.newBasis.isMember(y));
+    TS_ASSERT_EQUALS(sol.newValues[x], DeltaRational(1));
+    TS_ASSERT_EQUALS(sol.newValues[y], DeltaRational(2));
+    TS_ASSERT_EQUALS(sol.newValues[s], DeltaRational(4));
+  }
+
+  void testInfeasible()
+  {
+    // s = x + y >= 3 with x, y in [0, 1]: both flip and s stays at 2
+    mkRow(1, 1, 1, 1, 3);
+    std::unique_ptr<ApproximateSimplex> approx = mkSolver();
+    TS_ASSERT_EQUALS(approx->solveRelaxation(), LinInfeasible);
+    TS_ASSERT_EQUALS(d_stats->d_floatBoundFlips.getData(), 2);
+    TS_ASSERT_EQUALS(d_stats->d_floatPivots.getData(), 0);
+    TS_ASSERT_EQUALS(approx->sumInfeasibilities(false), 1.0);
+  }
+};
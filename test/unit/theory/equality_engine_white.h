@@ -0,0 +1,324 @@
+/*********************                                                        */
+/*! \file equality_engine_white.h
+ ** \verbatim
+ ** Top contributors (to current version):
+ **
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2019 by the authors listed in the file AUTHORS
+ ** in the top-level source directory) and their institutional affiliations.
+ ** All rights reserved.  See the file COPYING in the top-level source
+ ** directory for licensing information.\endverbatim
+ **
+ ** \brief White box testing of CVC4::theory::eq::EqualityEngine.
+ **
+ ** White box testing of CVC4::theory::eq::EqualityEngine, its term table and
+ ** its explanation cache, and benchmarks of the merge throughput on random
+ ** congruence workloads and of the explanation latency on long equality
+ ** chains that only run with CVC4_UNIT_BENCHMARKS set.
+ **/
+
+#include <cxxtest/TestSuite.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <set>
+#include <vector>
+
+#include "context/context.h"
+#include "expr/node.h"
+#include "expr/node_manager.h"
+#include "smt/smt_engine.h"
+#include "smt/smt_engine_scope.h"
+#include "test_utils.h"
+#include "theory/uf/equality_engine.h"
+#include "util/random.h"
+
+using namespace CVC4;
+using namespace CVC4::context;
+using namespace CVC4::smt;
+using namespace CVC4::theory::eq;
+
+class EqualityEngineWhite : public CxxTest::TestSuite
+{
+  ExprManager* d_em;
+  NodeManager* d_nm;
+  SmtEngine* d_smt;
+  SmtScope* d_scope;
+  Context* d_context;
+
+  TypeNode d_sort;
+  Node d_f;
+  Node d_g;
+
+  Random d_rnd{1};
+
+  std::vector<Node> mkConstants(unsigned n)
+  {
+    std::vector<Node> constants;
+    for (unsigned i = 0; i < n; ++i)
+    {
+      constants.push_back(d_nm->mkSkolem("a", d_sort));
+    }
+    return constants;
+  }
+
+  /** Asserts a = b in ee with the equality itself as the reason. */
+  Node assertEqual(EqualityEngine& ee, TNode a, TNode b)
+  {
+    Node eq = a.eqNode(b);
+    ee.assertEquality(eq, true, eq);
+    return eq;
+  }
+
+ public:
+  void setUp() override
+  {
+    d_em = new ExprManager();
+    d_nm = NodeManager::fromExprManager(d_em);
+    d_smt = new SmtEngine(d_em);
+    d_scope = new SmtScope(d_smt);
+    d_context = new Context();
+    d_sort = d_nm->mkSort("U");
+    d_f = d_nm->mkSkolem("f", d_nm->mkFunctionType(d_sort, d_sort));
+    std::vector<TypeNode> args(2, d_sort);
+    d_g = d_nm->mkSkolem("g", d_nm->mkFunctionType(args, d_sort));
+    d_rnd.setSeed(1);
+  }
+
+  void tearDown() override
+  {
+    d_f = Node::null();
+    d_g = Node::null();
+    d_sort = TypeNode::null();
+    delete d_context;
+    delete d_scope;
+    delete d_smt;
+    delete d_em;
+  }
+
+  void testNodeIdTable()
+  {
+    std::vector<Node> constants = mkConstants(1000);
+    NodeIdTable table;
+    for (unsigned i = 0; i < constants.size(); ++i)
+    {
+      TS_ASSERT_EQUALS(table.find(constants[i]), null_id);
+      table.insert(constants[i], i);
+    }
+    TS_ASSERT_EQUALS(table.size(), constants.size());
+
+    // Inserting again replaces the id
+    table.insert(constants[0], 7);
+    TS_ASSERT_EQUALS(table.find(constants[0]), 7u);
+    table.insert(constants[0], 0);
+    TS_ASSERT_EQUALS(table.size(), constants.size());
+
+    // Erase a random half, in random order
+    std::vector<unsigned> order;
+    for (unsigned i = 0; i < constants.size(); ++i)
+    {
+      order.push_back(i);
+    }
+    std::shuffle(order.begin(), order.end(), d_rnd);
+    std::vector<bool> erased(constants.size(), false);
+    for (unsigned i = 0; i < order.size() / 2; ++i)
+    {
+      table.erase(constants[order[i]]);
+      erased[order[i]] = true;
+    }
+    table.erase(constants[order[0]]);
+    TS_ASSERT_EQUALS(table.size(), constants.size() - order.size() / 2);
+    for (unsigned i = 0; i < constants.size(); ++i)
+    {
+      TS_ASSERT_EQUALS(table.find(constants[i]), erased[i] ? null_id : i);
+    }
+
+    // Reinsert them with new ids
+    for (unsigned i = 0; i < constants.size(); ++i)
+    {
+      if (erased[i])
+      {
+        table.insert(constants[i], i + constants.size());
+      }
+    }
+    for (unsigned i = 0; i < constants.size(); ++i)
+    {
+      TS_ASSERT_EQUALS(table.find(constants[i]),
+                       erased[i] ? i + constants.size() : i);
+    }
+  }
+
+  void testBacktrackTerms()
+  {
+    EqualityEngine ee(d_context, "ee_test", false);
+    ee.addFunctionKind(kind::APPLY_UF);
+    std::vector<Node> constants = mkConstants(100);
+    ee.addTerm(constants[0]);
+    d_context->push();
+    for (const Node& a : constants)
+    {
+      ee.addTerm(d_nm->mkNode(kind::APPLY_UF, d_f, a));
+    }
+    TS_ASSERT(ee.hasTerm(constants[50]));
+    d_context->pop();
+    TS_ASSERT(ee.hasTerm(constants[0]));
+    for (unsigned i = 1; i < constants.size(); ++i)
+    {
+      TS_ASSERT(!ee.hasTerm(constants[i]));
+      TS_ASSERT(!ee.hasTerm(d_nm->mkNode(kind::APPLY_UF, d_f, constants[i])));
+    }
+    ee.addTerm(constants[99]);
+    TS_ASSERT(ee.hasTerm(constants[99]));
+  }
+
+  void testCongruence()
+  {
+    EqualityEngine ee(d_context, "ee_test", false);
+    ee.addFunctionKind(kind::APPLY_UF);
+    std::vector<Node> a = mkConstants(3);
+    Node ga = d_nm->mkNode(kind::APPLY_UF, d_g, a[0], a[1]);
+    Node gb = d_nm->mkNode(kind::APPLY_UF, d_g, a[2], a[1]);
+    ee.addTerm(ga);
+    ee.addTerm(gb);
+    TS_ASSERT(!ee.areEqual(ga, gb));
+    d_context->push();
+    Node eq = assertEqual(ee, a[0], a[2]);
+    TS_ASSERT(ee.areEqual(ga, gb));
+    std::vector<TNode> assertions;
+    ee.explainEquality(ga, gb, true, assertions);
+    TS_ASSERT_EQUALS(assertions.size(), 1u);
+    TS_ASSERT_EQUALS(assertions[0], eq);
+    d_context->pop();
+    TS_ASSERT(!ee.areEqual(ga, gb));
+  }
+
+  void testExplanationCache()
+  {
+    EqualityEngine ee(d_context, "ee_test", false);
+    std::vector<Node> a = mkConstants(3);
+    for (const Node& t : a)
+    {
+      ee.addTerm(t);
+    }
+    d_context->push();
+    Node eq1 = assertEqual(ee, a[0], a[1]);
+    Node eq2 = assertEqual(ee, a[1], a[2]);
+    std::vector<TNode> assertions;
+    ee.explainEquality(a[0], a[2], true, assertions);
+    TS_ASSERT_EQUALS(assertions.size(), 2u);
+    TS_ASSERT_EQUALS(ee.d_stats.explanationCacheHits.getData(), 0);
+
+    // The explanation survives pushing and popping a deeper level
+    d_context->push();
+    d_context->pop();
+    std::vector<TNode> cached;
+    ee.explainEquality(a[2], a[0], true, cached);
+    TS_ASSERT_EQUALS(ee.d_stats.explanationCacheHits.getData(), 1);
+    TS_ASSERT_EQUALS(std::set<TNode>(cached.begin(), cached.end()),
+                     std::set<TNode>(assertions.begin(), assertions.end()));
+    d_context->pop();
+
+    // But not popping its own level
+    d_context->push();
+    Node eq3 = assertEqual(ee, a[2], a[0]);
+    assertions.clear();
+    ee.explainEquality(a[0], a[2], true, assertions);
+    TS_ASSERT_EQUALS(assertions.size(), 1u);
+    TS_ASSERT_EQUALS(assertions[0], eq3);
+    TS_ASSERT_EQUALS(ee.d_stats.explanationCacheHits.getData(), 1);
+    d_context->pop();
+  }
+
+  void testBenchmarkMerges()
+  {
+    if (!runUnitBenchmarks())
+    {
+      return;
+    }
+    unsigned n = 20000;
+    EqualityEngine ee(d_context, "ee_bench", false);
+    ee.addFunctionKind(kind::APPLY_UF);
+    std::vector<Node> constants = mkConstants(n);
+    for (unsigned i = 0; i < n; ++i)
+    {
+      ee.addTerm(d_nm->mkNode(kind::APPLY_UF, d_f, constants[i]));
+      ee.addTerm(d_nm->mkNode(
+          kind::APPLY_UF, d_g, constants[i], constants[(i + 1) % n]));
+    }
+
+    std::vector<Node> reasons;
+    std::cout << std::endl;
+    for (unsigned round = 0; round < 5; ++round)
+    {
+      d_context->push();
+      int64_t merges = ee.d_stats.mergesCount.getData();
+      auto start = std::chrono::steady_clock::now();
+      for (unsigned i = 0; i < n / 2; ++i)
+      {
+        reasons.push_back(
+            assertEqual(ee,
+                        constants[d_rnd.pick(0, n - 1)],
+                        constants[d_rnd.pick(0, n - 1)]));
+      }
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      merges = ee.d_stats.mergesCount.getData() - merges;
+      std::cout << "congruence round " << round << ": " << merges
+                << " merges, " << merges / elapsed.count() / 1e3
+                << " Kmerges/s" << std::endl;
+      d_context->pop();
+      reasons.clear();
+    }
+    TS_ASSERT(!ee.areEqual(constants[0], constants[1]));
+  }
+
+  void testBenchmarkExplain()
+  {
+    if (!runUnitBenchmarks())
+    {
+      return;
+    }
+    unsigned n = 2000;
+    EqualityEngine ee(d_context, "ee_bench", false);
+    ee.addFunctionKind(kind::APPLY_UF);
+    std::vector<Node> constants = mkConstants(n);
+    std::vector<Node> apps;
+    for (const Node& a : constants)
+    {
+      apps.push_back(d_nm->mkNode(kind::APPLY_UF, d_f, a));
+      ee.addTerm(apps.back());
+    }
+    std::vector<Node> reasons;
+    for (unsigned i = 0; i + 1 < n; ++i)
+    {
+      reasons.push_back(assertEqual(ee, constants[i], constants[i + 1]));
+    }
+    TS_ASSERT(ee.areEqual(apps.front(), apps.back()));
+
+    // Explain f(a_0) = f(a_j) for distinct j, then again from the cache
+    unsigned calls = 200;
+    std::cout << std::endl;
+    for (unsigned pass = 0; pass < 2; ++pass)
+    {
+      size_t explained = 0;
+      auto start = std::chrono::steady_clock::now();
+      for (unsigned i = 0; i < calls; ++i)
+      {
+        unsigned j = n - 1 - i;
+        std::vector<TNode> assertions;
+        ee.explainEquality(apps.front(), apps[j], true, assertions);
+        std::set<TNode> distinct(assertions.begin(), assertions.end());
+        TS_ASSERT_EQUALS(distinct.size(), j);
+        explained += assertions.size();
+      }
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      std::cout << (pass == 0 ? "uncached" : "cached")
+                << " explain latency on chains of " << n - calls << " to "
+                << n - 1 << " equalities: " << elapsed.count() / calls * 1e6
+                << " us, " << explained / calls << " assertions" << std::endl;
+    }
+    TS_ASSERT_EQUALS(ee.d_stats.explanationCacheHits.getData(), calls);
+  }
+};
@@ -0,0 +1,370 @@
+/*********************                                                        */
+/*! \file rewriter_white.h
+ ** \verbatim
+ ** Top contributors (to current version):
+ **
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2019 by the authors listed in the file AUTHORS
+ ** in the top-level source directory) and their institutional affiliations.
+ ** All rights reserved.  See the file COPYING in the top-level source
+ ** directory for licensing information.\endverbatim
+ **
+ ** \brief White box testing of CVC4::theory::Rewriter.
+ **
+ ** White box testing of CVC4::theory::Rewriter, and a measurement of the
+ ** number of nodes rewritten per second on a large term DAG that only runs
+ ** with CVC4_UNIT_BENCHMARKS set.
+ **/
+
+#include <cxxtest/TestSuite.h>
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "expr/attribute.h"
+#include "expr/node.h"
+#include "expr/node_manager.h"
+#include "options/theory_options.h"
+#include "smt/smt_engine.h"
+#include "smt/smt_engine_scope.h"
+#include "test_utils.h"
+#include "theory/rewriter.h"
+#include "util/random.h"
+#include "util/rational.h"
+
+using namespace CVC4;
+using namespace CVC4::kind;
+using namespace CVC4::smt;
+using namespace CVC4::theory;
+
+class RewriterWhite : public CxxTest::TestSuite
+{
+  ExprManager* d_em;
+  NodeManager* d_nm;
+  SmtEngine* d_smt;
+  SmtScope* d_scope;
+
+  /** The sum of the given cache counter over all theories */
+  int64_t sumCounters(int64_t Rewriter::CacheCounters::*counter)
+  {
+    RewriterState& state = Rewriter::getState();
+    int64_t sum = 0;
+    for (unsigned i = 0; i < THEORY_LAST; ++i)
+    {
+      sum += state.d_cacheCounters[i].*counter;
+    }
+    return sum;
+  }
+
+  /** The number of evictions from the rewrite caches over all theories */
+  int64_t sumEvictions()
+  {
+    RewriterState& state = Rewriter::getState();
+    int64_t sum = 0;
+    for (unsigned i = 0; i < THEORY_LAST; ++i)
+    {
+      sum += state.d_evictions[i];
+    }
+    return sum;
+  }
+
+  /** Build n distinct terms x_i + 0 */
+  std::vector<Node> mkTerms(unsigned n)
+  {
+    Node zero = d_nm->mkConst(Rational(0));
+    std::vector<Node> terms;
+    for (unsigned i = 0; i < n; ++i)
+    {
+      Node x = d_nm->mkVar(d_nm->integerType());
+      terms.push_back(d_nm->mkNode(PLUS, x, zero));
+    }
+    return terms;
+  }
+
+  /**
+   * Build a DAG of n arithmetic terms over a few integer variables, where
+   * every term shares subterms with earlier ones.
+   */
+  std::vector<Node> mkDag(unsigned n)
+  {
+    std::vector<Node> terms;
+    for (unsigned i = 0; i < 8; ++i)
+    {
+      terms.push_back(d_nm->mkVar(d_nm->integerType()));
+    }
+    terms.push_back(d_nm->mkConst(Rational(0)));
+    terms.push_back(d_nm->mkConst(Rational(2)));
+    Random rnd(1);
+    while (terms.size() < n)
+    {
+      const Node& a = terms[rnd.pick(0, terms.size() - 1)];
+      const Node& b = terms[rnd.pick(0, terms.size() - 1)];
+      uint64_t op = rnd.pick(0, 3);
+      Kind k = op < 2 ? PLUS : (op == 2 ? MINUS : MULT);
+      // keep the terms linear
+      if (k == MULT && !a.isConst() && !b.isConst())
+      {
+        continue;
+      }
+      terms.push_back(d_nm->mkNode(k, a, b));
+    }
+    return terms;
+  }
+
+  /** The number of distinct nodes in the given terms */
+  size_t countNodes(const std::vector<Node>& terms)
+  {
+    std::unordered_set<TNode, TNodeHashFunction> visited;
+    std::vector<TNode> toVisit(terms.begin(), terms.end());
+    while (!toVisit.empty())
+    {
+      TNode n = toVisit.back();
+      toVisit.pop_back();
+      if (visited.insert(n).second)
+      {
+        toVisit.insert(toVisit.end(), n.begin(), n.end());
+      }
+    }
+    return visited.size();
+  }
+
+ public:
+  void setUp() override
+  {
+    d_em = new ExprManager();
+    d_nm = NodeManager::fromExprManager(d_em);
+    d_smt = new SmtEngine(d_em);
+    d_scope = new SmtScope(d_smt);
+    Rewriter::clearCaches();
+  }
+
+  void tearDown() override
+  {
+    Rewriter::clearCaches();
+    delete d_scope;
+    delete d_smt;
+    delete d_em;
+  }
+
+  void testCacheHits()
+  {
+    std::vector<Node> terms = mkTerms(10);
+    std::vector<Node> results;
+    int64_t misses = sumCounters(&Rewriter::CacheCounters::d_misses);
+    for (const Node& t : terms)
+    {
+      results.push_back(Rewriter::rewrite(t));
+      TS_ASSERT_EQUALS(results.back(), t[0]);
+    }
+    TS_ASSERT_LESS_THAN(misses, sumCounters(&Rewriter::CacheCounters::d_misses));
+
+    misses = sumCounters(&Rewriter::CacheCounters::d_misses);
+    int64_t hits = sumCounters(&Rewriter::CacheCounters::d_hits);
+    for (size_t i = 0; i < terms.size(); ++i)
+    {
+      TS_ASSERT_EQUALS(Rewriter::rewrite(terms[i]), results[i]);
+    }
+    // the second time around, every term is found in the post-rewrite cache
+    TS_ASSERT_EQUALS(sumCounters(&Rewriter::CacheCounters::d_misses), misses);
+    TS_ASSERT_EQUALS(sumCounters(&Rewriter::CacheCounters::d_hits),
+                     hits + static_cast<int64_t>(terms.size()));
+  }
+
+  void testBoundedCache()
+  {
+    const unsigned long limit = 64;
+    d_nm->getOptions().set(options::rewriteCacheLimit, limit);
+    expr::attr::AttributeManager* am = d_nm->d_attrManager;
+
+    std::vector<Node> terms = mkTerms(500);
+    int64_t evictions = sumEvictions();
+    for (const Node& t : terms)
+    {
+      TS_ASSERT_EQUALS(Rewriter::rewrite(t), t[0]);
+      TS_ASSERT_LESS_THAN_EQUALS(am->d_denseNodes.size(), limit + 1);
+    }
+    TS_ASSERT_LESS_THAN(evictions, sumEvictions());
+
+    // a term that is rewritten over and over stays cached
+    Node hot = terms[0];
+    for (const Node& t : terms)
+    {
+      Rewriter::rewrite(t);
+      int64_t misses = sumCounters(&Rewriter::CacheCounters::d_misses);
+      TS_ASSERT_EQUALS(Rewriter::rewrite(hot), hot[0]);
+      TS_ASSERT_EQUALS(sumCounters(&Rewriter::CacheCounters::d_misses), misses);
+    }
+
+    d_nm->getOptions().set(options::rewriteCacheLimit, 0ul);
+  }
+
+  void testEvictionCounts()
+  {
+    // each generation holds two entries
+    d_nm->getOptions().set(options::rewriteCacheLimit, 4ul);
+    RewriterState& state = Rewriter::getState();
+    Rewriter& rewriter = Rewriter::getInstance();
+    std::vector<Node> terms = mkTerms(3);
+    int64_t evictions = state.d_evictions[THEORY_ARITH];
+
+    // overwriting an entry does not add one
+    rewriter.storePostRewriteCache(THEORY_ARITH, terms[0], terms[0][0]);
+    rewriter.storePostRewriteCache(THEORY_ARITH, terms[0], terms[0][0]);
+    TS_ASSERT_EQUALS(state.d_entries[THEORY_ARITH][state.d_current], 1);
+    TS_ASSERT_EQUALS(state.d_size, 1u);
+
+    // the second entry fills the generation, a new one is started
+    rewriter.storePostRewriteCache(THEORY_ARITH, terms[1], terms[1][0]);
+    TS_ASSERT(state.d_hasOld);
+    TS_ASSERT_EQUALS(state.d_size, 0u);
+    TS_ASSERT_EQUALS(state.d_entries[THEORY_ARITH][1 - state.d_current], 2);
+    TS_ASSERT_EQUALS(state.d_evictions[THEORY_ARITH], evictions);
+
+    // an entry found in the previous generation is moved to the current one
+    TS_ASSERT_EQUALS(rewriter.lookupPostRewriteCache(THEORY_ARITH, terms[0]),
+                     terms[0][0]);
+    TS_ASSERT_EQUALS(state.d_entries[THEORY_ARITH][state.d_current], 1);
+    TS_ASSERT_EQUALS(state.d_entries[THEORY_ARITH][1 - state.d_current], 1);
+
+    // only the entry that was not used since is evicted
+    rewriter.storePostRewriteCache(THEORY_ARITH, terms[2], terms[2][0]);
+    TS_ASSERT_EQUALS(state.d_evictions[THEORY_ARITH], evictions + 1);
+    TS_ASSERT_EQUALS(rewriter.lookupPostRewriteCache(THEORY_ARITH, terms[0]),
+                     terms[0][0]);
+    TS_ASSERT(rewriter.lookupPostRewriteCache(THEORY_ARITH, terms[1]).isNull());
+
+    d_nm->getOptions().set(options::rewriteCacheLimit, 0ul);
+  }
+
+  void testProfile()
+  {
+    d_nm->getOptions().set(options::rewriteProfile, true);
+    Rewriter& rewriter = Rewriter::getInstance();
+
+    std::vector<Node> terms = mkTerms(10);
+    for (const Node& t : terms)
+    {
+      Rewriter::rewrite(t);
+    }
+    Rewriter::ProfileEntry plus = rewriter.getProfileEntry(THEORY_ARITH, PLUS);
+    TS_ASSERT_LESS_THAN_EQUALS(20, plus.d_rewrites);
+    TS_ASSERT_LESS_THAN_EQUALS(plus.d_rewrites, plus.d_iterations);
+
+    for (const Node& t : terms)
+    {
+      Rewriter::rewrite(t);
+    }
+    TS_ASSERT_EQUALS(rewriter.getProfileEntry(THEORY_ARITH, PLUS).d_cacheHits,
+                     plus.d_cacheHits + 10);
+    TS_ASSERT_EQUALS(rewriter.getProfileEntry(THEORY_ARITH, PLUS).d_rewrites,
+                     plus.d_rewrites);
+
+    std::stringstream ss;
+    ss << d_smt->getStatistic("theory::Rewriter::profile");
+    TS_ASSERT_DIFFERS(ss.str().find("THEORY_ARITH"), std::string::npos);
+    TS_ASSERT_DIFFERS(ss.str().find("PLUS"), std::string::npos);
+
+    d_nm->getOptions().set(options::rewriteProfile, false);
+  }
+
+  void testStatisticsOfOtherThreads()
+  {
+    // the rewrites of another thread are counted by the SmtEngine in scope
+    // there, and still reported after that thread has finished
+    std::vector<Node> terms = mkTerms(10);
+    int64_t misses = sumCounters(&Rewriter::CacheCounters::d_misses);
+    std::thread worker([&]() {
+      SmtScope scope(d_smt);
+      for (const Node& t : terms)
+      {
+        Rewriter::rewrite(t);
+      }
+    });
+    worker.join();
+    TS_ASSERT_LESS_THAN(misses,
+                        sumCounters(&Rewriter::CacheCounters::d_misses));
+
+    std::stringstream ss;
+    ss << d_smt->getStatistic("theory::Rewriter::THEORY_ARITH::cacheMisses");
+    TS_ASSERT_DIFFERS(ss.str(), "0");
+  }
+
+  void testWorkStackReuse()
+  {
+    std::vector<Node> terms = mkDag(2000);
+    Rewriter& rewriter = Rewriter::getInstance();
+    std::vector<Node> results;
+    for (const Node& t : terms)
+    {
+      results.push_back(Rewriter::rewrite(t));
+    }
+    // the work stack is released between rewrites, but not deallocated
+    TS_ASSERT(rewriter.d_workStack.empty());
+    TS_ASSERT(rewriter.d_rewrittenChildren.empty());
+    TS_ASSERT_LESS_THAN(0u, rewriter.d_workStack.capacity());
+
+    Rewriter::clearCaches();
+    for (size_t i = 0; i < terms.size(); ++i)
+    {
+      TS_ASSERT_EQUALS(Rewriter::rewrite(terms[i]), results[i]);
+    }
+  }
+
+  void testThroughput()
+  {
+    if (!runUnitBenchmarks())
+    {
+      return;
+    }
+    std::vector<Node> terms = mkDag(200000);
+    size_t n = countNodes(terms);
+    Rewriter& rewriter = Rewriter::getInstance();
+
+    // construct the rewritten nodes once, so that both runs below only find
+    // them in the NodeManager
+    std::vector<Node> warmup;
+    for (const Node& t : terms)
+    {
+      warmup.push_back(Rewriter::rewrite(t));
+    }
+
+    // before: the work stack is allocated afresh for each top-level rewrite
+    Rewriter::clearCaches();
+    std::vector<Node> fresh;
+    auto t0 = std::chrono::steady_clock::now();
+    for (const Node& t : terms)
+    {
+      std::vector<Rewriter::RewriteStackElement>().swap(rewriter.d_workStack);
+      std::vector<Node>().swap(rewriter.d_rewrittenChildren);
+      fresh.push_back(Rewriter::rewrite(t));
+    }
+    std::chrono::duration<double> before =
+        std::chrono::steady_clock::now() - t0;
+
+    // after: the work stack is kept across rewrites
+    Rewriter::clearCaches();
+    std::vector<Node> reused;
+    t0 = std::chrono::steady_clock::now();
+    for (const Node& t : terms)
+    {
+      reused.push_back(Rewriter::rewrite(t));
+    }
+    std::chrono::duration<double> after =
+        std::chrono::steady_clock::now() - t0;
+
+    TS_ASSERT(fresh == warmup);
+    TS_ASSERT(reused == warmup);
+
+    std::cout << std::endl
+              << "rewriter throughput on " << n
+              << " nodes (Mnodes/s):" << std::endl
+              << "  fresh work stack per rewrite: " << n / before.count() / 1e6
+              << std::endl
+              << "  reused work stack:            " << n / after.count() / 1e6
+              << std::endl;
+  }
+};
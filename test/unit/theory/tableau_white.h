@@ -0,0 +1,182 @@
+/*********************                                                        */
+/*! \file tableau_white.h
+ ** \verbatim
+ ** Top contributors (to current version):
+ **
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2019 by the authors listed in the file AUTHORS
+ ** in the top-level source directory) and their institutional affiliations.
+ ** All rights reserved.  See the file COPYING in the top-level source
+ ** directory for licensing information.\endverbatim
+ **
+ ** \brief White box testing of CVC4::theory::arith::Tableau.
+ **
+ ** White box testing of CVC4::theory::arith::Tableau, and a benchmark of the
+ ** pivot throughput on a large random tableau with small coefficients, as
+ ** in most linear real arithmetic problems, that only runs with
+ ** CVC4_UNIT_BENCHMARKS set.
+ **/
+
+#include <cxxtest/TestSuite.h>
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "test_utils.h"
+#include "theory/arith/tableau.h"
+#include "util/random.h"
+#include "util/rational.h"
+
+using namespace CVC4;
+using namespace CVC4::theory::arith;
+
+class TableauWhite : public CxxTest::TestSuite
+{
+  Random d_rnd{1};
+
+  /** A random number in [0, n) */
+  unsigned random(unsigned n) { return d_rnd.pick(0, n - 1); }
+
+  /**
+   * Builds a tableau with numRows basic variables, each defined as a sum of
+   * rowLength of the numCols original variables with coefficients in
+   * [-9, 9], and an assignment satisfying the rows.
+   */
+  void mkRandomTableau(Tableau& tableau,
+                       std::vector<Rational>& assignment,
+                       unsigned numRows,
+                       unsigned numCols,
+                       unsigned rowLength)
+  {
+    tableau.increaseSizeTo(numCols + numRows);
+    for (unsigned x = 0; x < numCols; ++x)
+    {
+      assignment.push_back(Rational((int)random(201) - 100, (int)random(9) + 1));
+    }
+    for (unsigned r = 0; r < numRows; ++r)
+    {
+      std::vector<Rational> coeffs;
+      std::vector<ArithVar> vars;
+      Rational value;
+      while (vars.size() < rowLength)
+      {
+        ArithVar x = random(numCols);
+        bool fresh = true;
+        for (ArithVar y : vars)
+        {
+          fresh = fresh && x != y;
+        }
+        if (fresh)
+        {
+          int c = (int)random(18) - 9;
+          coeffs.push_back(Rational(c >= 0 ? c + 1 : c));
+          vars.push_back(x);
+          value += coeffs.back() * assignment[x];
+        }
+      }
+      tableau.addRow(numCols + r, coeffs, vars);
+      assignment.push_back(value);
+    }
+  }
+
+  /** Returns true if the assignment satisfies every row of the tableau. */
+  bool satisfies(const Tableau& tableau, const std::vector<Rational>& assignment)
+  {
+    for (Tableau::BasicIterator b = tableau.beginBasic(),
+                                b_end = tableau.endBasic();
+         b != b_end;
+         ++b)
+    {
+      Rational sum;
+      for (Tableau::RowIterator i = tableau.basicRowIterator(*b); !i.atEnd();
+           ++i)
+      {
+        sum += (*i).getCoefficient() * assignment[(*i).getColVar()];
+      }
+      if (!sum.isZero())
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Pivots the basic variable of a random row with a random nonbasic variable
+   * of the row.
+   */
+  void pivotRandom(Tableau& tableau, unsigned numVars)
+  {
+    ArithVar basic;
+    do
+    {
+      basic = random(numVars);
+    } while (!tableau.isBasic(basic));
+    std::vector<ArithVar> candidates;
+    for (Tableau::RowIterator i = tableau.basicRowIterator(basic); !i.atEnd();
+         ++i)
+    {
+      if ((*i).getColVar() != basic)
+      {
+        candidates.push_back((*i).getColVar());
+      }
+    }
+    NoEffectCCCB noEffect;
+    tableau.pivot(basic, candidates[random(candidates.size())], noEffect);
+  }
+
+ public:
+  void setUp() override { d_rnd.setSeed(1); }
+
+  void testPivotPreservesRows()
+  {
+    Tableau tableau;
+    std::vector<Rational> assignment;
+    mkRandomTableau(tableau, assignment, 30, 60, 4);
+    TS_ASSERT(satisfies(tableau, assignment));
+    for (unsigned i = 0; i < 200; ++i)
+    {
+      pivotRandom(tableau, assignment.size());
+    }
+    TS_ASSERT(satisfies(tableau, assignment));
+  }
+
+  void testBenchmarkPivots()
+  {
+    if (!runUnitBenchmarks())
+    {
+      return;
+    }
+    unsigned numRows = 2000;
+    unsigned numCols = 4000;
+    unsigned pivots = 500;
+    Tableau tableau;
+    std::vector<Rational> assignment;
+    mkRandomTableau(tableau, assignment, numRows, numCols, 5);
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < pivots; ++i)
+    {
+      pivotRandom(tableau, assignment.size());
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    TS_ASSERT(satisfies(tableau, assignment));
+
+    size_t entries = 0;
+    for (Tableau::BasicIterator b = tableau.beginBasic(),
+                                b_end = tableau.endBasic();
+         b != b_end;
+         ++b)
+    {
+      entries += tableau.basicRowLength(*b);
+    }
+    std::cout << std::endl
+              << "pivot throughput on " << numRows << " x "
+              << numCols + numRows << ": " << pivots / elapsed.count()
+              << " pivots/s, " << entries << " entries after pivoting, "
+              << "average row complexity " << tableau.avgRowComplexity()
+              << std::endl;
+  }
+};
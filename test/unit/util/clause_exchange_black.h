@@ -0,0 +1,116 @@
+/*********************                                                        */
+/*! \file clause_exchange_black.h
+ ** \verbatim
+ ** Top contributors (to current version):
+ **
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2019 by the authors listed in the file AUTHORS
+ ** in the top-level source directory) and their institutional affiliations.
+ ** All rights reserved.  See the file COPYING in the top-level source
+ ** directory for licensing information.\endverbatim
+ **
+ ** \brief Black box testing of CVC4::ClauseExchange
+ **
+ ** Black box testing of CVC4::ClauseExchange.
+ **/
+
+#include <cxxtest/TestSuite.h>
+
+#include <thread>
+#include <vector>
+
+#include "util/clause_exchange.h"
+
+using namespace CVC4;
+
+class ClauseExchangeBlack : public CxxTest::TestSuite
+{
+ public:
+  void testAtomIds()
+  {
+    ClauseExchange exchange;
+    uint32_t a = exchange.getAtomId("a");
+    uint32_t b = exchange.getAtomId("b");
+    TS_ASSERT_DIFFERS(a, b);
+    TS_ASSERT_EQUALS(exchange.getAtomId("a"), a);
+    TS_ASSERT_EQUALS(exchange.getAtomId("b"), b);
+  }
+
+  void testPublishCollect()
+  {
+    ClauseExchange exchange;
+    unsigned p0 = exchange.join();
+    unsigned p1 = exchange.join();
+    unsigned p2 = exchange.join();
+    TS_ASSERT_DIFFERS(p0, p1);
+    TS_ASSERT_DIFFERS(p1, p2);
+
+    ClauseExchange::Clause c;
+    c.push_back(ClauseExchange::Literal(exchange.getAtomId("a"), false));
+    c.push_back(ClauseExchange::Literal(exchange.getAtomId("b"), true));
+    exchange.publish(p0, c);
+
+    std::vector<ClauseExchange::Clause> clauses;
+    exchange.collect(p0, clauses);
+    TS_ASSERT(clauses.empty());
+    exchange.collect(p1, clauses);
+    TS_ASSERT_EQUALS(clauses.size(), 1u);
+    TS_ASSERT(clauses[0] == c);
+    exchange.collect(p1, clauses);
+    TS_ASSERT(clauses.empty());
+
+    // clauses published to a participant that left are dropped
+    exchange.leave(p2);
+    unsigned p3 = exchange.join();
+    TS_ASSERT_EQUALS(p3, p2);
+    exchange.collect(p3, clauses);
+    TS_ASSERT(clauses.empty());
+
+    exchange.publish(p1, c);
+    exchange.clear();
+    exchange.collect(p0, clauses);
+    TS_ASSERT(clauses.empty());
+  }
+
+  void testCapacity()
+  {
+    ClauseExchange exchange(2);
+    unsigned p0 = exchange.join();
+    unsigned p1 = exchange.join();
+    ClauseExchange::Clause c(1, ClauseExchange::Literal(0, false));
+    for (unsigned i = 0; i < 5; ++i)
+    {
+      exchange.publish(p0, c);
+    }
+    std::vector<ClauseExchange::Clause> clauses;
+    exchange.collect(p1, clauses);
+    TS_ASSERT_EQUALS(clauses.size(), 2u);
+  }
+
+  void testConcurrentPublish()
+  {
+    ClauseExchange exchange;
+    unsigned receiver = exchange.join();
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < 4; ++t)
+    {
+      threads.emplace_back([&exchange]() {
+        unsigned p = exchange.join();
+        ClauseExchange::Clause c(1, ClauseExchange::Literal(0, false));
+        for (unsigned i = 0; i < 100; ++i)
+        {
+          c[0].first = exchange.getAtomId(std::to_string(i));
+          exchange.publish(p, c);
+        }
+      });
+    }
+    for (std::thread& t : threads)
+    {
+      t.join();
+    }
+    std::vector<ClauseExchange::Clause> clauses;
+    exchange.collect(receiver, clauses);
+    TS_ASSERT_EQUALS(clauses.size(), 400u);
+    TS_ASSERT_EQUALS(exchange.getAtomId("100"), 100u);
+  }
+};
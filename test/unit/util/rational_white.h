@@ -15,7 +15,9 @@
  **/
 
 #include <cxxtest/TestSuite.h>
+#include <climits>
 #include <sstream>
+#include <vector>
 
 #include "util/rational.h"
 
@@ -441,4 +443,78 @@ public:
                      Rational((unsigned long)u_above2tothe29));
 
   }
+
+  /**
+   * Compares the arithmetic on rationals around the limits of the machine
+   * words against the results built from the exact integer operations.
+   */
+  void testArithmeticNearOverflow(){
+    Integer two(2);
+    std::vector<Integer> magnitudes = {Integer(1),
+                                       Integer(2),
+                                       Integer(3),
+                                       Integer(12),
+                                       Integer(1 << 20) + 7,
+                                       two.pow(31) - 1,
+                                       two.pow(31) + 1,
+                                       two.pow(62),
+                                       two.pow(63) - 1,
+                                       two.pow(63),
+                                       two.pow(64) + 3,
+                                       Integer(3).pow(45)};
+    std::vector<Rational> values;
+    for (const Integer& n : magnitudes)
+    {
+      for (const Integer& d : magnitudes)
+      {
+        values.push_back(Rational(n, d));
+        values.push_back(Rational(-n, d));
+      }
+      values.push_back(Rational(Integer(0), n));
+    }
+
+    for (const Rational& a : values)
+    {
+      Integer na = a.getNumerator();
+      Integer da = a.getDenominator();
+      TS_ASSERT_EQUALS(a.floor(), na.floorDivideQuotient(da));
+      TS_ASSERT_EQUALS(a.ceiling(), -((-na).floorDivideQuotient(da)));
+      TS_ASSERT_EQUALS(a.isIntegral(), da == 1);
+      TS_ASSERT_EQUALS(Rational(a.toString()), a);
+      for (const Rational& b : values)
+      {
+        Integer nb = b.getNumerator();
+        Integer db = b.getDenominator();
+        Rational sum(na * db + nb * da, da * db);
+        Rational difference(na * db - nb * da, da * db);
+        Rational product(na * nb, da * db);
+        TS_ASSERT_EQUALS(a + b, sum);
+        TS_ASSERT_EQUALS(a - b, difference);
+        TS_ASSERT_EQUALS(a * b, product);
+        TS_ASSERT_EQUALS((a + b).hash(), sum.hash());
+        int cmp = a.cmp(b);
+        TS_ASSERT_EQUALS((cmp > 0) - (cmp < 0), difference.sgn());
+        TS_ASSERT_EQUALS(a == b, difference.isZero());
+        TS_ASSERT_EQUALS(a < b, difference.sgn() < 0);
+        Rational c = a;
+        c += b;
+        TS_ASSERT_EQUALS(c, sum);
+        c -= b;
+        TS_ASSERT_EQUALS(c, a);
+        c *= b;
+        TS_ASSERT_EQUALS(c, product);
+        if (!b.isZero())
+        {
+          TS_ASSERT_EQUALS(a / b, Rational(na * db, da * nb));
+          TS_ASSERT_EQUALS(b.inverse(), Rational(db, nb));
+        }
+      }
+    }
+
+    Rational max((long)LONG_MAX);
+    Rational sum = max + Rational(1);
+    TS_ASSERT_EQUALS(sum - Rational(1), max);
+    TS_ASSERT_EQUALS((sum - Rational(1)).hash(), max.hash());
+    TS_ASSERT_EQUALS(Rational((long)LONG_MIN), -sum);
+  }
 };